@@ -6,12 +6,18 @@
 #include "OpenGL.h"
 #include "Combiner.h"
 #include "GLSLCombiner.h"
+#include "ShaderUtils.h"
 #include "UniformCollection.h"
 #include "Debug.h"
 #include "gDP.h"
 #include "Config.h"
 #include "PluginAPI.h"
 #include "RSP.h"
+#include "Log.h"
+#include "GBI.h"
+#include "gSP.h"
+#include "VI.h"
+#include "FrameBuffer.h"
 
 static int saRGBExpanded[] =
 {
@@ -73,8 +79,8 @@ static int aAExpanded[] =
 
 void Combiner_Init() {
 	CombinerInfo & cmbInfo = CombinerInfo::get();
-	cmbInfo.init();
 	InitShaderCombiner();
+	cmbInfo.init();
 	if (cmbInfo.getCombinersNumber() == 0) {
 		gDP.otherMode.cycleType = G_CYC_COPY;
 		cmbInfo.setCombine(EncodeCombineMode(0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0));
@@ -107,12 +113,24 @@ void CombinerInfo::init()
 								OGLVideo::isExtensionSupported(GET_PROGRAM_BINARY_EXTENSION) &&
 								numBinaryFormats > 0;
 
-	m_shadersLoaded = 0;
-	if (m_bShaderCacheSupported && !_loadShadersStorage()) {
-		for (Combiners::iterator cur = m_combiners.begin(); cur != m_combiners.end(); ++cur)
-			delete cur->second;
-		m_combiners.clear();
-	}
+	if (m_bShaderCacheSupported && !_loadShadersStorage())
+		_resetShadersStorage();
+
+	m_waitLinkFrame = 0;
+	m_waitedLinks = 0;
+	m_uberShaderActivations = 0;
+	m_sharedCombiners = 0;
+	m_draws = 0;
+	m_uberShaderDraws = 0;
+	m_uniformUpdates = 0;
+	m_uniformGroupsUpdated = 0;
+	m_uniformGroupsSkipped = 0;
+#ifndef GLES2
+	m_pUberShader = ShaderCombiner::createUberShader();
+	m_pUberShader->update(true);
+	m_pUniformCollection->bindWithShaderCombiner(m_pUberShader);
+	m_pCurrent = NULL;
+#endif
 }
 
 void CombinerInfo::destroy()
@@ -120,12 +138,26 @@ void CombinerInfo::destroy()
 	delete m_pUniformCollection;
 	m_pUniformCollection = NULL;
 	m_pCurrent = NULL;
-	if (m_bShaderCacheSupported)
-		_saveShadersStorage();
-	m_shadersLoaded = 0;
-	for (Combiners::iterator cur = m_combiners.begin(); cur != m_combiners.end(); ++cur)
+	LOG(LOG_VERBOSE, "Combiners: %u key lookups, %u found in recent keys\n", m_combiners.getLookups(), m_combiners.getRecentHits());
+	if (m_storage.is_open())
+		m_storage.close();
+	m_storageIndex.clear();
+	m_storageCanonicalIndex.clear();
+	// Combiners are owned by canonical map, m_combiners may have several keys for the same combiner.
+	for (CanonicalCombiners::iterator cur = m_canonicalCombiners.begin(); cur != m_canonicalCombiners.end(); ++cur)
 		delete cur->second;
+	m_canonicalCombiners.clear();
 	m_combiners.clear();
+	delete m_pUberShader;
+	m_pUberShader = NULL;
+	LOG(LOG_VERBOSE, "Combiners: waited for link %u times, uber shader used %u times\n", m_waitedLinks, m_uberShaderActivations);
+	LOG(LOG_VERBOSE, "Combiners: %u keys share equivalent combiner\n", m_sharedCombiners);
+	LOG(LOG_VERBOSE, "Combiners: %u draws, %u of them with uber shader\n", m_draws, m_uberShaderDraws);
+	if (m_uniformUpdates > 0)
+		LOG(LOG_VERBOSE, "Combiners: %u updates, uniform groups updated %u, skipped %u (%.2f updated per update)\n",
+			m_uniformUpdates, m_uniformGroupsUpdated, m_uniformGroupsSkipped, (float)m_uniformGroupsUpdated / m_uniformUpdates);
+	if (m_draws > 0)
+		LOG(LOG_VERBOSE, "Combiners: %.2f uniform groups updated per draw\n", (float)m_uniformGroupsUpdated / m_draws);
 }
 
 static
@@ -188,90 +220,392 @@ void SimplifyCycle( CombineCycle *cc, CombinerStage *stage )
 	}
 }
 
-ShaderCombiner * CombinerInfo::_compile(u64 mux) const
+static
+void DecodeCombineCycles(const gDPCombine & _combine, CombineCycle * _cc, CombineCycle * _ac)
 {
-	gDPCombine combine;
-
-	combine.mux = mux;
-
-	int numCycles;
-
-	Combiner color, alpha;
+	// Decode and expand the combine mode into a more general form
+	_cc[0].sa = saRGBExpanded[_combine.saRGB0];
+	_cc[0].sb = sbRGBExpanded[_combine.sbRGB0];
+	_cc[0].m = mRGBExpanded[_combine.mRGB0];
+	_cc[0].a = aRGBExpanded[_combine.aRGB0];
+	_ac[0].sa = saAExpanded[_combine.saA0];
+	_ac[0].sb = sbAExpanded[_combine.sbA0];
+	_ac[0].m = mAExpanded[_combine.mA0];
+	_ac[0].a = aAExpanded[_combine.aA0];
+
+	_cc[1].sa = saRGBExpanded[_combine.saRGB1];
+	_cc[1].sb = sbRGBExpanded[_combine.sbRGB1];
+	_cc[1].m  = mRGBExpanded[_combine.mRGB1];
+	_cc[1].a  = aRGBExpanded[_combine.aRGB1];
+	_ac[1].sa = saAExpanded[_combine.saA1];
+	_ac[1].sb = sbAExpanded[_combine.sbA1];
+	_ac[1].m  = mAExpanded[_combine.mA1];
+	_ac[1].a  = aAExpanded[_combine.aA1];
+}
 
-	numCycles = gDP.otherMode.cycleType + 1;
-	color.numStages = numCycles;
-	alpha.numStages = numCycles;
+static
+void SimplifyCombine(const gDPCombine & _combine, u32 _cycleType, Combiner & _color, Combiner & _alpha)
+{
+	const int numCycles = _cycleType + 1;
+	_color.numStages = numCycles;
+	_alpha.numStages = numCycles;
 
 	CombineCycle cc[2];
 	CombineCycle ac[2];
-
-	// Decode and expand the combine mode into a more general form
-	cc[1].sa = saRGBExpanded[combine.saRGB1];
-	cc[1].sb = sbRGBExpanded[combine.sbRGB1];
-	cc[1].m  = mRGBExpanded[combine.mRGB1];
-	cc[1].a  = aRGBExpanded[combine.aRGB1];
-	ac[1].sa = saAExpanded[combine.saA1];
-	ac[1].sb = sbAExpanded[combine.sbA1];
-	ac[1].m  = mAExpanded[combine.mA1];
-	ac[1].a  = aAExpanded[combine.aA1];
+	DecodeCombineCycles(_combine, cc, ac);
 
 	// Simplify each RDP combiner cycle into a combiner stage
-	if (gDP.otherMode.cycleType == G_CYC_1CYCLE) {
-		SimplifyCycle(&cc[1], &color.stage[0]);
-		SimplifyCycle(&ac[1], &alpha.stage[0]);
+	if (_cycleType == G_CYC_1CYCLE) {
+		SimplifyCycle(&cc[1], &_color.stage[0]);
+		SimplifyCycle(&ac[1], &_alpha.stage[0]);
 	}
 	else {
-		cc[0].sa = saRGBExpanded[combine.saRGB0];
-		cc[0].sb = sbRGBExpanded[combine.sbRGB0];
-		cc[0].m = mRGBExpanded[combine.mRGB0];
-		cc[0].a = aRGBExpanded[combine.aRGB0];
-		ac[0].sa = saAExpanded[combine.saA0];
-		ac[0].sb = sbAExpanded[combine.sbA0];
-		ac[0].m = mAExpanded[combine.mA0];
-		ac[0].a = aAExpanded[combine.aA0];
-
-		SimplifyCycle(&cc[0], &color.stage[0]);
-		SimplifyCycle(&ac[0], &alpha.stage[0]);
-		SimplifyCycle(&cc[1], &color.stage[1]);
-		SimplifyCycle(&ac[1], &alpha.stage[1]);
+		SimplifyCycle(&cc[0], &_color.stage[0]);
+		SimplifyCycle(&ac[0], &_alpha.stage[0]);
+		SimplifyCycle(&cc[1], &_color.stage[1]);
+		SimplifyCycle(&ac[1], &_alpha.stage[1]);
 	}
+}
 
-	return new ShaderCombiner( color, alpha, combine );
+static
+void AppendCombinerStage(const CombinerStage & _stage, std::vector<int> & _data)
+{
+	_data.push_back(_stage.numOps);
+	for (int i = 0; i < _stage.numOps; ++i) {
+		_data.push_back(_stage.op[i].op);
+		_data.push_back(_stage.op[i].param1);
+		// param2 and param3 are set only for interpolation.
+		if (_stage.op[i].op == INTER) {
+			_data.push_back(_stage.op[i].param2);
+			_data.push_back(_stage.op[i].param3);
+		}
+	}
 }
 
+// Combiner keys with the same simplified combiner stages produce identical shaders.
+static
+u64 GetCanonicalCombinerKey(u64 _key)
+{
+	gDPCombine combine;
+	combine.mux = _key;
+	const u32 cycleType = combine.muxs0 >> 24;
+	combine.muxs0 &= 0x00FFFFFF;
+
+	Combiner color, alpha;
+	SimplifyCombine(combine, cycleType, color, alpha);
+
+	// Only two cycle mode has second stage and second blender cycle in shader.
+	const bool b2Cycle = cycleType == G_CYC_2CYCLE;
+	std::vector<int> data;
+	data.push_back(b2Cycle ? 2 : 1);
+	AppendCombinerStage(color.stage[0], data);
+	AppendCombinerStage(alpha.stage[0], data);
+	if (b2Cycle) {
+		AppendCombinerStage(color.stage[1], data);
+		AppendCombinerStage(alpha.stage[1], data);
+	}
+
+	// FNV-1a
+	u64 hash = 0xCBF29CE484222325ULL;
+	const u8 * pData = reinterpret_cast<const u8*>(data.data());
+	for (size_t i = 0; i < data.size() * sizeof(int); ++i) {
+		hash ^= pData[i];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+ShaderCombiner * CombinerInfo::_compile(u64 mux)
+{
+	gDPCombine combine;
+
+	combine.mux = mux;
+
+	Combiner color, alpha;
+	SimplifyCombine(combine, gDP.otherMode.cycleType, color, alpha);
+
+	ShaderCombiner * pCombiner = new ShaderCombiner( color, alpha, combine );
+	m_canonicalCombiners[GetCanonicalCombinerKey(pCombiner->getKey())] = pCombiner;
+	return pCombiner;
+}
+
+ShaderCombiner * CombinerInfo::_findEquivalentCombiner(u64 _key)
+{
+	const u64 canonicalKey = GetCanonicalCombinerKey(_key);
+	ShaderCombiner * pCombiner = NULL;
+	CanonicalCombiners::const_iterator iter = m_canonicalCombiners.find(canonicalKey);
+	if (iter != m_canonicalCombiners.end())
+		pCombiner = iter->second;
+#ifndef GLES2
+	else {
+		StorageIndex::iterator storageIter = m_storageCanonicalIndex.find(canonicalKey);
+		if (storageIter != m_storageCanonicalIndex.end()) {
+			pCombiner = _readShadersStorageRecord(storageIter->second);
+			if (pCombiner == NULL)
+				m_storageCanonicalIndex.erase(storageIter);
+		}
+	}
+#endif
+	if (pCombiner == NULL)
+		return NULL;
+	m_combiners.insert(_key, pCombiner);
+	++m_sharedCombiners;
+	return pCombiner;
+}
+
+static const u64 copyModeMux = EncodeCombineMode(0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0);
+static const u64 copyModeKey = getCombinerKey(copyModeMux, G_CYC_COPY);
+static const u64 fillModeMux = EncodeCombineMode(0, 0, 0, SHADE, 0, 0, 0, SHADE, 0, 0, 0, SHADE, 0, 0, 0, SHADE);
+static const u64 fillModeKey = getCombinerKey(fillModeMux, G_CYC_FILL);
+
 void CombinerInfo::update()
 {
 	// TODO: find, why gDP.changed & CHANGED_COMBINE not always works (e.g. Mario Tennis).
 //	if (gDP.changed & CHANGED_COMBINE) {
 		if (gDP.otherMode.cycleType == G_CYC_COPY)
-			setCombine(EncodeCombineMode(0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0, 0, 0, 0, TEXEL0));
+			_setCombine(copyModeMux, copyModeKey);
 		else if (gDP.otherMode.cycleType == G_CYC_FILL)
-			setCombine(EncodeCombineMode(0, 0, 0, SHADE, 0, 0, 0, SHADE, 0, 0, 0, SHADE, 0, 0, 0, SHADE));
+			_setCombine(fillModeMux, fillModeKey);
 		else
 			setCombine(gDP.combine.mux);
 		gDP.changed &= ~CHANGED_COMBINE;
 //	}
 }
 
-void CombinerInfo::setCombine(u64 _mux )
+#ifndef GLES2
+static
+int correctFirstStageInput(int _input)
+{
+	switch (_input) {
+	case TEXEL1:
+		return TEXEL0;
+	case TEXEL1_ALPHA:
+		return TEXEL0_ALPHA;
+	}
+	return _input;
+}
+
+static
+int correctSecondStageInput(int _input)
+{
+	switch (_input) {
+	case TEXEL0:
+		return TEXEL1;
+	case TEXEL1:
+		return TEXEL0;
+	case TEXEL0_ALPHA:
+		return TEXEL1_ALPHA;
+	case TEXEL1_ALPHA:
+		return TEXEL0_ALPHA;
+	}
+	return _input;
+}
+
+static
+int noCorrection(int _input)
+{
+	return _input;
+}
+
+static
+int correctCombineCycle(CombineCycle & _cycle, int(*_correct)(int))
+{
+	_cycle.sa = _correct(_cycle.sa);
+	_cycle.sb = _correct(_cycle.sb);
+	_cycle.m = _correct(_cycle.m);
+	_cycle.a = _correct(_cycle.a);
+	return (1 << _cycle.sa) | (1 << _cycle.sb) | (1 << _cycle.m) | (1 << _cycle.a);
+}
+
+// Decode combine mode into uber shader parameters. Returns the set of used combiner inputs.
+static
+int decodeUberShaderCombine(u64 _mux, CombineCycle * _cc, CombineCycle * _ac, int & _numCycles)
+{
+	gDPCombine combine;
+	combine.mux = _mux;
+	DecodeCombineCycles(combine, _cc, _ac);
+
+	// Stage inputs are corrected the same way as in compileCombiner.
+	if (gDP.otherMode.cycleType == G_CYC_1CYCLE) {
+		_cc[0] = _cc[1];
+		_ac[0] = _ac[1];
+	}
+	int nInputs = 0;
+	if (gDP.otherMode.cycleType == G_CYC_2CYCLE) {
+		_numCycles = 2;
+		nInputs |= correctCombineCycle(_cc[0], noCorrection);
+		nInputs |= correctCombineCycle(_ac[0], noCorrection);
+		nInputs |= correctCombineCycle(_cc[1], correctSecondStageInput);
+		nInputs |= correctCombineCycle(_ac[1], correctSecondStageInput);
+	} else {
+		_numCycles = 1;
+		nInputs |= correctCombineCycle(_cc[0], correctFirstStageInput);
+		nInputs |= correctCombineCycle(_ac[0], correctFirstStageInput);
+	}
+	return nInputs;
+}
+
+static
+bool isUberShaderCompatible(int _nInputs)
+{
+	if ((_nInputs & (1 << LOD_FRACTION)) != 0)
+		return false;
+	return config.generalEmulation.enableHWLighting == 0 || !GBI.isHWLSupported() || (_nInputs & (1 << SHADE)) == 0;
+}
+
+ShaderCombiner * CombinerInfo::addCombiner(u64 _mux)
 {
 	const u64 key = getCombinerKey(_mux);
-	if (m_pCurrent != NULL && m_pCurrent->getKey() == key) {
+	if (m_combiners.find(key) != NULL || _loadFromShadersStorage(key) != NULL || _findEquivalentCombiner(key) != NULL)
+		return NULL;
+	ShaderCombiner * pCombiner = _compile(_mux);
+	m_combiners.insert(key, pCombiner);
+	return pCombiner;
+}
+
+int CombinerInfo::generateCombiner(u64 _mux, std::string & _strShader)
+{
+	gDPCombine combine;
+	combine.mux = _mux;
+	Combiner color, alpha;
+	SimplifyCombine(combine, gDP.otherMode.cycleType, color, alpha);
+	return compileCombiner(color, alpha, _strShader);
+}
+
+bool CombinerInfo::_linkCombiner(ShaderCombiner * _pCombiner, bool _bWait)
+{
+	if (!_pCombiner->finishLinking(_bWait))
+		return false;
+	if (_bWait) {
+		++m_waitedLinks;
+		m_waitLinkFrame = video().getBuffersSwapCount();
+	}
+	_pCombiner->update(true);
+	m_pUniformCollection->bindWithShaderCombiner(_pCombiner);
+	if (m_bShaderCacheSupported)
+		_appendToShadersStorage(_pCombiner);
+	return true;
+}
+#endif // GLES2
+
+template <typename T>
+static
+bool updateStateValue(T & _stored, T _value)
+{
+	if (_stored == _value)
+		return false;
+	_stored = _value;
+	return true;
+}
+
+void CombinerInfo::_updateStateVersions()
+{
+	StateSnapshot & s = m_stateSnapshot;
+
+	if (updateStateValue(s.otherMode, gDP.otherMode._u64))
+		++m_stateVersions[sbOtherMode];
+
+	bool bChanged = updateStateValue(s.geometryMode, gSP.geometryMode);
+	bChanged |= updateStateValue(s.objRendermode, gSP.objRendermode);
+	bChanged |= updateStateValue(s.textureLevel, gSP.texture.level);
+	bChanged |= updateStateValue(s.fogMultiplier, gSP.fog.multiplier);
+	bChanged |= updateStateValue(s.fogOffset, gSP.fog.offset);
+	bChanged |= updateStateValue(s.bLLE, RSP.bLLE);
+	bChanged |= updateStateValue(s.bTextureGen, GBI.isTextureGen());
+	bChanged |= updateStateValue(s.bTexturePersp, GBI.isTexturePersp());
+	if (bChanged)
+		++m_stateVersions[sbGeometry];
+
+	bChanged = updateStateValue(s.vscaleZ, gSP.viewport.vscale[2]);
+	bChanged |= updateStateValue(s.vtransZ, gSP.viewport.vtrans[2]);
+	if (bChanged)
+		++m_stateVersions[sbViewport];
+
+	bChanged = updateStateValue(s.primLODMin, gDP.primColor.m);
+	bChanged |= updateStateValue(s.blendAlpha, gDP.blendColor.a);
+	bChanged |= updateStateValue(s.primDeltaZ, gDP.primDepth.deltaZ);
+	if (bChanged)
+		++m_stateVersions[sbColors];
+
+	const FrameBuffer * pBuffer = frameBufferList().getCurrent();
+	bChanged = updateStateValue(s.pFrameBuffer, (const void*)pBuffer);
+	if (pBuffer != NULL) {
+		bChanged |= updateStateValue(s.pDepthBuffer, (const void*)pBuffer->m_pDepthBuffer);
+		bChanged |= updateStateValue(s.frameBufferWidth, pBuffer->m_width);
+		bChanged |= updateStateValue(s.frameBufferHeight, pBuffer->m_height);
+	}
+	bChanged |= updateStateValue(s.colorImageAddress, gDP.colorImage.address);
+	bChanged |= updateStateValue(s.depthImageAddress, gDP.depthImageAddress);
+	bChanged |= updateStateValue(s.rwidth, VI.rwidth);
+	bChanged |= updateStateValue(s.rheight, VI.rheight);
+	bChanged |= updateStateValue(s.scaleX, video().getScaleX());
+	bChanged |= updateStateValue(s.scaleY, video().getScaleY());
+	if (bChanged)
+		++m_stateVersions[sbFrameBuffer];
+}
+
+void CombinerInfo::setCombine(u64 _mux )
+{
+	_setCombine(_mux, getCombinerKey(_mux));
+}
+
+void CombinerInfo::_setCombine(u64 _mux, u64 _key)
+{
+	_updateStateVersions();
+	if (m_pCurrent != NULL && m_pCurrent != m_pUberShader && m_pCurrent->getKey() == _key) {
 		m_bChanged = false;
 		m_pCurrent->update(false);
 		return;
 	}
-	Combiners::const_iterator iter = m_combiners.find(key);
-	if (iter != m_combiners.end()) {
-		m_pCurrent = iter->second;
+	ShaderCombiner * pCombiner = m_combiners.find(_key);
+#ifdef GLES2
+	if (pCombiner == NULL)
+		pCombiner = _findEquivalentCombiner(_key);
+	if (pCombiner != NULL) {
+		m_pCurrent = pCombiner;
 		m_pCurrent->update(false);
 	} else {
 		m_pCurrent = _compile(_mux);
 		m_pCurrent->update(true);
 		m_pUniformCollection->bindWithShaderCombiner(m_pCurrent);
-		m_combiners[m_pCurrent->getKey()] = m_pCurrent;
+		m_combiners.insert(m_pCurrent->getKey(), m_pCurrent);
 	}
 	m_bChanged = true;
+#else
+	if (pCombiner == NULL)
+		pCombiner = _loadFromShadersStorage(_key);
+	if (pCombiner == NULL)
+		pCombiner = _findEquivalentCombiner(_key);
+	if (pCombiner == NULL || !pCombiner->isLinked()) {
+		CombineCycle cc[2], ac[2];
+		int numCycles;
+		const int nInputs = decodeUberShaderCombine(_mux, cc, ac, numCycles);
+		// With parallel shader compile the driver builds combiners in background.
+		// Otherwise compilation blocks, so build at most one new combiner per frame.
+		// Programs loaded from storage are already built and only need to be linked.
+		const bool bParallel = video().getRender().isParallelShaderCompileSupported();
+		const bool bCompatible = isUberShaderCompatible(nInputs);
+		if (pCombiner == NULL && (bParallel || !bCompatible || m_waitLinkFrame != video().getBuffersSwapCount())) {
+			pCombiner = _compile(_mux);
+			m_combiners.insert(_key, pCombiner);
+		}
+		if (pCombiner == NULL || !_linkCombiner(pCombiner, !bParallel || !bCompatible)) {
+			// Draw with the uber shader until the combiner is ready.
+			m_bChanged = m_pCurrent != m_pUberShader || m_pUberShader->getKey() != _key;
+			if (m_bChanged) {
+				m_pUberShader->setUberShaderCombine(_key, nInputs, cc, ac, numCycles);
+				++m_uberShaderActivations;
+			}
+			m_pCurrent = m_pUberShader;
+			m_pCurrent->update(false);
+			return;
+		}
+	}
+	// Equivalent keys share combiner, so the current combiner may be kept.
+	m_bChanged = m_pCurrent != pCombiner;
+	m_pCurrent = pCombiner;
+	m_pCurrent->update(false);
+#endif
 }
 
 void CombinerInfo::updatePrimColor()
@@ -358,6 +692,22 @@ u32 CombinerInfo::_getConfigOptionsBitSet() const
 	return optionsSet;
 }
 
+template <class Stream>
+static
+bool openStorageFile(Stream & _stream, std::ios_base::openmode _mode)
+{
+	wchar_t fileName[PLUGIN_PATH_SIZE];
+	getStorageFileName(fileName);
+#ifdef OS_WINDOWS
+	_stream.open(fileName, _mode);
+#else
+	char fileName_c[PATH_MAX];
+	wcstombs(fileName_c, fileName, PATH_MAX);
+	_stream.open(fileName_c, _mode);
+#endif
+	return _stream.is_open();
+}
+
 /*
 Storage format:
   uint32 - format version;
@@ -366,116 +716,194 @@ Storage format:
   char * - renderer string
   uint32 - len of GL version string
   char * - GL version string
-  uint32 - number of shaders
-  shaders in binary form
+  shader records, appended as soon as shader is linked:
+    uint64 - combiner key
+    int32  - combiner inputs
+    uint32 - binary format
+    int32  - binary length
+    char * - program binary
+Index of records is built on load. Programs are read from the storage on first use of their key.
+Truncated record at the end of the file (e.g. after a crash) is dropped.
 */
-static const u32 ShaderStorageFormatVersion = 0x07U;
-void CombinerInfo::_saveShadersStorage() const
-{
-	if (m_shadersLoaded >= m_combiners.size())
-		return;
-
-	wchar_t fileName[PLUGIN_PATH_SIZE];
-	getStorageFileName(fileName);
+static const u32 ShaderStorageFormatVersion = 0x08U;
+static const u32 ShaderStorageRecordHeaderSize = sizeof(u64) + sizeof(int) + sizeof(GLenum) + sizeof(GLint);
 
-#ifdef OS_WINDOWS
-	std::ofstream fout(fileName, std::ofstream::binary | std::ofstream::trunc);
-#else
-	char fileName_c[PATH_MAX];
-	wcstombs(fileName_c, fileName, PATH_MAX);
-	std::ofstream fout(fileName_c, std::ofstream::binary | std::ofstream::trunc);
-#endif
-	if (!fout)
-		return;
-
-	fout.write((char*)&ShaderStorageFormatVersion, sizeof(ShaderStorageFormatVersion));
+void CombinerInfo::_writeShadersStorageHeader(std::ostream & _os) const
+{
+	_os.write((char*)&ShaderStorageFormatVersion, sizeof(ShaderStorageFormatVersion));
 
-	fout.write((char*)&m_configOptionsBitSet, sizeof(m_configOptionsBitSet));
+	_os.write((char*)&m_configOptionsBitSet, sizeof(m_configOptionsBitSet));
 
 	const char * strRenderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
 	u32 len = strlen(strRenderer);
-	fout.write((char*)&len, sizeof(len));
-	fout.write(strRenderer, len);
+	_os.write((char*)&len, sizeof(len));
+	_os.write(strRenderer, len);
 
 	const char * strGLVersion = reinterpret_cast<const char *>(glGetString(GL_VERSION));
 	len = strlen(strGLVersion);
-	fout.write((char*)&len, sizeof(len));
-	fout.write(strGLVersion, len);
+	_os.write((char*)&len, sizeof(len));
+	_os.write(strGLVersion, len);
+}
 
-	len = m_combiners.size();
-	fout.write((char*)&len, sizeof(len));
-	for (Combiners::const_iterator cur = m_combiners.begin(); cur != m_combiners.end(); ++cur)
-		fout << *(cur->second);
-	fout.flush();
-	fout.close();
+bool CombinerInfo::_readShadersStorageHeader(std::istream & _is) const
+{
+	u32 version = 0;
+	_is.read((char*)&version, sizeof(version));
+	if (!_is || version != ShaderStorageFormatVersion)
+		return false;
+
+	u32 optionsSet = 0;
+	_is.read((char*)&optionsSet, sizeof(optionsSet));
+	if (!_is || optionsSet != m_configOptionsBitSet)
+		return false;
+
+	const char * strRenderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+	u32 len = 0;
+	_is.read((char*)&len, sizeof(len));
+	if (!_is || len != strlen(strRenderer))
+		return false;
+	std::vector<char> strBuf(len);
+	_is.read(strBuf.data(), len);
+	if (!_is || strncmp(strRenderer, strBuf.data(), len) != 0)
+		return false;
+
+	const char * strGLVersion = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+	_is.read((char*)&len, sizeof(len));
+	if (!_is || len != strlen(strGLVersion))
+		return false;
+	strBuf.resize(len);
+	_is.read(strBuf.data(), len);
+	return _is && strncmp(strGLVersion, strBuf.data(), len) == 0;
 }
 
 bool CombinerInfo::_loadShadersStorage()
 {
-	wchar_t fileName[PLUGIN_PATH_SIZE];
-	getStorageFileName(fileName);
 	m_configOptionsBitSet = _getConfigOptionsBitSet();
+	m_storageIndex.clear();
+	m_storageCanonicalIndex.clear();
 
-#ifdef OS_WINDOWS
-	std::ifstream fin(fileName, std::ofstream::binary);
-#else
-	char fileName_c[PATH_MAX];
-	wcstombs(fileName_c, fileName, PATH_MAX);
-	std::ifstream fin(fileName_c, std::ofstream::binary);
-#endif
-	if (!fin)
+	if (!openStorageFile(m_storage, std::ifstream::binary))
+		return false;
+
+	if (!_readShadersStorageHeader(m_storage))
+		return false;
+
+	std::streamoff offset = m_storage.tellg();
+	m_storage.seekg(0, std::ifstream::end);
+	const std::streamoff fileSize = m_storage.tellg();
+	m_storage.seekg(offset, std::ifstream::beg);
+
+	while (offset + ShaderStorageRecordHeaderSize <= fileSize) {
+		u64 key;
+		int nInputs;
+		GLenum binaryFormat;
+		GLint binaryLength;
+		m_storage.read((char*)&key, sizeof(key));
+		m_storage.read((char*)&nInputs, sizeof(nInputs));
+		m_storage.read((char*)&binaryFormat, sizeof(binaryFormat));
+		m_storage.read((char*)&binaryLength, sizeof(binaryLength));
+		if (!m_storage || binaryLength < 1 || offset + ShaderStorageRecordHeaderSize + binaryLength > fileSize)
+			break;
+		m_storageIndex[key] = offset;
+		m_storageCanonicalIndex[GetCanonicalCombinerKey(key)] = offset;
+		offset += ShaderStorageRecordHeaderSize + binaryLength;
+		m_storage.seekg(offset, std::ifstream::beg);
+	}
+	m_storage.clear();
+
+	if (offset == fileSize)
+		return true;
+
+	// Drop truncated record: rewrite valid part of the storage.
+	std::vector<char> data(offset);
+	m_storage.seekg(0, std::ifstream::beg);
+	m_storage.read(data.data(), offset);
+	m_storage.close();
+	std::ofstream fout;
+	if (!openStorageFile(fout, std::ofstream::binary | std::ofstream::trunc))
 		return false;
+	fout.write(data.data(), offset);
+	fout.close();
+	return openStorageFile(m_storage, std::ifstream::binary);
+}
 
+void CombinerInfo::_resetShadersStorage()
+{
+	m_storageIndex.clear();
+	m_storageCanonicalIndex.clear();
+	if (m_storage.is_open())
+		m_storage.close();
+	std::ofstream fout;
+	if (!openStorageFile(fout, std::ofstream::binary | std::ofstream::trunc)) {
+		m_bShaderCacheSupported = false;
+		return;
+	}
+	_writeShadersStorageHeader(fout);
+	fout.close();
+	if (!openStorageFile(m_storage, std::ifstream::binary))
+		m_bShaderCacheSupported = false;
+}
+
+ShaderCombiner * CombinerInfo::_readShadersStorageRecord(std::streamoff _offset)
+{
+	ShaderCombiner * pCombiner = new ShaderCombiner();
 	try {
-		u32 version;
-		fin.read((char*)&version, sizeof(version));
-		if (version != ShaderStorageFormatVersion)
-			return false;
-
-		u32 optionsSet;
-		fin.read((char*)&optionsSet, sizeof(optionsSet));
-		if (optionsSet != m_configOptionsBitSet)
-			return false;
-
-		const char * strRenderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
-		u32 len;
-		fin.read((char*)&len, sizeof(len));
-		std::vector<char> strBuf(len);
-		fin.read(strBuf.data(), len);
-		if (strncmp(strRenderer, strBuf.data(), len) != 0)
-			return false;
-
-		const char * strGLVersion = reinterpret_cast<const char *>(glGetString(GL_VERSION));
-		fin.read((char*)&len, sizeof(len));
-		strBuf.resize(len);
-		fin.read(strBuf.data(), len);
-		if (strncmp(strGLVersion, strBuf.data(), len) != 0)
-			return false;
-
-		fin.read((char*)&len, sizeof(len));
-		for (u32 i = 0; i < len; ++i) {
-			m_pCurrent = new ShaderCombiner();
-			fin >> *m_pCurrent;
-			m_pCurrent->update(true);
-			m_pUniformCollection->bindWithShaderCombiner(m_pCurrent);
-			m_combiners[m_pCurrent->getKey()] = m_pCurrent;
-		}
+		m_storage.clear();
+		m_storage.seekg(_offset, std::ifstream::beg);
+		m_storage >> *pCombiner;
 	}
 	catch (...) {
-		m_shadersLoaded = 0;
-		return false;
+		m_storage.clear();
+		delete pCombiner;
+		return NULL;
+	}
+	if (!m_storage || isGLError()) {
+		m_storage.clear();
+		delete pCombiner;
+		return NULL;
 	}
+	m_combiners.insert(pCombiner->getKey(), pCombiner);
+	m_canonicalCombiners[GetCanonicalCombinerKey(pCombiner->getKey())] = pCombiner;
+	return pCombiner;
+}
 
-	m_shadersLoaded = m_combiners.size();
-	fin.close();
-	return !isGLError();
+ShaderCombiner * CombinerInfo::_loadFromShadersStorage(u64 _key)
+{
+	StorageIndex::iterator iter = m_storageIndex.find(_key);
+	if (iter == m_storageIndex.end())
+		return NULL;
+
+	ShaderCombiner * pCombiner = _readShadersStorageRecord(iter->second);
+	if (pCombiner == NULL)
+		m_storageIndex.erase(iter);
+	return pCombiner;
 }
-#else // GLES2
-void CombinerInfo::_saveShadersStorage() const
-{}
 
+void CombinerInfo::_appendToShadersStorage(const ShaderCombiner * _pCombiner)
+{
+	const u64 canonicalKey = GetCanonicalCombinerKey(_pCombiner->getKey());
+	if (m_storageCanonicalIndex.find(canonicalKey) != m_storageCanonicalIndex.end())
+		return;
+
+	std::ofstream fout;
+	if (!openStorageFile(fout, std::ofstream::binary | std::ofstream::app))
+		return;
+	fout.seekp(0, std::ofstream::end);
+	const std::streamoff offset = fout.tellp();
+	fout << *_pCombiner;
+	fout.flush();
+	if (fout && fout.tellp() > offset) {
+		m_storageIndex[_pCombiner->getKey()] = offset;
+		m_storageCanonicalIndex[canonicalKey] = offset;
+	}
+	fout.close();
+}
+#else // GLES2
 bool CombinerInfo::_loadShadersStorage()
 {
 	return true;
 }
+
+void CombinerInfo::_resetShadersStorage()
+{}
 #endif //GLES2
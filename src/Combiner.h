@@ -2,11 +2,14 @@
 #define COMBINER_H
 
 #include <map>
+#include <string>
+#include <fstream>
 
 #include "GLideN64.h"
 #include "OpenGL.h"
 #include "gDP.h"
 #include "Types.h"
+#include "CombinerKeyMap.h"
 
 /*
 * G_SETCOMBINE: color combine modes
@@ -142,28 +145,123 @@ public:
 	// Update uniforms for GL without UniformBlock support
 	void updateParameters(OGLRender::RENDER_STATE _renderState);
 
+#ifndef GLES2
+	// Used by the headless combiner compiler.
+	// addCombiner builds combiner for the mux and current cycle type, but does not wait for link.
+	// It returns NULL when the key or an equivalent one is already built or stored.
+	ShaderCombiner * addCombiner(u64 _mux);
+	// storeCombiner waits for link and appends the combiner to the shaders storage.
+	bool storeCombiner(ShaderCombiner * _pCombiner) { return _linkCombiner(_pCombiner, true); }
+	// Generates GLSL of the combiner body only. Returns combiner inputs.
+	static int generateCombiner(u64 _mux, std::string & _strShader);
+#endif
+
+	// Global state blocks, which combiner uniforms are calculated from.
+	// Version of a block is incremented each time the block changes.
+	enum StateBlock {
+		sbOtherMode,
+		sbGeometry,
+		sbViewport,
+		sbColors,
+		sbFrameBuffer,
+		sbTotal
+	};
+	const u32 * getStateVersions() const { return m_stateVersions; }
+	void countUniformUpdates(u32 _updated, u32 _skipped) {
+		++m_uniformUpdates;
+		m_uniformGroupsUpdated += _updated;
+		m_uniformGroupsSkipped += _skipped;
+	}
+	// Called by the renderer after each draw.
+	void countDraw() {
+		++m_draws;
+		if (m_pCurrent != NULL && m_pCurrent == m_pUberShader)
+			++m_uberShaderDraws;
+	}
+	u32 getDraws() const { return m_draws; }
+	u32 getUberShaderDraws() const { return m_uberShaderDraws; }
+	u32 getUniformGroupsUpdated() const { return m_uniformGroupsUpdated; }
+	u32 getUniformGroupsSkipped() const { return m_uniformGroupsSkipped; }
+
 private:
 	CombinerInfo()
 		: m_bChanged(false)
 		, m_bShaderCacheSupported(false)
-		, m_shadersLoaded(0)
 		, m_configOptionsBitSet(0)
-		, m_pCurrent(NULL) {}
+		, m_waitLinkFrame(0)
+		, m_waitedLinks(0)
+		, m_uberShaderActivations(0)
+		, m_sharedCombiners(0)
+		, m_draws(0)
+		, m_uberShaderDraws(0)
+		, m_uniformUpdates(0)
+		, m_uniformGroupsUpdated(0)
+		, m_uniformGroupsSkipped(0)
+		, m_pCurrent(NULL)
+		, m_pUberShader(NULL) {
+		for (u32 i = 0; i < sbTotal; ++i)
+			m_stateVersions[i] = 1;
+	}
 	CombinerInfo(const CombinerInfo &);
 
-	void _saveShadersStorage() const;
 	bool _loadShadersStorage();
+	void _resetShadersStorage();
+	void _writeShadersStorageHeader(std::ostream & _os) const;
+	bool _readShadersStorageHeader(std::istream & _is) const;
+	ShaderCombiner * _readShadersStorageRecord(std::streamoff _offset);
+	ShaderCombiner * _loadFromShadersStorage(u64 _key);
+	void _appendToShadersStorage(const ShaderCombiner * _pCombiner);
 	u32 _getConfigOptionsBitSet() const;
-	ShaderCombiner * _compile(u64 mux) const;
+	ShaderCombiner * _compile(u64 mux);
+	ShaderCombiner * _findEquivalentCombiner(u64 _key);
+	bool _linkCombiner(ShaderCombiner * _pCombiner, bool _bWait);
+	void _updateStateVersions();
+	void _setCombine(u64 _mux, u64 _key);
 
 	bool m_bChanged;
 	bool m_bShaderCacheSupported;
-	u32 m_shadersLoaded;
 	u32 m_configOptionsBitSet;
+	u32 m_waitLinkFrame;
+	// Statistics: number of combiners the renderer had to wait for and number of times the uber shader replaced a combiner.
+	u32 m_waitedLinks;
+	u32 m_uberShaderActivations;
+	u32 m_sharedCombiners;
+	// Statistics: number of draws and number of them drawn with the uber shader.
+	u32 m_draws;
+	u32 m_uberShaderDraws;
+	// Statistics: number of combiner updates and number of uniform groups updated and skipped by them.
+	u32 m_uniformUpdates;
+	u32 m_uniformGroupsUpdated;
+	u32 m_uniformGroupsSkipped;
+
+	// Values of the state blocks at the last versions update.
+	struct StateSnapshot {
+		u64 otherMode;
+		u32 geometryMode, objRendermode;
+		s32 textureLevel;
+		s16 fogMultiplier, fogOffset;
+		bool bLLE, bTextureGen, bTexturePersp;
+		f32 vscaleZ, vtransZ;
+		f32 primLODMin, blendAlpha, primDeltaZ;
+		const void * pFrameBuffer;
+		const void * pDepthBuffer;
+		u32 frameBufferWidth, frameBufferHeight;
+		u32 colorImageAddress, depthImageAddress;
+		f32 rwidth, rheight, scaleX, scaleY;
+	} m_stateSnapshot;
+	u32 m_stateVersions[sbTotal];
 
 	ShaderCombiner * m_pCurrent;
-	typedef std::map<u64, ShaderCombiner *> Combiners;
-	Combiners m_combiners;
+	ShaderCombiner * m_pUberShader;
+	CombinerKeyMap m_combiners;
+	// Combiners with the same simplified stages, keyed by hash of the stages.
+	typedef std::map<u64, ShaderCombiner *> CanonicalCombiners;
+	CanonicalCombiners m_canonicalCombiners;
+	// Offsets of combiner records in the shader storage file.
+	typedef std::map<u64, std::streamoff> StorageIndex;
+	StorageIndex m_storageIndex;
+	StorageIndex m_storageCanonicalIndex;
+	std::ifstream m_storage;
 	UniformCollection * m_pUniformCollection;
 };
 
@@ -176,13 +274,19 @@ void Combiner_Init();
 void Combiner_Destroy();
 
 inline
-u64 getCombinerKey(u64 _mux)
+u64 getCombinerKey(u64 _mux, u32 _cycleType)
 {
 	gDPCombine cmb;
 	cmb.mux = _mux;
-	cmb.muxs0 |= (gDP.otherMode.cycleType<<24);
+	cmb.muxs0 |= (_cycleType<<24);
 	return cmb.mux;
 }
 
+inline
+u64 getCombinerKey(u64 _mux)
+{
+	return getCombinerKey(_mux, gDP.otherMode.cycleType);
+}
+
 #endif
 
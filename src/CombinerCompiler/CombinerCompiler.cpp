@@ -0,0 +1,199 @@
+/*
+Headless combiner compiler.
+Builds shader combiners for a list of keys on an off-screen EGL context, reports
+generation, compile and link times and program binary size per key and writes
+the shader storage file, which the plugin loads at ROM start.
+Storage is written to <output folder>/shaders, the same way the plugin writes it to the user cache folder.
+
+Usage: GLideN64CombinerCompiler -k <keys file> -o <output folder> -r <ROM name> [-c <config options bitset>]
+
+Keys file has one combiner per line, '#' starts a comment:
+  <combiner key>           - 64 bit hex key as it is stored in the shader storage (cycle type in bits 56-57)
+  <combine mux> <cycle>    - 64 bit hex mux of G_SETCOMBINE and cycle type (0 - 1 cycle, 1 - 2 cycle, 2 - copy, 3 - fill)
+Config options bitset has the same layout as in the storage header:
+  bit 0 - multisampling, bit 1 - bilinear mode (0 - 3 point, 1 - standard), bit 2 - HW lighting,
+  bit 3 - noise, bit 4 - LOD emulation, bit 5 - N64 depth compare.
+Compile time covers shader compilation and link start. Drivers, which link synchronously, finish linking there too.
+Exit code is 2 if some combiner failed to link.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+#include "../mupenplus/GLideN64_mupenplus.h"
+#include "../mupenplus/CoreVideo_EGL.h"
+#include "../OpenGL.h"
+#include "../Combiner.h"
+#include "../GLSLCombiner.h"
+#include "../ShaderUtils.h"
+#include "../Config.h"
+#include "../RSP.h"
+#include "../gDP.h"
+
+static std::string strOutputPath;
+
+static
+const char * GetUserPath()
+{
+	// Plugin cuts the last path component, as it expects a path with a trailing separator.
+	return strOutputPath.c_str();
+}
+
+static
+void applyConfigOptions(u32 _options)
+{
+	config.resetToDefaults();
+	config.video.windowedWidth = 320;
+	config.video.windowedHeight = 240;
+	config.video.multisampling = (_options & (1 << 0)) != 0 ? 4 : 0;
+	config.texture.bilinearMode = (_options >> 1) & 1;
+	config.generalEmulation.enableHWLighting = (_options >> 2) & 1;
+	config.generalEmulation.enableNoise = (_options >> 3) & 1;
+	config.generalEmulation.enableLOD = (_options >> 4) & 1;
+	config.frameBufferEmulation.N64DepthCompare = (_options >> 5) & 1;
+	config.generalEmulation.enableShadersStorage = 1;
+}
+
+struct CombinerKey {
+	u64 mux;
+	u32 cycleType;
+};
+
+static
+bool readKeys(const char * _fileName, std::vector<CombinerKey> & _keys)
+{
+	std::ifstream fin(_fileName);
+	if (!fin.is_open())
+		return false;
+	std::string line;
+	while (std::getline(fin, line)) {
+		const std::string::size_type comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+		std::istringstream sin(line);
+		std::string strMux;
+		if (!(sin >> strMux))
+			continue;
+		gDPCombine combine;
+		combine.mux = strtoull(strMux.c_str(), NULL, 16);
+		CombinerKey key;
+		u32 cycleType;
+		if (sin >> cycleType)
+			key.cycleType = cycleType;
+		else
+			key.cycleType = combine.muxs0 >> 24;
+		combine.muxs0 &= 0x00FFFFFF;
+		key.mux = combine.mux;
+		if (key.cycleType > G_CYC_FILL) {
+			fprintf(stderr, "Skip key %s: wrong cycle type %u\n", strMux.c_str(), key.cycleType);
+			continue;
+		}
+		_keys.push_back(key);
+	}
+	return true;
+}
+
+static
+double elapsedUs(std::chrono::high_resolution_clock::time_point _start, std::chrono::high_resolution_clock::time_point _end)
+{
+	return std::chrono::duration<double, std::micro>(_end - _start).count();
+}
+
+int main(int argc, char * argv[])
+{
+	const char * strKeys = NULL;
+	const char * strRomName = NULL;
+	u32 options = 0;
+	strOutputPath = "./";
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-k") == 0)
+			strKeys = argv[i + 1];
+		else if (strcmp(argv[i], "-o") == 0)
+			strOutputPath = std::string(argv[i + 1]) + "/";
+		else if (strcmp(argv[i], "-r") == 0)
+			strRomName = argv[i + 1];
+		else if (strcmp(argv[i], "-c") == 0)
+			options = strtoul(argv[i + 1], NULL, 0);
+	}
+	if (strKeys == NULL || strRomName == NULL) {
+		fprintf(stderr, "Usage: %s -k <keys file> -o <output folder> -r <ROM name> [-c <config options bitset>]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<CombinerKey> keys;
+	if (!readKeys(strKeys, keys)) {
+		fprintf(stderr, "Can't read keys file %s\n", strKeys);
+		return 1;
+	}
+
+	CoreVideo_EGL_Install();
+	ConfigGetUserDataPath = GetUserPath;
+	ConfigGetUserCachePath = GetUserPath;
+
+	applyConfigOptions(options);
+	strncpy(RSP.romname, strRomName, sizeof(RSP.romname) - 1);
+	RSP.romname[sizeof(RSP.romname) - 1] = 0;
+
+	video().start();
+	if (!CoreVideo_EGL_HasContext()) {
+		fprintf(stderr, "Can't create OpenGL 3.3 context\n");
+		return 1;
+	}
+	printf("# renderer: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	printf("key,generation_us,compile_us,link_us,binary_bytes\n");
+
+	typedef std::chrono::high_resolution_clock Clock;
+	CombinerInfo & cmbInfo = CombinerInfo::get();
+	double totalGeneration = 0.0, totalCompile = 0.0, totalLink = 0.0;
+	u32 built = 0, skipped = 0, failed = 0;
+	for (std::vector<CombinerKey>::const_iterator iter = keys.begin(); iter != keys.end(); ++iter) {
+		gDP.otherMode.cycleType = iter->cycleType;
+		const u64 key = getCombinerKey(iter->mux);
+
+		std::string strCombiner;
+		const Clock::time_point start = Clock::now();
+		CombinerInfo::generateCombiner(iter->mux, strCombiner);
+		const Clock::time_point generated = Clock::now();
+		ShaderCombiner * pCombiner = cmbInfo.addCombiner(iter->mux);
+		const Clock::time_point compiled = Clock::now();
+		if (pCombiner == NULL) {
+			++skipped;
+			printf("%016llx,,,,\n", (unsigned long long)key);
+			continue;
+		}
+		pCombiner->finishLinking(true);
+		const Clock::time_point linked = Clock::now();
+
+		// finishLinking only asserts link status, release build must check it here.
+		size_t binarySize = 0;
+		if (checkProgramLinkStatus(pCombiner->getProgram())) {
+			++built;
+			cmbInfo.storeCombiner(pCombiner);
+			// Program binary goes after key, inputs, format and length in the storage record.
+			std::ostringstream record;
+			record << *pCombiner;
+			const size_t recordHeaderSize = sizeof(u64) + sizeof(int) + sizeof(GLenum) + sizeof(GLint);
+			binarySize = record.str().size() > recordHeaderSize ? record.str().size() - recordHeaderSize : 0;
+		} else
+			++failed;
+
+		const double generationUs = elapsedUs(start, generated);
+		const double compileUs = elapsedUs(generated, compiled);
+		const double linkUs = elapsedUs(compiled, linked);
+		totalGeneration += generationUs;
+		totalCompile += compileUs;
+		totalLink += linkUs;
+		printf("%016llx,%.1f,%.1f,%.1f,%u\n", (unsigned long long)key, generationUs, compileUs, linkUs, (u32)binarySize);
+	}
+	printf("# built %u, skipped %u (already stored or equivalent), failed %u\n", built, skipped, failed);
+	printf("# total generation %.1f ms, compile %.1f ms, link %.1f ms\n", totalGeneration / 1000.0, totalCompile / 1000.0, totalLink / 1000.0);
+
+	video().stop();
+	return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,113 @@
+#ifndef COMBINER_KEY_MAP_H
+#define COMBINER_KEY_MAP_H
+
+#include <vector>
+#include "Types.h"
+
+class ShaderCombiner;
+
+// Open addressing hash map from combiner keys to combiners.
+// Games often alternate between a few combiners, so a small direct mapped
+// cache of recently found keys is checked before the table.
+class CombinerKeyMap
+{
+public:
+	CombinerKeyMap() { clear(); }
+
+	ShaderCombiner * find(u64 _key)
+	{
+		++m_lookups;
+		const u32 hash = _hash(_key);
+		Entry & recent = m_recent[hash & (RECENT_SIZE - 1)];
+		if (recent.pCombiner != NULL && recent.key == _key) {
+			++m_hits;
+			return recent.pCombiner;
+		}
+		const Entry & entry = m_entries[_findSlot(_key, hash)];
+		if (entry.pCombiner != NULL)
+			recent = entry;
+		return entry.pCombiner;
+	}
+
+	// Adds the key or replaces its combiner.
+	void insert(u64 _key, ShaderCombiner * _pCombiner)
+	{
+		const u32 hash = _hash(_key);
+		Entry & recent = m_recent[hash & (RECENT_SIZE - 1)];
+		if (recent.key == _key)
+			recent.pCombiner = _pCombiner;
+		Entry & entry = m_entries[_findSlot(_key, hash)];
+		if (entry.pCombiner == NULL) {
+			if ((m_size + 1) * 2 > m_entries.size()) {
+				_grow();
+				insert(_key, _pCombiner);
+				return;
+			}
+			++m_size;
+			entry.key = _key;
+		}
+		entry.pCombiner = _pCombiner;
+	}
+
+	void clear()
+	{
+		m_entries.assign(INITIAL_SIZE, Entry());
+		for (u32 i = 0; i < RECENT_SIZE; ++i)
+			m_recent[i] = Entry();
+		m_size = 0;
+		m_hits = m_lookups = 0;
+	}
+
+	size_t size() const { return m_size; }
+	// Statistics: number of lookups and number of them served by the recent keys cache.
+	u32 getLookups() const { return m_lookups; }
+	u32 getRecentHits() const { return m_hits; }
+
+private:
+	enum {
+		INITIAL_SIZE = 256,
+		RECENT_SIZE = 16
+	};
+
+	struct Entry {
+		Entry() : key(0), pCombiner(NULL) {}
+		u64 key;
+		// NULL marks empty slot. Combiners are never removed, so no deleted markers are needed.
+		ShaderCombiner * pCombiner;
+	};
+
+	static u32 _hash(u64 _key)
+	{
+		_key ^= _key >> 33;
+		_key *= 0xff51afd7ed558ccdULL;
+		_key ^= _key >> 33;
+		return (u32)_key;
+	}
+
+	size_t _findSlot(u64 _key, u32 _hash) const
+	{
+		const size_t mask = m_entries.size() - 1;
+		size_t slot = _hash & mask;
+		while (m_entries[slot].pCombiner != NULL && m_entries[slot].key != _key)
+			slot = (slot + 1) & mask;
+		return slot;
+	}
+
+	void _grow()
+	{
+		std::vector<Entry> entries(m_entries.size() * 2);
+		entries.swap(m_entries);
+		for (std::vector<Entry>::const_iterator iter = entries.cbegin(); iter != entries.cend(); ++iter) {
+			if (iter->pCombiner != NULL)
+				m_entries[_findSlot(iter->key, _hash(iter->key))] = *iter;
+		}
+	}
+
+	std::vector<Entry> m_entries;
+	Entry m_recent[RECENT_SIZE];
+	size_t m_size;
+	u32 m_hits;
+	u32 m_lookups;
+};
+
+#endif // COMBINER_KEY_MAP_H
@@ -67,14 +67,17 @@ void Config::resetToDefaults()
 	textureFilter.txEnhancementMode = 0;
 	textureFilter.txDeposterize = 0;
 	textureFilter.txFilterIgnoreBG = 0;
+	textureFilter.txEnhancementGPU = 0;
 	textureFilter.txCacheSize = 100 * gc_uMegabyte;
 
 	textureFilter.txHiresEnable = 0;
 	textureFilter.txHiresFullAlphaChannel = 0;
 	textureFilter.txHresAltCRC = 0;
+	textureFilter.txHiresLazyLoad = 0;
 	textureFilter.txDump = 0;
 
 	textureFilter.txForce16bpp = 0;
+	textureFilter.txGPUCompression = 0;
 	textureFilter.txCacheCompression = 1;
 	textureFilter.txSaveCache = 1;
 
@@ -101,15 +101,18 @@ struct Config
 		u32 txEnhancementMode;			// Texture enhancement mode, eg 2xSAI
 		u32 txDeposterize;				// Deposterize texture before enhancement
 		u32 txFilterIgnoreBG;			// Do not apply filtering to backgrounds textures
+		u32 txEnhancementGPU;			// Run enhancement in a shader when it has one (HQ2X, HQ4X)
 		u32 txCacheSize;				// Cache size in Mbytes
 
 		u32 txHiresEnable;				// Use high-resolution texture packs
 		u32 txHiresFullAlphaChannel;	// Use alpha channel fully
 		u32 txHresAltCRC;				// Use alternative method of paletted textures CRC calculation
+		u32 txHiresLazyLoad;			// Index texture pack at start, load textures on first use
 		u32 txDump;						// Dump textures
 
 		u32 txForce16bpp;				// Force use 16bit color textures
-		u32 txCacheCompression;			// Zip textures cache
+		u32 txGPUCompression;			// Compress enhanced and hi-res textures to S3TC or ETC2 for the GPU
+		u32 txCacheCompression;			// Compress textures cache
 		u32 txSaveCache;				// Save texture cache to hard disk
 
 		wchar_t txPath[PLUGIN_PATH_SIZE];
@@ -48,13 +48,13 @@ DepthBuffer::~DepthBuffer()
 	if (m_pDepthImageTexture != NULL)
 		textureCache().removeFrameBufferTexture(m_pDepthImageTexture);
 	if (m_pDepthBufferTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pDepthBufferTexture);
+		textureCache().releaseFrameBufferTexture(m_pDepthBufferTexture);
 	if (m_pResolveDepthBufferTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pResolveDepthBufferTexture);
+		textureCache().releaseFrameBufferTexture(m_pResolveDepthBufferTexture);
 	if (m_copyFBO != 0)
 		glDeleteFramebuffers(1, &m_copyFBO);
 	if (m_pDepthBufferCopyTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pDepthBufferCopyTexture);
+		textureCache().releaseFrameBufferTexture(m_pDepthBufferCopyTexture);
 }
 
 void DepthBuffer::initDepthImageTexture(FrameBuffer * _pBuffer)
@@ -100,60 +100,71 @@ void DepthBuffer::initDepthImageTexture(FrameBuffer * _pBuffer)
 #endif // GL_IMAGE_TEXTURES_SUPPORT
 }
 
-void DepthBuffer::_initDepthBufferTexture(FrameBuffer * _pBuffer, CachedTexture * _pTexture, bool _multisample)
+CachedTexture * DepthBuffer::_getDepthBufferTexture(FrameBuffer * _pBuffer, bool _multisample)
 {
+	u32 width, height;
 	if (_pBuffer != NULL) {
-		_pTexture->width = (u32)(_pBuffer->m_pTexture->width);
-		_pTexture->height = (u32)(_pBuffer->m_pTexture->height);
-		_pTexture->address = _pBuffer->m_startAddress;
-		_pTexture->clampWidth = _pBuffer->m_width;
-		_pTexture->clampHeight = _pBuffer->m_height;
+		width = _pBuffer->m_pTexture->width;
+		height = _pBuffer->m_pTexture->height;
+	} else if (config.frameBufferEmulation.nativeResFactor == 0) {
+		width = video().getWidth();
+		height = video().getHeight();
+	} else {
+		width = VI.width * config.frameBufferEmulation.nativeResFactor;
+		height = VI.height * config.frameBufferEmulation.nativeResFactor;
 	}
-	else {
-		if (config.frameBufferEmulation.nativeResFactor == 0) {
-			_pTexture->width = video().getWidth();
-			_pTexture->height = video().getHeight();
-		} else {
-			_pTexture->width = VI.width * config.frameBufferEmulation.nativeResFactor;
-			_pTexture->height = VI.height * config.frameBufferEmulation.nativeResFactor;
-		}
-		_pTexture->address = gDP.depthImageAddress;
-		_pTexture->clampWidth = VI.width;
-		_pTexture->clampHeight = VI.height;
+
+	bool bHasStorage;
+	CachedTexture * pTexture = textureCache().getFrameBufferTexture(_multisample ? GL_DEPTH_COMPONENT : fboFormats.depthInternalFormat,
+		width, height, _multisample ? config.video.multisampling : 0, bHasStorage);
+	pTexture->width = width;
+	pTexture->height = height;
+	if (_pBuffer != NULL) {
+		pTexture->address = _pBuffer->m_startAddress;
+		pTexture->clampWidth = _pBuffer->m_width;
+		pTexture->clampHeight = _pBuffer->m_height;
+	} else {
+		pTexture->address = gDP.depthImageAddress;
+		pTexture->clampWidth = VI.width;
+		pTexture->clampHeight = VI.height;
 	}
-	_pTexture->format = 0;
-	_pTexture->size = 2;
-	_pTexture->clampS = 1;
-	_pTexture->clampT = 1;
-	_pTexture->frameBufferTexture = CachedTexture::fbOneSample;
-	_pTexture->maskS = 0;
-	_pTexture->maskT = 0;
-	_pTexture->mirrorS = 0;
-	_pTexture->mirrorT = 0;
-	_pTexture->realWidth = _pTexture->width;
-	_pTexture->realHeight = _pTexture->height;
-	_pTexture->textureBytes = _pTexture->realWidth * _pTexture->realHeight * fboFormats.depthFormatBytes;
-	textureCache().addFrameBufferTextureSize(_pTexture->textureBytes);
+	pTexture->format = 0;
+	pTexture->size = 2;
+	pTexture->clampS = 1;
+	pTexture->clampT = 1;
+	pTexture->frameBufferTexture = CachedTexture::fbOneSample;
+	pTexture->maskS = 0;
+	pTexture->maskT = 0;
+	pTexture->mirrorS = 0;
+	pTexture->mirrorT = 0;
+	pTexture->realWidth = pTexture->width;
+	pTexture->realHeight = pTexture->height;
+	pTexture->textureBytes = pTexture->realWidth * pTexture->realHeight * fboFormats.depthFormatBytes;
+	textureCache().addFrameBufferTextureSize(pTexture->textureBytes);
 
 #ifdef GL_MULTISAMPLING_SUPPORT
 	if (_multisample) {
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, _pTexture->glName);
+		if (!bHasStorage) {
+			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, pTexture->glName);
 #if defined(GLES3_1)
-		glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_DEPTH_COMPONENT, _pTexture->realWidth, _pTexture->realHeight, false);
+			glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_DEPTH_COMPONENT, pTexture->realWidth, pTexture->realHeight, false);
 #else
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_DEPTH_COMPONENT, _pTexture->realWidth, _pTexture->realHeight, false);
+			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_DEPTH_COMPONENT, pTexture->realWidth, pTexture->realHeight, false);
 #endif
-		_pTexture->frameBufferTexture = CachedTexture::fbMultiSample;
+		}
+		pTexture->frameBufferTexture = CachedTexture::fbMultiSample;
 	} else
 #endif // GL_MULTISAMPLING_SUPPORT
 	{
-		glBindTexture(GL_TEXTURE_2D, _pTexture->glName);
-		glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.depthInternalFormat, _pTexture->realWidth, _pTexture->realHeight, 0, GL_DEPTH_COMPONENT, fboFormats.depthType, NULL);
+		glBindTexture(GL_TEXTURE_2D, pTexture->glName);
+		if (!bHasStorage)
+			glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.depthInternalFormat, pTexture->realWidth, pTexture->realHeight, 0, GL_DEPTH_COMPONENT, fboFormats.depthType, NULL);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	}
 	glBindTexture(GL_TEXTURE_2D, 0);
+	return pTexture;
 }
 
 void DepthBuffer::setDepthAttachment(GLenum _target)
@@ -171,14 +182,12 @@ void DepthBuffer::setDepthAttachment(GLenum _target)
 void DepthBuffer::initDepthBufferTexture(FrameBuffer * _pBuffer)
 {
 	if (m_pDepthBufferTexture == NULL) {
-		m_pDepthBufferTexture = textureCache().addFrameBufferTexture();
-		_initDepthBufferTexture(_pBuffer, m_pDepthBufferTexture, config.video.multisampling != 0);
+		m_pDepthBufferTexture = _getDepthBufferTexture(_pBuffer, config.video.multisampling != 0);
 	}
 
 #ifdef GL_MULTISAMPLING_SUPPORT
 	if (config.video.multisampling != 0 && m_pResolveDepthBufferTexture == NULL) {
-		m_pResolveDepthBufferTexture = textureCache().addFrameBufferTexture();
-		_initDepthBufferTexture(_pBuffer, m_pResolveDepthBufferTexture, false);
+		m_pResolveDepthBufferTexture = _getDepthBufferTexture(_pBuffer, false);
 	}
 #endif
 }
@@ -221,8 +230,7 @@ CachedTexture * DepthBuffer::copyDepthBufferTexture(FrameBuffer * _pBuffer)
 		return m_pDepthBufferCopyTexture;
 
 	if (m_pDepthBufferCopyTexture == NULL) {
-		m_pDepthBufferCopyTexture = textureCache().addFrameBufferTexture();
-		_initDepthBufferTexture(_pBuffer, m_pDepthBufferCopyTexture, false);
+		m_pDepthBufferCopyTexture = _getDepthBufferTexture(_pBuffer, false);
 	}
 
 	glScissor(0, 0, m_pDepthBufferTexture->realWidth, m_pDepthBufferTexture->realHeight);
@@ -305,6 +313,8 @@ void DepthBufferList::init()
 
 void DepthBufferList::destroy()
 {
+	for (DepthBuffers::iterator iter = m_list.begin(); iter != m_list.end(); ++iter)
+		FrameBuffer_DiscardDepthReadbacks(iter->m_address);
 	m_pCurrent = NULL;
 	m_list.clear();
 }
@@ -327,6 +337,7 @@ void DepthBufferList::removeBuffer(u32 _address )
 {
 	for (DepthBuffers::iterator iter = m_list.begin(); iter != m_list.end(); ++iter)
 		if (iter->m_address == _address) {
+			FrameBuffer_DiscardDepthReadbacks(_address);
 			frameBufferList().clearDepthBuffer(&(*iter));
 			m_list.erase(iter);
 			return;
@@ -342,8 +353,11 @@ void DepthBufferList::saveBuffer(u32 _address)
 	if (pFrameBuffer != NULL)
 		pFrameBuffer->m_isDepthBuffer = true;
 
-	if (m_pCurrent == NULL || m_pCurrent->m_address != _address)
+	if (m_pCurrent == NULL || m_pCurrent->m_address != _address) {
+		if (m_pCurrent != NULL)
+			FrameBuffer_DiscardDepthReadbacks(m_pCurrent->m_address);
 		m_pCurrent = findBuffer(_address);
+	}
 
 	if (m_pCurrent != NULL && pFrameBuffer != NULL && m_pCurrent->m_width != pFrameBuffer->m_width) {
 		removeBuffer(_address);
@@ -35,7 +35,7 @@ struct DepthBuffer
 	bool m_copied;
 
 private:
-	void _initDepthBufferTexture(FrameBuffer * _pBuffer, CachedTexture *_pTexture, bool _multisample);
+	CachedTexture * _getDepthBufferTexture(FrameBuffer * _pBuffer, bool _multisample);
 	void _DepthBufferTexture(FrameBuffer * _pBuffer);
 };
 
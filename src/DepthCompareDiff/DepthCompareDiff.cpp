@@ -0,0 +1,283 @@
+/*
+Headless N64 depth compare check.
+Draws sets of random overlapping triangles, which test and update depth, with N64 depth compare
+on an off-screen EGL context. Each set is drawn twice: triangle by triangle with a barrier between
+draws, the way depth updating triangles were drawn before, and batched by gSPTriangle.
+Colour buffer and depth image of both passes must be the same.
+
+Usage: GLideN64DepthCompareDiff [-n <number of triangle sets>]
+Exit code is 2 if some set differs or draws nothing, 1 if the context has no image textures support.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../mupenplus/GLideN64_mupenplus.h"
+#include "../mupenplus/CoreVideo_EGL.h"
+#include "../OpenGL.h"
+#include "../FrameBuffer.h"
+#include "../DepthBuffer.h"
+#include "../Config.h"
+#include "../Combiner.h"
+#include "../N64.h"
+#include "../RSP.h"
+#include "../gDP.h"
+#include "../gSP.h"
+#include "../VI.h"
+
+static const u32 width = 320;
+static const u32 height = 240;
+static const u32 colorAddress = 0x100000;
+static const u32 depthAddress = 0x200000;
+// Vertices are loaded in groups, the way gSPVertex does, and gSPTriangle takes indices below INDEXMAP_SIZE.
+static const u32 groupVertices = 3 * (INDEXMAP_SIZE / 3);
+
+static
+const char * GetUserPath()
+{
+	return "./";
+}
+
+static u32 regs[32];
+
+static
+void initN64State(std::vector<u8> & _rdram)
+{
+	RDRAM = _rdram.data();
+	RDRAMSize = (u32)_rdram.size() - 1;
+	u32 ** pRegs = (u32**)&REG;
+	for (u32 i = 0; i < sizeof(REG) / sizeof(u32*); ++i)
+		pRegs[i] = &regs[i];
+	*REG.VI_WIDTH = width;
+	VI.width = width;
+	VI.height = height;
+	VI.rwidth = 1.0f / width;
+	VI.rheight = 1.0f / height;
+}
+
+// Buffers are cleared in fill mode without depth compare, as games do.
+static
+void setClearState()
+{
+	gDP.otherMode._u64 = 0;
+	gDP.otherMode.cycleType = G_CYC_FILL;
+	gDP.changed |= CHANGED_RENDERMODE | CHANGED_CYCLETYPE;
+}
+
+static
+void setDrawState()
+{
+	gDP.otherMode._u64 = 0;
+	gDP.otherMode.cycleType = G_CYC_1CYCLE;
+	gDP.otherMode.depthCompare = 1;
+	gDP.otherMode.depthUpdate = 1;
+
+	// Shade color and alpha in both cycles.
+	gDPCombine combine;
+	combine.mux = 0;
+	combine.saRGB0 = combine.saRGB1 = 15;
+	combine.sbRGB0 = combine.sbRGB1 = 15;
+	combine.mRGB0 = combine.mRGB1 = 31;
+	combine.aRGB0 = combine.aRGB1 = 4;
+	combine.saA0 = combine.saA1 = 7;
+	combine.sbA0 = combine.sbA1 = 7;
+	combine.mA0 = combine.mA1 = 7;
+	combine.aA0 = combine.aA1 = 4;
+	gDPSetCombine(combine.muxs0, combine.muxs1);
+
+	gSP.geometryMode = G_ZBUFFER | G_SHADE | G_SHADING_SMOOTH;
+	gSP.viewport.x = 0.0f;
+	gSP.viewport.y = 0.0f;
+	gSP.viewport.width = (f32)width;
+	gSP.viewport.height = (f32)height;
+	gSP.viewport.vscale[2] = 0.5f;
+	gSP.viewport.vtrans[2] = 0.5f;
+	gSP.viewport.nearz = 0.0f;
+	gSP.viewport.farz = 1.0f;
+	gDPSetScissor(G_SC_NON_INTERLACE, 0.0f, 0.0f, (f32)width, (f32)height);
+
+	gDP.changed |= CHANGED_RENDERMODE | CHANGED_CYCLETYPE | CHANGED_COMBINE | CHANGED_SCISSOR;
+	gSP.changed |= CHANGED_GEOMETRYMODE | CHANGED_VIEWPORT;
+}
+
+static
+f32 random(f32 _min, f32 _max)
+{
+	return _min + (_max - _min) * (f32)rand() / (f32)RAND_MAX;
+}
+
+struct Triangle {
+	SPVertex vtx[3];
+};
+
+static
+void makeTriangles(std::vector<Triangle> & _triangles, u32 _count)
+{
+	_triangles.resize(_count);
+	for (u32 t = 0; t < _count; ++t) {
+		// Small and large triangles, so both batching and overlap happen.
+		const f32 size = rand() % 4 == 0 ? 0.8f : 0.15f;
+		const f32 cx = random(-1.0f, 1.0f);
+		const f32 cy = random(-1.0f, 1.0f);
+		for (u32 i = 0; i < 3; ++i) {
+			SPVertex & vtx = _triangles[t].vtx[i];
+			memset(&vtx, 0, sizeof(vtx));
+			vtx.w = random(1.0f, 4.0f);
+			vtx.x = (cx + random(-size, size)) * vtx.w;
+			vtx.y = (cy + random(-size, size)) * vtx.w;
+			vtx.z = random(-0.9f, 0.9f) * vtx.w;
+			vtx.r = random(0.0f, 1.0f);
+			vtx.g = random(0.0f, 1.0f);
+			vtx.b = random(0.0f, 1.0f);
+			vtx.a = 1.0f;
+		}
+	}
+}
+
+struct Result {
+	std::vector<u8> color;
+	std::vector<u8> depth;
+};
+
+static
+bool drawTriangles(const std::vector<Triangle> & _triangles, bool _bBatch, Result & _result)
+{
+	OGLRender & render = video().getRender();
+	gDPSetColorImage(G_IM_FMT_RGBA, G_IM_SIZ_16b, width, colorAddress);
+	gDPSetDepthImage(depthAddress);
+	setClearState();
+	FrameBuffer * pBuffer = frameBufferList().getCurrent();
+	DepthBuffer * pDepthBuffer = depthBufferList().getCurrent();
+	if (pBuffer == NULL || pDepthBuffer == NULL || pDepthBuffer->m_pDepthImageTexture == NULL)
+		return false;
+
+	render.clearColorBuffer(NULL);
+	render.clearDepthBuffer(0, height);
+	setDrawState();
+
+	u32 loaded = 0;
+	for (u32 t = 0; t < _triangles.size(); ++t) {
+		if (loaded + 3 > groupVertices) {
+			render.drawTriangles();
+			loaded = 0;
+		}
+		for (u32 i = 0; i < 3; ++i)
+			render.getVertex(loaded + i) = _triangles[t].vtx[i];
+		gSPTriangle(loaded, loaded + 1, loaded + 2);
+		if (!_bBatch)
+			render.drawTriangles();
+		loaded += 3;
+	}
+	render.drawTriangles();
+
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	const CachedTexture * pTexture = pBuffer->m_pTexture;
+	_result.color.resize(pTexture->realWidth * pTexture->realHeight * 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, pBuffer->m_FBO);
+	glReadPixels(0, 0, pTexture->realWidth, pTexture->realHeight, GL_RGBA, GL_UNSIGNED_BYTE, _result.color.data());
+
+	const CachedTexture * pDepthImage = pDepthBuffer->m_pDepthImageTexture;
+	_result.depth.resize(pDepthImage->textureBytes);
+	glBindTexture(GL_TEXTURE_2D, pDepthImage->glName);
+	glGetTexImage(GL_TEXTURE_2D, 0, fboFormats.depthImageFormat, fboFormats.depthImageType, _result.depth.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+static
+u32 countDrawn(const std::vector<u8> & _color)
+{
+	u32 drawn = 0;
+	for (size_t i = 0; i + 4 <= _color.size(); i += 4) {
+		if ((_color[i] | _color[i + 1] | _color[i + 2]) != 0)
+			++drawn;
+	}
+	return drawn;
+}
+
+static
+u32 countDiffs(const std::vector<u8> & _a, const std::vector<u8> & _b, u32 _pixelBytes)
+{
+	u32 diffs = 0;
+	for (size_t i = 0; i + _pixelBytes <= _a.size(); i += _pixelBytes) {
+		if (memcmp(&_a[i], &_b[i], _pixelBytes) != 0)
+			++diffs;
+	}
+	return diffs;
+}
+
+int main(int argc, char * argv[])
+{
+	u32 sets = 8;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-n") == 0)
+			sets = strtoul(argv[i + 1], NULL, 0);
+	}
+
+	std::vector<u8> rdram(8 * 1024 * 1024);
+	initN64State(rdram);
+
+	CoreVideo_EGL_Install();
+	ConfigGetUserDataPath = GetUserPath;
+	ConfigGetUserCachePath = GetUserPath;
+
+	config.resetToDefaults();
+	config.video.windowedWidth = width;
+	config.video.windowedHeight = height;
+	config.generalEmulation.enableShadersStorage = 0;
+	config.frameBufferEmulation.enable = 1;
+	config.frameBufferEmulation.N64DepthCompare = 1;
+	strcpy(RSP.romname, "DEPTH COMPARE DIFF");
+
+	video().start();
+	if (!CoreVideo_EGL_HasContext()) {
+		fprintf(stderr, "Can't create OpenGL 3.3 context\n");
+		return 1;
+	}
+	// VI update sets the scale of the output to N64 frame buffer size.
+	video().updateScale();
+	printf("# renderer: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	if (!video().getRender().isImageTexturesSupported()) {
+		fprintf(stderr, "N64 depth compare needs image textures support\n");
+		video().stop();
+		return 1;
+	}
+	printf("set,triangles,drawn_pixels,color_diff_pixels,depth_diff_pixels,result\n");
+
+	srand(1);
+	// Combiner is linked and frame buffer is created by the first draw.
+	std::vector<Triangle> triangles;
+	makeTriangles(triangles, 16);
+	Result warmUp;
+	drawTriangles(triangles, true, warmUp);
+
+	bool match = true;
+	for (u32 s = 0; s < sets; ++s) {
+		makeTriangles(triangles, 64 + s * 64);
+		Result single, batched;
+		if (!drawTriangles(triangles, false, single) || !drawTriangles(triangles, true, batched)) {
+			fprintf(stderr, "Can't create frame buffer with depth image\n");
+			match = false;
+			break;
+		}
+		const u32 colorDiffs = countDiffs(single.color, batched.color, 4);
+		const u32 depthDiffs = countDiffs(single.depth, batched.depth, fboFormats.depthImageFormatBytes);
+		// A set which draws nothing would match trivially.
+		const u32 drawn = countDrawn(batched.color);
+		const bool same = drawn != 0 && colorDiffs == 0 && depthDiffs == 0;
+		printf("%u,%u,%u,%u,%u,%s\n", s, (u32)triangles.size(), drawn, colorDiffs, depthDiffs, same ? "ok" : "DIFF");
+		match = match && same;
+	}
+
+	// Combiners link while the first sets draw, the uber shader draws meanwhile.
+	const CombinerInfo & combiners = CombinerInfo::get();
+	printf("# draws %u, uber shader draws %u\n", combiners.getDraws(), combiners.getUberShaderDraws());
+	if (combiners.getDraws() > 0)
+		printf("# uniform groups per draw: updated %.2f, skipped %.2f\n",
+			(float)combiners.getUniformGroupsUpdated() / combiners.getDraws(), (float)combiners.getUniformGroupsSkipped() / combiners.getDraws());
+
+	video().stop();
+	return match ? 0 : 2;
+}
@@ -18,6 +18,7 @@
 #include "Debug.h"
 #include "PostProcessor.h"
 #include "FrameBufferInfo.h"
+#include "ShaderUtils.h"
 
 using namespace std;
 
@@ -72,32 +73,61 @@ class DepthBufferToRDRAM
 public:
 	DepthBufferToRDRAM() :
 		m_FBO(0),
-		m_PBO(0),
+		m_convertFBO(0),
+		m_convertProgram(0),
+		m_heightLoc(-1),
+		m_curIndex(0),
 		m_frameCount(-1),
+		m_maxHeight(0),
 		m_pColorTexture(nullptr),
 		m_pDepthTexture(nullptr),
+		m_pConvertTexture(nullptr),
 		m_pCurDepthBuffer(nullptr)
-	{}
+	{
+		memset(m_readbacks, 0, sizeof(m_readbacks));
+	}
 
 	void Init();
 	void Destroy();
 
-	bool copyToRDRAM(u32 _address);
+	bool copyToRDRAM(u32 _address, bool _sync);
 	bool copyChunkToRDRAM(u32 _address);
+	void flushReadbacks();
+	void discardReadbacks(u32 _depthAddress);
 
 private:
+	// Pending read of converted depth into a pixel buffer object.
+	struct Readback {
+		GLuint PBO;
+		GLsync fence;
+		u32 frame;
+		u32 depthAddress; // address of the depth buffer the data was read from
+		u32 rowAddress; // RDRAM address of the first row read into PBO
+		u32 startAddress;
+		u32 numBytes;
+	};
+
 	bool _prepareCopy(u32 _address, bool _copyChunk);
-	bool _copy(u32 _startAddress, u32 _endAddress);
+	void _convert();
+	bool _copy(u32 _startAddress, u32 _endAddress, bool _sync);
+	void _writeReadback(Readback & _readback, bool _wait);
+	void _dropReadback(Readback & _readback);
+	void _flushReadbacks(u32 _curFrame, bool _all);
 
-	// Convert pixel from video memory to N64 depth buffer format.
-	static u16 _FloatToUInt16(f32 _z);
+	static const u32 numReadbacks = 3;
 
 	GLuint m_FBO;
-	GLuint m_PBO;
+	GLuint m_convertFBO;
+	GLuint m_convertProgram;
+	GLint m_heightLoc;
+	u32 m_curIndex;
 	u32 m_frameCount;
+	u32 m_maxHeight;
 	CachedTexture * m_pColorTexture;
 	CachedTexture * m_pDepthTexture;
+	CachedTexture * m_pConvertTexture;
 	DepthBuffer * m_pCurDepthBuffer;
+	Readback m_readbacks[numReadbacks];
 };
 #endif // GLES2
 
@@ -107,7 +137,18 @@ public:
 	RDRAMtoFrameBuffer()
 		: m_pCurBuffer(nullptr)
 		, m_pTexture(nullptr)
-		, m_PBO(0) {
+		, m_PBO(0)
+#ifndef GLES2
+		, m_pRawTexture(nullptr)
+		, m_rawProgram(0)
+		, m_rawWidthLoc(-1)
+		, m_rawPixelSizeLoc(-1)
+		, m_rawCFBLoc(-1)
+		, m_rawScaleLoc(-1)
+#endif
+		, m_generation(1)
+		, m_firstWord(0xFFFFFFFF)
+		, m_lastWord(0) {
 	}
 
 	void Init();
@@ -118,6 +159,17 @@ public:
 
 private:
 	void Reset();
+	bool _isEmpty() const { return m_firstWord > m_lastWord; }
+	void _markPixels(u32 _pixel, u32 _count);
+
+	template <typename TSrc>
+	bool _copyPixelsFromRdram(u32 _address, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _width, u32 _height, bool _bCFB) const;
+#ifndef GLES2
+	void _initRawCopy();
+	void _destroyRawCopy();
+	void _drawRawFromRdram(u32 _address, u32 _width, u32 _height, bool _bCFB);
+#endif
+
 	class Cleaner
 	{
 	public:
@@ -133,7 +185,26 @@ private:
 	FrameBuffer * m_pCurBuffer;
 	CachedTexture * m_pTexture;
 	GLuint m_PBO;
-	std::vector<u32> m_vecAddress;
+
+#ifndef GLES2
+	// Whole buffer copy: raw RDRAM words are uploaded as is and converted by m_rawProgram.
+	CachedTexture * m_pRawTexture;
+	GLuint m_rawProgram;
+	GLint m_rawWidthLoc;
+	GLint m_rawPixelSizeLoc;
+	GLint m_rawCFBLoc;
+	GLint m_rawScaleLoc;
+#endif
+
+	// Bitmap of pixels written by CPU, one bit per pixel of m_pCurBuffer.
+	// A word is valid only if its generation equals m_generation, so Reset() does not touch the bitmap.
+	struct WriteMask {
+		u32 generation;
+		u64 bits;
+	};
+	u32 m_generation;
+	u32 m_firstWord, m_lastWord;
+	std::vector<WriteMask> m_vecWriteMask;
 };
 
 #ifndef GLES2
@@ -151,7 +222,7 @@ FrameBuffer::FrameBuffer() :
 	m_pDepthBuffer(NULL), m_resolveFBO(0), m_pResolveTexture(NULL), m_resolved(false),
 	m_SubFBO(0), m_pSubTexture(NULL)
 {
-	m_pTexture = textureCache().addFrameBufferTexture();
+	m_pTexture = NULL;
 	glGenFramebuffers(1, &m_FBO);
 }
 
@@ -184,15 +255,27 @@ FrameBuffer::~FrameBuffer()
 	if (m_FBO != 0)
 		glDeleteFramebuffers(1, &m_FBO);
 	if (m_pTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pTexture);
+		textureCache().releaseFrameBufferTexture(m_pTexture);
 	if (m_resolveFBO != 0)
 		glDeleteFramebuffers(1, &m_resolveFBO);
 	if (m_pResolveTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pResolveTexture);
+		textureCache().releaseFrameBufferTexture(m_pResolveTexture);
 	if (m_SubFBO != 0)
 		glDeleteFramebuffers(1, &m_SubFBO);
 	if (m_pSubTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pSubTexture);
+		textureCache().releaseFrameBufferTexture(m_pSubTexture);
+}
+
+CachedTexture * FrameBuffer::_getTexture(u16 _width, u16 _height, u16 _size, u32 _samples, bool & _bHasStorage) const
+{
+	GLint internalFormat;
+	if (_size <= G_IM_SIZ_8b)
+		internalFormat = fboFormats.monochromeInternalFormat;
+	else if (_samples != 0)
+		internalFormat = GL_RGBA8;
+	else
+		internalFormat = fboFormats.colorInternalFormat;
+	return textureCache().getFrameBufferTexture(internalFormat, (u32)(_width * m_scaleX), (u32)(_height * m_scaleY), _samples, _bHasStorage);
 }
 
 void FrameBuffer::_initTexture(u16 _width, u16 _height, u16 _format, u16 _size, CachedTexture *_pTexture)
@@ -221,13 +304,15 @@ void FrameBuffer::_initTexture(u16 _width, u16 _height, u16 _format, u16 _size,
 	textureCache().addFrameBufferTextureSize(_pTexture->textureBytes);
 }
 
-void FrameBuffer::_setAndAttachTexture(u16 _size, CachedTexture *_pTexture)
+void FrameBuffer::_setAndAttachTexture(u16 _size, CachedTexture *_pTexture, bool _bHasStorage)
 {
 	glBindTexture(GL_TEXTURE_2D, _pTexture->glName);
-	if (_size > G_IM_SIZ_8b)
-		glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.colorInternalFormat, _pTexture->realWidth, _pTexture->realHeight, 0, fboFormats.colorFormat, fboFormats.colorType, NULL);
-	else
-		glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.monochromeInternalFormat, _pTexture->realWidth, _pTexture->realHeight, 0, fboFormats.monochromeFormat, fboFormats.monochromeType, NULL);
+	if (!_bHasStorage) {
+		if (_size > G_IM_SIZ_8b)
+			glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.colorInternalFormat, _pTexture->realWidth, _pTexture->realHeight, 0, fboFormats.colorFormat, fboFormats.colorType, NULL);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.monochromeInternalFormat, _pTexture->realWidth, _pTexture->realHeight, 0, fboFormats.monochromeFormat, fboFormats.monochromeType, NULL);
+	}
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
@@ -273,37 +358,46 @@ void FrameBuffer::init(u32 _address, u32 _endAddress, u16 _format, u16 _size, u1
 	m_cleared = false;
 	m_fingerprint = false;
 
+#ifdef GL_MULTISAMPLING_SUPPORT
+	const u32 samples = config.video.multisampling;
+#else
+	const u32 samples = 0;
+#endif
+	bool bHasStorage;
+	m_pTexture = _getTexture(_width, _height, _size, samples, bHasStorage);
 	_initTexture(_width, _height, _format, _size, m_pTexture);
 	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 
 #ifdef GL_MULTISAMPLING_SUPPORT
 	if (config.video.multisampling != 0) {
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_pTexture->glName);
+		if (!bHasStorage) {
 #if defined(GLES3_1)
-		if (_size > G_IM_SIZ_8b)
-			glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_RGBA8, m_pTexture->realWidth, m_pTexture->realHeight, false);
-		else
-			glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, fboFormats.monochromeInternalFormat, m_pTexture->realWidth, m_pTexture->realHeight, false);
+			if (_size > G_IM_SIZ_8b)
+				glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_RGBA8, m_pTexture->realWidth, m_pTexture->realHeight, false);
+			else
+				glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, fboFormats.monochromeInternalFormat, m_pTexture->realWidth, m_pTexture->realHeight, false);
 #else
-		if (_size > G_IM_SIZ_8b)
-			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_RGBA8, m_pTexture->realWidth, m_pTexture->realHeight, false);
-		else
-			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, fboFormats.monochromeInternalFormat, m_pTexture->realWidth, m_pTexture->realHeight, false);
+			if (_size > G_IM_SIZ_8b)
+				glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, GL_RGBA8, m_pTexture->realWidth, m_pTexture->realHeight, false);
+			else
+				glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, config.video.multisampling, fboFormats.monochromeInternalFormat, m_pTexture->realWidth, m_pTexture->realHeight, false);
 #endif
+		}
 		m_pTexture->frameBufferTexture = CachedTexture::fbMultiSample;
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, m_pTexture->glName, 0);
 
-		m_pResolveTexture = textureCache().addFrameBufferTexture();
+		m_pResolveTexture = _getTexture(_width, _height, _size, 0, bHasStorage);
 		_initTexture(_width, _height, _format, _size, m_pResolveTexture);
 		glGenFramebuffers(1, &m_resolveFBO);
 		glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFBO);
-		_setAndAttachTexture(_size, m_pResolveTexture);
+		_setAndAttachTexture(_size, m_pResolveTexture, bHasStorage);
 		assert(checkFBO());
 
 		glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 	} else
 #endif // GL_MULTISAMPLING_SUPPORT
-		_setAndAttachTexture(_size, m_pTexture);
+		_setAndAttachTexture(_size, m_pTexture, bHasStorage);
 
 	ogl.getRender().clearColorBuffer(nullptr);
 }
@@ -313,12 +407,13 @@ void FrameBuffer::reinit(u16 _height)
 	const u16 format = m_pTexture->format;
 	const u32 endAddress = m_startAddress + ((m_width * _height) << m_size >> 1) - 1;
 	if (m_pTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pTexture);
+		textureCache().releaseFrameBufferTexture(m_pTexture);
 	if (m_resolveFBO != 0)
 		glDeleteFramebuffers(1, &m_resolveFBO);
 	if (m_pResolveTexture != NULL)
-		textureCache().removeFrameBufferTexture(m_pResolveTexture);
-	m_pTexture = textureCache().addFrameBufferTexture();
+		textureCache().releaseFrameBufferTexture(m_pResolveTexture);
+	m_resolveFBO = 0;
+	m_pResolveTexture = NULL;
 	init(m_startAddress, endAddress, format, m_size, m_width, _height, m_cfb);
 }
 
@@ -439,10 +534,11 @@ bool FrameBuffer::_initSubTexture(u32 _t)
 			m_pSubTexture->clampWidth == width &&
 			m_pSubTexture->clampHeight == height)
 			return true;
-		textureCache().removeFrameBufferTexture(m_pSubTexture);
+		textureCache().releaseFrameBufferTexture(m_pSubTexture);
 	}
 
-	m_pSubTexture = textureCache().addFrameBufferTexture();
+	bool bHasStorage;
+	m_pSubTexture = _getTexture(width, height, m_pTexture->size, 0, bHasStorage);
 	_initTexture(width, height, m_pTexture->format, m_pTexture->size, m_pSubTexture);
 
 	m_pSubTexture->clampS = pTile->clamps;
@@ -452,10 +548,12 @@ bool FrameBuffer::_initSubTexture(u32 _t)
 
 	glActiveTexture(GL_TEXTURE0 + _t);
 	glBindTexture(GL_TEXTURE_2D, m_pSubTexture->glName);
-	if (m_pSubTexture->size > G_IM_SIZ_8b)
-		glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.colorInternalFormat, m_pSubTexture->realWidth, m_pSubTexture->realHeight, 0, fboFormats.colorFormat, fboFormats.colorType, NULL);
-	else
-		glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.monochromeInternalFormat, m_pSubTexture->realWidth, m_pSubTexture->realHeight, 0, fboFormats.monochromeFormat, fboFormats.monochromeType, NULL);
+	if (!bHasStorage) {
+		if (m_pSubTexture->size > G_IM_SIZ_8b)
+			glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.colorInternalFormat, m_pSubTexture->realWidth, m_pSubTexture->realHeight, 0, fboFormats.colorFormat, fboFormats.colorType, NULL);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.monochromeInternalFormat, m_pSubTexture->realWidth, m_pSubTexture->realHeight, 0, fboFormats.monochromeFormat, fboFormats.monochromeType, NULL);
+	}
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
@@ -1430,6 +1528,52 @@ void FrameBuffer_CopyChunkToRDRAM(u32 _address)
 }
 
 #ifndef GLES2
+#if defined(GLES3_1)
+#define CONVERT_SHADER_VERSION "#version 310 es \n"
+#elif defined(GLES3)
+#define CONVERT_SHADER_VERSION "#version 300 es \n"
+#else
+#define CONVERT_SHADER_VERSION "#version 330 core \n"
+#endif
+
+static const char * depthConvertVertexShader =
+CONVERT_SHADER_VERSION
+"in highp vec2 aPosition;								\n"
+"void main()											\n"
+"{														\n"
+"  gl_Position = vec4(aPosition.x, aPosition.y, 0.0, 1.0);\n"
+"}														\n"
+;
+
+// Converts float depth to N64 16bit z. Same as DepthBufferList::m_pzLUT, but calculated per pixel.
+// Output pixels are flipped and swapped to match RDRAM layout, so the result can be copied to RDRAM as is.
+static const char * depthConvertFragmentShader =
+CONVERT_SHADER_VERSION
+"uniform highp sampler2D uDepthImage;					\n"
+"uniform mediump int uHeight;							\n"
+"out highp uint fragColor;								\n"
+"highp uint n64z(highp float z)							\n"
+"{														\n"
+"  highp uint idx = 0x3FFFFu;							\n"
+"  if (z < 1.0)											\n"
+"    idx = min(0x3FFFFu, uint(floor(z*262144.0 + 0.5)));\n"
+"  highp uint exponent = 0u;							\n"
+"  highp uint testbit = 1u << 17;						\n"
+"  while ((idx & testbit) != 0u && exponent < 7u) {		\n"
+"    ++exponent;										\n"
+"    testbit = 1u << (17u - exponent);					\n"
+"  }													\n"
+"  highp uint mantissa = (idx >> (6u - min(6u, exponent))) & 0x7FFu;\n"
+"  return ((exponent << 11) | mantissa) << 2;			\n"
+"}														\n"
+"void main()											\n"
+"{														\n"
+"  mediump ivec2 coord = ivec2(gl_FragCoord.xy);		\n"
+"  coord = ivec2(coord.x ^ 1, uHeight - 1 - coord.y);	\n"
+"  fragColor = n64z(texelFetch(uDepthImage, coord, 0).r);\n"
+"}														\n"
+;
+
 void DepthBufferToRDRAM::Init()
 {
 	// generate a framebuffer
@@ -1465,6 +1609,20 @@ void DepthBufferToRDRAM::Init()
 	m_pDepthTexture->textureBytes = m_pDepthTexture->realWidth * m_pDepthTexture->realHeight * sizeof(float);
 	textureCache().addFrameBufferTextureSize(m_pDepthTexture->textureBytes);
 
+	m_pConvertTexture = textureCache().addFrameBufferTexture();
+	m_pConvertTexture->format = G_IM_FMT_I;
+	m_pConvertTexture->clampS = 1;
+	m_pConvertTexture->clampT = 1;
+	m_pConvertTexture->frameBufferTexture = CachedTexture::fbOneSample;
+	m_pConvertTexture->maskS = 0;
+	m_pConvertTexture->maskT = 0;
+	m_pConvertTexture->mirrorS = 0;
+	m_pConvertTexture->mirrorT = 0;
+	m_pConvertTexture->realWidth = 640;
+	m_pConvertTexture->realHeight = 580;
+	m_pConvertTexture->textureBytes = m_pConvertTexture->realWidth * m_pConvertTexture->realHeight * sizeof(u16);
+	textureCache().addFrameBufferTextureSize(m_pConvertTexture->textureBytes);
+
 	glBindTexture( GL_TEXTURE_2D, m_pColorTexture->glName );
 	glTexImage2D(GL_TEXTURE_2D, 0, fboFormats.monochromeInternalFormat, m_pColorTexture->realWidth, m_pColorTexture->realHeight, 0, fboFormats.monochromeFormat, fboFormats.monochromeType, NULL);
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
@@ -1475,6 +1633,11 @@ void DepthBufferToRDRAM::Init()
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
 
+	glBindTexture( GL_TEXTURE_2D, m_pConvertTexture->glName );
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, m_pConvertTexture->realWidth, m_pConvertTexture->realHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, NULL);
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pColorTexture->glName, 0);
@@ -1482,19 +1645,36 @@ void DepthBufferToRDRAM::Init()
 	// check if everything is OK
 	assert(checkFBO());
 	assert(!isGLError());
+
+	glGenFramebuffers(1, &m_convertFBO);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_convertFBO);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pConvertTexture->glName, 0);
+	assert(checkFBO());
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
+	m_convertProgram = createShaderProgram(depthConvertVertexShader, depthConvertFragmentShader);
+	glUseProgram(m_convertProgram);
+	const int texLoc = glGetUniformLocation(m_convertProgram, "uDepthImage");
+	glUniform1i(texLoc, 0);
+	m_heightLoc = glGetUniformLocation(m_convertProgram, "uHeight");
+	glUseProgram(0);
+
 	// Generate and initialize Pixel Buffer Objects
-	glGenBuffers(1, &m_PBO);
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PBO);
-	glBufferData(GL_PIXEL_PACK_BUFFER, m_pDepthTexture->realWidth * m_pDepthTexture->realHeight * sizeof(float), NULL, GL_DYNAMIC_READ);
+	for (u32 i = 0; i < numReadbacks; ++i) {
+		glGenBuffers(1, &m_readbacks[i].PBO);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbacks[i].PBO);
+		glBufferData(GL_PIXEL_PACK_BUFFER, m_pConvertTexture->textureBytes, NULL, GL_DYNAMIC_READ);
+	}
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_curIndex = 0;
 }
 
 void DepthBufferToRDRAM::Destroy() {
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 	glDeleteFramebuffers(1, &m_FBO);
 	m_FBO = 0;
+	glDeleteFramebuffers(1, &m_convertFBO);
+	m_convertFBO = 0;
 	if (m_pColorTexture != NULL) {
 		textureCache().removeFrameBufferTexture(m_pColorTexture);
 		m_pColorTexture = NULL;
@@ -1503,10 +1683,21 @@ void DepthBufferToRDRAM::Destroy() {
 		textureCache().removeFrameBufferTexture(m_pDepthTexture);
 		m_pDepthTexture = NULL;
 	}
-	if (m_PBO != 0) {
-		glDeleteBuffers(1, &m_PBO);
-		m_PBO = 0;
+	if (m_pConvertTexture != NULL) {
+		textureCache().removeFrameBufferTexture(m_pConvertTexture);
+		m_pConvertTexture = NULL;
 	}
+	if (m_convertProgram != 0) {
+		glDeleteProgram(m_convertProgram);
+		m_convertProgram = 0;
+	}
+	for (u32 i = 0; i < numReadbacks; ++i) {
+		if (m_readbacks[i].fence != 0)
+			glDeleteSync(m_readbacks[i].fence);
+		if (m_readbacks[i].PBO != 0)
+			glDeleteBuffers(1, &m_readbacks[i].PBO);
+	}
+	memset(m_readbacks, 0, sizeof(m_readbacks));
 }
 
 bool DepthBufferToRDRAM::_prepareCopy(u32 _address, bool _copyChunk)
@@ -1527,6 +1718,12 @@ bool DepthBufferToRDRAM::_prepareCopy(u32 _address, bool _copyChunk)
 	if (address + numPixels * 2 > RDRAMSize)
 		return false;
 
+	// Data read from another depth buffer is stale now.
+	for (u32 i = 0; i < numReadbacks; ++i) {
+		if (m_readbacks[i].numBytes != 0 && m_readbacks[i].depthAddress != address)
+			_dropReadback(m_readbacks[i]);
+	}
+
 	const u32 height = _cutHeight(address, min(VI.height, m_pCurDepthBuffer->m_lry), pBuffer->m_width * 2);
 	if (height == 0)
 		return false;
@@ -1544,68 +1741,146 @@ bool DepthBufferToRDRAM::_prepareCopy(u32 _address, bool _copyChunk)
 		0, 0, pBuffer->m_width, pBuffer->m_height,
 		GL_DEPTH_BUFFER_BIT, GL_NEAREST
 	);
+	m_maxHeight = height;
+	_convert();
 	frameBufferList().setCurrentDrawBuffer();
 	m_frameCount = curFrame;
 	return true;
 }
 
-u16 DepthBufferToRDRAM::_FloatToUInt16(f32 _z)
+void DepthBufferToRDRAM::_convert()
 {
-	static const u16 * const zLUT = depthBufferList().getZLUT();
-	u32 idx = 0x3FFFF;
-	if (_z < 1.0f) {
-		_z *= 262144.0f;
-		idx = min(0x3FFFFU, u32(floorf(_z + 0.5f)));
-	}
-	return zLUT[idx];
+	static const float vert[] =
+	{
+		-1.0, -1.0,
+		+1.0, -1.0,
+		-1.0, +1.0,
+		+1.0, +1.0
+	};
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_convertFBO);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glEnableVertexAttribArray(SC_POSITION);
+	glVertexAttribPointer(SC_POSITION, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), vert);
+	glDisableVertexAttribArray(SC_COLOR);
+	glDisableVertexAttribArray(SC_TEXCOORD0);
+	glDisableVertexAttribArray(SC_TEXCOORD1);
+	glDisableVertexAttribArray(SC_NUMLIGHTS);
+	glDisableVertexAttribArray(SC_MODIFY);
+	glViewport(0, 0, m_pCurDepthBuffer->m_width, m_maxHeight);
+	glScissor(0, 0, m_pCurDepthBuffer->m_width, m_maxHeight);
+	textureCache().activateTexture(0, m_pDepthTexture);
+	glUseProgram(m_convertProgram);
+	glUniform1i(m_heightLoc, m_maxHeight);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	video().getRender().dropRenderState();
+	gSP.changed |= CHANGED_VIEWPORT | CHANGED_TEXTURE;
+	gDP.changed |= CHANGED_RENDERMODE | CHANGED_COMBINE | CHANGED_SCISSOR;
 }
 
-bool DepthBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress)
+void DepthBufferToRDRAM::_writeReadback(Readback & _readback, bool _wait)
 {
-	const u32 stride = m_pCurDepthBuffer->m_width << 1;
-	const u32 max_height = _cutHeight(_startAddress, min(VI.height, m_pCurDepthBuffer->m_lry), stride);
+	if (_readback.fence != 0) {
+		const GLenum res = glClientWaitSync(_readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, _wait ? GL_TIMEOUT_IGNORED : 0);
+		if (res == GL_TIMEOUT_EXPIRED)
+			return;
+		glDeleteSync(_readback.fence);
+		_readback.fence = 0;
+	}
 
-	u32 numPixels = (_endAddress - _startAddress) >> 1;
-	if (numPixels / m_pCurDepthBuffer->m_width > max_height) {
-		_endAddress = _startAddress + (max_height * stride);
-		numPixels = (_endAddress - _startAddress) >> 1;
+	if (_readback.numBytes == 0)
+		return;
+
+	const u32 offset = _readback.startAddress - _readback.rowAddress;
+	PBOBinder binder(GL_PIXEL_PACK_BUFFER, _readback.PBO);
+	GLubyte* pixelData = (GLubyte*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, offset + _readback.numBytes, GL_MAP_READ_BIT);
+	if (pixelData != NULL) {
+		memcpy(RDRAM + _readback.startAddress, pixelData + offset, _readback.numBytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
 	}
+	_readback.numBytes = 0;
+}
 
-	const GLsizei width = m_pCurDepthBuffer->m_width;
-	const GLint x0 = 0;
-	const GLint y0 = max_height - (_endAddress - m_pCurDepthBuffer->m_address) / stride;
-	const GLint y1 = max_height - (_startAddress - m_pCurDepthBuffer->m_address) / stride;
-	const GLsizei height = std::min(max_height, 1u + y1 - y0);
+void DepthBufferToRDRAM::_dropReadback(Readback & _readback)
+{
+	// Deleting the fence does not wait for the GPU, the PBO is reused after the read anyway.
+	if (_readback.fence != 0) {
+		glDeleteSync(_readback.fence);
+		_readback.fence = 0;
+	}
+	_readback.numBytes = 0;
+}
 
-	PBOBinder binder(GL_PIXEL_PACK_BUFFER, m_PBO);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FBO);
-	glReadPixels(x0, y0, width, height, fboFormats.depthFormat, fboFormats.depthType, 0);
+void DepthBufferToRDRAM::_flushReadbacks(u32 _curFrame, bool _all)
+{
+	// Write pending readbacks from oldest to newest.
+	// Async mode keeps data of current frame in flight, so RDRAM gets it one frame later.
+	for (u32 i = 0; i < numReadbacks; ++i) {
+		Readback & readback = m_readbacks[(m_curIndex + i) % numReadbacks];
+		if (readback.numBytes == 0)
+			continue;
+		if (!_all && readback.frame == _curFrame)
+			continue;
+		_writeReadback(readback, true);
+	}
+}
 
-	GLubyte* pixelData = (GLubyte*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * fboFormats.depthFormatBytes, GL_MAP_READ_BIT);
-	if (pixelData == NULL)
+bool DepthBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
+{
+	const u32 stride = m_pCurDepthBuffer->m_width << 1;
+	const u32 address = m_pCurDepthBuffer->m_address;
+	if (_startAddress < address)
 		return false;
 
-	f32 * ptr_src = (f32*)pixelData;
-	u16 *ptr_dst = (u16*)(RDRAM + _startAddress);
-	_writeToRdram<f32, u16>(ptr_src, ptr_dst, &DepthBufferToRDRAM::_FloatToUInt16, 2.0f, 1, width, height, numPixels, _startAddress, m_pCurDepthBuffer->m_address, G_IM_SIZ_16b);
+	const u32 firstRow = (_startAddress - address) / stride;
+	const u32 lastRow = min(m_maxHeight, (_endAddress - address + stride - 1) / stride);
+	if (firstRow >= lastRow)
+		return false;
+	_endAddress = min(_endAddress, address + lastRow * stride);
+
+	const u32 curFrame = video().getBuffersSwapCount();
+	_flushReadbacks(curFrame, _sync);
+
+	Readback & readback = m_readbacks[m_curIndex];
+	// The slot may be still in flight if copy was requested more than numReadbacks times per frame.
+	_writeReadback(readback, true);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_convertFBO);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+	glReadPixels(0, firstRow, m_pCurDepthBuffer->m_width, lastRow - firstRow, GL_RED_INTEGER, GL_UNSIGNED_SHORT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.frame = curFrame;
+	readback.depthAddress = address;
+	readback.rowAddress = address + firstRow * stride;
+	readback.startAddress = _startAddress;
+	readback.numBytes = _endAddress - _startAddress;
+
+	if (_sync)
+		_writeReadback(readback, true);
+	else {
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_curIndex = (m_curIndex + 1) % numReadbacks;
+	}
 
 	m_pCurDepthBuffer->m_cleared = false;
 	FrameBuffer * pBuffer = frameBufferList().findBuffer(m_pCurDepthBuffer->m_address);
 	if (pBuffer != NULL)
 		pBuffer->m_cleared = false;
 
-	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
 	gDP.changed |= CHANGED_SCISSOR;
 	return true;
 }
 
-bool DepthBufferToRDRAM::copyToRDRAM( u32 _address)
+bool DepthBufferToRDRAM::copyToRDRAM(u32 _address, bool _sync)
 {
 	if (!_prepareCopy(_address, false))
 		return false;
 
-	const u32 endAddress = m_pCurDepthBuffer->m_address + (min(VI.height, m_pCurDepthBuffer->m_lry) * m_pCurDepthBuffer->m_width * 2);
-	return _copy(m_pCurDepthBuffer->m_address, endAddress);
+	const u32 endAddress = m_pCurDepthBuffer->m_address + (m_maxHeight * m_pCurDepthBuffer->m_width * 2);
+	return _copy(m_pCurDepthBuffer->m_address, endAddress, _sync);
 }
 
 bool DepthBufferToRDRAM::copyChunkToRDRAM(u32 _address)
@@ -1614,11 +1889,26 @@ bool DepthBufferToRDRAM::copyChunkToRDRAM(u32 _address)
 		return false;
 
 	const u32 endAddress = _address + 0x1000;
-	return _copy(_address, endAddress);
+	return _copy(_address, endAddress, true);
+}
+
+void DepthBufferToRDRAM::flushReadbacks()
+{
+	// Frame is finished, write data of previous frames.
+	// Data of the finished frame is written on next swap or next copy, whichever comes first.
+	_flushReadbacks(video().getBuffersSwapCount(), false);
+}
+
+void DepthBufferToRDRAM::discardReadbacks(u32 _depthAddress)
+{
+	for (u32 i = 0; i < numReadbacks; ++i) {
+		if (m_readbacks[i].numBytes != 0 && m_readbacks[i].depthAddress == _depthAddress)
+			_dropReadback(m_readbacks[i]);
+	}
 }
 #endif // GLES2
 
-bool FrameBuffer_CopyDepthBuffer( u32 address )
+bool FrameBuffer_CopyDepthBuffer(u32 address, bool _sync)
 {
 #ifndef GLES2
 	FrameBuffer * pCopyBuffer = frameBufferList().getCopyBuffer();
@@ -1629,7 +1919,7 @@ bool FrameBuffer_CopyDepthBuffer( u32 address )
 		frameBufferList().setCopyBuffer(NULL);
 		return true;
 	} else
-		return g_dbToRDRAM.copyToRDRAM(address);
+		return g_dbToRDRAM.copyToRDRAM(address, _sync);
 #else
 	return false;
 #endif
@@ -1644,6 +1934,159 @@ bool FrameBuffer_CopyDepthBufferChunk(u32 address)
 #endif
 }
 
+void FrameBuffer_FlushDepthReadbacks()
+{
+#ifndef GLES2
+	g_dbToRDRAM.flushReadbacks();
+#endif
+}
+
+void FrameBuffer_DiscardDepthReadbacks(u32 _depthAddress)
+{
+#ifndef GLES2
+	g_dbToRDRAM.discardReadbacks(_depthAddress);
+#endif
+}
+
+#ifndef GLES2
+static const char * rdramCopyVertexShader =
+CONVERT_SHADER_VERSION
+"in highp vec2 aPosition;								\n"
+"uniform mediump vec2 uScale;							\n"
+"out mediump vec2 vPixel;								\n"
+"void main()											\n"
+"{														\n"
+"  gl_Position = vec4(aPosition.x*uScale.x - 1.0, 1.0 - aPosition.y*uScale.y, 0.0, 1.0);\n"
+"  vPixel = aPosition;									\n"
+"}														\n"
+;
+
+// Converts raw RDRAM pixels to RGBA. Same as RGBA16ToABGR32 and RGBA32ToABGR32, but calculated per pixel.
+// The texture holds RDRAM as 16bit words, uWidth pixels per row, so 32bit pixels occupy two texels.
+static const char * rdramCopyFragmentShader =
+CONVERT_SHADER_VERSION
+"uniform highp usampler2D uRdramImage;					\n"
+"uniform mediump int uWidth;							\n"
+"uniform lowp int uPixelSize;							\n"
+"uniform lowp int uCFB;									\n"
+"in mediump vec2 vPixel;								\n"
+"out lowp vec4 fragColor;								\n"
+"highp uint fetchWord(highp int idx, highp int stride)	\n"
+"{														\n"
+"  return texelFetch(uRdramImage, ivec2(idx % stride, idx / stride), 0).r;\n"
+"}														\n"
+"void main()											\n"
+"{														\n"
+"  highp int idx = int(vPixel.y) * uWidth + int(vPixel.x);\n"
+"  highp uvec4 col;										\n"
+"  if (uPixelSize == 2) {								\n"
+"    highp uint c = fetchWord(idx ^ 1, uWidth);			\n"
+"    col = uvec4((c >> 11) & 31u, (c >> 6) & 31u, (c >> 1) & 31u, 0u) << 3;\n"
+"    col.a = (c & 1u) != 0u && col.rgb != uvec3(0u) ? 255u : 0u;\n"
+"  } else {												\n"
+"    highp uint c = (fetchWord(idx * 2 + 1, uWidth * 2) << 16) | fetchWord(idx * 2, uWidth * 2);\n"
+"    col = uvec4(c >> 24, (c >> 16) & 255u, (c >> 8) & 255u, c & 255u);\n"
+"    if (col.rgb == uvec3(0u)) col.a = 0u;				\n"
+"  }													\n"
+"  if (uCFB != 0) col.a = 255u;							\n"
+"  fragColor = vec4(col) / 255.0;						\n"
+"}														\n"
+;
+
+void RDRAMtoFrameBuffer::_initRawCopy()
+{
+	m_pRawTexture = textureCache().addFrameBufferTexture();
+	m_pRawTexture->format = G_IM_FMT_RGBA;
+	m_pRawTexture->clampS = 1;
+	m_pRawTexture->clampT = 1;
+	m_pRawTexture->frameBufferTexture = CachedTexture::fbOneSample;
+	m_pRawTexture->maskS = 0;
+	m_pRawTexture->maskT = 0;
+	m_pRawTexture->mirrorS = 0;
+	m_pRawTexture->mirrorT = 0;
+	// 16bit words: enough for 640 32bit pixels per row.
+	m_pRawTexture->realWidth = 1280;
+	m_pRawTexture->realHeight = 580;
+	m_pRawTexture->textureBytes = m_pRawTexture->realWidth * m_pRawTexture->realHeight * 2;
+	textureCache().addFrameBufferTextureSize(m_pRawTexture->textureBytes);
+	glBindTexture(GL_TEXTURE_2D, m_pRawTexture->glName);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, m_pRawTexture->realWidth, m_pRawTexture->realHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	m_rawProgram = createShaderProgram(rdramCopyVertexShader, rdramCopyFragmentShader);
+	glUseProgram(m_rawProgram);
+	const int texLoc = glGetUniformLocation(m_rawProgram, "uRdramImage");
+	glUniform1i(texLoc, 0);
+	m_rawWidthLoc = glGetUniformLocation(m_rawProgram, "uWidth");
+	m_rawPixelSizeLoc = glGetUniformLocation(m_rawProgram, "uPixelSize");
+	m_rawCFBLoc = glGetUniformLocation(m_rawProgram, "uCFB");
+	m_rawScaleLoc = glGetUniformLocation(m_rawProgram, "uScale");
+	glUseProgram(0);
+}
+
+void RDRAMtoFrameBuffer::_destroyRawCopy()
+{
+	if (m_pRawTexture != nullptr) {
+		textureCache().removeFrameBufferTexture(m_pRawTexture);
+		m_pRawTexture = nullptr;
+	}
+	if (m_rawProgram != 0) {
+		glDeleteProgram(m_rawProgram);
+		m_rawProgram = 0;
+	}
+}
+
+void RDRAMtoFrameBuffer::_drawRawFromRdram(u32 _address, u32 _width, u32 _height, bool _bCFB)
+{
+	const u32 pixelSize = 1 << m_pCurBuffer->m_size >> 1;
+	const u32 rowWords = _width * pixelSize / 2;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_pRawTexture->glName);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rowWords, _height, GL_RED_INTEGER, GL_UNSIGNED_SHORT, RDRAM + _address);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	const float W = (float)_width;
+	const float H = (float)_height;
+	const float vert[] =
+	{
+		0.0f, 0.0f,
+		W, 0.0f,
+		0.0f, H,
+		W, H
+	};
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_pCurBuffer->m_FBO);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnableVertexAttribArray(SC_POSITION);
+	glVertexAttribPointer(SC_POSITION, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), vert);
+	glDisableVertexAttribArray(SC_COLOR);
+	glDisableVertexAttribArray(SC_TEXCOORD0);
+	glDisableVertexAttribArray(SC_TEXCOORD1);
+	glDisableVertexAttribArray(SC_NUMLIGHTS);
+	glDisableVertexAttribArray(SC_MODIFY);
+	glViewport(0, 0, (GLsizei)(m_pCurBuffer->m_width*m_pCurBuffer->m_scaleX), (GLsizei)(m_pCurBuffer->m_height*m_pCurBuffer->m_scaleY));
+	glUseProgram(m_rawProgram);
+	glUniform1i(m_rawWidthLoc, _width);
+	glUniform1i(m_rawPixelSizeLoc, pixelSize);
+	glUniform1i(m_rawCFBLoc, _bCFB ? 1 : 0);
+	glUniform2f(m_rawScaleLoc, 2.0f / m_pCurBuffer->m_width, 2.0f / m_pCurBuffer->m_height);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	frameBufferList().setCurrentDrawBuffer();
+
+	video().getRender().dropRenderState();
+	gSP.changed |= CHANGED_VIEWPORT | CHANGED_TEXTURE;
+	gDP.changed |= CHANGED_RENDERMODE | CHANGED_COMBINE | CHANGED_SCISSOR;
+}
+#endif // GLES2
+
 void RDRAMtoFrameBuffer::Init()
 {
 	m_pTexture = textureCache().addFrameBufferTexture();
@@ -1668,6 +2111,7 @@ void RDRAMtoFrameBuffer::Init()
 	// Generate Pixel Buffer Object. Initialize it later
 #ifndef GLES2
 	glGenBuffers(1, &m_PBO);
+	_initRawCopy();
 #endif
 }
 
@@ -1682,21 +2126,52 @@ void RDRAMtoFrameBuffer::Destroy()
 		glDeleteBuffers(1, &m_PBO);
 		m_PBO = 0;
 	}
+	_destroyRawCopy();
 #endif
 }
 
+inline
+void RDRAMtoFrameBuffer::_markPixels(u32 _pixel, u32 _count)
+{
+	const u32 bit = _pixel & 63;
+	if (bit + _count > 64) {
+		const u32 count = 64 - bit;
+		_markPixels(_pixel, count);
+		_markPixels(_pixel + count, _count - count);
+		return;
+	}
+
+	const u32 word = _pixel >> 6;
+	if (word >= m_vecWriteMask.size())
+		m_vecWriteMask.resize(word + 1);
+	WriteMask & mask = m_vecWriteMask[word];
+	if (mask.generation != m_generation) {
+		mask.generation = m_generation;
+		mask.bits = 0;
+	}
+	mask.bits |= (_count == 64 ? ~0ULL : ((1ULL << _count) - 1)) << bit;
+	m_firstWord = min(m_firstWord, word);
+	m_lastWord = max(m_lastWord, word);
+}
+
 void RDRAMtoFrameBuffer::AddAddress(u32 _address, u32 _size)
 {
 	if (m_pCurBuffer == nullptr) {
 		m_pCurBuffer = frameBufferList().findBuffer(_address);
 		if (m_pCurBuffer == nullptr)
 			return;
+		m_vecWriteMask.reserve((m_pCurBuffer->m_width * m_pCurBuffer->m_height + 63) >> 6);
 	}
 
 	const u32 pixelSize = 1 << m_pCurBuffer->m_size >> 1;
 	if (_size != pixelSize && (_address%pixelSize) > 0)
 		return;
-	m_vecAddress.push_back(_address);
+	if (_address < m_pCurBuffer->m_startAddress || _address > RDRAMSize)
+		return;
+	const u32 pixel = (_address - m_pCurBuffer->m_startAddress) / pixelSize;
+	// Wide aligned write covers several pixels at once.
+	const u32 count = (_size > pixelSize && (_address % _size) == 0) ? _size / pixelSize : 1;
+	_markPixels(pixel, count);
 	gDP.colorImage.changed = TRUE;
 }
 
@@ -1726,28 +2201,58 @@ bool _copyBufferFromRdram(u32 _address, u32* _dst, u32(*converter)(TSrc _c, bool
 	return summ != 0;
 }
 
+static inline
+u32 _countTrailingZeros(u64 _v)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(_v);
+#else
+	u32 n = 0;
+	while ((_v & 1) == 0) {
+		_v >>= 1;
+		++n;
+	}
+	return n;
+#endif
+}
+
 // Write only pixels provided with FBWrite
 template <typename TSrc>
-bool _copyPixelsFromRdram(u32 _address, const vector<u32> & _vecAddress, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _width, u32 _height, bool _bCFB)
+bool RDRAMtoFrameBuffer::_copyPixelsFromRdram(u32 _address, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _width, u32 _height, bool _bCFB) const
 {
 	memset(_dst, 0, _width*_height*sizeof(u32));
-	TSrc * src = reinterpret_cast<TSrc*>(RDRAM + _address);
-	const u32 szPixel = sizeof(TSrc);
-	const size_t numPixels = _vecAddress.size();
+	const TSrc * src = reinterpret_cast<const TSrc*>(RDRAM + _address);
+	const u32 numPixels = _width * _height;
+	const u32 lastWord = min(m_lastWord, (numPixels - 1) >> 6);
 	TSrc col;
 	u32 summ = 0;
-	u32 idx, w, h;
-	for (size_t i = 0; i < numPixels; ++i) {
-		if (_vecAddress[i] < _address)
-			return false;
-		idx = (_vecAddress[i] - _address) / szPixel;
-		w = idx % _width;
-		h = idx / _width;
-		if (h > _height)
-			return false;
-		col = src[idx];
-		summ += col;
-		_dst[(w + (_height - h)*_width) ^ _xor] = converter(col, _bCFB);
+	for (u32 w = m_firstWord; w <= lastWord; ++w) {
+		const WriteMask & mask = m_vecWriteMask[w];
+		if (mask.generation != m_generation)
+			continue;
+		// Walk runs of set bits: whole word at once when all 64 pixels are written.
+		u64 bits = mask.bits;
+		while (bits != 0) {
+			const u32 start = _countTrailingZeros(bits);
+			const u64 run = ~(bits >> start);
+			const u32 len = run == 0 ? 64 - start : _countTrailingZeros(run);
+			bits &= ~((len == 64 ? ~0ULL : ((1ULL << len) - 1)) << start);
+
+			u32 pixel = (w << 6) + start;
+			const u32 end = min(pixel + len, numPixels);
+			while (pixel < end) {
+				const u32 x = pixel % _width;
+				const u32 y = pixel / _width;
+				const u32 count = min(end - pixel, _width - x);
+				u32 * dst = _dst + x + (_height - y - 1)*_width;
+				for (u32 i = 0; i < count; ++i) {
+					col = src[(pixel + i) ^ _xor];
+					summ += col;
+					dst[i] = converter(col, _bCFB);
+				}
+				pixel += count;
+			}
+		}
 	}
 
 	return summ != 0;
@@ -1786,7 +2291,7 @@ void RDRAMtoFrameBuffer::CopyFromRDRAM(u32 _address, bool _bCFB)
 	if (m_pCurBuffer == nullptr) {
 		if (_bCFB || (config.frameBufferEmulation.copyFromRDRAM != 0 && !FBInfo::fbInfo.isSupported()))
 			m_pCurBuffer = frameBufferList().findBuffer(_address);
-	} else if (m_vecAddress.empty())
+	} else if (_isEmpty())
 		return;
 
 	if (m_pCurBuffer == nullptr || m_pCurBuffer->m_size < G_IM_SIZ_16b)
@@ -1809,6 +2314,22 @@ void RDRAMtoFrameBuffer::CopyFromRDRAM(u32 _address, bool _bCFB)
 
 	const bool bUseAlpha = !_bCFB && m_pCurBuffer->m_changed;
 
+#ifndef GLES2
+	if (_isEmpty() && width <= 640) {
+		// Whole buffer: skip CPU conversion, upload RDRAM as is and convert it in shader.
+		const u32 totalBytes = (width * height) << m_pCurBuffer->m_size >> 1;
+		const u32 * src = reinterpret_cast<const u32*>(RDRAM + address);
+		bool bCopy = false;
+		for (u32 i = 0; i < totalBytes / 4 && !bCopy; ++i)
+			bCopy = src[i] != 0;
+		if (bCopy)
+			_drawRawFromRdram(address, width, height, _bCFB);
+		if (bUseAlpha)
+			memset(RDRAM + address, 0, totalBytes);
+		return;
+	}
+#endif
+
 	m_pTexture->width = width;
 	m_pTexture->height = height;
 	const u32 dataSize = width*height * 4;
@@ -1825,7 +2346,7 @@ void RDRAMtoFrameBuffer::CopyFromRDRAM(u32 _address, bool _bCFB)
 
 	u32 * dst = (u32*)ptr;
 	bool bCopy;
-	if (m_vecAddress.empty()) {
+	if (_isEmpty()) {
 		if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
 			bCopy = _copyBufferFromRdram<u16>(address, dst, RGBA16ToABGR32, 1, x0, y0, width, height, _bCFB);
 		else
@@ -1833,9 +2354,9 @@ void RDRAMtoFrameBuffer::CopyFromRDRAM(u32 _address, bool _bCFB)
 	}
 	else {
 		if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
-			bCopy = _copyPixelsFromRdram<u16>(address, m_vecAddress, dst, RGBA16ToABGR32, 1, width, height, _bCFB);
+			bCopy = _copyPixelsFromRdram<u16>(address, dst, RGBA16ToABGR32, 1, width, height, _bCFB);
 		else
-			bCopy = _copyPixelsFromRdram<u32>(address, m_vecAddress, dst, RGBA32ToABGR32, 0, width, height, _bCFB);
+			bCopy = _copyPixelsFromRdram<u32>(address, dst, RGBA32ToABGR32, 0, width, height, _bCFB);
 	}
 
 	if (bUseAlpha) {
@@ -1898,7 +2419,14 @@ void RDRAMtoFrameBuffer::CopyFromRDRAM(u32 _address, bool _bCFB)
 void RDRAMtoFrameBuffer::Reset()
 {
 	m_pCurBuffer = nullptr;
-	m_vecAddress.clear();
+	if (_isEmpty())
+		return;
+	m_firstWord = 0xFFFFFFFF;
+	m_lastWord = 0;
+	if (++m_generation == 0) {
+		m_vecWriteMask.assign(m_vecWriteMask.size(), WriteMask());
+		m_generation = 1;
+	}
 }
 
 void FrameBuffer_CopyFromRDRAM(u32 _address, bool _bCFB)
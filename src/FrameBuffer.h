@@ -58,7 +58,8 @@ struct FrameBuffer
 
 private:
 	void _initTexture(u16 _width, u16 _height, u16 _format, u16 _size, CachedTexture *_pTexture);
-	void _setAndAttachTexture(u16 _size, CachedTexture *_pTexture);
+	CachedTexture * _getTexture(u16 _width, u16 _height, u16 _size, u32 _samples, bool & _bHasStorage) const;
+	void _setAndAttachTexture(u16 _size, CachedTexture *_pTexture, bool _bHasStorage);
 	bool _initSubTexture(u32 _t);
 	CachedTexture * _getSubTexture(u32 _t);
 };
@@ -133,8 +134,10 @@ void FrameBuffer_CopyToRDRAM( u32 _address , bool _sync );
 void FrameBuffer_CopyChunkToRDRAM(u32 _address);
 void FrameBuffer_CopyFromRDRAM(u32 address, bool bUseAlpha);
 void FrameBuffer_AddAddress(u32 address, u32 _size);
-bool FrameBuffer_CopyDepthBuffer(u32 address);
+bool FrameBuffer_CopyDepthBuffer(u32 address, bool _sync);
 bool FrameBuffer_CopyDepthBufferChunk(u32 address);
+void FrameBuffer_FlushDepthReadbacks();
+void FrameBuffer_DiscardDepthReadbacks(u32 _depthAddress);
 void FrameBuffer_ActivateBufferTexture(u32 t, FrameBuffer *pBuffer);
 void FrameBuffer_ActivateBufferTextureBG(u32 t, FrameBuffer *pBuffer);
 
@@ -57,7 +57,7 @@ namespace FBInfo {
 			if (config.frameBufferEmulation.fbInfoReadDepthChunk != 0)
 				FrameBuffer_CopyDepthBufferChunk(address);
 			else if (pBuffer != m_pReadBuffer)
-				FrameBuffer_CopyDepthBuffer(address);
+				FrameBuffer_CopyDepthBuffer(address, true);
 		}
 		else {
 			if (config.frameBufferEmulation.fbInfoReadColorChunk != 0)
@@ -143,7 +143,7 @@ void DestroyShaderCombiner() {
 	noiseTex.destroy();
 }
 
-ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCombine & _combine) : m_key(getCombinerKey(_combine.mux))
+ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCombine & _combine) : m_key(getCombinerKey(_combine.mux)), m_fragmentShader(0), m_bLinked(true)
 {
 	std::string strCombiner;
 	m_nInputs = compileCombiner(_color, _alpha, strCombiner);
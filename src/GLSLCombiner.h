@@ -2,6 +2,7 @@
 #define GLSL_COMBINER_H
 
 #include <vector>
+#include <string>
 #include <iostream>
 #include "gDP.h"
 #include "Combiner.h"
@@ -12,6 +13,18 @@ public:
 	ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCombine & _combine);
 	~ShaderCombiner();
 
+#ifndef GLES2
+	// Uber shader takes combine mode from uniforms and can replace any combiner, which is not linked yet.
+	static ShaderCombiner * createUberShader();
+	void setUberShaderCombine(u64 _key, int _nInputs, const CombineCycle * _color, const CombineCycle * _alpha, int _numCycles);
+
+	// New and loaded from storage combiners are linked in background when possible.
+	// finishLinking returns false while link is in progress.
+	bool isLinked() const {return m_bLinked;}
+	bool finishLinking(bool _bWait);
+	GLuint getProgram() const {return m_program;}
+#endif
+
 	void update(bool _bForce);
 	void updateFogMode(bool _bForce = false);
 	void updateDitherMode(bool _bForce = false);
@@ -119,7 +132,7 @@ private:
 			uMaxTile, uTextureDetail, uTexturePersp, uTextureFilterMode, uMSAASamples,
 			uAlphaCompareMode, uAlphaDitherMode, uColorDitherMode,
 			uCvgXAlpha, uAlphaCvgSel, uRenderTarget,
-			uForceBlendCycle1, uForceBlendCycle2;
+			uForceBlendCycle1, uForceBlendCycle2, uCombineCycles;
 
 		fUniform uMinLod, uDeltaZ, uAlphaTestValue, uMSAAScale;
 
@@ -127,7 +140,8 @@ private:
 
 		iv2Uniform uMSTexEnabled, uFbMonochrome, uFbFixedAlpha;
 
-		i4Uniform uBlendMux1, uBlendMux2;
+		i4Uniform uBlendMux1, uBlendMux2,
+			uCombineColor0, uCombineAlpha0, uCombineColor1, uCombineAlpha1;
 	};
 
 #ifdef OS_MAC_OS_X
@@ -141,12 +155,21 @@ private:
 
 	void _locate_attributes() const;
 	void _locateUniforms();
+	void _linkProgram(const std::string & _strCombiner, bool _bUseHWLight, bool _bUberShader);
+	void _resetStateVersions();
+	// Recalculates uniform groups, which depend on _changedBlocks bit set of CombinerInfo state blocks.
+	void _updateUniformGroups(u32 _changedBlocks, bool _bForce, u32 & _updated, u32 & _skipped);
 
 	u64 m_key;
 	UniformLocation m_uniforms;
 	GLuint m_program;
+	GLuint m_fragmentShader;
+	bool m_bLinked;
 	int m_nInputs;
 	bool m_bNeedUpdate;
+	bool m_bUsesNoise;
+	// Versions of CombinerInfo state blocks, which uniforms were last calculated from.
+	u32 m_stateVersions[CombinerInfo::sbTotal];
 };
 
 void InitShaderCombiner();
@@ -86,20 +86,25 @@ typedef unsigned char boolean;
 
 #define DEPOSTERIZE         0x00001000
 
+#define COMPRESSION_MASK    0x0000e000 /* GPU texture format for COMPRESS_TEX and COMPRESS_HIRESTEX */
+#define NO_COMPRESSION      0x00000000
+#define S3TC_COMPRESSION    0x00002000 /* BC1 or BC3 */
+#define ETC2_COMPRESSION    0x00004000 /* ETC2 RGB8 or RGBA8 EAC */
+
 #define HIRESTEXTURES_MASK  0x000f0000
 #define NO_HIRESTEXTURES    0x00000000
 #define GHQ_HIRESTEXTURES   0x00010000
 #define RICE_HIRESTEXTURES  0x00020000
 #define JABO_HIRESTEXTURES  0x00030000
 
-//#define COMPRESS_TEX        0x00100000 // Not used anymore
-//#define COMPRESS_HIRESTEX   0x00200000 // Not used anymore
+#define COMPRESS_TEX        0x00100000
+#define COMPRESS_HIRESTEX   0x00200000
 #define GZ_TEXCACHE         0x00400000
 #define GZ_HIRESTEXCACHE    0x00800000
 #define DUMP_TEXCACHE       0x01000000
 #define DUMP_HIRESTEXCACHE  0x02000000
 #define TILE_HIRESTEX       0x04000000
-#define UNDEFINED_0         0x08000000
+#define LAZY_HIRESTEX       0x08000000 /* index hires texture pack, decode textures on first use */
 #define FORCE16BPP_HIRESTEX 0x10000000
 #define FORCE16BPP_TEX      0x20000000
 #define LET_TEXARTISTS_FLY  0x40000000 /* a little freedom for texture artists */
@@ -241,6 +246,12 @@ txfilter_dmptx(uint8 *src, int width, int height, int rowStridePixel, uint16 gfm
 TAPI boolean TAPIENTRY
 txfilter_reloadhirestex();
 
+/* Fills lut with the lookup table of a shader implementation of the enhancement,
+ * see hq2x_32_lut. Returns the scale, 0 if the enhancement has no lookup table.
+ * lut has 256 * 16 * scale * scale entries, it may be NULL to query the scale only. */
+TAPI int TAPIENTRY
+txfilter_enhancementlut(int enhancement, uint32 *lut);
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,6 +25,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <string.h>
 #include "TextureFilters.h"
 #include "TxUtil.h"
+#include "TxThreadPool.h"
 
 /************************************************************************/
 /* 2X filters                                                           */
@@ -743,21 +744,22 @@ void deposterizeV(uint32* data, uint32* out, int w, int h, int l, int u) {
 	}
 }
 
+/* rows in a block of work for pool threads */
+#define FILTER_BLOCK_ROWS 16
+
 static
 void DePosterize(uint32* source, uint32* dest, int width, int height) {
 	uint32 * buf = (uint32*)TxMemBuf::getInstance()->get(3);
-	deposterizeH(source, buf, width, 0, height);
-	deposterizeV(buf, dest, width, height, 0, height);
-	deposterizeH(dest, buf, width, 0, height);
-	deposterizeV(buf, dest, width, height, 0, height);
+	TxThreadPool * pool = TxThreadPool::getInstance();
+	/* every pass reads neighbour rows of the previous one, so passes run one after another */
+	pool->run(height, FILTER_BLOCK_ROWS, [=](unsigned int first, unsigned int last) { deposterizeH(source, buf, width, first, last); });
+	pool->run(height, FILTER_BLOCK_ROWS, [=](unsigned int first, unsigned int last) { deposterizeV(buf, dest, width, height, first, last); });
+	pool->run(height, FILTER_BLOCK_ROWS, [=](unsigned int first, unsigned int last) { deposterizeH(dest, buf, width, first, last); });
+	pool->run(height, FILTER_BLOCK_ROWS, [=](unsigned int first, unsigned int last) { deposterizeV(buf, dest, width, height, first, last); });
 }
 
-void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter) {
-	if (filter & DEPOSTERIZE) {
-		uint32 * tex = (uint32*)TxMemBuf::getInstance()->get(2);
-		DePosterize(src, tex, srcwidth, srcheight);
-		src = tex;
-	}
+static
+void filterBand_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter) {
 	switch (filter & ENHANCEMENT_MASK) {
 	case BRZ2X_ENHANCEMENT:
 		xbrz::scale(2, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR);
@@ -810,3 +812,42 @@ void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, u
 	return;
 	}
 }
+
+void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter) {
+	if (filter & DEPOSTERIZE) {
+		uint32 * tex = (uint32*)TxMemBuf::getInstance()->get(2);
+		DePosterize(src, tex, srcwidth, srcheight);
+		src = tex;
+	}
+
+	TxThreadPool * pool = TxThreadPool::getInstance();
+	const uint32 enhancement = filter & ENHANCEMENT_MASK;
+	if (enhancement >= BRZ2X_ENHANCEMENT && enhancement <= BRZ6X_ENHANCEMENT) {
+		/* xBRZ scales slices of the whole image, so blocks do not make seams */
+		const size_t scale = ((enhancement - BRZ2X_ENHANCEMENT) >> 8) + 2;
+		pool->run(srcheight, FILTER_BLOCK_ROWS, [=](unsigned int first, unsigned int last) {
+			xbrz::scale(scale, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR,
+						xbrz::ScalerCfg(), first, last);
+		});
+		return;
+	}
+
+	/* other filters process horizontal bands as separate images,
+	 * so the image is split into one band per thread to keep the number of band edges low */
+	const uint32 scale = enhancement == HQ4X_ENHANCEMENT ? 4 : (enhancement != NO_ENHANCEMENT ? 2 : 1);
+	uint32 numBands = pool->getNumThreads();
+	if (numBands > (srcheight >> 2))
+		numBands = srcheight >> 2;
+	if (numBands < 2) {
+		filterBand_8888(src, srcwidth, srcheight, dest, filter);
+		return;
+	}
+	const uint32 blkheight = ((srcheight >> 2) / numBands) << 2;
+	pool->run(numBands, 1, [=](unsigned int first, unsigned int last) {
+		for (unsigned int band = first; band < last; band++) {
+			const uint32 height = band == numBands - 1 ? srcheight - blkheight * band : blkheight;
+			filterBand_8888(src + srcwidth * blkheight * band, srcwidth, height,
+							dest + srcwidth * blkheight * band * scale * scale, filter);
+		}
+	});
+}
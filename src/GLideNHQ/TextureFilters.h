@@ -47,6 +47,17 @@ void Super2xSaI_8888(uint32 *srcPtr, uint32 *destPtr, uint32 width, uint32 heigh
 
 void Texture2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height);
 
+/* Lookup tables of the hq2x and hq4x switch tables, for shader implementations.
+ * Entry (pattern << 4 | flags) * scale * scale + y * scale + x gives output pixel (x, y)
+ * of a source pixel with the neighbour pattern and edge flags of the switch tables.
+ * Flag bit 0..3 is set when the neighbours top and right, right and bottom,
+ * bottom and left, left and top differ. An entry has up to three 9 bit terms:
+ * neighbour index (0..8, row by row, center is 4) << 5 | weight in 1/16.
+ * Output color is the weighted sum of the neighbours / 16, rounded down per channel. */
+#define HQ_LUT_TERM(t, p, w) ((uint32)(((p) << 5) | (w)) << (9 * (t)))
+void hq2x_32_lut(uint32 *lut);
+void hq4x_8888_lut(uint32 *lut);
+
 /* filters */
 void SharpFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter);
 
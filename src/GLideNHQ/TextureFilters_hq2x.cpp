@@ -23,7 +23,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 /* 2007 Mudlord - Added hq2xS lq2xS filters */
 
+#include <stdlib.h>
 #include "TextureFilters.h"
+#include "TextureFilters_simd.h"
 
 /************************************************************************/
 /* hq2x filters                                                         */
@@ -523,9 +525,11 @@ static void hq2xS_16_def(uint16* dst0, uint16* dst1, const uint16* src0, const u
 }
 #endif /* !_16BPP_HACK */
 
-static void hq2x_32_def(uint32* dst0, uint32* dst1, const uint32* src0, const uint32* src1, const uint32* src2, unsigned count)
+static void hq2x_32_def(uint32* dst0, uint32* dst1, const uint32* src0, const uint32* src1, const uint32* src2, unsigned count, uint8* pattern)
 {
   unsigned i;
+  /* pixels [1, simdEnd) are classified by the vector unit */
+  const unsigned simdEnd = pattern != NULL ? hq2x_32_pattern(src0, src1, src2, pattern, count) : 1;
 
   for(i=0;i<count;++i) {
 	unsigned char mask;
@@ -556,24 +560,28 @@ static void hq2x_32_def(uint32* dst0, uint32* dst1, const uint32* src0, const ui
 	  c[8] = src2[0];
 	}
 
-	mask = 0;
+	if (i > 0 && i < simdEnd) {
+	  mask = pattern[i];
+	} else {
+	  mask = 0;
 
-	if (hq2x_interp_32_diff(c[0], c[4]))
-	  mask |= 1 << 0;
-	if (hq2x_interp_32_diff(c[1], c[4]))
-	  mask |= 1 << 1;
-	if (hq2x_interp_32_diff(c[2], c[4]))
-	  mask |= 1 << 2;
-	if (hq2x_interp_32_diff(c[3], c[4]))
-	  mask |= 1 << 3;
-	if (hq2x_interp_32_diff(c[5], c[4]))
-	  mask |= 1 << 4;
-	if (hq2x_interp_32_diff(c[6], c[4]))
-	  mask |= 1 << 5;
-	if (hq2x_interp_32_diff(c[7], c[4]))
-	  mask |= 1 << 6;
-	if (hq2x_interp_32_diff(c[8], c[4]))
-	  mask |= 1 << 7;
+	  if (hq2x_interp_32_diff(c[0], c[4]))
+		mask |= 1 << 0;
+	  if (hq2x_interp_32_diff(c[1], c[4]))
+		mask |= 1 << 1;
+	  if (hq2x_interp_32_diff(c[2], c[4]))
+		mask |= 1 << 2;
+	  if (hq2x_interp_32_diff(c[3], c[4]))
+		mask |= 1 << 3;
+	  if (hq2x_interp_32_diff(c[5], c[4]))
+		mask |= 1 << 4;
+	  if (hq2x_interp_32_diff(c[6], c[4]))
+		mask |= 1 << 5;
+	  if (hq2x_interp_32_diff(c[7], c[4]))
+		mask |= 1 << 6;
+	  if (hq2x_interp_32_diff(c[8], c[4]))
+		mask |= 1 << 7;
+	}
 
 #define P0 dst0[0]
 #define P1 dst0[1]
@@ -1323,8 +1331,14 @@ void hq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int
 
   int count;
 
-  hq2x_32_def(dst0, dst1, src0, src0, src1, width);
-  if( height == 1 ) return;
+  /* neighbour patterns of one row */
+  uint8 *pattern = (uint8 *)malloc(width);
+
+  hq2x_32_def(dst0, dst1, src0, src0, src1, width, pattern);
+  if( height == 1 ) {
+	free(pattern);
+	return;
+  }
 
   count = height;
 
@@ -1332,7 +1346,7 @@ void hq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int
   while(count>0) {
 	dst0 += dstPitch >> 1;
 	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src2, width);
+	hq2x_32_def(dst0, dst1, src0, src1, src2, width, pattern);
 	src0 = src1;
 	src1 = src2;
 	src2 += srcPitch >> 2;
@@ -1340,7 +1354,69 @@ void hq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int
   }
   dst0 += dstPitch >> 1;
   dst1 += dstPitch >> 1;
-  hq2x_32_def(dst0, dst1, src0, src1, src1, width);
+  hq2x_32_def(dst0, dst1, src0, src1, src1, width, pattern);
+  free(pattern);
+}
+
+void hq2x_32_lut(uint32 *lut)
+{
+  unsigned mask, flags;
+
+  for(mask=0;mask<256;++mask) {
+	for(flags=0;flags<16;++flags) {
+	  uint32 *dst = lut + ((mask << 4) | flags) * 4;
+
+#define P0 dst[0]
+#define P1 dst[1]
+#define P2 dst[2]
+#define P3 dst[3]
+#define HQ2X_MUR ((flags & 1) != 0)
+#define HQ2X_MDR ((flags & 2) != 0)
+#define HQ2X_MDL ((flags & 4) != 0)
+#define HQ2X_MUL ((flags & 8) != 0)
+#define IC(p0) HQ_LUT_TERM(0, p0, 16)
+#define I11(p0,p1) (HQ_LUT_TERM(0, p0, 8) | HQ_LUT_TERM(1, p1, 8))
+#define I211(p0,p1,p2) (HQ_LUT_TERM(0, p0, 8) | HQ_LUT_TERM(1, p1, 4) | HQ_LUT_TERM(2, p2, 4))
+#define I31(p0,p1) (HQ_LUT_TERM(0, p0, 12) | HQ_LUT_TERM(1, p1, 4))
+#define I332(p0,p1,p2) (HQ_LUT_TERM(0, p0, 6) | HQ_LUT_TERM(1, p1, 6) | HQ_LUT_TERM(2, p2, 4))
+#define I431(p0,p1,p2) (HQ_LUT_TERM(0, p0, 8) | HQ_LUT_TERM(1, p1, 6) | HQ_LUT_TERM(2, p2, 2))
+#define I521(p0,p1,p2) (HQ_LUT_TERM(0, p0, 10) | HQ_LUT_TERM(1, p1, 4) | HQ_LUT_TERM(2, p2, 2))
+#define I53(p0,p1) (HQ_LUT_TERM(0, p0, 10) | HQ_LUT_TERM(1, p1, 6))
+#define I611(p0,p1,p2) (HQ_LUT_TERM(0, p0, 12) | HQ_LUT_TERM(1, p1, 2) | HQ_LUT_TERM(2, p2, 2))
+#define I71(p0,p1) (HQ_LUT_TERM(0, p0, 14) | HQ_LUT_TERM(1, p1, 2))
+#define I772(p0,p1,p2) (HQ_LUT_TERM(0, p0, 7) | HQ_LUT_TERM(1, p1, 7) | HQ_LUT_TERM(2, p2, 2))
+#define I97(p0,p1) (HQ_LUT_TERM(0, p0, 9) | HQ_LUT_TERM(1, p1, 7))
+#define I1411(p0,p1,p2) (HQ_LUT_TERM(0, p0, 14) | HQ_LUT_TERM(1, p1, 1) | HQ_LUT_TERM(2, p2, 1))
+#define I151(p0,p1) (HQ_LUT_TERM(0, p0, 15) | HQ_LUT_TERM(1, p1, 1))
+
+	  switch (mask) {
+#include "TextureFilters_hq2x.h"
+	  }
+
+#undef P0
+#undef P1
+#undef P2
+#undef P3
+#undef HQ2X_MUR
+#undef HQ2X_MDR
+#undef HQ2X_MDL
+#undef HQ2X_MUL
+#undef IC
+#undef I11
+#undef I211
+#undef I31
+#undef I332
+#undef I431
+#undef I521
+#undef I53
+#undef I611
+#undef I71
+#undef I772
+#undef I97
+#undef I1411
+#undef I151
+	}
+  }
 }
 
 void hq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
@@ -1445,8 +1521,14 @@ void lq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int
 
   int count;
 
+  /* neighbour patterns of one row */
+  uint8 *pattern = (uint8 *)malloc(width);
+
   lq2x_32_def(dst0, dst1, src0, src0, src1, width);
-  if( height == 1 ) return;
+  if( height == 1 ) {
+	free(pattern);
+	return;
+  }
 
   count = height;
 
@@ -1454,7 +1536,7 @@ void lq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int
   while(count>0) {
 	dst0 += dstPitch >> 1;
 	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src2, width);
+	hq2x_32_def(dst0, dst1, src0, src1, src2, width, pattern);
 	src0 = src1;
 	src1 = src2;
 	src2 += srcPitch >> 2;
@@ -1463,6 +1545,7 @@ void lq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int
   dst0 += dstPitch >> 1;
   dst1 += dstPitch >> 1;
   lq2x_32_def(dst0, dst1, src0, src1, src1, width);
+  free(pattern);
 }
 
 void lq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
@@ -1476,8 +1559,14 @@ void lq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 
   int count;
 
+  /* neighbour patterns of one row */
+  uint8 *pattern = (uint8 *)malloc(width);
+
   lq2xS_32_def(dst0, dst1, src0, src0, src1, width);
-  if( height == 1 ) return;
+  if( height == 1 ) {
+	free(pattern);
+	return;
+  }
 
   count = height;
 
@@ -1485,7 +1574,7 @@ void lq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
   while(count>0) {
 	dst0 += dstPitch >> 1;
 	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src2, width);
+	hq2x_32_def(dst0, dst1, src0, src1, src2, width, pattern);
 	src0 = src1;
 	src1 = src2;
 	src2 += srcPitch >> 2;
@@ -1494,6 +1583,7 @@ void lq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
   dst0 += dstPitch >> 1;
   dst1 += dstPitch >> 1;
   lq2xS_32_def(dst0, dst1, src0, src1, src1, width);
+  free(pattern);
 }
 
 /************************************************************************/
@@ -26,6 +26,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include "TextureFilters.h"
+#include "TextureFilters_simd.h"
 
 #if !_16BPP_HACK
 static uint32 RGB444toYUV[4096];
@@ -713,6 +714,10 @@ void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, in
 
   int YUV1, YUV2;
 
+  /* neighbour patterns of one row */
+  uint8 *patterns = (uint8 *)malloc(Xres);
+  unsigned int simdEnd;
+
   //   +----+----+----+
   //   |    |    |    |
   //   | w1 | w2 | w3 |
@@ -728,6 +733,9 @@ void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, in
 	if (j>0)      prevline = -SrcPPL*4; else prevline = 0;
 	if (j<Yres-1) nextline =  SrcPPL*4; else nextline = 0;
 
+	/* pixels [1, simdEnd) are classified by the vector unit */
+	simdEnd = patterns != NULL ? hq4x_8888_pattern((uint32*)(pIn + prevline), (uint32*)pIn, (uint32*)(pIn + nextline), patterns, Xres) : 1;
+
 	for (i=0; i<Xres; i++) {
 	  w[2] = *((uint32*)(pIn + prevline));
 	  w[5] = *((uint32*)pIn);
@@ -753,22 +761,26 @@ void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, in
 		w[9] = w[8];
 	  }
 
-	  pattern = 0;
-	  flag = 1;
-
-	  YUV1 = RGB888toYUV(w[5]);
-
-	  for (k=1; k<=9; k++) {
-		if (k==5) continue;
-
-		if ( w[k] != w[5] ) {
-		  YUV2 = RGB888toYUV(w[k]);
-		  if ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
-			   ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
-			   ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) )
-			pattern |= flag;
+	  if (i > 0 && (unsigned int)i < simdEnd) {
+		pattern = patterns[i];
+	  } else {
+		pattern = 0;
+		flag = 1;
+
+		YUV1 = RGB888toYUV(w[5]);
+
+		for (k=1; k<=9; k++) {
+		  if (k==5) continue;
+
+		  if ( w[k] != w[5] ) {
+			YUV2 = RGB888toYUV(w[k]);
+			if ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
+				 ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
+				 ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) )
+			  pattern |= flag;
+		  }
+		  flag <<= 1;
 		}
-		flag <<= 1;
 	  }
 
 	  for (k=1; k<=9; k++)
@@ -787,6 +799,8 @@ void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, in
 	pOut+=BpL;
   }
 
+  free(patterns);
+
 #undef BPP
 #undef BPP2
 #undef BPP3
@@ -801,6 +815,97 @@ void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, in
 #undef hq4x_Interp8
 }
 
+/* lookup table: c[] and w[] hold "copy neighbour" lut terms instead of colors */
+static void hq4x_lut_Interp1(uint8 * pc, uint32 p1, uint32 p2)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 12) | HQ_LUT_TERM(1, p2 >> 5, 4);
+}
+
+static void hq4x_lut_Interp2(uint8 * pc, uint32 p1, uint32 p2, uint32 p3)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 8) | HQ_LUT_TERM(1, p2 >> 5, 4) | HQ_LUT_TERM(2, p3 >> 5, 4);
+}
+
+static void hq4x_lut_Interp3(uint8 * pc, uint32 p1, uint32 p2)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 14) | HQ_LUT_TERM(1, p2 >> 5, 2);
+}
+
+static void hq4x_lut_Interp5(uint8 * pc, uint32 p1, uint32 p2)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 8) | HQ_LUT_TERM(1, p2 >> 5, 8);
+}
+
+static void hq4x_lut_Interp6(uint8 * pc, uint32 p1, uint32 p2, uint32 p3)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 10) | HQ_LUT_TERM(1, p2 >> 5, 4) | HQ_LUT_TERM(2, p3 >> 5, 2);
+}
+
+static void hq4x_lut_Interp7(uint8 * pc, uint32 p1, uint32 p2, uint32 p3)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 12) | HQ_LUT_TERM(1, p2 >> 5, 2) | HQ_LUT_TERM(2, p3 >> 5, 2);
+}
+
+static void hq4x_lut_Interp8(uint8 * pc, uint32 p1, uint32 p2)
+{
+  *((uint32*)pc) = HQ_LUT_TERM(0, p1 >> 5, 10) | HQ_LUT_TERM(1, p2 >> 5, 6);
+}
+
+/* the switch table compares the edge neighbours clockwise: 2-6, 6-8, 8-4, 4-2 */
+static int hq4x_lut_Diff(int flags, uint32 w1, uint32 w2)
+{
+  switch (w1 >> 5) {
+  case 1: return flags & 1;
+  case 5: return flags & 2;
+  case 7: return flags & 4;
+  }
+  return flags & 8;
+}
+
+void hq4x_8888_lut(uint32 *lut)
+{
+#define hq4x_Interp1 hq4x_lut_Interp1
+#define hq4x_Interp2 hq4x_lut_Interp2
+#define hq4x_Interp3 hq4x_lut_Interp3
+#define hq4x_Interp5 hq4x_lut_Interp5
+#define hq4x_Interp6 hq4x_lut_Interp6
+#define hq4x_Interp7 hq4x_lut_Interp7
+#define hq4x_Interp8 hq4x_lut_Interp8
+#define Diff(w1, w2) hq4x_lut_Diff(flags, w1, w2)
+#define BPP  4
+#define BPP2 8
+#define BPP3 12
+
+  const int BpL = 16;
+  int  k;
+  int  pattern, flags;
+  uint32  w[10];
+  uint32  c[10];
+
+  for (k=1; k<=9; k++)
+	c[k] = w[k] = HQ_LUT_TERM(0, k - 1, 16);
+
+  for (pattern = 0; pattern < 256; pattern++) {
+	for (flags = 0; flags < 16; flags++) {
+	  unsigned char * pOut = (unsigned char *)(lut + ((pattern << 4) | flags) * 16);
+
+#include "TextureFilters_hq4x.h"
+	}
+  }
+
+#undef BPP
+#undef BPP2
+#undef BPP3
+#undef Diff
+#undef hq4x_Interp1
+#undef hq4x_Interp2
+#undef hq4x_Interp3
+#undef hq4x_Interp5
+#undef hq4x_Interp6
+#undef hq4x_Interp7
+#undef hq4x_Interp8
+}
+
 #if !_16BPP_HACK
 void hq4x_init(void)
 {
@@ -0,0 +1,386 @@
+/*
+ * Texture Filtering
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Make; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* Vector versions of the hq2x and hq4x neighbour classification.
+ * Each lane evaluates the same integer expressions as the scalar diff
+ * functions, so the patterns are identical to the scalar ones.
+ * x86 kernels are compiled for their instruction set with function
+ * attributes and picked at runtime, so no special build flags are needed. */
+
+#include <string.h>
+#include "TextureFilters_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#define SIMD_TARGET(isa)
+#else
+#include <immintrin.h>
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_ARM
+#include <arm_neon.h>
+#endif
+
+/* hq2x_interp_32_diff limits */
+#define HQ2X_Y_LIMIT (0x30*4)
+#define HQ2X_U_LIMIT (0x07*4)
+#define HQ2X_V_LIMIT (0x06*8)
+#define HQ2X_EQUAL_MASK 0xF8F8F8
+
+/* Diff_888 limits */
+#define HQ4X_Y_LIMIT 0x30
+#define HQ4X_U_LIMIT 0x07
+#define HQ4X_V_LIMIT 0x06
+
+#ifdef SIMD_X86
+static bool cpuHasSse41()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.1") != 0;
+#endif
+}
+
+static bool cpuHasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	/* AVX and OS support for saving ymm registers */
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+static int simd_detect(void)
+{
+#if defined(SIMD_X86)
+	if (cpuHasAvx2())
+		return SIMD_AVX2;
+	if (cpuHasSse41())
+		return SIMD_SSE41;
+#elif defined(SIMD_ARM)
+	return SIMD_NEON;
+#endif
+	return SIMD_NONE;
+}
+
+static const int s_supportedLevel = simd_detect();
+static int s_level = s_supportedLevel;
+
+int simd_getLevel(void)
+{
+	return s_level;
+}
+
+void simd_setLevel(int level)
+{
+	if (level > s_supportedLevel || (level == SIMD_NEON && s_supportedLevel != SIMD_NEON))
+		level = SIMD_NONE;
+	s_level = level;
+}
+
+#ifdef SIMD_X86
+
+/* SSE4.1, 4 pixels */
+
+struct Hq2xDiff_sse41
+{
+	SIMD_TARGET("sse4.1")
+	static inline __m128i diff(__m128i n, __m128i c)
+	{
+		const __m128i mask = _mm_set1_epi32(HQ2X_EQUAL_MASK);
+		const __m128i same = _mm_cmpeq_epi32(_mm_and_si128(n, mask), _mm_and_si128(c, mask));
+		const __m128i ff = _mm_set1_epi32(0xFF);
+		const __m128i r = _mm_sub_epi32(_mm_and_si128(n, ff), _mm_and_si128(c, ff));
+		const __m128i g = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(n, 8), ff), _mm_and_si128(_mm_srli_epi32(c, 8), ff));
+		const __m128i b = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(n, 16), ff), _mm_and_si128(_mm_srli_epi32(c, 16), ff));
+		const __m128i y = _mm_add_epi32(_mm_add_epi32(r, g), b);
+		const __m128i u = _mm_sub_epi32(r, b);
+		const __m128i v = _mm_sub_epi32(_mm_add_epi32(g, g), _mm_add_epi32(r, b));
+		const __m128i differs = _mm_or_si128(_mm_or_si128(
+			_mm_cmpgt_epi32(_mm_abs_epi32(y), _mm_set1_epi32(HQ2X_Y_LIMIT)),
+			_mm_cmpgt_epi32(_mm_abs_epi32(u), _mm_set1_epi32(HQ2X_U_LIMIT))),
+			_mm_cmpgt_epi32(_mm_abs_epi32(v), _mm_set1_epi32(HQ2X_V_LIMIT)));
+		return _mm_andnot_si128(same, differs);
+	}
+};
+
+struct Hq4xDiff_sse41
+{
+	SIMD_TARGET("sse4.1")
+	static inline void yuv(__m128i p, __m128i &y, __m128i &u, __m128i &v)
+	{
+		const __m128i ff = _mm_set1_epi32(0xFF);
+		const __m128i r = _mm_and_si128(p, ff);
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(p, 8), ff);
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), ff);
+		y = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(r, g), b), 2);
+		u = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_set1_epi32(0x200), r), b), 2);
+		v = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_set1_epi32(0x400), _mm_add_epi32(g, g)), _mm_add_epi32(r, b)), 3);
+	}
+
+	SIMD_TARGET("sse4.1")
+	static inline __m128i diff(__m128i n, __m128i c)
+	{
+		__m128i yn, un, vn, yc, uc, vc;
+		yuv(n, yn, un, vn);
+		yuv(c, yc, uc, vc);
+		return _mm_or_si128(_mm_or_si128(
+			_mm_cmpgt_epi32(_mm_abs_epi32(_mm_sub_epi32(yn, yc)), _mm_set1_epi32(HQ4X_Y_LIMIT)),
+			_mm_cmpgt_epi32(_mm_abs_epi32(_mm_sub_epi32(un, uc)), _mm_set1_epi32(HQ4X_U_LIMIT))),
+			_mm_cmpgt_epi32(_mm_abs_epi32(_mm_sub_epi32(vn, vc)), _mm_set1_epi32(HQ4X_V_LIMIT)));
+	}
+};
+
+template <class Diff>
+SIMD_TARGET("sse4.1")
+static unsigned int pattern_sse41(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int i, unsigned int count)
+{
+#define LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define BIT(n, c, bit) _mm_and_si128(Diff::diff(n, c), _mm_set1_epi32(1 << bit))
+	for (; i + 4 < count; i += 4) {
+		const __m128i c = LOAD(cur + i);
+		__m128i pat = BIT(LOAD(prev + i - 1), c, 0);
+		pat = _mm_or_si128(pat, BIT(LOAD(prev + i), c, 1));
+		pat = _mm_or_si128(pat, BIT(LOAD(prev + i + 1), c, 2));
+		pat = _mm_or_si128(pat, BIT(LOAD(cur + i - 1), c, 3));
+		pat = _mm_or_si128(pat, BIT(LOAD(cur + i + 1), c, 4));
+		pat = _mm_or_si128(pat, BIT(LOAD(next + i - 1), c, 5));
+		pat = _mm_or_si128(pat, BIT(LOAD(next + i), c, 6));
+		pat = _mm_or_si128(pat, BIT(LOAD(next + i + 1), c, 7));
+		pat = _mm_packus_epi32(pat, pat);
+		pat = _mm_packus_epi16(pat, pat);
+		const uint32 bytes = (uint32)_mm_cvtsi128_si32(pat);
+		memcpy(pattern + i, &bytes, 4);
+	}
+#undef BIT
+#undef LOAD
+	return i;
+}
+
+/* AVX2, 8 pixels */
+
+struct Hq2xDiff_avx2
+{
+	SIMD_TARGET("avx2")
+	static inline __m256i diff(__m256i n, __m256i c)
+	{
+		const __m256i mask = _mm256_set1_epi32(HQ2X_EQUAL_MASK);
+		const __m256i same = _mm256_cmpeq_epi32(_mm256_and_si256(n, mask), _mm256_and_si256(c, mask));
+		const __m256i ff = _mm256_set1_epi32(0xFF);
+		const __m256i r = _mm256_sub_epi32(_mm256_and_si256(n, ff), _mm256_and_si256(c, ff));
+		const __m256i g = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(n, 8), ff), _mm256_and_si256(_mm256_srli_epi32(c, 8), ff));
+		const __m256i b = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(n, 16), ff), _mm256_and_si256(_mm256_srli_epi32(c, 16), ff));
+		const __m256i y = _mm256_add_epi32(_mm256_add_epi32(r, g), b);
+		const __m256i u = _mm256_sub_epi32(r, b);
+		const __m256i v = _mm256_sub_epi32(_mm256_add_epi32(g, g), _mm256_add_epi32(r, b));
+		const __m256i differs = _mm256_or_si256(_mm256_or_si256(
+			_mm256_cmpgt_epi32(_mm256_abs_epi32(y), _mm256_set1_epi32(HQ2X_Y_LIMIT)),
+			_mm256_cmpgt_epi32(_mm256_abs_epi32(u), _mm256_set1_epi32(HQ2X_U_LIMIT))),
+			_mm256_cmpgt_epi32(_mm256_abs_epi32(v), _mm256_set1_epi32(HQ2X_V_LIMIT)));
+		return _mm256_andnot_si256(same, differs);
+	}
+};
+
+struct Hq4xDiff_avx2
+{
+	SIMD_TARGET("avx2")
+	static inline void yuv(__m256i p, __m256i &y, __m256i &u, __m256i &v)
+	{
+		const __m256i ff = _mm256_set1_epi32(0xFF);
+		const __m256i r = _mm256_and_si256(p, ff);
+		const __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 8), ff);
+		const __m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 16), ff);
+		y = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(r, g), b), 2);
+		u = _mm256_srli_epi32(_mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(0x200), r), b), 2);
+		v = _mm256_srli_epi32(_mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(0x400), _mm256_add_epi32(g, g)), _mm256_add_epi32(r, b)), 3);
+	}
+
+	SIMD_TARGET("avx2")
+	static inline __m256i diff(__m256i n, __m256i c)
+	{
+		__m256i yn, un, vn, yc, uc, vc;
+		yuv(n, yn, un, vn);
+		yuv(c, yc, uc, vc);
+		return _mm256_or_si256(_mm256_or_si256(
+			_mm256_cmpgt_epi32(_mm256_abs_epi32(_mm256_sub_epi32(yn, yc)), _mm256_set1_epi32(HQ4X_Y_LIMIT)),
+			_mm256_cmpgt_epi32(_mm256_abs_epi32(_mm256_sub_epi32(un, uc)), _mm256_set1_epi32(HQ4X_U_LIMIT))),
+			_mm256_cmpgt_epi32(_mm256_abs_epi32(_mm256_sub_epi32(vn, vc)), _mm256_set1_epi32(HQ4X_V_LIMIT)));
+	}
+};
+
+template <class Diff, class Diff128>
+SIMD_TARGET("avx2")
+static unsigned int pattern_avx2(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int count)
+{
+#define LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define BIT(n, c, bit) _mm256_and_si256(Diff::diff(n, c), _mm256_set1_epi32(1 << bit))
+	unsigned int i = 1;
+	for (; i + 8 < count; i += 8) {
+		const __m256i c = LOAD(cur + i);
+		__m256i pat = BIT(LOAD(prev + i - 1), c, 0);
+		pat = _mm256_or_si256(pat, BIT(LOAD(prev + i), c, 1));
+		pat = _mm256_or_si256(pat, BIT(LOAD(prev + i + 1), c, 2));
+		pat = _mm256_or_si256(pat, BIT(LOAD(cur + i - 1), c, 3));
+		pat = _mm256_or_si256(pat, BIT(LOAD(cur + i + 1), c, 4));
+		pat = _mm256_or_si256(pat, BIT(LOAD(next + i - 1), c, 5));
+		pat = _mm256_or_si256(pat, BIT(LOAD(next + i), c, 6));
+		pat = _mm256_or_si256(pat, BIT(LOAD(next + i + 1), c, 7));
+		/* packs work within 128 bit lanes: pixels 0-3 end up in the low lane, 4-7 in the high one */
+		pat = _mm256_packus_epi32(pat, pat);
+		pat = _mm256_packus_epi16(pat, pat);
+		const uint32 lo = (uint32)_mm_cvtsi128_si32(_mm256_castsi256_si128(pat));
+		const uint32 hi = (uint32)_mm_cvtsi128_si32(_mm256_extracti128_si256(pat, 1));
+		memcpy(pattern + i, &lo, 4);
+		memcpy(pattern + i + 4, &hi, 4);
+	}
+#undef BIT
+#undef LOAD
+	return pattern_sse41<Diff128>(prev, cur, next, pattern, i, count);
+}
+
+#endif /* SIMD_X86 */
+
+#ifdef SIMD_ARM
+
+/* NEON, 4 pixels */
+
+struct Hq2xDiff_neon
+{
+	static inline uint32x4_t diff(uint32x4_t n, uint32x4_t c)
+	{
+		const uint32x4_t mask = vdupq_n_u32(HQ2X_EQUAL_MASK);
+		const uint32x4_t same = vceqq_u32(vandq_u32(n, mask), vandq_u32(c, mask));
+		const uint32x4_t ff = vdupq_n_u32(0xFF);
+		const int32x4_t r = vsubq_s32(vreinterpretq_s32_u32(vandq_u32(n, ff)), vreinterpretq_s32_u32(vandq_u32(c, ff)));
+		const int32x4_t g = vsubq_s32(vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(n, 8), ff)), vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(c, 8), ff)));
+		const int32x4_t b = vsubq_s32(vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(n, 16), ff)), vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(c, 16), ff)));
+		const int32x4_t y = vaddq_s32(vaddq_s32(r, g), b);
+		const int32x4_t u = vsubq_s32(r, b);
+		const int32x4_t v = vsubq_s32(vaddq_s32(g, g), vaddq_s32(r, b));
+		const uint32x4_t differs = vorrq_u32(vorrq_u32(
+			vcgtq_s32(vabsq_s32(y), vdupq_n_s32(HQ2X_Y_LIMIT)),
+			vcgtq_s32(vabsq_s32(u), vdupq_n_s32(HQ2X_U_LIMIT))),
+			vcgtq_s32(vabsq_s32(v), vdupq_n_s32(HQ2X_V_LIMIT)));
+		return vbicq_u32(differs, same);
+	}
+};
+
+struct Hq4xDiff_neon
+{
+	static inline void yuv(uint32x4_t p, int32x4_t &y, int32x4_t &u, int32x4_t &v)
+	{
+		const uint32x4_t ff = vdupq_n_u32(0xFF);
+		const uint32x4_t r = vandq_u32(p, ff);
+		const uint32x4_t g = vandq_u32(vshrq_n_u32(p, 8), ff);
+		const uint32x4_t b = vandq_u32(vshrq_n_u32(p, 16), ff);
+		y = vreinterpretq_s32_u32(vshrq_n_u32(vaddq_u32(vaddq_u32(r, g), b), 2));
+		u = vreinterpretq_s32_u32(vshrq_n_u32(vsubq_u32(vaddq_u32(vdupq_n_u32(0x200), r), b), 2));
+		v = vreinterpretq_s32_u32(vshrq_n_u32(vsubq_u32(vaddq_u32(vdupq_n_u32(0x400), vaddq_u32(g, g)), vaddq_u32(r, b)), 3));
+	}
+
+	static inline uint32x4_t diff(uint32x4_t n, uint32x4_t c)
+	{
+		int32x4_t yn, un, vn, yc, uc, vc;
+		yuv(n, yn, un, vn);
+		yuv(c, yc, uc, vc);
+		return vorrq_u32(vorrq_u32(
+			vcgtq_s32(vabdq_s32(yn, yc), vdupq_n_s32(HQ4X_Y_LIMIT)),
+			vcgtq_s32(vabdq_s32(un, uc), vdupq_n_s32(HQ4X_U_LIMIT))),
+			vcgtq_s32(vabdq_s32(vn, vc), vdupq_n_s32(HQ4X_V_LIMIT)));
+	}
+};
+
+template <class Diff>
+static unsigned int pattern_neon(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int count)
+{
+#define LOAD(p) vld1q_u32((const uint32_t*)(p))
+#define BIT(n, c, bit) vandq_u32(Diff::diff(n, c), vdupq_n_u32(1 << bit))
+	unsigned int i = 1;
+	for (; i + 4 < count; i += 4) {
+		const uint32x4_t c = LOAD(cur + i);
+		uint32x4_t pat = BIT(LOAD(prev + i - 1), c, 0);
+		pat = vorrq_u32(pat, BIT(LOAD(prev + i), c, 1));
+		pat = vorrq_u32(pat, BIT(LOAD(prev + i + 1), c, 2));
+		pat = vorrq_u32(pat, BIT(LOAD(cur + i - 1), c, 3));
+		pat = vorrq_u32(pat, BIT(LOAD(cur + i + 1), c, 4));
+		pat = vorrq_u32(pat, BIT(LOAD(next + i - 1), c, 5));
+		pat = vorrq_u32(pat, BIT(LOAD(next + i), c, 6));
+		pat = vorrq_u32(pat, BIT(LOAD(next + i + 1), c, 7));
+		const uint16x4_t pat16 = vmovn_u32(pat);
+		const uint8x8_t pat8 = vmovn_u16(vcombine_u16(pat16, pat16));
+		const uint32 bytes = vget_lane_u32(vreinterpret_u32_u8(pat8), 0);
+		memcpy(pattern + i, &bytes, 4);
+	}
+#undef BIT
+#undef LOAD
+	return i;
+}
+
+#endif /* SIMD_ARM */
+
+unsigned int hq2x_32_pattern(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int count)
+{
+	switch (s_level) {
+#ifdef SIMD_X86
+	case SIMD_AVX2:
+		return pattern_avx2<Hq2xDiff_avx2, Hq2xDiff_sse41>(prev, cur, next, pattern, count);
+	case SIMD_SSE41:
+		return pattern_sse41<Hq2xDiff_sse41>(prev, cur, next, pattern, 1, count);
+#endif
+#ifdef SIMD_ARM
+	case SIMD_NEON:
+		return pattern_neon<Hq2xDiff_neon>(prev, cur, next, pattern, count);
+#endif
+	}
+	return 1;
+}
+
+unsigned int hq4x_8888_pattern(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int count)
+{
+	switch (s_level) {
+#ifdef SIMD_X86
+	case SIMD_AVX2:
+		return pattern_avx2<Hq4xDiff_avx2, Hq4xDiff_sse41>(prev, cur, next, pattern, count);
+	case SIMD_SSE41:
+		return pattern_sse41<Hq4xDiff_sse41>(prev, cur, next, pattern, 1, count);
+#endif
+#ifdef SIMD_ARM
+	case SIMD_NEON:
+		return pattern_neon<Hq4xDiff_neon>(prev, cur, next, pattern, count);
+#endif
+	}
+	return 1;
+}
@@ -0,0 +1,49 @@
+/*
+ * Texture Filtering
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Make; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* SIMD kernels for the ARGB8888 enhancement filters */
+
+#ifndef __TEXTUREFILTERS_SIMD_H__
+#define __TEXTUREFILTERS_SIMD_H__
+
+#include "TxInternal.h"
+
+/* instruction sets, in order of preference */
+enum {
+	SIMD_NONE = 0,
+	SIMD_NEON,
+	SIMD_SSE41,
+	SIMD_AVX2
+};
+
+/* best instruction set supported by the compiler and the cpu */
+int simd_getLevel(void);
+/* restrict kernels to the given instruction set, e.g. to compare against scalar code.
+ * Levels the cpu does not support are ignored. */
+void simd_setLevel(int level);
+
+/* Neighbour patterns of a row, as used by the hq2x and hq4x switch tables.
+ * Bit 0..7 of pattern[i] is set when the top left, top, top right, left,
+ * right, bottom left, bottom and bottom right neighbour of cur[i] differs
+ * from it. Only pixels with both horizontal neighbours inside the row are
+ * classified, starting at pixel 1. Returns the end of the classified run:
+ * pattern[1] to pattern[end - 1] are valid, the caller classifies the rest. */
+unsigned int hq2x_32_pattern(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int count);
+unsigned int hq4x_8888_pattern(const uint32 *prev, const uint32 *cur, const uint32 *next, uint8 *pattern, unsigned int count);
+
+#endif /* __TEXTUREFILTERS_SIMD_H__ */
@@ -27,11 +27,27 @@
 
 #include "TxCache.h"
 #include "TxDbg.h"
+#include "TxCodec.h"
 #include <osal_files.h>
 #include <zlib.h>
 #include <memory.h>
 #include <stdlib.h>
 
+/* entries per slab, a power of 2 */
+#define TXCACHE_SLAB_SHIFT 10
+#define TXCACHE_SLAB_ENTRIES (1 << TXCACHE_SLAB_SHIFT)
+/* no entry */
+#define TXCACHE_NIL 0xffffffff
+/* initial hash table size, a power of 2 */
+#define TXCACHE_MIN_SLOTS 64
+
+static inline uint32
+hashChecksum(uint64 checksum)
+{
+	/* texture checksums are CRCs, spread the bits anyway */
+	return (uint32)((checksum * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
 TxCache::~TxCache()
 {
 	/* free memory, clean up, etc */
@@ -49,6 +65,12 @@ TxCache::TxCache(int options, int cachesize, const wchar_t *path, const wchar_t
 	_cacheSize = cachesize;
 	_callback = callback;
 	_totalSize = 0;
+	_count = 0;
+	_freeEntry = TXCACHE_NIL;
+	_lruFirst = TXCACHE_NIL;
+	_lruLast = TXCACHE_NIL;
+	_slots.assign(TXCACHE_MIN_SLOTS, SLOT());
+	_totalSize += TXCACHE_MIN_SLOTS * sizeof(SLOT);
 
 	/* save path name */
 	if (path)
@@ -58,7 +80,7 @@ TxCache::TxCache(int options, int cachesize, const wchar_t *path, const wchar_t
 	if (ident)
 		_ident.assign(ident);
 
-	/* zlib memory buffers to (de)compress hires textures */
+	/* memory buffers to decompress textures */
 	if (_options & (GZ_TEXCACHE|GZ_HIRESTEXCACHE)) {
 		_gzdest0   = TxMemBuf::getInstance()->get(0);
 		_gzdest1   = TxMemBuf::getInstance()->get(1);
@@ -74,15 +96,125 @@ TxCache::TxCache(int options, int cachesize, const wchar_t *path, const wchar_t
 	}
 }
 
+TxCache::TXCACHE *
+TxCache::_entry(uint32 n) const
+{
+	return &_slabs[n >> TXCACHE_SLAB_SHIFT][n & (TXCACHE_SLAB_ENTRIES - 1)];
+}
+
+uint32
+TxCache::_findSlot(uint64 checksum) const
+{
+	/* slot of checksum, or the empty slot it goes to */
+	const uint32 mask = (uint32)_slots.size() - 1;
+	uint32 slot = hashChecksum(checksum) & mask;
+	while (_slots[slot].checksum && _slots[slot].checksum != checksum)
+		slot = (slot + 1) & mask;
+	return slot;
+}
+
+void
+TxCache::_growSlots()
+{
+	std::vector<SLOT> slots(_slots.size() * 2, SLOT());
+	_totalSize += (int)(_slots.size() * sizeof(SLOT));
+	_slots.swap(slots);
+	for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].checksum)
+			_slots[_findSlot(slots[i].checksum)] = slots[i];
+	}
+}
+
+void
+TxCache::_eraseSlot(uint32 slot)
+{
+	/* move following slots of the probe sequence back, no tombstones */
+	const uint32 mask = (uint32)_slots.size() - 1;
+	uint32 next = slot;
+	for (;;) {
+		next = (next + 1) & mask;
+		if (!_slots[next].checksum)
+			break;
+		const uint32 home = hashChecksum(_slots[next].checksum) & mask;
+		/* keep it when its home slot is cyclically in (slot, next] */
+		const boolean keep = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+		if (!keep) {
+			_slots[slot] = _slots[next];
+			slot = next;
+		}
+	}
+	_slots[slot].checksum = 0;
+}
+
+uint32
+TxCache::_newEntry()
+{
+	if (_freeEntry == TXCACHE_NIL) {
+		TXCACHE *slab = new TXCACHE[TXCACHE_SLAB_ENTRIES];
+		const uint32 first = (uint32)_slabs.size() << TXCACHE_SLAB_SHIFT;
+		for (uint32 i = 0; i < TXCACHE_SLAB_ENTRIES; i++)
+			slab[i].next = (i + 1 < TXCACHE_SLAB_ENTRIES) ? first + i + 1 : TXCACHE_NIL;
+		_slabs.push_back(slab);
+		_freeEntry = first;
+		_totalSize += TXCACHE_SLAB_ENTRIES * sizeof(TXCACHE);
+	}
+	const uint32 n = _freeEntry;
+	_freeEntry = _entry(n)->next;
+	return n;
+}
+
+void
+TxCache::_lruLink(uint32 n)
+{
+	/* the most recently used entry is the last */
+	TXCACHE *entry = _entry(n);
+	entry->prev = _lruLast;
+	entry->next = TXCACHE_NIL;
+	if (_lruLast != TXCACHE_NIL)
+		_entry(_lruLast)->next = n;
+	else
+		_lruFirst = n;
+	_lruLast = n;
+}
+
+void
+TxCache::_lruUnlink(uint32 n)
+{
+	TXCACHE *entry = _entry(n);
+	if (entry->prev != TXCACHE_NIL)
+		_entry(entry->prev)->next = entry->next;
+	else
+		_lruFirst = entry->next;
+	if (entry->next != TXCACHE_NIL)
+		_entry(entry->next)->prev = entry->prev;
+	else
+		_lruLast = entry->prev;
+}
+
+void
+TxCache::_remove(uint32 slot)
+{
+	const uint32 n = _slots[slot].entry;
+	TXCACHE *entry = _entry(n);
+	free(entry->info.data);
+	_totalSize -= entry->size;
+	_lruUnlink(n);
+	entry->next = _freeEntry;
+	_freeEntry = n;
+	_eraseSlot(slot);
+	_count--;
+}
+
 boolean
 TxCache::add(uint64 checksum, GHQTexInfo *info, int dataSize)
 {
-	/* NOTE: dataSize must be provided if info->data is zlib compressed. */
+	/* NOTE: dataSize must be provided if info->data is compressed. */
 
 	if (!checksum || !info->data) return 0;
 
 	uint8 *dest = info->data;
 	uint32 format = info->format;
+	uint8 *packed = NULL;
 
 	if (!dataSize) {
 		dataSize = _txUtil->sizeofTx(info->width, info->height, info->format);
@@ -90,94 +222,78 @@ TxCache::add(uint64 checksum, GHQTexInfo *info, int dataSize)
 		if (!dataSize) return 0;
 
 		if (_options & (GZ_TEXCACHE|GZ_HIRESTEXCACHE)) {
-			/* zlib compress it. compression level:1 (best speed) */
-			uLongf destLen = _gzdestLen;
-			dest = (dest == _gzdest0) ? _gzdest1 : _gzdest0;
-			if (compress2(dest, &destLen, info->data, dataSize, 1) != Z_OK) {
-				dest = info->data;
-				DBG_INFO(80, wst("Error: zlib compression failed!\n"));
+			/* LZ4 compress it straight into the memory kept by the cache */
+			packed = (uint8*)malloc(txpack_bound(dataSize));
+			uint32 packedSize = packed ? txpack(info->data, dataSize, packed) : 0;
+			if (!packedSize) {
+				free(packed);
+				packed = NULL;
+				DBG_INFO(80, wst("Error: compression failed!\n"));
 			} else {
-				DBG_INFO(80, wst("zlib compressed: %.02fkb->%.02fkb\n"), (float)dataSize/1000, (float)destLen/1000);
-				dataSize = destLen;
-				format |= GL_TEXFMT_GZ;
+				DBG_INFO(80, wst("compressed: %.02fkb->%.02fkb\n"), (float)dataSize/1000, (float)packedSize/1000);
+				uint8 *shrunk = (uint8*)realloc(packed, packedSize);
+				if (shrunk)
+					packed = shrunk;
+				dest = packed;
+				dataSize = packedSize;
+				format |= GL_TEXFMT_LZ4;
 			}
 		}
 	}
 
-	/* if cache size exceeds limit, remove old cache */
-	if (_cacheSize > 0) {
-		_totalSize += dataSize;
-		if ((_totalSize > _cacheSize) && !_cachelist.empty()) {
-			/* _cachelist is arranged so that frequently used textures are in the back */
-			std::list<uint64>::iterator itList = _cachelist.begin();
-			while (itList != _cachelist.end()) {
-				/* find it in _cache */
-				std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(*itList);
-				if (itMap != _cache.end()) {
-					/* yep we have it. remove it. */
-					_totalSize -= (*itMap).second->size;
-					free((*itMap).second->info.data);
-					delete (*itMap).second;
-					_cache.erase(itMap);
-				}
-				itList++;
+	/* if cache size exceeds limit, remove least recently used textures */
+	if (_cacheSize > 0 && _totalSize + dataSize > _cacheSize && _lruFirst != TXCACHE_NIL) {
+		while (_totalSize + dataSize > _cacheSize && _lruFirst != TXCACHE_NIL)
+			_remove(_findSlot(_entry(_lruFirst)->checksum));
 
-				/* check if memory cache has enough space */
-				if (_totalSize <= _cacheSize)
-					break;
-			}
-			/* remove from _cachelist */
-			_cachelist.erase(_cachelist.begin(), itList);
-
-			DBG_INFO(80, wst("+++++++++\n"));
-		}
-		_totalSize -= dataSize;
+		DBG_INFO(80, wst("+++++++++\n"));
 	}
 
 	/* cache it */
-	uint8 *tmpdata = (uint8*)malloc(dataSize);
+	uint8 *tmpdata = packed ? packed : (uint8*)malloc(dataSize);
 	if (tmpdata) {
-		TXCACHE *txCache = new TXCACHE;
-		if (txCache) {
-			/* we can directly write as we filter, but for now we get away
-	   * with doing memcpy after all the filtering is done.
-	   */
+		/* we can directly write as we filter, but for now we get away
+	 * with doing memcpy after all the filtering is done.
+	 */
+		if (tmpdata != dest)
 			memcpy(tmpdata, dest, dataSize);
 
-			/* copy it */
-			memcpy(&txCache->info, info, sizeof(GHQTexInfo));
-			txCache->info.data = tmpdata;
-			txCache->info.format = format;
-			txCache->size = dataSize;
-
-			/* add to cache */
-			if (_cacheSize > 0) {
-				_cachelist.push_back(checksum);
-				txCache->it = --(_cachelist.end());
-			}
-			/* _cache[checksum] = txCache; */
-			_cache.insert(std::map<uint64, TXCACHE*>::value_type(checksum, txCache));
+		/* keep the table at most 3/4 full */
+		if ((_count + 1) * 4 > _slots.size() * 3)
+			_growSlots();
+		const uint32 slot = _findSlot(checksum);
+		if (_slots[slot].checksum)
+			_remove(slot);
+
+		/* copy it */
+		const uint32 n = _newEntry();
+		TXCACHE *txCache = _entry(n);
+		memcpy(&txCache->info, info, sizeof(GHQTexInfo));
+		txCache->checksum = checksum;
+		txCache->info.data = tmpdata;
+		txCache->info.format = format;
+		txCache->size = dataSize;
+
+		/* add to cache, removing a texture moves slots */
+		const uint32 newSlot = _findSlot(checksum);
+		_slots[newSlot].checksum = checksum;
+		_slots[newSlot].entry = n;
+		_lruLink(n);
+		_count++;
+
+		/* total cache size */
+		_totalSize += dataSize;
 
 #ifdef DEBUG
-			DBG_INFO(80, wst("[%5d] added!! crc:%08X %08X %d x %d gfmt:%x total:%.02fmb\n"),
-					 _cache.size(), (uint32)(checksum >> 32), (uint32)(checksum & 0xffffffff),
-					 info->width, info->height, info->format & 0xffff, (float)_totalSize/1000000);
+		DBG_INFO(80, wst("[%5d] added!! crc:%08X %08X %d x %d gfmt:%x total:%.02fmb\n"),
+				 _count, (uint32)(checksum >> 32), (uint32)(checksum & 0xffffffff),
+				 info->width, info->height, info->format & 0xffff, (float)_totalSize/1000000);
 
-			if (_cacheSize > 0) {
-				DBG_INFO(80, wst("cache max config:%.02fmb\n"), (float)_cacheSize/1000000);
-
-				if (_cache.size() != _cachelist.size()) {
-					DBG_INFO(80, wst("Error: cache/cachelist mismatch! (%d/%d)\n"), _cache.size(), _cachelist.size());
-				}
-			}
+		if (_cacheSize > 0)
+			DBG_INFO(80, wst("cache max config:%.02fmb\n"), (float)_cacheSize/1000000);
 #endif
 
-			/* total cache size */
-			_totalSize += dataSize;
-
-			return 1;
-		}
-		free(tmpdata);
+		return 1;
 	}
 
 	return 0;
@@ -186,32 +302,46 @@ TxCache::add(uint64 checksum, GHQTexInfo *info, int dataSize)
 boolean
 TxCache::get(uint64 checksum, GHQTexInfo *info)
 {
-	if (!checksum || _cache.empty()) return 0;
+	if (!checksum || !_count) return 0;
 
 	/* find a match in cache */
-	std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(checksum);
-	if (itMap != _cache.end()) {
+	const uint32 slot = _findSlot(checksum);
+	if (_slots[slot].checksum) {
 		/* yep, we've got it. */
-		memcpy(info, &(((*itMap).second)->info), sizeof(GHQTexInfo));
+		const uint32 n = _slots[slot].entry;
+		TXCACHE *txCache = _entry(n);
+		memcpy(info, &txCache->info, sizeof(GHQTexInfo));
+
+		/* move it to the back of the list */
+		if (_cacheSize > 0 && n != _lruLast) {
+			_lruUnlink(n);
+			_lruLink(n);
+		}
 
-		/* push it to the back of the list */
-		if (_cacheSize > 0) {
-			_cachelist.erase(((*itMap).second)->it);
-			_cachelist.push_back(checksum);
-			((*itMap).second)->it = --(_cachelist.end());
+		/* LZ4 decompress it, on the thread pool into the buffer the texture is uploaded from */
+		if (info->format & GL_TEXFMT_LZ4) {
+			uint8 *dest = (_gzdest0 == info->data) ? _gzdest1 : _gzdest0;
+			uint32 destLen = _txUtil->sizeofTx(info->width, info->height, (uint16)(info->format & ~GL_TEXFMT_PACKED));
+			if (!dest || destLen > _gzdestLen ||
+				!txunpack(info->data, txCache->size, dest, destLen)) {
+				DBG_INFO(80, wst("Error: decompression failed!\n"));
+				return 0;
+			}
+			info->data = dest;
+			info->format &= ~GL_TEXFMT_LZ4;
 		}
 
 		/* zlib decompress it */
 		if (info->format & GL_TEXFMT_GZ) {
 			uLongf destLen = _gzdestLen;
 			uint8 *dest = (_gzdest0 == info->data) ? _gzdest1 : _gzdest0;
-			if (uncompress(dest, &destLen, info->data, ((*itMap).second)->size) != Z_OK) {
+			if (uncompress(dest, &destLen, info->data, txCache->size) != Z_OK) {
 				DBG_INFO(80, wst("Error: zlib decompression failed!\n"));
 				return 0;
 			}
 			info->data = dest;
 			info->format &= ~GL_TEXFMT_GZ;
-			DBG_INFO(80, wst("zlib decompressed: %.02fkb->%.02fkb\n"), (float)(((*itMap).second)->size)/1000, (float)destLen/1000);
+			DBG_INFO(80, wst("zlib decompressed: %.02fkb->%.02fkb\n"), (float)txCache->size/1000, (float)destLen/1000);
 		}
 
 		return 1;
@@ -223,7 +353,7 @@ TxCache::get(uint64 checksum, GHQTexInfo *info)
 boolean
 TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 {
-	if (_cache.empty())
+	if (!_count)
 		return true;
 
 	/* dump cache to disk */
@@ -251,12 +381,14 @@ TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 		/* write header to determine config match */
 		gzwrite(gzfp, &config, 4);
 
-		std::map<uint64, TXCACHE*>::iterator itMap = _cache.begin();
 		int total = 0;
-		while (itMap != _cache.end()) {
-			uint8 *dest = (*itMap).second->info.data;
-			uint32 destLen = (*itMap).second->size;
-			uint32 format = (*itMap).second->info.format;
+		for (size_t i = 0; i < _slots.size(); i++) {
+			if (!_slots[i].checksum)
+				continue;
+			const TXCACHE *txCache = _entry(_slots[i].entry);
+			uint8 *dest = txCache->info.data;
+			uint32 destLen = txCache->size;
+			uint32 format = txCache->info.format;
 
 			/* to keep things simple, we save the texture data in a zlib uncompressed state. */
 			/* sigh... for those who cannot wait the extra few seconds. changed to keep
@@ -267,7 +399,7 @@ TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 	  dest = _gzdest0;
 	  destLen = _gzdestLen;
 	  if (dest && destLen) {
-	  if (uncompress(dest, &destLen, (*itMap).second->info.data, (*itMap).second->size) != Z_OK) {
+	  if (uncompress(dest, &destLen, txCache->info.data, txCache->size) != Z_OK) {
 	  dest = NULL;
 	  destLen = 0;
 	  }
@@ -277,22 +409,20 @@ TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 
 			if (dest && destLen) {
 				/* texture checksum */
-				gzwrite(gzfp, &((*itMap).first), 8);
+				gzwrite(gzfp, &txCache->checksum, 8);
 
 				/* other texture info */
-				gzwrite(gzfp, &((*itMap).second->info.width), 4);
-				gzwrite(gzfp, &((*itMap).second->info.height), 4);
+				gzwrite(gzfp, &txCache->info.width, 4);
+				gzwrite(gzfp, &txCache->info.height, 4);
 				gzwrite(gzfp, &format, 4);
-				gzwrite(gzfp, &((*itMap).second->info.texture_format), 2);
-				gzwrite(gzfp, &((*itMap).second->info.pixel_type), 2);
-				gzwrite(gzfp, &((*itMap).second->info.is_hires_tex), 1);
+				gzwrite(gzfp, &txCache->info.texture_format, 2);
+				gzwrite(gzfp, &txCache->info.pixel_type, 2);
+				gzwrite(gzfp, &txCache->info.is_hires_tex, 1);
 
 				gzwrite(gzfp, &destLen, 4);
 				gzwrite(gzfp, dest, destLen);
 			}
 
-			itMap++;
-
 			if (_callback)
 				(*_callback)(wst("Total textures saved to HDD: %d\n"), ++total);
 		}
@@ -301,7 +431,7 @@ TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 
 	CHDIR(curpath);
 
-	return _cache.empty();
+	return !_count;
 }
 
 boolean
@@ -353,7 +483,7 @@ TxCache::load(const wchar_t *path, const wchar_t *filename, int config)
 					gzread(gzfp, tmpInfo.data, dataSize);
 
 					/* add to memory cache */
-					add(checksum, &tmpInfo, (tmpInfo.format & GL_TEXFMT_GZ) ? dataSize : 0);
+					add(checksum, &tmpInfo, (tmpInfo.format & GL_TEXFMT_PACKED) ? dataSize : 0);
 
 					free(tmpInfo.data);
 				} else {
@@ -361,8 +491,8 @@ TxCache::load(const wchar_t *path, const wchar_t *filename, int config)
 				}
 
 				/* skip in between to prevent the loop from being tied down to vsync */
-				if (_callback && (!(_cache.size() % 100) || gzeof(gzfp)))
-					(*_callback)(wst("[%d] total mem:%.02fmb - %ls\n"), _cache.size(), (float)_totalSize/1000000, filename);
+				if (_callback && (!(_count % 100) || gzeof(gzfp)))
+					(*_callback)(wst("[%d] total mem:%.02fmb - %ls\n"), _count, (float)_totalSize/1000000, filename);
 
 			} while (!gzeof(gzfp));
 			gzclose(gzfp);
@@ -371,25 +501,19 @@ TxCache::load(const wchar_t *path, const wchar_t *filename, int config)
 
 	CHDIR(curpath);
 
-	return !_cache.empty();
+	return _count != 0;
 }
 
 boolean
 TxCache::del(uint64 checksum)
 {
-	if (!checksum || _cache.empty()) return 0;
-
-	std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(checksum);
-	if (itMap != _cache.end()) {
+	if (!checksum || !_count) return 0;
 
-		/* for texture cache (not hi-res cache) */
-		if (!_cachelist.empty()) _cachelist.erase(((*itMap).second)->it);
+	const uint32 slot = _findSlot(checksum);
+	if (_slots[slot].checksum) {
 
 		/* remove from cache */
-		free((*itMap).second->info.data);
-		_totalSize -= (*itMap).second->size;
-		delete (*itMap).second;
-		_cache.erase(itMap);
+		_remove(slot);
 
 		DBG_INFO(80, wst("removed from cache: checksum = %08X %08X\n"), (uint32)(checksum & 0xffffffff), (uint32)(checksum >> 32));
 
@@ -402,26 +526,37 @@ TxCache::del(uint64 checksum)
 boolean
 TxCache::is_cached(uint64 checksum)
 {
-	std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(checksum);
-	if (itMap != _cache.end()) return 1;
+	if (!checksum) return 0;
 
-	return 0;
+	return _slots[_findSlot(checksum)].checksum != 0;
 }
 
 void
-TxCache::clear()
+TxCache::checksums(std::vector<uint64> &list) const
 {
-	if (!_cache.empty()) {
-		std::map<uint64, TXCACHE*>::iterator itMap = _cache.begin();
-		while (itMap != _cache.end()) {
-			free((*itMap).second->info.data);
-			delete (*itMap).second;
-			itMap++;
-		}
-		_cache.clear();
+	list.clear();
+	list.reserve(_count);
+	for (size_t i = 0; i < _slots.size(); i++) {
+		if (_slots[i].checksum)
+			list.push_back(_slots[i].checksum);
 	}
+}
 
-	if (!_cachelist.empty()) _cachelist.clear();
-
-	_totalSize = 0;
+void
+TxCache::clear()
+{
+	for (size_t i = 0; i < _slots.size(); i++) {
+		if (_slots[i].checksum)
+			free(_entry(_slots[i].entry)->info.data);
+	}
+	for (size_t i = 0; i < _slabs.size(); i++)
+		delete[] _slabs[i];
+	_slabs.clear();
+	_slots.assign(TXCACHE_MIN_SLOTS, SLOT());
+
+	_count = 0;
+	_freeEntry = TXCACHE_NIL;
+	_lruFirst = TXCACHE_NIL;
+	_lruLast = TXCACHE_NIL;
+	_totalSize = TXCACHE_MIN_SLOTS * sizeof(SLOT);
 }
@@ -26,13 +26,11 @@
 
 #include "TxInternal.h"
 #include "TxUtil.h"
-#include <list>
-#include <map>
+#include <vector>
 
 class TxCache
 {
 private:
-  std::list<uint64> _cachelist;
   uint8 *_gzdest0;
   uint8 *_gzdest1;
   uint32 _gzdestLen;
@@ -42,19 +40,45 @@ protected:
   tx_wstring _path;
   dispInfoFuncExt _callback;
   TxUtil *_txUtil;
+  /* entries are allocated in slabs and linked in LRU order, oldest first.
+   * Free entries are linked through next. */
   struct TXCACHE {
+    uint64 checksum;
     int size;
     GHQTexInfo info;
-    std::list<uint64>::iterator it;
+    uint32 prev;
+    uint32 next;
   };
+  /* texture data, entry slabs and hash table in bytes */
   int _totalSize;
   int _cacheSize;
-  std::map<uint64, TXCACHE*> _cache;
   boolean save(const wchar_t *path, const wchar_t *filename, const int config);
   boolean load(const wchar_t *path, const wchar_t *filename, const int config);
   boolean del(uint64 checksum); /* checksum hi:palette low:texture */
   boolean is_cached(uint64 checksum); /* checksum hi:palette low:texture */
   void clear();
+  uint32 count() const { return _count; }
+  void checksums(std::vector<uint64> &list) const;
+private:
+  /* open addressing with linear probing, checksum 0 marks an empty slot */
+  struct SLOT {
+    uint64 checksum;
+    uint32 entry;
+  };
+  std::vector<SLOT> _slots;
+  std::vector<TXCACHE*> _slabs;
+  uint32 _count;
+  uint32 _freeEntry;
+  uint32 _lruFirst;
+  uint32 _lruLast;
+  TXCACHE *_entry(uint32 n) const;
+  uint32 _findSlot(uint64 checksum) const;
+  void _growSlots();
+  void _eraseSlot(uint32 slot);
+  uint32 _newEntry();
+  void _remove(uint32 slot);
+  void _lruLink(uint32 n);
+  void _lruUnlink(uint32 n);
 public:
   ~TxCache();
   TxCache(int options, int cachesize, const wchar_t *path, const wchar_t *ident,
@@ -0,0 +1,270 @@
+#include "TxCodec.h"
+#include "TxThreadPool.h"
+#include <atomic>
+#include <string.h>
+#include <vector>
+
+/* LZ4 block format:
+ * token (literal length << 4 | match length - 4), more literal length bytes when it is 15,
+ * literals, match offset (2 bytes, little endian), more match length bytes when it is 15.
+ * The last sequence has literals only. */
+#define LZ4_MINMATCH 4
+#define LZ4_LASTLITERALS 5 /* last bytes are always literals */
+#define LZ4_MFLIMIT 12     /* last match starts this far from the end */
+#define LZ4_MAXOFFSET 65535
+#define LZ4_HASHLOG 12
+
+/* unpacked size of a txpack block */
+#define TXPACK_BLOCK 65536
+
+static inline uint32
+read32(const uint8 *p)
+{
+  uint32 v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+static inline uint32
+hash32(uint32 v)
+{
+  return (v * 2654435761u) >> (32 - LZ4_HASHLOG);
+}
+
+/* writes length of 15 and more after the token */
+static inline uint8 *
+writeLength(uint8 *op, uint32 len)
+{
+  for (len -= 15; len >= 255; len -= 255)
+	*op++ = 255;
+  *op++ = (uint8)len;
+  return op;
+}
+
+int
+lz4_compress(const uint8 *src, int srcSize, uint8 *dst, int dstCapacity)
+{
+  const uint8 *ip = src;
+  const uint8 *anchor = src;
+  const uint8 *const iend = src + srcSize;
+  uint8 *op = dst;
+  uint8 *const oend = dst + dstCapacity;
+
+  if (srcSize > LZ4_MFLIMIT) {
+	const uint8 *const mflimit = iend - LZ4_MFLIMIT;
+	const uint8 *const matchlimit = iend - LZ4_LASTLITERALS;
+	uint32 table[1 << LZ4_HASHLOG];
+	memset(table, 0, sizeof(table));
+
+	ip++;
+	while (ip <= mflimit) {
+	  const uint32 h = hash32(read32(ip));
+	  const uint8 *ref = src + table[h];
+	  table[h] = (uint32)(ip - src);
+	  if (ref >= ip || ip - ref > LZ4_MAXOFFSET || read32(ref) != read32(ip)) {
+		/* skip faster through data which does not compress */
+		ip += 1 + ((ip - anchor) >> 6);
+		continue;
+	  }
+
+	  /* extend the match backwards, then forwards */
+	  while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+		ip--;
+		ref--;
+	  }
+	  const uint8 *mp = ip + LZ4_MINMATCH;
+	  const uint8 *rp = ref + LZ4_MINMATCH;
+	  while (mp < matchlimit && *mp == *rp) {
+		mp++;
+		rp++;
+	  }
+
+	  const uint32 litLen = (uint32)(ip - anchor);
+	  const uint32 matchLen = (uint32)(mp - ip) - LZ4_MINMATCH;
+	  if ((uint32)(oend - op) < 1 + litLen + litLen / 255 + 1 + 2 + matchLen / 255 + 1)
+		return 0;
+
+	  uint8 *token = op++;
+	  if (litLen >= 15) {
+		*token = 15 << 4;
+		op = writeLength(op, litLen);
+	  } else {
+		*token = (uint8)(litLen << 4);
+	  }
+	  memcpy(op, anchor, litLen);
+	  op += litLen;
+
+	  const uint32 offset = (uint32)(ip - ref);
+	  *op++ = (uint8)offset;
+	  *op++ = (uint8)(offset >> 8);
+
+	  if (matchLen >= 15) {
+		*token |= 15;
+		op = writeLength(op, matchLen);
+	  } else {
+		*token |= (uint8)matchLen;
+	  }
+
+	  ip = anchor = mp;
+	  if (ip <= mflimit)
+		table[hash32(read32(ip - 2))] = (uint32)(ip - 2 - src);
+	}
+  }
+
+  /* last literals */
+  const uint32 litLen = (uint32)(iend - anchor);
+  if ((uint32)(oend - op) < 1 + litLen + litLen / 255 + 1)
+	return 0;
+  if (litLen >= 15) {
+	*op++ = 15 << 4;
+	op = writeLength(op, litLen);
+  } else {
+	*op++ = (uint8)(litLen << 4);
+  }
+  memcpy(op, anchor, litLen);
+  op += litLen;
+
+  return (int)(op - dst);
+}
+
+/* reads length of 15 and more after the token, 0 if src ends */
+static inline uint32
+readLength(const uint8 **ip, const uint8 *iend, uint32 len)
+{
+  uint8 s;
+  do {
+	if (*ip >= iend)
+	  return 0;
+	s = *(*ip)++;
+	len += s;
+  } while (s == 255);
+  return len;
+}
+
+int
+lz4_decompress(const uint8 *src, int srcSize, uint8 *dst, int dstSize)
+{
+  const uint8 *ip = src;
+  const uint8 *const iend = src + srcSize;
+  uint8 *op = dst;
+  uint8 *const oend = dst + dstSize;
+
+  while (ip < iend) {
+	const uint8 token = *ip++;
+
+	uint32 litLen = token >> 4;
+	if (litLen == 15 && !(litLen = readLength(&ip, iend, litLen)))
+	  return 0;
+	if (litLen > (uint32)(iend - ip) || litLen > (uint32)(oend - op))
+	  return 0;
+	memcpy(op, ip, litLen);
+	op += litLen;
+	ip += litLen;
+
+	/* last sequence */
+	if (ip == iend)
+	  break;
+
+	if (iend - ip < 2)
+	  return 0;
+	const uint32 offset = ip[0] | (ip[1] << 8);
+	ip += 2;
+	if (offset == 0 || offset > (uint32)(op - dst))
+	  return 0;
+
+	uint32 matchLen = token & 15;
+	if (matchLen == 15 && !(matchLen = readLength(&ip, iend, matchLen)))
+	  return 0;
+	matchLen += LZ4_MINMATCH;
+	if (matchLen > (uint32)(oend - op))
+	  return 0;
+
+	/* overlapping matches repeat the last offset bytes, copy them in growing steps */
+	const uint8 *match = op - offset;
+	uint8 *const mend = op + matchLen;
+	while (op < mend) {
+	  const size_t n = (size_t)(op - match) < (size_t)(mend - op) ? (size_t)(op - match) : (size_t)(mend - op);
+	  memcpy(op, match, n);
+	  op += n;
+	}
+  }
+
+  return (int)(op - dst);
+}
+
+uint32
+txpack_bound(uint32 size)
+{
+  /* block sizes, then blocks which may be stored as they are */
+  return ((size + TXPACK_BLOCK - 1) / TXPACK_BLOCK) * 4 + size;
+}
+
+uint32
+txpack(const uint8 *src, uint32 size, uint8 *dst)
+{
+  const uint32 numBlocks = (size + TXPACK_BLOCK - 1) / TXPACK_BLOCK;
+  if (!numBlocks)
+	return 0;
+  uint32 *blockSizes = (uint32 *)dst;
+  uint8 *data = dst + numBlocks * 4;
+
+  /* every block is compressed into its own place first, blocks are moved together after */
+  TxThreadPool::getInstance()->run(numBlocks, 1, [&](unsigned int first, unsigned int last) {
+	for (unsigned int i = first; i < last; i++) {
+	  const uint32 rawSize = (i + 1 < numBlocks) ? TXPACK_BLOCK : size - i * TXPACK_BLOCK;
+	  uint8 *out = data + i * TXPACK_BLOCK;
+	  /* store it as it is if it does not get smaller */
+	  int packedSize = lz4_compress(src + i * TXPACK_BLOCK, rawSize, out, rawSize - 1);
+	  if (!packedSize) {
+		memcpy(out, src + i * TXPACK_BLOCK, rawSize);
+		packedSize = rawSize;
+	  }
+	  blockSizes[i] = packedSize;
+	}
+  });
+
+  uint32 packedSize = 0;
+  for (uint32 i = 0; i < numBlocks; i++) {
+	if (packedSize != i * TXPACK_BLOCK)
+	  memmove(data + packedSize, data + i * TXPACK_BLOCK, blockSizes[i]);
+	packedSize += blockSizes[i];
+  }
+  packedSize += numBlocks * 4;
+
+  return packedSize < size ? packedSize : 0;
+}
+
+boolean
+txunpack(const uint8 *src, uint32 packedSize, uint8 *dst, uint32 size)
+{
+  const uint32 numBlocks = (size + TXPACK_BLOCK - 1) / TXPACK_BLOCK;
+  if (!numBlocks || packedSize < numBlocks * 4)
+	return 0;
+
+  /* block positions */
+  std::vector<uint32> offsets(numBlocks + 1);
+  offsets[0] = numBlocks * 4;
+  for (uint32 i = 0; i < numBlocks; i++) {
+	const uint32 blockSize = read32(src + i * 4);
+	if (blockSize > packedSize - offsets[i])
+	  return 0;
+	offsets[i + 1] = offsets[i] + blockSize;
+  }
+  if (offsets[numBlocks] != packedSize)
+	return 0;
+
+  std::atomic<bool> ok(true);
+  TxThreadPool::getInstance()->run(numBlocks, 1, [&](unsigned int first, unsigned int last) {
+	for (unsigned int i = first; i < last; i++) {
+	  const uint32 rawSize = (i + 1 < numBlocks) ? TXPACK_BLOCK : size - i * TXPACK_BLOCK;
+	  const uint32 blockSize = offsets[i + 1] - offsets[i];
+	  uint8 *out = dst + i * TXPACK_BLOCK;
+	  if (blockSize == rawSize)
+		memcpy(out, src + offsets[i], rawSize);
+	  else if ((uint32)lz4_decompress(src + offsets[i], blockSize, out, rawSize) != rawSize)
+		ok = false;
+	}
+  });
+
+  return ok ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+#ifndef __TXCODEC_H__
+#define __TXCODEC_H__
+
+#include "TxInternal.h"
+
+/* LZ4 block format compressor and decompressor for the texture caches.
+ * No LZ4 library comes with GLideNHQ, the format is simple enough to have here.
+ * Both return the size written to dst, 0 if dst is too small or src is broken. */
+int lz4_compress(const uint8 *src, int srcSize, uint8 *dst, int dstCapacity);
+int lz4_decompress(const uint8 *src, int srcSize, uint8 *dst, int dstSize);
+
+/* Texture data packed in independent LZ4 blocks, compressed and decompressed
+ * in parallel on the thread pool. Packed data starts with the packed size of
+ * each block, blocks which do not compress are stored as they are. */
+uint32 txpack_bound(uint32 size);
+/* returns packed size, 0 if data does not get smaller */
+uint32 txpack(const uint8 *src, uint32 size, uint8 *dst);
+/* size is the unpacked size */
+boolean txunpack(const uint8 *src, uint32 packedSize, uint8 *dst, uint32 size);
+
+#endif /* __TXCODEC_H__ */
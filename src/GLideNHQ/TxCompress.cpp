@@ -0,0 +1,467 @@
+#include "TxCompress.h"
+#include "TxThreadPool.h"
+#include <math.h>
+#include <string.h>
+
+/* rows of blocks per thread pool job block */
+#define COMPRESS_BLOCK_ROWS 4
+
+static inline int
+clamp255(int v)
+{
+  return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int
+colorError(const uint8 *p, int r, int g, int b)
+{
+  const int dr = p[0] - r, dg = p[1] - g, db = p[2] - b;
+  return dr * dr + dg * dg + db * db;
+}
+
+/*
+ * S3TC
+ */
+
+static inline uint16
+pack565(float r, float g, float b)
+{
+  const int r5 = clamp255((int)(r + 0.5f)) * 31 + 127;
+  const int g6 = clamp255((int)(g + 0.5f)) * 63 + 127;
+  const int b5 = clamp255((int)(b + 0.5f)) * 31 + 127;
+  return (uint16)(((r5 / 255) << 11) | ((g6 / 255) << 5) | (b5 / 255));
+}
+
+static inline void
+unpack565(uint16 v, int *c)
+{
+  const int r = v >> 11, g = (v >> 5) & 0x3f, b = v & 0x1f;
+  c[0] = (r << 3) | (r >> 2);
+  c[1] = (g << 2) | (g >> 4);
+  c[2] = (b << 3) | (b >> 2);
+}
+
+/* 2 bit indices of the 4 color palette, c0 > c1 */
+static uint32
+colorIndices(const uint8 *block, uint16 c0, uint16 c1, int *error)
+{
+  int palette[4][3];
+  unpack565(c0, palette[0]);
+  unpack565(c1, palette[1]);
+  for (int i = 0; i < 3; i++) {
+	palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+	palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+  }
+
+  uint32 indices = 0;
+  *error = 0;
+  for (int i = 0; i < 16; i++) {
+	const uint8 *p = block + i * 4;
+	int best = 0, bestError = colorError(p, palette[0][0], palette[0][1], palette[0][2]);
+	for (int j = 1; j < 4; j++) {
+	  const int e = colorError(p, palette[j][0], palette[j][1], palette[j][2]);
+	  if (e < bestError) {
+		best = j;
+		bestError = e;
+	  }
+	}
+	indices |= (uint32)best << (i * 2);
+	*error += bestError;
+  }
+  return indices;
+}
+
+/* least squares endpoints for the indices, 0 if all pixels use one endpoint */
+static boolean
+refineEndpoints(const uint8 *block, uint32 indices, uint16 *c0, uint16 *c1)
+{
+  static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+  float a = 0.0f, b = 0.0f, c = 0.0f;
+  float x[3] = { 0.0f, 0.0f, 0.0f }, y[3] = { 0.0f, 0.0f, 0.0f };
+  for (int i = 0; i < 16; i++) {
+	const float w = weights[(indices >> (i * 2)) & 3];
+	a += w * w;
+	b += w * (1.0f - w);
+	c += (1.0f - w) * (1.0f - w);
+	for (int j = 0; j < 3; j++) {
+	  x[j] += w * block[i * 4 + j];
+	  y[j] += (1.0f - w) * block[i * 4 + j];
+	}
+  }
+  const float det = a * c - b * b;
+  if (det < 1e-4f)
+	return 0;
+  float e0[3], e1[3];
+  for (int j = 0; j < 3; j++) {
+	e0[j] = (c * x[j] - b * y[j]) / det;
+	e1[j] = (a * y[j] - b * x[j]) / det;
+  }
+  *c0 = pack565(e0[0], e0[1], e0[2]);
+  *c1 = pack565(e1[0], e1[1], e1[2]);
+  return 1;
+}
+
+/* BC1 color block: endpoints at the ends of the principal axis, refined once */
+static void
+encodeColorBlock(const uint8 *block, uint8 *dst)
+{
+  float mean[3] = { 0.0f, 0.0f, 0.0f };
+  for (int i = 0; i < 16; i++)
+	for (int j = 0; j < 3; j++)
+	  mean[j] += block[i * 4 + j];
+  for (int j = 0; j < 3; j++)
+	mean[j] /= 16.0f;
+
+  float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+  for (int i = 0; i < 16; i++) {
+	const float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+	cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+	cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+  }
+
+  /* power iteration, starting from luminance */
+  float axis[3] = { 0.299f, 0.587f, 0.114f };
+  for (int n = 0; n < 4; n++) {
+	const float r = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+	const float g = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+	const float b = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+	float m = fabsf(r) > fabsf(g) ? fabsf(r) : fabsf(g);
+	m = m > fabsf(b) ? m : fabsf(b);
+	if (m < 1e-4f)
+	  break;
+	axis[0] = r / m; axis[1] = g / m; axis[2] = b / m;
+  }
+
+  int minIdx = 0, maxIdx = 0;
+  float minDot = 1e30f, maxDot = -1e30f;
+  for (int i = 0; i < 16; i++) {
+	const float d = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+	if (d < minDot) { minDot = d; minIdx = i; }
+	if (d > maxDot) { maxDot = d; maxIdx = i; }
+  }
+
+  const uint8 *pmax = block + maxIdx * 4, *pmin = block + minIdx * 4;
+  uint16 c0 = pack565(pmax[0], pmax[1], pmax[2]);
+  uint16 c1 = pack565(pmin[0], pmin[1], pmin[2]);
+  if (c0 < c1) {
+	const uint16 t = c0; c0 = c1; c1 = t;
+  }
+
+  int error = 0;
+  uint32 indices = 0;
+  if (c0 != c1) {
+	indices = colorIndices(block, c0, c1, &error);
+	uint16 r0, r1;
+	if (refineEndpoints(block, indices, &r0, &r1)) {
+	  if (r0 < r1) {
+		const uint16 t = r0; r0 = r1; r1 = t;
+	  }
+	  if (r0 != r1) {
+		int refinedError;
+		const uint32 refined = colorIndices(block, r0, r1, &refinedError);
+		if (refinedError < error) {
+		  c0 = r0; c1 = r1;
+		  indices = refined;
+		}
+	  }
+	}
+  }
+
+  dst[0] = (uint8)c0; dst[1] = (uint8)(c0 >> 8);
+  dst[2] = (uint8)c1; dst[3] = (uint8)(c1 >> 8);
+  dst[4] = (uint8)indices; dst[5] = (uint8)(indices >> 8);
+  dst[6] = (uint8)(indices >> 16); dst[7] = (uint8)(indices >> 24);
+}
+
+/* BC3 alpha block: 8 alpha values between max and min alpha */
+static void
+encodeAlphaBlock(const uint8 *block, uint8 *dst)
+{
+  int amin = 255, amax = 0;
+  for (int i = 0; i < 16; i++) {
+	const int a = block[i * 4 + 3];
+	amin = a < amin ? a : amin;
+	amax = a > amax ? a : amax;
+  }
+
+  dst[0] = (uint8)amax;
+  dst[1] = (uint8)amin;
+  uint64 indices = 0;
+  if (amax != amin) {
+	int palette[8];
+	palette[0] = amax;
+	palette[1] = amin;
+	for (int j = 2; j < 8; j++)
+	  palette[j] = ((8 - j) * amax + (j - 1) * amin) / 7;
+	for (int i = 0; i < 16; i++) {
+	  const int a = block[i * 4 + 3];
+	  int best = 0, bestError = 256;
+	  for (int j = 0; j < 8; j++) {
+		const int e = a > palette[j] ? a - palette[j] : palette[j] - a;
+		if (e < bestError) {
+		  best = j;
+		  bestError = e;
+		}
+	  }
+	  indices |= (uint64)best << (i * 3);
+	}
+  }
+  for (int i = 0; i < 6; i++)
+	dst[2 + i] = (uint8)(indices >> (i * 8));
+}
+
+/*
+ * ETC2
+ */
+
+static const int etcModifiers[8][2] = {
+  { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static const int eacModifiers[16][8] = {
+  { -3, -6,  -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+  { -2, -5,  -8, -13, 1, 4, 7, 12 }, { -2, -4,  -6, -13, 1, 3, 5, 12 },
+  { -3, -6,  -8, -12, 2, 5, 7, 11 }, { -3, -7,  -9, -11, 2, 6, 8, 10 },
+  { -4, -7,  -8, -11, 3, 6, 7, 10 }, { -3, -5,  -8, -11, 2, 4, 7, 10 },
+  { -2, -6,  -8, -10, 1, 5, 7,  9 }, { -2, -5,  -8, -10, 1, 4, 7,  9 },
+  { -2, -4,  -8, -10, 1, 3, 7,  9 }, { -2, -5,  -7, -10, 1, 4, 6,  9 },
+  { -3, -4,  -7, -10, 2, 3, 6,  9 }, { -1, -2,  -3, -10, 0, 1, 2,  9 },
+  { -4, -6,  -8,  -9, 3, 5, 7,  8 }, { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+static inline void
+writeBE32(uint8 *dst, uint32 v)
+{
+  dst[0] = (uint8)(v >> 24); dst[1] = (uint8)(v >> 16);
+  dst[2] = (uint8)(v >> 8); dst[3] = (uint8)v;
+}
+
+/* pixels of a sub block: left/right halves, or top/bottom halves when flipped */
+static inline int
+subBlock(int x, int y, int flip)
+{
+  return flip ? (y >> 1) : (x >> 1);
+}
+
+/* best modifier table of a sub block around base color, pixel indices in ETC order */
+static int
+encodeSubBlock(const uint8 *block, int flip, int sub, const int *base, int *table, uint32 *indices)
+{
+  const uint8 *pixels[8];
+  int pixelIndex[8], n = 0;
+  for (int y = 0; y < 4; y++) {
+	for (int x = 0; x < 4; x++) {
+	  if (subBlock(x, y, flip) != sub)
+		continue;
+	  pixels[n] = block + (y * 4 + x) * 4;
+	  pixelIndex[n++] = x * 4 + y;
+	}
+  }
+
+  int bestError = 0x7fffffff;
+  for (int t = 0; t < 8 && bestError > 0; t++) {
+	/* 0: +a, 1: +b, 2: -a, 3: -b */
+	int palette[4][3];
+	for (int m = 0; m < 4; m++) {
+	  const int mod = (m & 2) ? -etcModifiers[t][m & 1] : etcModifiers[t][m & 1];
+	  for (int j = 0; j < 3; j++)
+		palette[m][j] = clamp255(base[j] + mod);
+	}
+
+	int error = 0;
+	uint32 tableIndices = 0;
+	for (int i = 0; i < n && error < bestError; i++) {
+	  int best = 0, bestPixelError = colorError(pixels[i], palette[0][0], palette[0][1], palette[0][2]);
+	  for (int m = 1; m < 4; m++) {
+		const int e = colorError(pixels[i], palette[m][0], palette[m][1], palette[m][2]);
+		if (e < bestPixelError) {
+		  best = m;
+		  bestPixelError = e;
+		}
+	  }
+	  tableIndices |= ((uint32)(best & 1) << pixelIndex[i]) | ((uint32)(best >> 1) << (16 + pixelIndex[i]));
+	  error += bestPixelError;
+	}
+	if (error < bestError) {
+	  bestError = error;
+	  *table = t;
+	  *indices = tableIndices;
+	}
+  }
+  return bestError;
+}
+
+/* ETC1 compatible block, the average color of each sub block is its base color */
+static void
+encodeEtcBlock(const uint8 *block, uint8 *dst)
+{
+  int bestError = 0x7fffffff;
+  for (int flip = 0; flip < 2; flip++) {
+	int sum[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+	for (int y = 0; y < 4; y++)
+	  for (int x = 0; x < 4; x++)
+		for (int j = 0; j < 3; j++)
+		  sum[subBlock(x, y, flip)][j] += block[(y * 4 + x) * 4 + j];
+
+	/* differential mode when the 5 bit colors are close enough, 4 bit colors otherwise */
+	int q5[2][3], q4[2][3], base[2][3];
+	boolean diff = 1;
+	for (int s = 0; s < 2; s++) {
+	  for (int j = 0; j < 3; j++) {
+		q5[s][j] = (sum[s][j] * 31 + 8 * 255 / 2) / (8 * 255);
+		q4[s][j] = (sum[s][j] * 15 + 8 * 255 / 2) / (8 * 255);
+	  }
+	}
+	for (int j = 0; j < 3; j++) {
+	  const int d = q5[1][j] - q5[0][j];
+	  if (d < -4 || d > 3)
+		diff = 0;
+	}
+	for (int s = 0; s < 2; s++)
+	  for (int j = 0; j < 3; j++)
+		base[s][j] = diff ? (q5[s][j] << 3) | (q5[s][j] >> 2) : q4[s][j] * 17;
+
+	int table[2];
+	uint32 indices[2];
+	const int error = encodeSubBlock(block, flip, 0, base[0], &table[0], &indices[0]) +
+	  encodeSubBlock(block, flip, 1, base[1], &table[1], &indices[1]);
+	if (error >= bestError)
+	  continue;
+	bestError = error;
+
+	uint32 high;
+	if (diff) {
+	  high = ((uint32)q5[0][0] << 27) | ((uint32)((q5[1][0] - q5[0][0]) & 7) << 24) |
+		((uint32)q5[0][1] << 19) | ((uint32)((q5[1][1] - q5[0][1]) & 7) << 16) |
+		((uint32)q5[0][2] << 11) | ((uint32)((q5[1][2] - q5[0][2]) & 7) << 8) | 2;
+	} else {
+	  high = ((uint32)q4[0][0] << 28) | ((uint32)q4[1][0] << 24) | ((uint32)q4[0][1] << 20) |
+		((uint32)q4[1][1] << 16) | ((uint32)q4[0][2] << 12) | ((uint32)q4[1][2] << 8);
+	}
+	high |= (table[0] << 5) | (table[1] << 2) | flip;
+	writeBE32(dst, high);
+	writeBE32(dst + 4, indices[0] | indices[1]);
+  }
+}
+
+/* EAC alpha block, base alpha in the middle of the range for each table and multiplier */
+static void
+encodeEacBlock(const uint8 *block, uint8 *dst)
+{
+  int amin = 255, amax = 0;
+  for (int i = 0; i < 16; i++) {
+	const int a = block[i * 4 + 3];
+	amin = a < amin ? a : amin;
+	amax = a > amax ? a : amax;
+  }
+
+  int bestError = 0x7fffffff, bestBase = amin, bestMul = 1, bestTable = 13;
+  uint64 bestIndices = 0;
+  for (int t = 0; t < 16; t++) {
+	const int span = eacModifiers[t][7] - eacModifiers[t][3];
+	const int mul = (amax - amin + span / 2) / span;
+	for (int m = mul - 1; m <= mul + 1; m++) {
+	  /* encoders must not write multiplier 0 for RGBA8 alpha */
+	  if (m < 1 || m > 15)
+		continue;
+	  const int base = clamp255((amin + amax - m * (eacModifiers[t][7] + eacModifiers[t][3]) + 1) / 2);
+	  int error = 0;
+	  uint64 indices = 0;
+	  for (int y = 0; y < 4 && error < bestError; y++) {
+		for (int x = 0; x < 4; x++) {
+		  const int a = block[(y * 4 + x) * 4 + 3];
+		  int best = 0, bestPixelError = 0x7fffffff;
+		  for (int j = 0; j < 8; j++) {
+			const int d = a - clamp255(base + eacModifiers[t][j] * m);
+			if (d * d < bestPixelError) {
+			  best = j;
+			  bestPixelError = d * d;
+			}
+		  }
+		  indices |= (uint64)best << (45 - (x * 4 + y) * 3);
+		  error += bestPixelError;
+		}
+	  }
+	  if (error < bestError) {
+		bestError = error;
+		bestBase = base;
+		bestMul = m;
+		bestTable = t;
+		bestIndices = indices;
+	  }
+	}
+  }
+
+  const uint64 bits = ((uint64)bestBase << 56) | ((uint64)bestMul << 52) | ((uint64)bestTable << 48) | bestIndices;
+  writeBE32(dst, (uint32)(bits >> 32));
+  writeBE32(dst + 4, (uint32)bits);
+}
+
+uint16
+txcompress_format(const uint8 *src, int width, int height, int compression)
+{
+  if (!width || !height || (width & 3) || (height & 3))
+	return 0;
+
+  boolean opaque = 1;
+  for (int i = 0; i < width * height && opaque; i++)
+	opaque = src[i * 4 + 3] == 0xff;
+
+  switch (compression & COMPRESSION_MASK) {
+  case S3TC_COMPRESSION:
+	return opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  case ETC2_COMPRESSION:
+	return opaque ? GL_COMPRESSED_RGB8_ETC2 : GL_COMPRESSED_RGBA8_ETC2_EAC;
+  }
+  return 0;
+}
+
+boolean
+txcompress(const uint8 *src, int width, int height, uint16 format, uint8 *dst)
+{
+  int blockSize;
+  switch (format) {
+  case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGB8_ETC2:
+	blockSize = 8;
+	break;
+  case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+  case GL_COMPRESSED_RGBA8_ETC2_EAC:
+	blockSize = 16;
+	break;
+  default:
+	return 0;
+  }
+  if (!width || !height || (width & 3) || (height & 3))
+	return 0;
+
+  const int blocksX = width >> 2;
+  TxThreadPool::getInstance()->run(height >> 2, COMPRESS_BLOCK_ROWS, [&](unsigned int first, unsigned int last) {
+	uint8 block[64];
+	for (unsigned int by = first; by < last; by++) {
+	  uint8 *out = dst + by * blocksX * blockSize;
+	  for (int bx = 0; bx < blocksX; bx++, out += blockSize) {
+		for (int y = 0; y < 4; y++)
+		  memcpy(block + y * 16, src + ((by * 4 + y) * width + bx * 4) * 4, 16);
+		switch (format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		  encodeColorBlock(block, out);
+		  break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		  encodeAlphaBlock(block, out);
+		  encodeColorBlock(block, out + 8);
+		  break;
+		case GL_COMPRESSED_RGB8_ETC2:
+		  encodeEtcBlock(block, out);
+		  break;
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		  encodeEacBlock(block, out);
+		  encodeEtcBlock(block, out + 8);
+		  break;
+		}
+	  }
+	}
+  });
+
+  return 1;
+}
@@ -0,0 +1,18 @@
+#ifndef __TXCOMPRESS_H__
+#define __TXCOMPRESS_H__
+
+#include "TxInternal.h"
+
+/* GPU texture compression of RGBA8 textures into 4x4 blocks.
+ * S3TC_COMPRESSION: BC1 (DXT1) for opaque textures, BC3 (DXT5) otherwise.
+ * ETC2_COMPRESSION: ETC2 RGB8 for opaque textures, ETC2 RGBA8 EAC otherwise.
+ * ETC2 color blocks use the ETC1 individual and differential modes only. */
+
+/* compressed format for the texture, 0 if it can't be compressed.
+ * Width and height must be multiples of 4. */
+uint16 txcompress_format(const uint8 *src, int width, int height, int compression);
+/* compresses rows of blocks in parallel on the thread pool.
+ * dst must hold TxUtil::sizeofTx(width, height, format) bytes. */
+boolean txcompress(const uint8 *src, int width, int height, uint16 format, uint8 *dst);
+
+#endif /* __TXCOMPRESS_H__ */
@@ -0,0 +1,183 @@
+#include "TxDump.h"
+#include "TxImage.h"
+#include "TxQuantize.h"
+#include "TxDbg.h"
+#include <osal_files.h>
+#include <string.h>
+#ifdef WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+TxDump::TxDump(const wchar_t *path, const wchar_t *ident, size_t budget) :
+  _budget(budget), _pending(0), _stop(false)
+{
+  _ident.assign(ident);
+  _path.assign(path);
+  _path.append(wst("/texture_dump/"));
+  _path.append(_ident);
+  _path.append(wst("/GLideNHQ"));
+
+  _worker = std::thread(&TxDump::_workerLoop, this);
+}
+
+TxDump::~TxDump()
+{
+  {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stop = true;
+  }
+  _wakeCond.notify_one();
+  _worker.join();
+}
+
+boolean
+TxDump::dump(const uint8 *src, int width, int height, int rowStridePixel, uint16 gfmt, uint16 n64fmt, uint64 r_crc64)
+{
+  int bpp;
+  switch (gfmt) {
+  case GL_RGBA:
+  case GL_RGBA8:
+	bpp = 4;
+  break;
+  case GL_RGBA4:
+  case GL_RGB5_A1:
+  case GL_RGB:
+	bpp = 2;
+  break;
+  default:
+	return 0;
+  }
+  const size_t size = (size_t)rowStridePixel * height * bpp;
+  KEY key;
+  key.checksum = r_crc64;
+  key.n64fmt = n64fmt;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_dumped.count(key) || _pending + size > _budget)
+	return 0;
+  _dumped.insert(key);
+  _pending += size;
+  /* copy outside the lock, the worker only takes queued jobs */
+  lock.unlock();
+
+  JOB job;
+  job.checksum = r_crc64;
+  job.n64fmt = n64fmt;
+  job.gfmt = gfmt;
+  job.width = width;
+  job.height = height;
+  job.rowStridePixel = rowStridePixel;
+  job.data.assign(src, src + size);
+
+  lock.lock();
+  _jobs.push_back(std::move(job));
+  lock.unlock();
+  _wakeCond.notify_one();
+
+  return 1;
+}
+
+void
+TxDump::flush()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idleCond.wait(lock, [this]{ return _pending == 0; });
+}
+
+void
+TxDump::_workerLoop()
+{
+  /* encoding must not take time from the emulation threads */
+#ifdef WIN32
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+#endif
+
+  while (true) {
+	JOB job;
+	{
+	  std::unique_lock<std::mutex> lock(_mutex);
+	  _wakeCond.wait(lock, [this]{ return _stop || !_jobs.empty(); });
+	  if (_jobs.empty())
+		return;
+	  job = std::move(_jobs.front());
+	  _jobs.pop_front();
+	}
+
+	const boolean written = _write(job);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!written) {
+	  KEY key;
+	  key.checksum = job.checksum;
+	  key.n64fmt = job.n64fmt;
+	  _dumped.erase(key);
+	}
+	_pending -= job.data.size();
+	if (_pending == 0)
+	  _idleCond.notify_all();
+  }
+}
+
+boolean
+TxDump::_write(JOB &job)
+{
+  tx_wstring filename(_path);
+  wchar_t wbuf[256];
+  if ((job.n64fmt >> 8) == 0x2)
+	tx_swprintf(wbuf, 256, wst("/%ls#%08X#%01X#%01X#%08X_ciByRGBA.png"), _ident.c_str(), (uint32)(job.checksum & 0xffffffff), (job.n64fmt >> 8), (job.n64fmt & 0xf), (uint32)(job.checksum >> 32));
+  else
+	tx_swprintf(wbuf, 256, wst("/%ls#%08X#%01X#%01X_all.png"), _ident.c_str(), (uint32)(job.checksum & 0xffffffff), (job.n64fmt >> 8), (job.n64fmt & 0xf));
+  filename.append(wbuf);
+
+  /* dumped in an earlier session */
+  if (osal_path_existsW(filename.c_str()))
+	return 1;
+
+  if (!osal_path_existsW(_path.c_str()) && osal_mkdirp(_path.c_str()) != 0)
+	return 0;
+
+  uint8 *src = job.data.data();
+  std::vector<uint8> rgba;
+  if (job.gfmt != GL_RGBA && job.gfmt != GL_RGBA8) {
+	/* one row at a time, so the quantizer runs on this thread and not on the pool */
+	rgba.resize((size_t)job.rowStridePixel * job.height * 4);
+	TxQuantize quantize;
+	const size_t srcStride = (size_t)job.rowStridePixel * 2;
+	const size_t destStride = (size_t)job.rowStridePixel * 4;
+	for (int y = 0; y < job.height; y++) {
+	  if (!quantize.quantize(src + y * srcStride, rgba.data() + y * destStride, job.rowStridePixel, 1, job.gfmt, GL_RGBA8))
+		return 0;
+	}
+	src = rgba.data();
+  }
+
+  FILE *fp = NULL;
+#ifdef WIN32
+  if ((fp = _wfopen(filename.c_str(), wst("wb"))) != NULL) {
+#else
+  char cbuf[MAX_PATH];
+  wcstombs(cbuf, filename.c_str(), MAX_PATH);
+  if ((fp = fopen(cbuf, "wb")) != NULL) {
+#endif
+	TxImage image;
+	const boolean written = image.writePNG(src, fp, job.width, job.height, (job.rowStridePixel << 2), 0x0003, 0);
+	fclose(fp);
+	if (written)
+	  return 1;
+	/* a partial file would keep the texture from being dumped again */
+#ifdef WIN32
+	_wremove(filename.c_str());
+#else
+	remove(cbuf);
+#endif
+  }
+
+  DBG_INFO(80, wst("Error: cannot write dump %ls\n"), filename.c_str());
+  return 0;
+}
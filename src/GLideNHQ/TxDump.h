@@ -0,0 +1,69 @@
+#ifndef __TXDUMP_H__
+#define __TXDUMP_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "TxInternal.h"
+
+/* memory for textures waiting to be written, 32MB */
+#define TXDUMP_BUDGET (32 * 1024 * 1024)
+
+/* Background texture dumper.
+ * dump() copies the decoded texture and returns. A low priority worker
+ * converts it to RGBA8 and writes the PNG. A texture is dumped once per
+ * checksum and format, and files from earlier sessions are not rewritten.
+ * Textures which fail to write are dumped again the next time they load.
+ * Textures which do not fit in the memory budget are dropped and queued
+ * again the next time they load.
+ */
+class TxDump
+{
+private:
+  struct JOB {
+	uint64 checksum;  /* hi:palette low:texture */
+	uint16 n64fmt;
+	uint16 gfmt;
+	int width;
+	int height;
+	int rowStridePixel;
+	std::vector<uint8> data;
+  };
+  struct KEY {
+	uint64 checksum;
+	uint16 n64fmt;
+	bool operator==(const KEY &other) const { return checksum == other.checksum && n64fmt == other.n64fmt; }
+  };
+  struct KEYHASH {
+	size_t operator()(const KEY &key) const {
+	  const uint64 hash = key.checksum * 0x9E3779B97F4A7C15ULL + key.n64fmt;
+	  return (size_t)(hash ^ (hash >> 32));
+	}
+  };
+  tx_wstring _path;   /* texture_dump/<ident>/GLideNHQ */
+  tx_wstring _ident;
+  size_t _budget;
+  size_t _pending;    /* bytes of queued and writing textures */
+  std::deque<JOB> _jobs;
+  std::unordered_set<KEY, KEYHASH> _dumped;
+  std::mutex _mutex;
+  std::condition_variable _wakeCond;
+  std::condition_variable _idleCond;
+  std::thread _worker;
+  bool _stop;
+  void _workerLoop();
+  boolean _write(JOB &job);
+public:
+  TxDump(const wchar_t *path, const wchar_t *ident, size_t budget = TXDUMP_BUDGET);
+  /* writes the queued textures, then stops the worker */
+  ~TxDump();
+  /* queues the texture, 0 if it is already dumped or over the budget */
+  boolean dump(const uint8 *src, int width, int height, int rowStridePixel, uint16 gfmt, uint16 n64fmt, uint64 r_crc64);
+  /* waits until the queued textures are written */
+  void flush();
+};
+
+#endif /* __TXDUMP_H__ */
@@ -25,18 +25,21 @@
 #pragma warning(disable: 4786)
 #endif
 
-#include <functional>
-#include <thread>
 #include <stdlib.h>
 
 #include <osal_files.h>
 #include "TxFilter.h"
 #include "TextureFilters.h"
+#include "TxCompress.h"
+#include "TxThreadPool.h"
 #include "TxDbg.h"
 #include "bldno.h"
 
 void TxFilter::clear()
 {
+	/* write pending texture dumps */
+	delete _txDump;
+
 	/* clear hires texture cache */
 	delete _txHiResCache;
 
@@ -46,6 +49,9 @@ void TxFilter::clear()
 	/* free memory */
 	TxMemBuf::getInstance()->shutdown();
 
+	/* stop worker threads */
+	TxThreadPool::getInstance()->shutdown();
+
 	/* clear other stuff */
 	delete _txImage;
 	delete _txQuantize;
@@ -60,7 +66,7 @@ TxFilter::~TxFilter()
 TxFilter::TxFilter(int maxwidth, int maxheight, int maxbpp, int options,
 	int cachesize, const wchar_t * path, const wchar_t * texPackPath, const wchar_t * ident,
 				   dispInfoFuncExt callback) :
-	_tex1(NULL), _tex2(NULL), _txQuantize(NULL), _txTexCache(NULL), _txHiResCache(NULL), _txUtil(NULL), _txImage(NULL)
+	_tex1(NULL), _tex2(NULL), _txQuantize(NULL), _txTexCache(NULL), _txHiResCache(NULL), _txUtil(NULL), _txImage(NULL), _txDump(NULL)
 {
 	/* HACKALERT: the emulator misbehaves and sometimes forgets to shutdown */
 	if ((ident && wcscmp(ident, wst("DEFAULT")) != 0 && _ident.compare(ident) == 0) &&
@@ -95,6 +101,9 @@ TxFilter::TxFilter(int maxwidth, int maxheight, int maxbpp, int options,
 	/* get number of CPU cores. */
 	_numcore = _txUtil->getNumberofProcessors();
 
+	/* worker threads live until the filter is destroyed */
+	TxThreadPool::getInstance()->init(_numcore);
+
 	_initialized = 0;
 
 	_tex1 = NULL;
@@ -134,12 +143,16 @@ TxFilter::TxFilter(int maxwidth, int maxheight, int maxbpp, int options,
 
 	/* hires texture */
 #if HIRES_TEXTURE
-	_txHiResCache = new TxHiResCache(_maxwidth, _maxheight, _maxbpp, _options, _path.c_str(), texPackPath, _ident.c_str(), callback);
+	_txHiResCache = new TxHiResCache(_maxwidth, _maxheight, _maxbpp, _options, _cacheSize, _path.c_str(), texPackPath, _ident.c_str(), callback);
 
 	if (_txHiResCache->empty())
 		_options &= ~HIRESTEXTURES_MASK;
 #endif
 
+	/* texture dumps are written in the background */
+	if ((_options & DUMP_TEX) && !_path.empty() && !_ident.empty())
+		_txDump = new TxDump(_path.c_str(), _ident.c_str());
+
 	if (_tex1 && _tex2)
 		_initialized = 1;
 }
@@ -291,44 +304,7 @@ TxFilter::filter(uint8 *src, int srcwidth, int srcheight, uint16 srcformat, uint
 
 				tmptex = (texture == _tex1) ? _tex2 : _tex1;
 
-				uint8 *_texture = texture;
-				uint8 *_tmptex  = tmptex;
-
-				unsigned int numcore = _numcore;
-				unsigned int blkrow = 0;
-				while (numcore > 1 && blkrow == 0) {
-					blkrow = (srcheight >> 2) / numcore;
-					numcore--;
-				}
-				if (blkrow > 0 && numcore > 1) {
-					std::thread *thrd[MAX_NUMCORE];
-					unsigned int i;
-					int blkheight = blkrow << 2;
-					unsigned int srcStride = (srcwidth * blkheight) << 2;
-					unsigned int destStride = srcStride * scale * scale;
-					for (i = 0; i < numcore - 1; i++) {
-						thrd[i] = new std::thread(std::bind(filter_8888,
-																(uint32*)_texture,
-																srcwidth,
-																blkheight,
-																(uint32*)_tmptex,
-																filter));
-						_texture += srcStride;
-						_tmptex  += destStride;
-					}
-					thrd[i] = new std::thread(std::bind(filter_8888,
-															(uint32*)_texture,
-															srcwidth,
-															srcheight - blkheight * i,
-															(uint32*)_tmptex,
-															filter));
-					for (i = 0; i < numcore; i++) {
-						thrd[i]->join();
-						delete thrd[i];
-					}
-				} else {
-					filter_8888((uint32*)_texture, srcwidth, srcheight, (uint32*)_tmptex, filter);
-				}
+				filter_8888((uint32*)texture, srcwidth, srcheight, (uint32*)tmptex, filter);
 
 				if (filter & ENHANCEMENT_MASK) {
 					srcwidth  *= scale;
@@ -358,6 +334,20 @@ TxFilter::filter(uint8 *src, int srcwidth, int srcheight, uint16 srcformat, uint
 				}
 			}
 
+			/*
+	   * GPU texture compression
+	   */
+			if (destformat == GL_RGBA8 && (_options & COMPRESS_TEX)) {
+				const uint16 compressedformat = txcompress_format(texture, srcwidth, srcheight, _options);
+				if (compressedformat) {
+					tmptex = (texture == _tex1) ? _tex2 : _tex1;
+					if (txcompress(texture, srcwidth, srcheight, compressedformat, tmptex)) {
+						texture = tmptex;
+						destformat = compressedformat;
+					}
+				}
+			}
+
 		break;
 #if !_16BPP_HACK
 		case GL_RGBA4:
@@ -579,47 +569,9 @@ TxFilter::dmptx(uint8 *src, int width, int height, int rowStridePixel, uint16 gf
 	DBG_INFO(80, wst("hirestex: r_crc64:%08X %08X\n"),
 			 (uint32)(r_crc64 >> 32), (uint32)(r_crc64 & 0xffffffff));
 
-	if (gfmt != GL_RGBA && gfmt != GL_RGBA8) {
-		if (!_txQuantize->quantize(src, _tex1, rowStridePixel, height, gfmt, GL_RGBA8))
-			return 0;
-		src = _tex1;
-	}
-
-	if (!_path.empty() && !_ident.empty()) {
-		/* dump it to disk */
-		FILE *fp = NULL;
-		tx_wstring tmpbuf;
-
-		/* create directories */
-		tmpbuf.assign(_path + wst("/texture_dump"));
-		tmpbuf.append(wst("/"));
-		tmpbuf.append(_ident);
-		tmpbuf.append(wst("/GLideNHQ"));
-		if (!osal_path_existsW(tmpbuf.c_str()) && osal_mkdirp(tmpbuf.c_str()) != 0)
-			return 0;
-
-		if ((n64fmt >> 8) == 0x2) {
-			wchar_t wbuf[256];
-			tx_swprintf(wbuf, 256, wst("/%ls#%08X#%01X#%01X#%08X_ciByRGBA.png"), _ident.c_str(), (uint32)(r_crc64 & 0xffffffff), (n64fmt >> 8), (n64fmt & 0xf), (uint32)(r_crc64 >> 32));
-			tmpbuf.append(wbuf);
-		} else {
-			wchar_t wbuf[256];
-			tx_swprintf(wbuf, 256, wst("/%ls#%08X#%01X#%01X_all.png"), _ident.c_str(), (uint32)(r_crc64 & 0xffffffff), (n64fmt >> 8), (n64fmt & 0xf));
-			tmpbuf.append(wbuf);
-		}
-
-#ifdef WIN32
-		if ((fp = _wfopen(tmpbuf.c_str(), wst("wb"))) != NULL) {
-#else
-		char cbuf[MAX_PATH];
-		wcstombs(cbuf, tmpbuf.c_str(), MAX_PATH);
-		if ((fp = fopen(cbuf, "wb")) != NULL) {
-#endif
-			_txImage->writePNG(src, fp, width, height, (rowStridePixel << 2), 0x0003, 0);
-			fclose(fp);
-			return 1;
-		}
-	}
+	/* copies the texture, conversion and PNG encoding run on the dump thread */
+	if (_txDump)
+		return _txDump->dump(src, width, height, rowStridePixel, gfmt, n64fmt, r_crc64);
 
 	return 0;
 }
@@ -30,6 +30,7 @@
 #include "TxTexCache.h"
 #include "TxUtil.h"
 #include "TxImage.h"
+#include "TxDump.h"
 
 class TxFilter
 {
@@ -50,6 +51,7 @@ private:
   TxHiResCache *_txHiResCache;
   TxUtil *_txUtil;
   TxImage *_txImage;
+  TxDump *_txDump;
   boolean _initialized;
   void clear();
 public:
@@ -26,6 +26,7 @@
 #endif
 
 #include "TxFilter.h"
+#include "TextureFilters.h"
 
 TxFilter *txFilter = NULL;
 
@@ -101,6 +102,23 @@ txfilter_reloadhirestex()
   return 0;
 }
 
+TAPI int TAPIENTRY
+txfilter_enhancementlut(int enhancement, uint32 *lut)
+{
+  switch (enhancement & ENHANCEMENT_MASK) {
+  case HQ2X_ENHANCEMENT:
+	if (lut)
+	  hq2x_32_lut(lut);
+	return 2;
+  case HQ4X_ENHANCEMENT:
+	if (lut)
+	  hq4x_8888_lut(lut);
+	return 4;
+  }
+
+  return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
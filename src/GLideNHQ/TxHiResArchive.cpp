@@ -0,0 +1,188 @@
+#include "TxHiResArchive.h"
+#include "TxUtil.h"
+#include "TxDbg.h"
+#include <osal_files.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIRESARCHIVE_MAGIC "GHTA"
+#define HIRESARCHIVE_VERSION 1
+/* texture data alignment in the file */
+#define HIRESARCHIVE_ALIGN 16
+/* larger textures are not valid, this also keeps TxUtil::sizeofTx from overflowing */
+#define HIRESARCHIVE_MAX_SIZE 16384
+
+boolean
+TxHiResArchive::open(const wchar_t *filename, int config)
+{
+  close();
+
+  size_t size = 0;
+  const uint8 *data = (const uint8 *)osal_file_map(filename, &size);
+  if (!data)
+	return 0;
+
+  const HEADER *header = (const HEADER *)data;
+  if (size < sizeof(HEADER) ||
+	  memcmp(header->magic, HIRESARCHIVE_MAGIC, 4) != 0 ||
+	  header->version != HIRESARCHIVE_VERSION ||
+	  header->config != (uint32)config ||
+	  (header->index % sizeof(uint64)) != 0 ||
+	  header->index > size ||
+	  header->count > (size - header->index) / sizeof(ENTRY)) {
+	DBG_INFO(80, wst("Error: hires archive header mismatch! %ls\n"), filename);
+	osal_file_unmap(data, size);
+	return 0;
+  }
+
+  /* lookups trust the index from here on. Texture data is uploaded in place,
+   * so it must hold the whole texture in its format. Packed data (GL_TEXFMT_PACKED
+   * in the high bits) is never unpacked and is rejected, as are unknown formats. */
+  TxUtil txUtil;
+  const ENTRY *entries = (const ENTRY *)(data + header->index);
+  for (uint32 i = 0; i < header->count; i++) {
+	const ENTRY &entry = entries[i];
+	const int dataSize = (entry.format & 0xffff0000) || entry.width > HIRESARCHIVE_MAX_SIZE || entry.height > HIRESARCHIVE_MAX_SIZE ?
+	  0 : txUtil.sizeofTx(entry.width, entry.height, (uint16)entry.format);
+	if (entry.offset > header->index || entry.size > header->index - entry.offset ||
+		dataSize <= 0 || entry.size < (uint32)dataSize ||
+		(i > 0 && entry.checksum <= entries[i - 1].checksum)) {
+	  DBG_INFO(80, wst("Error: hires archive index broken! %ls\n"), filename);
+	  osal_file_unmap(data, size);
+	  return 0;
+	}
+  }
+
+  _data = data;
+  _size = size;
+  _entries = entries;
+  _count = header->count;
+
+  return 1;
+}
+
+void
+TxHiResArchive::close()
+{
+  osal_file_unmap(_data, _size);
+  _data = NULL;
+  _size = 0;
+  _entries = NULL;
+  _count = 0;
+}
+
+boolean
+TxHiResArchive::get(uint64 checksum, GHQTexInfo *info) const
+{
+  if (!_count || !checksum)
+	return 0;
+
+  const ENTRY *entry = std::lower_bound(_entries, _entries + _count, checksum,
+	[](const ENTRY &e, uint64 value) { return e.checksum < value; });
+  if (entry == _entries + _count || entry->checksum != checksum)
+	return 0;
+
+  info->data = (uint8 *)(_data + entry->offset);
+  info->width = entry->width;
+  info->height = entry->height;
+  info->format = entry->format;
+  info->texture_format = entry->texture_format;
+  info->pixel_type = entry->pixel_type;
+  info->is_hires_tex = 1;
+
+  return 1;
+}
+
+TxHiResArchive::Writer::~Writer()
+{
+  /* not closed, leave a file which fails to open */
+  if (_fp)
+	fclose(_fp);
+}
+
+boolean
+TxHiResArchive::Writer::open(const wchar_t *filename, int config)
+{
+#ifdef WIN32
+  _fp = _wfopen(filename, L"wb");
+#else
+  char cbuf[MAX_PATH];
+  wcstombs(cbuf, filename, MAX_PATH);
+  _fp = fopen(cbuf, "wb");
+#endif
+  if (!_fp)
+	return 0;
+
+  _config = config;
+  _index.clear();
+
+  /* header is written at the end, zeroed magic keeps unfinished files from loading */
+  HEADER header;
+  memset(&header, 0, sizeof(header));
+  _offset = sizeof(header);
+  return fwrite(&header, sizeof(header), 1, _fp) == 1;
+}
+
+boolean
+TxHiResArchive::Writer::_pad(uint64 alignment)
+{
+  static const uint8 zeros[HIRESARCHIVE_ALIGN] = { 0 };
+  const size_t padding = (size_t)((alignment - (_offset % alignment)) % alignment);
+  _offset += padding;
+  return padding == 0 || fwrite(zeros, padding, 1, _fp) == 1;
+}
+
+boolean
+TxHiResArchive::Writer::add(uint64 checksum, const GHQTexInfo *info, const uint8 *data, uint32 size)
+{
+  if (!_fp || !checksum || !size || (!_index.empty() && checksum <= _index.back().checksum) ||
+	  info->width > 0xffff || info->height > 0xffff)
+	return 0;
+
+  if (!_pad(HIRESARCHIVE_ALIGN))
+	return 0;
+
+  ENTRY entry;
+  entry.checksum = checksum;
+  entry.offset = _offset;
+  entry.size = size;
+  entry.format = info->format;
+  entry.width = (uint16)info->width;
+  entry.height = (uint16)info->height;
+  entry.texture_format = info->texture_format;
+  entry.pixel_type = info->pixel_type;
+
+  if (fwrite(data, size, 1, _fp) != 1)
+	return 0;
+  _offset += size;
+  _index.push_back(entry);
+
+  return 1;
+}
+
+boolean
+TxHiResArchive::Writer::close()
+{
+  if (!_fp)
+	return 0;
+
+  boolean ok = _pad(sizeof(uint64));
+
+  HEADER header;
+  memcpy(header.magic, HIRESARCHIVE_MAGIC, 4);
+  header.version = HIRESARCHIVE_VERSION;
+  header.config = (uint32)_config;
+  header.count = (uint32)_index.size();
+  header.index = _offset;
+
+  if (ok && !_index.empty())
+	ok = fwrite(_index.data(), sizeof(ENTRY), _index.size(), _fp) == _index.size();
+  if (ok)
+	ok = fseek(_fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, _fp) == 1;
+  ok = (fclose(_fp) == 0) && ok;
+  _fp = NULL;
+  _index.clear();
+
+  return ok;
+}
@@ -0,0 +1,72 @@
+#ifndef __TXHIRESARCHIVE_H__
+#define __TXHIRESARCHIVE_H__
+
+#include <stdio.h>
+#include <vector>
+#include "TxInternal.h"
+
+#define HIRESARCHIVE_EXT wst("hta")
+
+/* Hires texture archive.
+ * Single file with the textures of a pack in the formats TxHiResCache gives
+ * to the plugin: header, texture data, then the index sorted by checksum.
+ * The file is memory mapped. Lookups are a binary search over the index and
+ * return pointers into the mapping, which are uploaded without a copy.
+ * Values are in the byte order of the machine which wrote the archive.
+ */
+class TxHiResArchive
+{
+private:
+  struct HEADER {
+	char magic[4];
+	uint32 version;
+	uint32 config;    /* hires options the textures were converted with */
+	uint32 count;
+	uint64 index;     /* file offset of the index */
+  };
+  struct ENTRY {
+	uint64 checksum;  /* hi:palette low:texture */
+	uint64 offset;    /* file offset of the texture data */
+	uint32 size;
+	uint32 format;
+	uint16 width;
+	uint16 height;
+	uint16 texture_format;
+	uint16 pixel_type;
+  };
+  const uint8 *_data;
+  size_t _size;
+  const ENTRY *_entries;
+  uint32 _count;
+  TxHiResArchive(const TxHiResArchive &);
+public:
+  TxHiResArchive() : _data(NULL), _size(0), _entries(NULL), _count(0) {}
+  ~TxHiResArchive() { close(); }
+  /* fails if the file is missing, broken or made with another config */
+  boolean open(const wchar_t *filename, int config);
+  void close();
+  boolean isOpen() const { return _data != NULL; }
+  uint32 count() const { return _count; }
+  boolean get(uint64 checksum, GHQTexInfo *info) const;
+
+  /* textures must be added with increasing checksum */
+  class Writer
+  {
+  private:
+	FILE *_fp;
+	int _config;
+	uint64 _offset;
+	std::vector<ENTRY> _index;
+	boolean _pad(uint64 alignment);
+	Writer(const Writer &);
+  public:
+	Writer() : _fp(NULL), _config(0), _offset(0) {}
+	~Writer();
+	boolean open(const wchar_t *filename, int config);
+	boolean add(uint64 checksum, const GHQTexInfo *info, const uint8 *data, uint32 size);
+	/* writes the index, the archive is valid after that */
+	boolean close();
+  };
+};
+
+#endif /* __TXHIRESARCHIVE_H__ */
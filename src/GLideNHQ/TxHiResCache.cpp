@@ -45,10 +45,17 @@
  * (0:disable, 1:enable, 2:extreme) */
 #define AGGRESSIVE_QUANTIZATION 1
 
+/* number of files per pool thread decoded in parallel
+ * before they are added to the cache */
+#define LOAD_BATCH_PER_THREAD 4
+
 #include "TxHiResCache.h"
+#include "TxCompress.h"
 #include "TxDbg.h"
+#include "TxThreadPool.h"
 #include <osal_files.h>
 #include <zlib.h>
+#include <algorithm>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -58,13 +65,12 @@ TxHiResCache::~TxHiResCache()
 #if DUMP_CACHE
   if ((_options & DUMP_HIRESTEXCACHE) && !_haveCache && !_abortLoad) {
 	/* dump cache to disk */
-	tx_wstring filename = _ident + wst("_HIRESTEXTURES.") + TEXCACHE_EXT;
+	tx_wstring filename = _ident + wst("_HIRESTEXTURES.") + HIRESARCHIVE_EXT;
 	tx_wstring cachepath(_path);
 	cachepath += OSAL_DIR_SEPARATOR_STR;
 	cachepath += wst("cache");
-	int config = _options & (HIRESTEXTURES_MASK|TILE_HIRESTEX|FORCE16BPP_HIRESTEX|GZ_HIRESTEXCACHE|LET_TEXARTISTS_FLY);
 
-	TxCache::save(cachepath.c_str(), filename.c_str(), config);
+	saveArchive(cachepath.c_str(), filename.c_str());
   }
 #endif
 
@@ -73,10 +79,10 @@ TxHiResCache::~TxHiResCache()
   delete _txReSample;
 }
 
-TxHiResCache::TxHiResCache(int maxwidth, int maxheight, int maxbpp, int options,
+TxHiResCache::TxHiResCache(int maxwidth, int maxheight, int maxbpp, int options, int cachesize,
 	const wchar_t *cachePath, const wchar_t *texPackPath, const wchar_t *ident,
 	dispInfoFuncExt callback
-	) : TxCache((options & ~GZ_TEXCACHE), 0, cachePath, ident, callback)
+	) : TxCache((options & ~GZ_TEXCACHE), (options & LAZY_HIRESTEX) ? cachesize : 0, cachePath, ident, callback)
 {
   _txImage = new TxImage();
   _txQuantize  = new TxQuantize();
@@ -97,19 +103,25 @@ TxHiResCache::TxHiResCache(int maxwidth, int maxheight, int maxbpp, int options,
   }
 
 #if DUMP_CACHE
-  /* read in hires texture cache */
+  /* map hires texture archive */
   if (_options & DUMP_HIRESTEXCACHE) {
 	/* find it on disk */
-	tx_wstring filename = _ident + wst("_HIRESTEXTURES.") + TEXCACHE_EXT;
-	tx_wstring cachepath(_path);
-	cachepath += OSAL_DIR_SEPARATOR_STR;
-	cachepath += wst("cache");
-	int config = _options & (HIRESTEXTURES_MASK|TILE_HIRESTEX|FORCE16BPP_HIRESTEX|GZ_HIRESTEXCACHE|LET_TEXARTISTS_FLY);
-
-	_haveCache = TxCache::load(cachepath.c_str(), filename.c_str(), config);
+	tx_wstring filename(_path);
+	filename += OSAL_DIR_SEPARATOR_STR;
+	filename += wst("cache");
+	filename += OSAL_DIR_SEPARATOR_STR;
+	filename += _ident + wst("_HIRESTEXTURES.") + HIRESARCHIVE_EXT;
+
+	_haveCache = _archive.open(filename.c_str(), archiveConfig());
+	if (_haveCache && _callback)
+	  (*_callback)(wst("[%d] hires textures in archive\n"), _archive.count());
   }
 #endif
 
+  /* an archive is written from all textures of the pack in memory, the lazy index does not have them */
+  if (_options & LAZY_HIRESTEX)
+	_options &= ~DUMP_HIRESTEXCACHE;
+
   /* read in hires textures */
   if (!_haveCache) TxHiResCache::load(0);
 }
@@ -117,7 +129,54 @@ TxHiResCache::TxHiResCache(int maxwidth, int maxheight, int maxbpp, int options,
 boolean
 TxHiResCache::empty()
 {
-  return _cache.empty();
+  return !count() && _index.empty() && !_archive.isOpen();
+}
+
+int
+TxHiResCache::archiveConfig() const
+{
+  /* textures are stored as they are uploaded, GZ_HIRESTEXCACHE does not matter */
+  return _options & (HIRESTEXTURES_MASK|COMPRESSION_MASK|COMPRESS_HIRESTEX|TILE_HIRESTEX|FORCE16BPP_HIRESTEX|LET_TEXARTISTS_FLY);
+}
+
+boolean
+TxHiResCache::get(uint64 checksum, GHQTexInfo *info)
+{
+  if (TxCache::get(checksum, info))
+	return 1;
+
+  /* archive textures are used in place */
+  if (_archive.get(checksum, info))
+	return info->width <= _maxwidth && info->height <= _maxheight;
+
+  if (!(_options & LAZY_HIRESTEX) || !checksum)
+	return 0;
+
+  std::unordered_map<uint64, HIRESFILE>::iterator itIndex = _index.find(checksum);
+  if (itIndex == _index.end())
+	return 0;
+
+  /* decode it on first request. memory cache drops least recently used
+   * textures when it is full, they are decoded again when requested. */
+  char fname[MAX_PATH];
+  strcpy(fname, itIndex->second.path.c_str());
+  int width = 0, height = 0;
+  uint16 format = 0;
+  uint8 *tex = loadFile(fname, fname + itIndex->second.suffix, itIndex->second.fmt, itIndex->second.siz,
+						&width, &height, &format);
+  boolean added = 0;
+  if (tex) {
+	added = addFile(checksum, tex, width, height, format, 0);
+	free(tex);
+  }
+  if (!added) {
+	/* do not try broken files again */
+	DBG_INFO(80, wst("Error: lazy load failed! %s\n"), itIndex->second.path.c_str());
+	_index.erase(itIndex);
+	return 0;
+  }
+
+  return TxCache::get(checksum, info);
 }
 
 boolean
@@ -125,7 +184,11 @@ TxHiResCache::load(boolean replace) /* 0 : reload, 1 : replace partial */
 {
   if (!_texPackPath.empty() && !_ident.empty()) {
 
-	if (!replace) TxCache::clear();
+	if (!replace) {
+	  TxCache::clear();
+	  _index.clear();
+	  _archive.close();
+	}
 
 	tx_wstring dir_path(_texPackPath);
 
@@ -148,6 +211,9 @@ TxHiResCache::load(boolean replace) /* 0 : reload, 1 : replace partial */
 	  dir_path += _ident;
 
 	  loadHiResTextures(dir_path.c_str(), replace);
+	  flushLoadQueue(replace);
+	  if ((_options & LAZY_HIRESTEX) && _callback)
+		(*_callback)(wst("[%d] hires textures indexed\n"), _index.size());
 	  break;
 	case JABO_HIRESTEXTURES:
 	  ;
@@ -159,6 +225,27 @@ TxHiResCache::load(boolean replace) /* 0 : reload, 1 : replace partial */
   return 0;
 }
 
+/* _all.png, _all.dds, _allciByRGBA.png, _allciByRGBA.dds,
+ * _ciByRGBA.png, _ciByRGBA.dds, _ci.bmp */
+static boolean
+isSingleFileTexture(const char *fname, const char *pfname)
+{
+  return (pfname == strstr(fname, "_all.png") ||
+		  pfname == strstr(fname, "_all.dds") ||
+#ifdef WIN32
+		  pfname == strstr(fname, "_allcibyrgba.png") ||
+		  pfname == strstr(fname, "_allcibyrgba.dds") ||
+		  pfname == strstr(fname, "_cibyrgba.png") ||
+		  pfname == strstr(fname, "_cibyrgba.dds") ||
+#else
+		  pfname == strstr(fname, "_allciByRGBA.png") ||
+		  pfname == strstr(fname, "_allciByRGBA.dds") ||
+		  pfname == strstr(fname, "_ciByRGBA.png") ||
+		  pfname == strstr(fname, "_ciByRGBA.dds") ||
+#endif
+		  pfname == strstr(fname, "_ci.bmp"));
+}
+
 boolean
 TxHiResCache::loadHiResTextures(const wchar_t * dir_path, boolean replace)
 {
@@ -188,6 +275,11 @@ TxHiResCache::loadHiResTextures(const wchar_t * dir_path, boolean replace)
   CHDIR(cbuf);
 #endif
 
+  /* files are opened later with full path, by lazy loading or on the thread pool.
+   * folder names are US-ASCII anyway. */
+  char dirname[MAX_PATH];
+  wcstombs(dirname, dir_path, MAX_PATH);
+
   void *dir = osal_search_dir_open(dir_path);
   const wchar_t *foundfilename;
   // the path of the texture
@@ -223,20 +315,12 @@ TxHiResCache::loadHiResTextures(const wchar_t * dir_path, boolean replace)
 	DBG_INFO(80, wst("-----\n"));
 	DBG_INFO(80, wst("file: %ls\n"), foundfilename);
 
-	int width = 0, height = 0;
-	uint16 format = 0;
-	uint8 *tex = NULL;
-	int tmpwidth = 0, tmpheight = 0;
-	uint16 tmpformat = 0;
-	uint8 *tmptex= NULL;
-	uint16 destformat = 0;
 
 	/* Rice hi-res textures: begin
 	 */
 	uint32 chksum = 0, fmt = 0, siz = 0, palchksum = 0;
 	char *pfname = NULL, fname[MAX_PATH];
 	std::string ident;
-	FILE *fp = NULL;
 
 	wcstombs(fname, _ident.c_str(), MAX_PATH);
 	/* XXX case sensitivity fiasco!
@@ -304,12 +388,13 @@ TxHiResCache::loadHiResTextures(const wchar_t * dir_path, boolean replace)
 	  continue;
 	}
 
+	uint64 chksum64 = (uint64)palchksum;
+	chksum64 <<= 32;
+	chksum64 |= (uint64)chksum;
+
 	/* check if we already have it in hires texture cache */
 	if (!replace) {
-	  uint64 chksum64 = (uint64)palchksum;
-	  chksum64 <<= 32;
-	  chksum64 |= (uint64)chksum;
-	  if (TxCache::is_cached(chksum64)) {
+	  if (TxCache::is_cached(chksum64) || _index.find(chksum64) != _index.end()) {
 #if !DEBUG
 		INFO(80, wst("-----\n"));
 		INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
@@ -322,445 +407,573 @@ TxHiResCache::loadHiResTextures(const wchar_t * dir_path, boolean replace)
 
 	DBG_INFO(80, wst("rom: %ls chksum:%08X %08X fmt:%x size:%x\n"), _ident.c_str(), chksum, palchksum, fmt, siz);
 
-	/* Deal with the wackiness some texture packs utilize Rice format.
-	 * Read in the following order: _a.* + _rgb.*, _all.png _ciByRGBA.png,
-	 * _allciByRGBA.png, and _ci.bmp. PNG are prefered over BMP.
-	 *
-	 * For some reason there are texture packs that include them all. Some
-	 * even have RGB textures named as _all.* and ARGB textures named as
-	 * _rgb.*... Someone pleeeez write a GOOD guideline for the texture
-	 * designers!!!
-	 *
-	 * We allow hires textures to have higher bpp than the N64 originals.
-	 */
-	/* N64 formats
-	 * Format: 0 - RGBA, 1 - YUV, 2 - CI, 3 - IA, 4 - I
-	 * Size:   0 - 4bit, 1 - 8bit, 2 - 16bit, 3 - 32 bit
-	 */
+	HIRESFILE file;
+	file.path.assign(dirname);
+	file.path += '/';
+	file.path += fname;
+	if (file.path.size() >= MAX_PATH) {
+	  INFO(80, wst("Error: path too long!\n"));
+	  continue;
+	}
+	file.suffix = (uint16)(file.path.size() - strlen(pfname));
+	file.fmt = (uint8)fmt;
+	file.siz = (uint8)siz;
+
+	if (_options & LAZY_HIRESTEX) {
+	  /* only remember where the texture is. get() decodes it on first request. */
+	  if (!(pfname == strstr(fname, "_rgb.") || pfname == strstr(fname, "_a.") || isSingleFileTexture(fname, pfname))) {
+		INFO(80, wst("Error: not Rice texture naming convention!\n"));
+		continue;
+	  }
 
-	/*
-	 * read in _rgb.* and _a.*
-	 */
-	if (pfname == strstr(fname, "_rgb.") || pfname == strstr(fname, "_a.")) {
-	  strcpy(pfname, "_rgb.png");
+	  /* remove redundant in cache */
+	  if (replace && TxCache::del(chksum64)) {
+		DBG_INFO(80, wst("removed duplicate old cache.\n"));
+	  }
+	  _index[chksum64] = file;
+
+	  /* skip in between, the callback may wait for vsync */
+	  if (_callback && !(_index.size() % 1000))
+		(*_callback)(wst("[%d] hires textures indexed\n"), _index.size());
+	  continue;
+	}
+
+	/* decode it with the next batch */
+	HIRESLOAD load;
+	load.chksum64 = chksum64;
+	load.file = file;
+	load.tex = NULL;
+	load.width = load.height = 0;
+	load.format = 0;
+	_loadQueue.push_back(load);
+	if (_loadQueue.size() >= TxThreadPool::getInstance()->getNumThreads() * LOAD_BATCH_PER_THREAD)
+	  flushLoadQueue(replace);
+
+  } while (foundfilename != NULL);
+  osal_search_dir_close(dir);
+
+  CHDIR(curpath);
+
+  return 1;
+}
+
+void
+TxHiResCache::flushLoadQueue(boolean replace)
+{
+  /* decode and convert on all pool threads. files are opened with full
+   * paths, the current directory changes while the pack is searched. */
+  if (!_abortLoad) {
+	TxThreadPool::getInstance()->run((unsigned int)_loadQueue.size(), 1, [this](unsigned int first, unsigned int last) {
+	  for (unsigned int i = first; i < last; i++) {
+		HIRESLOAD &load = _loadQueue[i];
+		char fname[MAX_PATH];
+		strcpy(fname, load.file.path.c_str());
+		load.tex = loadFile(fname, fname + load.file.suffix, load.file.fmt, load.file.siz,
+							&load.width, &load.height, &load.format);
+	  }
+	});
+  }
+
+  /* TxCache and the callback are used from this thread only.
+   * files are added in the order they were found, so the first
+   * one of duplicate textures in a batch wins as before. */
+  for (unsigned int i = 0; i < _loadQueue.size(); i++) {
+	HIRESLOAD &load = _loadQueue[i];
+	if (!load.tex)
+	  continue;
+
+	if (!_abortLoad && (replace || !TxCache::is_cached(load.chksum64)) &&
+		addFile(load.chksum64, load.tex, load.width, load.height, load.format, replace)) {
+	  /* Callback to display hires texture info.
+	   * Gonetz <gonetz(at)ngs.ru> */
+	  if (_callback) {
+		wchar_t tmpbuf[MAX_PATH];
+		mbstowcs(tmpbuf, load.file.path.c_str() + load.file.path.rfind('/') + 1, MAX_PATH);
+		(*_callback)(wst("[%d] total mem:%.2fmb - %ls\n"), count(), (float)_totalSize/1000000, tmpbuf);
+	  }
+	  DBG_INFO(80, wst("texture loaded!\n"));
+	}
+	free(load.tex);
+  }
+  _loadQueue.clear();
+}
+
+uint8 *
+TxHiResCache::loadFile(char *fname, char *pfname, uint32 fmt, uint32 siz, int *texwidth, int *texheight, uint16 *texformat)
+{
+  int width = 0, height = 0;
+  uint16 format = 0;
+  uint8 *tex = NULL;
+  int tmpwidth = 0, tmpheight = 0;
+  uint16 tmpformat = 0;
+  uint8 *tmptex= NULL;
+  uint16 destformat = 0;
+  FILE *fp = NULL;
+
+  /* Deal with the wackiness some texture packs utilize Rice format.
+   * Read in the following order: _a.* + _rgb.*, _all.png _ciByRGBA.png,
+   * _allciByRGBA.png, and _ci.bmp. PNG are prefered over BMP.
+   *
+   * For some reason there are texture packs that include them all. Some
+   * even have RGB textures named as _all.* and ARGB textures named as
+   * _rgb.*... Someone pleeeez write a GOOD guideline for the texture
+   * designers!!!
+   *
+   * We allow hires textures to have higher bpp than the N64 originals.
+   */
+  /* N64 formats
+   * Format: 0 - RGBA, 1 - YUV, 2 - CI, 3 - IA, 4 - I
+   * Size:   0 - 4bit, 1 - 8bit, 2 - 16bit, 3 - 32 bit
+   */
+
+  /*
+   * read in _rgb.* and _a.*
+   */
+  if (pfname == strstr(fname, "_rgb.") || pfname == strstr(fname, "_a.")) {
+	strcpy(pfname, "_rgb.png");
+	if (!osal_path_existsA(fname)) {
+	  strcpy(pfname, "_rgb.bmp");
 	  if (!osal_path_existsA(fname)) {
-		strcpy(pfname, "_rgb.bmp");
-		if (!osal_path_existsA(fname)) {
 #if !DEBUG
-		  INFO(80, wst("-----\n"));
-		  INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
-		  INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
+		INFO(80, wst("-----\n"));
+		INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
+		INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
 #endif
-		  INFO(80, wst("Error: missing _rgb.*! _a.* must be paired with _rgb.*!\n"));
-		  continue;
-		}
+		INFO(80, wst("Error: missing _rgb.*! _a.* must be paired with _rgb.*!\n"));
+		return NULL;
 	  }
-	  /* _a.png */
-	  strcpy(pfname, "_a.png");
+	}
+	/* _a.png */
+	strcpy(pfname, "_a.png");
+	if ((fp = fopen(fname, "rb")) != NULL) {
+	  tmptex = _txImage->readPNG(fp, &tmpwidth, &tmpheight, &tmpformat);
+	  fclose(fp);
+	}
+	if (!tmptex) {
+	  /* _a.bmp */
+	  strcpy(pfname, "_a.bmp");
 	  if ((fp = fopen(fname, "rb")) != NULL) {
-		tmptex = _txImage->readPNG(fp, &tmpwidth, &tmpheight, &tmpformat);
+		tmptex = _txImage->readBMP(fp, &tmpwidth, &tmpheight, &tmpformat);
 		fclose(fp);
 	  }
-	  if (!tmptex) {
-		/* _a.bmp */
-		strcpy(pfname, "_a.bmp");
-		if ((fp = fopen(fname, "rb")) != NULL) {
-		  tmptex = _txImage->readBMP(fp, &tmpwidth, &tmpheight, &tmpformat);
-		  fclose(fp);
-		}
-	  }
-	  /* _rgb.png */
-	  strcpy(pfname, "_rgb.png");
+	}
+	/* _rgb.png */
+	strcpy(pfname, "_rgb.png");
+	if ((fp = fopen(fname, "rb")) != NULL) {
+	  tex = _txImage->readPNG(fp, &width, &height, &format);
+	  fclose(fp);
+	}
+	if (!tex) {
+	  /* _rgb.bmp */
+	  strcpy(pfname, "_rgb.bmp");
 	  if ((fp = fopen(fname, "rb")) != NULL) {
-		tex = _txImage->readPNG(fp, &width, &height, &format);
+		tex = _txImage->readBMP(fp, &width, &height, &format);
 		fclose(fp);
 	  }
-	  if (!tex) {
-		/* _rgb.bmp */
-		strcpy(pfname, "_rgb.bmp");
-		if ((fp = fopen(fname, "rb")) != NULL) {
-		  tex = _txImage->readBMP(fp, &width, &height, &format);
-		  fclose(fp);
-		}
-	  }
-	  if (tmptex) {
-		/* check if _rgb.* and _a.* have matching size and format. */
-		if (!tex || width != tmpwidth || height != tmpheight ||
-			format != GL_RGBA8 || tmpformat != GL_RGBA8) {
+	}
+	if (tmptex) {
+	  /* check if _rgb.* and _a.* have matching size and format. */
+	  if (!tex || width != tmpwidth || height != tmpheight ||
+		  format != GL_RGBA8 || tmpformat != GL_RGBA8) {
 #if !DEBUG
-		  INFO(80, wst("-----\n"));
-		  INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
-		  INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
+		INFO(80, wst("-----\n"));
+		INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
+		INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
 #endif
-		  if (!tex) {
-			INFO(80, wst("Error: missing _rgb.*!\n"));
-		  } else if (width != tmpwidth || height != tmpheight) {
-			INFO(80, wst("Error: _rgb.* and _a.* have mismatched width or height!\n"));
-		  } else if (format != GL_RGBA8 || tmpformat != GL_RGBA8) {
-			INFO(80, wst("Error: _rgb.* or _a.* not in 32bit color!\n"));
-		  }
-		  if (tex) free(tex);
-		  if (tmptex) free(tmptex);
-		  tex = NULL;
-		  tmptex = NULL;
-		  continue;
+		if (!tex) {
+		  INFO(80, wst("Error: missing _rgb.*!\n"));
+		} else if (width != tmpwidth || height != tmpheight) {
+		  INFO(80, wst("Error: _rgb.* and _a.* have mismatched width or height!\n"));
+		} else if (format != GL_RGBA8 || tmpformat != GL_RGBA8) {
+		  INFO(80, wst("Error: _rgb.* or _a.* not in 32bit color!\n"));
 		}
+		if (tex) free(tex);
+		if (tmptex) free(tmptex);
+		tex = NULL;
+		tmptex = NULL;
+		return NULL;
 	  }
-	  /* make adjustments */
-	  if (tex) {
-		if (tmptex) {
-		  /* merge (A)RGB and A comp */
-		  DBG_INFO(80, wst("merge (A)RGB and A comp\n"));
-		  int i;
-		  for (i = 0; i < height * width; i++) {
+	}
+	/* make adjustments */
+	if (tex) {
+	  if (tmptex) {
+		/* merge (A)RGB and A comp */
+		DBG_INFO(80, wst("merge (A)RGB and A comp\n"));
+		int i;
+		for (i = 0; i < height * width; i++) {
 #if 1
-			/* use R comp for alpha. this is what Rice uses. sigh... */
-			((uint32*)tex)[i] &= 0x00ffffff;
-			((uint32*)tex)[i] |= ((((uint32*)tmptex)[i] & 0xff) << 24);
+		  /* use R comp for alpha. this is what Rice uses. sigh... */
+		  ((uint32*)tex)[i] &= 0x00ffffff;
+		  ((uint32*)tex)[i] |= ((((uint32*)tmptex)[i] & 0xff) << 24);
 #endif
 #if 0
-			/* use libpng style grayscale conversion */
-			uint32 texel = ((uint32*)tmptex)[i];
-			uint32 acomp = (((texel >> 16) & 0xff) * 6969 +
-							((texel >>  8) & 0xff) * 23434 +
-							((texel      ) & 0xff) * 2365) / 32768;
-			((uint32*)tex)[i] = (acomp << 24) | (((uint32*)tex)[i] & 0x00ffffff);
+		  /* use libpng style grayscale conversion */
+		  uint32 texel = ((uint32*)tmptex)[i];
+		  uint32 acomp = (((texel >> 16) & 0xff) * 6969 +
+						  ((texel >>  8) & 0xff) * 23434 +
+						  ((texel      ) & 0xff) * 2365) / 32768;
+		  ((uint32*)tex)[i] = (acomp << 24) | (((uint32*)tex)[i] & 0x00ffffff);
 #endif
 #if 0
-			/* use the standard NTSC gray scale conversion */
-			uint32 texel = ((uint32*)tmptex)[i];
-			uint32 acomp = (((texel >> 16) & 0xff) * 299 +
-							((texel >>  8) & 0xff) * 587 +
-							((texel      ) & 0xff) * 114) / 1000;
-			((uint32*)tex)[i] = (acomp << 24) | (((uint32*)tex)[i] & 0x00ffffff);
+		  /* use the standard NTSC gray scale conversion */
+		  uint32 texel = ((uint32*)tmptex)[i];
+		  uint32 acomp = (((texel >> 16) & 0xff) * 299 +
+						  ((texel >>  8) & 0xff) * 587 +
+						  ((texel      ) & 0xff) * 114) / 1000;
+		  ((uint32*)tex)[i] = (acomp << 24) | (((uint32*)tex)[i] & 0x00ffffff);
 #endif
-		  }
-		  free(tmptex);
-		  tmptex = NULL;
-		} else {
-		  /* clobber A comp. never a question of alpha. only RGB used. */
+		}
+		free(tmptex);
+		tmptex = NULL;
+	  } else {
+		/* clobber A comp. never a question of alpha. only RGB used. */
 #if !DEBUG
-		  INFO(80, wst("-----\n"));
-		  INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
-		  INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
+		INFO(80, wst("-----\n"));
+		INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
+		INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
 #endif
-		  INFO(80, wst("Warning: missing _a.*! only using _rgb.*. treat as opaque texture.\n"));
-		  int i;
-		  for (i = 0; i < height * width; i++) {
-			((uint32*)tex)[i] |= 0xff000000;
-		  }
+		INFO(80, wst("Warning: missing _a.*! only using _rgb.*. treat as opaque texture.\n"));
+		int i;
+		for (i = 0; i < height * width; i++) {
+		  ((uint32*)tex)[i] |= 0xff000000;
 		}
 	  }
-	} else
+	}
+  } else
 
-	/*
-	 * read in _all.png, _all.dds, _allciByRGBA.png, _allciByRGBA.dds
-	 * _ciByRGBA.png, _ciByRGBA.dds, _ci.bmp
-	 */
-	if (pfname == strstr(fname, "_all.png") ||
-		pfname == strstr(fname, "_all.dds") ||
-#ifdef WIN32
-		pfname == strstr(fname, "_allcibyrgba.png") ||
-		pfname == strstr(fname, "_allcibyrgba.dds") ||
-		pfname == strstr(fname, "_cibyrgba.png") ||
-		pfname == strstr(fname, "_cibyrgba.dds") ||
-#else
-		pfname == strstr(fname, "_allciByRGBA.png") ||
-		pfname == strstr(fname, "_allciByRGBA.dds") ||
-		pfname == strstr(fname, "_ciByRGBA.png") ||
-		pfname == strstr(fname, "_ciByRGBA.dds") ||
-#endif
-		pfname == strstr(fname, "_ci.bmp")) {
-	  if ((fp = fopen(fname, "rb")) != NULL) {
-		if      (strstr(fname, ".png")) tex = _txImage->readPNG(fp, &width, &height, &format);
-		else                            tex = _txImage->readBMP(fp, &width, &height, &format);
-		fclose(fp);
-	  }
+  /*
+   * read in _all.png, _all.dds, _allciByRGBA.png, _allciByRGBA.dds
+   * _ciByRGBA.png, _ciByRGBA.dds, _ci.bmp
+   */
+  if (isSingleFileTexture(fname, pfname)) {
+	if ((fp = fopen(fname, "rb")) != NULL) {
+	  if      (strstr(fname, ".png")) tex = _txImage->readPNG(fp, &width, &height, &format);
+	  else                            tex = _txImage->readBMP(fp, &width, &height, &format);
+	  fclose(fp);
 	}
+  }
 
-	/* if we do not have a texture at this point we are screwed */
-	if (!tex) {
+  /* if we do not have a texture at this point we are screwed */
+  if (!tex) {
 #if !DEBUG
-	  INFO(80, wst("-----\n"));
-	  INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
-	  INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
+	INFO(80, wst("-----\n"));
+	INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
+	INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
 #endif
-	  INFO(80, wst("Error: load failed!\n"));
-	  continue;
-	}
-	DBG_INFO(80, wst("read in as %d x %d gfmt:%x\n"), tmpwidth, tmpheight, tmpformat);
+	INFO(80, wst("Error: load failed!\n"));
+	return NULL;
+  }
+  DBG_INFO(80, wst("read in as %d x %d gfmt:%x\n"), tmpwidth, tmpheight, tmpformat);
 
-	/* check if size and format are OK */
-	if (!(format == GL_RGBA8 || format == GL_COLOR_INDEX8_EXT ) ||
-		(width * height) < 4) { /* TxQuantize requirement: width * height must be 4 or larger. */
-	  free(tex);
-	  tex = NULL;
+  /* check if size and format are OK */
+  if (!(format == GL_RGBA8 || format == GL_COLOR_INDEX8_EXT ) ||
+	  (width * height) < 4) { /* TxQuantize requirement: width * height must be 4 or larger. */
+	free(tex);
+	tex = NULL;
 #if !DEBUG
-	  INFO(80, wst("-----\n"));
-	  INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
-	  INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
+	INFO(80, wst("-----\n"));
+	INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
+	INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
 #endif
-	  INFO(80, wst("Error: not width * height > 4 or 8bit palette color or 32bpp or dxt1 or dxt3 or dxt5!\n"));
-	  continue;
-	}
+	INFO(80, wst("Error: not width * height > 4 or 8bit palette color or 32bpp or dxt1 or dxt3 or dxt5!\n"));
+	return NULL;
+  }
 
-	/* analyze and determine best format to quantize */
-	if (format == GL_RGBA8) {
-	  int i;
-	  int alphabits = 0;
-	  int fullalpha = 0;
-	  boolean intensity = 1;
-
-	  if (!(_options & LET_TEXARTISTS_FLY)) {
-		/* HACK ALERT! */
-		/* Account for Rice's weirdness with fmt:0 siz:2 textures.
-		 * Although the conditions are relaxed with other formats,
-		 * the D3D RGBA5551 surface is used for this format in certain
-		 * cases. See Nintemod's SuperMario64 life gauge and power
-		 * meter. The same goes for fmt:2 textures. See Mollymutt's
-		 * PaperMario text. */
-		if ((fmt == 0 && siz == 2) || fmt == 2) {
-		  DBG_INFO(80, wst("Remove black, white, etc borders along the alpha edges.\n"));
-		  /* round A comp */
-		  for (i = 0; i < height * width; i++) {
-			uint32 texel = ((uint32*)tex)[i];
-			((uint32*)tex)[i] = ((texel & 0xff000000) == 0xff000000 ? 0xff000000 : 0) |
-								(texel & 0x00ffffff);
-		  }
-		  /* Substitute texel color with the average of the surrounding
-		   * opaque texels. This removes borders regardless of hardware
-		   * texture filtering (bilinear, etc). */
-		  int j;
-		  for (i = 0; i < height; i++) {
-			for (j = 0; j < width; j++) {
-			  uint32 texel = ((uint32*)tex)[i * width + j];
-			  if ((texel & 0xff000000) != 0xff000000) {
-				uint32 tmptexel[8];
-				uint32 k, numtexel, r, g, b;
-				numtexel = r = g = b = 0;
-				memset(&tmptexel, 0, sizeof(tmptexel));
-				if (i > 0) {
-				  tmptexel[0] = ((uint32*)tex)[(i - 1) * width + j];                        /* north */
-				  if (j > 0)         tmptexel[1] = ((uint32*)tex)[(i - 1) * width + j - 1]; /* north-west */
-				  if (j < width - 1) tmptexel[2] = ((uint32*)tex)[(i - 1) * width + j + 1]; /* north-east */
-				}
-				if (i < height - 1) {
-				  tmptexel[3] = ((uint32*)tex)[(i + 1) * width + j];                        /* south */
-				  if (j > 0)         tmptexel[4] = ((uint32*)tex)[(i + 1) * width + j - 1]; /* south-west */
-				  if (j < width - 1) tmptexel[5] = ((uint32*)tex)[(i + 1) * width + j + 1]; /* south-east */
-				}
-				if (j > 0)         tmptexel[6] = ((uint32*)tex)[i * width + j - 1]; /* west */
-				if (j < width - 1) tmptexel[7] = ((uint32*)tex)[i * width + j + 1]; /* east */
-				for (k = 0; k < 8; k++) {
-				  if ((tmptexel[k] & 0xff000000) == 0xff000000) {
-					b += ((tmptexel[k] & 0x00ff0000) >> 16);
-					g += ((tmptexel[k] & 0x0000ff00) >>  8);
-					r += ((tmptexel[k] & 0x000000ff)      );
-					numtexel++;
-				  }
-				}
-				if (numtexel) {
-				  ((uint32*)tex)[i * width + j] = ((b / numtexel) << 16) |
-												  ((g / numtexel) <<  8) |
-												  ((r / numtexel)      );
-				} else {
-				  ((uint32*)tex)[i * width + j] = texel & 0x00ffffff;
+  /* analyze and determine best format to quantize */
+  if (format == GL_RGBA8) {
+	int i;
+	int alphabits = 0;
+	int fullalpha = 0;
+	boolean intensity = 1;
+
+	if (!(_options & LET_TEXARTISTS_FLY)) {
+	  /* HACK ALERT! */
+	  /* Account for Rice's weirdness with fmt:0 siz:2 textures.
+	   * Although the conditions are relaxed with other formats,
+	   * the D3D RGBA5551 surface is used for this format in certain
+	   * cases. See Nintemod's SuperMario64 life gauge and power
+	   * meter. The same goes for fmt:2 textures. See Mollymutt's
+	   * PaperMario text. */
+	  if ((fmt == 0 && siz == 2) || fmt == 2) {
+		DBG_INFO(80, wst("Remove black, white, etc borders along the alpha edges.\n"));
+		/* round A comp */
+		for (i = 0; i < height * width; i++) {
+		  uint32 texel = ((uint32*)tex)[i];
+		  ((uint32*)tex)[i] = ((texel & 0xff000000) == 0xff000000 ? 0xff000000 : 0) |
+							  (texel & 0x00ffffff);
+		}
+		/* Substitute texel color with the average of the surrounding
+		 * opaque texels. This removes borders regardless of hardware
+		 * texture filtering (bilinear, etc). */
+		int j;
+		for (i = 0; i < height; i++) {
+		  for (j = 0; j < width; j++) {
+			uint32 texel = ((uint32*)tex)[i * width + j];
+			if ((texel & 0xff000000) != 0xff000000) {
+			  uint32 tmptexel[8];
+			  uint32 k, numtexel, r, g, b;
+			  numtexel = r = g = b = 0;
+			  memset(&tmptexel, 0, sizeof(tmptexel));
+			  if (i > 0) {
+				tmptexel[0] = ((uint32*)tex)[(i - 1) * width + j];                        /* north */
+				if (j > 0)         tmptexel[1] = ((uint32*)tex)[(i - 1) * width + j - 1]; /* north-west */
+				if (j < width - 1) tmptexel[2] = ((uint32*)tex)[(i - 1) * width + j + 1]; /* north-east */
+			  }
+			  if (i < height - 1) {
+				tmptexel[3] = ((uint32*)tex)[(i + 1) * width + j];                        /* south */
+				if (j > 0)         tmptexel[4] = ((uint32*)tex)[(i + 1) * width + j - 1]; /* south-west */
+				if (j < width - 1) tmptexel[5] = ((uint32*)tex)[(i + 1) * width + j + 1]; /* south-east */
+			  }
+			  if (j > 0)         tmptexel[6] = ((uint32*)tex)[i * width + j - 1]; /* west */
+			  if (j < width - 1) tmptexel[7] = ((uint32*)tex)[i * width + j + 1]; /* east */
+			  for (k = 0; k < 8; k++) {
+				if ((tmptexel[k] & 0xff000000) == 0xff000000) {
+				  b += ((tmptexel[k] & 0x00ff0000) >> 16);
+				  g += ((tmptexel[k] & 0x0000ff00) >>  8);
+				  r += ((tmptexel[k] & 0x000000ff)      );
+				  numtexel++;
 				}
 			  }
+			  if (numtexel) {
+				((uint32*)tex)[i * width + j] = ((b / numtexel) << 16) |
+												((g / numtexel) <<  8) |
+												((r / numtexel)      );
+			  } else {
+				((uint32*)tex)[i * width + j] = texel & 0x00ffffff;
+			  }
 			}
 		  }
 		}
 	  }
+	}
 
-	  /* simple analysis of texture */
-	  for (i = 0; i < height * width; i++) {
-		uint32 texel = ((uint32*)tex)[i];
-		if (alphabits != 8) {
+	/* simple analysis of texture */
+	for (i = 0; i < height * width; i++) {
+	  uint32 texel = ((uint32*)tex)[i];
+	  if (alphabits != 8) {
 #if AGGRESSIVE_QUANTIZATION
-		  if ((texel & 0xff000000) < 0x00000003) {
-			alphabits = 1;
-			fullalpha++;
-		  } else if ((texel & 0xff000000) < 0xfe000000) {
-			alphabits = 8;
-		  }
+		if ((texel & 0xff000000) < 0x00000003) {
+		  alphabits = 1;
+		  fullalpha++;
+		} else if ((texel & 0xff000000) < 0xfe000000) {
+		  alphabits = 8;
+		}
 #else
-		  if ((texel & 0xff000000) == 0x00000000) {
-			alphabits = 1;
-			fullalpha++;
-		  } else if ((texel & 0xff000000) != 0xff000000) {
-			alphabits = 8;
-		  }
-#endif
+		if ((texel & 0xff000000) == 0x00000000) {
+		  alphabits = 1;
+		  fullalpha++;
+		} else if ((texel & 0xff000000) != 0xff000000) {
+		  alphabits = 8;
 		}
-		if (intensity) {
-		  int rcomp = (texel >> 16) & 0xff;
-		  int gcomp = (texel >>  8) & 0xff;
-		  int bcomp = (texel      ) & 0xff;
+#endif
+	  }
+	  if (intensity) {
+		int rcomp = (texel >> 16) & 0xff;
+		int gcomp = (texel >>  8) & 0xff;
+		int bcomp = (texel      ) & 0xff;
 #if AGGRESSIVE_QUANTIZATION
-		  if (abs(rcomp - gcomp) > 8 || abs(rcomp - bcomp) > 8 || abs(gcomp - bcomp) > 8) intensity = 0;
+		if (abs(rcomp - gcomp) > 8 || abs(rcomp - bcomp) > 8 || abs(gcomp - bcomp) > 8) intensity = 0;
 #else
-		  if (rcomp != gcomp || rcomp != bcomp || gcomp != bcomp) intensity = 0;
+		if (rcomp != gcomp || rcomp != bcomp || gcomp != bcomp) intensity = 0;
 #endif
-		}
-		if (!intensity && alphabits == 8) break;
 	  }
-	  DBG_INFO(80, wst("required alpha bits:%d zero acomp texels:%d rgb as intensity:%d\n"), alphabits, fullalpha, intensity);
+	  if (!intensity && alphabits == 8) break;
+	}
+	DBG_INFO(80, wst("required alpha bits:%d zero acomp texels:%d rgb as intensity:%d\n"), alphabits, fullalpha, intensity);
 
-	  /* preparations based on above analysis */
+	/* preparations based on above analysis */
 #if !REDUCE_TEXTURE_FOOTPRINT
-	  if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX) {
+	if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX) {
 #endif
-		if      (alphabits == 0) destformat = GL_RGB;
-		else if (alphabits == 1) destformat = GL_RGB5_A1;
-		else                     destformat = GL_RGBA8;
+	  if      (alphabits == 0) destformat = GL_RGB;
+	  else if (alphabits == 1) destformat = GL_RGB5_A1;
+	  else                     destformat = GL_RGBA8;
 #if !REDUCE_TEXTURE_FOOTPRINT
-	  } else {
-		destformat = GL_RGBA8;
-	  }
+	} else {
+	  destformat = GL_RGBA8;
+	}
 #endif
-	  if (fmt == 4 && alphabits == 0) {
-		destformat = GL_RGBA8;
-		/* Rice I format; I = (R + G + B) / 3 */
-		for (i = 0; i < height * width; i++) {
-		  uint32 texel = ((uint32*)tex)[i];
-		  uint32 icomp = (((texel >> 16) & 0xff) +
-						  ((texel >>  8) & 0xff) +
-						  ((texel      ) & 0xff)) / 3;
-		  ((uint32*)tex)[i] = (icomp << 24) | (texel & 0x00ffffff);
-		}
+	if (fmt == 4 && alphabits == 0) {
+	  destformat = GL_RGBA8;
+	  /* Rice I format; I = (R + G + B) / 3 */
+	  for (i = 0; i < height * width; i++) {
+		uint32 texel = ((uint32*)tex)[i];
+		uint32 icomp = (((texel >> 16) & 0xff) +
+						((texel >>  8) & 0xff) +
+						((texel      ) & 0xff)) / 3;
+		((uint32*)tex)[i] = (icomp << 24) | (texel & 0x00ffffff);
 	  }
-
-	  DBG_INFO(80, wst("best gfmt:%x\n"), destformat);
 	}
-	/*
-	 * Rice hi-res textures: end */
 
+	DBG_INFO(80, wst("best gfmt:%x\n"), destformat);
+  }
+  /*
+   * Rice hi-res textures: end */
 
-	/* XXX: only RGBA8888 for now. comeback to this later... */
-	if (format == GL_RGBA8) {
 
-	  /* minification */
-	  if (width > _maxwidth || height > _maxheight) {
-		int ratio = 1;
-		if (width / _maxwidth > height / _maxheight) {
-		  ratio = (int)ceil((double)width / _maxwidth);
-		} else {
-		  ratio = (int)ceil((double)height / _maxheight);
-		}
-		if (!_txReSample->minify(&tex, &width, &height, ratio)) {
-		  free(tex);
-		  tex = NULL;
-		  DBG_INFO(80, wst("Error: minification failed!\n"));
-		  continue;
-		}
+  /* XXX: only RGBA8888 for now. comeback to this later... */
+  if (format == GL_RGBA8) {
+
+	/* minification */
+	if (width > _maxwidth || height > _maxheight) {
+	  int ratio = 1;
+	  if (width / _maxwidth > height / _maxheight) {
+		ratio = (int)ceil((double)width / _maxwidth);
+	  } else {
+		ratio = (int)ceil((double)height / _maxheight);
 	  }
+	  if (!_txReSample->minify(&tex, &width, &height, ratio)) {
+		free(tex);
+		tex = NULL;
+		DBG_INFO(80, wst("Error: minification failed!\n"));
+		return NULL;
+	  }
+	}
 
 #if POW2_TEXTURES
 #if (POW2_TEXTURES == 2)
-		/* 3dfx Glide3x aspect ratio (8:1 - 1:8) */
-		if (!_txReSample->nextPow2(&tex, &width , &height, 32, 1)) {
+	  /* 3dfx Glide3x aspect ratio (8:1 - 1:8) */
+	  if (!_txReSample->nextPow2(&tex, &width , &height, 32, 1)) {
 #else
-		/* normal pow2 expansion */
-		if (!_txReSample->nextPow2(&tex, &width , &height, 32, 0)) {
+	  /* normal pow2 expansion */
+	  if (!_txReSample->nextPow2(&tex, &width , &height, 32, 0)) {
 #endif
-		  free(tex);
-		  tex = NULL;
-		  DBG_INFO(80, wst("Error: aspect ratio adjustment failed!\n"));
-		  continue;
-		}
+		free(tex);
+		tex = NULL;
+		DBG_INFO(80, wst("Error: aspect ratio adjustment failed!\n"));
+		return NULL;
+	  }
 #endif
 
-	  /* quantize */
-	  {
-		tmptex = (uint8 *)malloc(_txUtil->sizeofTx(width, height, destformat));
-		if (tmptex) {
-		  switch (destformat) {
-		  case GL_RGBA8:
-		  case GL_RGBA4:
+	/* quantize */
+	{
+	  tmptex = (uint8 *)malloc(_txUtil->sizeofTx(width, height, destformat));
+	  if (tmptex) {
+		switch (destformat) {
+		case GL_RGBA8:
+		case GL_RGBA4:
 #if !REDUCE_TEXTURE_FOOTPRINT
-			if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX)
+		  if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX)
 #endif
-			  destformat = GL_RGBA4;
-			break;
-		  case GL_RGB5_A1:
+			destformat = GL_RGBA4;
+		  break;
+		case GL_RGB5_A1:
 #if !REDUCE_TEXTURE_FOOTPRINT
-			if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX)
+		  if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX)
 #endif
-			  destformat = GL_RGB5_A1;
-			break;
-		  case GL_RGB:
+			destformat = GL_RGB5_A1;
+		  break;
+		case GL_RGB:
 #if !REDUCE_TEXTURE_FOOTPRINT
-			if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX)
+		  if (_maxbpp < 32 || _options & FORCE16BPP_HIRESTEX)
 #endif
-			  destformat = GL_RGB;
-			break;
-		  }
-		  if (_txQuantize->quantize(tex, tmptex, width, height, GL_RGBA8, destformat, 0)) {
-			format = destformat;
-			free(tex);
-			tex = tmptex;
-		  } else
-			  free(tmptex);
-		  tmptex = NULL;
+			destformat = GL_RGB;
+		  break;
 		}
+		if (_txQuantize->quantize(tex, tmptex, width, height, GL_RGBA8, destformat, 0)) {
+		  format = destformat;
+		  free(tex);
+		  tex = tmptex;
+		} else
+			free(tmptex);
+		tmptex = NULL;
 	  }
+	}
 
+	/* GPU texture compression, on the loader threads */
+	if (format == GL_RGBA8 && (_options & COMPRESS_HIRESTEX)) {
+	  const uint16 compressedformat = txcompress_format(tex, width, height, _options);
+	  if (compressedformat) {
+		tmptex = (uint8 *)malloc(_txUtil->sizeofTx(width, height, compressedformat));
+		if (tmptex && txcompress(tex, width, height, compressedformat, tmptex)) {
+		  format = compressedformat;
+		  free(tex);
+		  tex = tmptex;
+		} else
+		  free(tmptex);
+		tmptex = NULL;
+	  }
 	}
 
+  }
+
 
-	/* last minute validations */
-	if (!tex || !chksum || !width || !height || !format || width > _maxwidth || height > _maxheight) {
+  /* last minute validations */
+  if (!tex || !width || !height || !format || width > _maxwidth || height > _maxheight) {
 #if !DEBUG
-	  INFO(80, wst("-----\n"));
-	  INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
-	  INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
+	INFO(80, wst("-----\n"));
+	INFO(80, wst("path: %ls\n"), dir_path.string().c_str());
+	INFO(80, wst("file: %ls\n"), it->path().leaf().c_str());
 #endif
-	  if (tex) {
-		free(tex);
-		tex = NULL;
-		INFO(80, wst("Error: bad format or size! %d x %d gfmt:%x\n"), width, height, format);
-	  } else {
-		INFO(80, wst("Error: load failed!!\n"));
-	  }
-	  continue;
+	if (tex) {
+	  free(tex);
+	  tex = NULL;
+	  INFO(80, wst("Error: bad format or size! %d x %d gfmt:%x\n"), width, height, format);
+	} else {
+	  INFO(80, wst("Error: load failed!!\n"));
 	}
+	return NULL;
+  }
 
-	/* load it into hires texture cache. */
-	{
-	  uint64 chksum64 = (uint64)palchksum;
-	  chksum64 <<= 32;
-	  chksum64 |= (uint64)chksum;
+  *texwidth = width;
+  *texheight = height;
+  *texformat = format;
 
-	  GHQTexInfo tmpInfo;
-	  tmpInfo.data = tex;
-	  tmpInfo.width = width;
-	  tmpInfo.height = height;
-	  tmpInfo.is_hires_tex = 1;
-	  setTextureFormat(format, &tmpInfo);
+  return tex;
+}
 
-	  /* remove redundant in cache */
-	  if (replace && TxCache::del(chksum64)) {
-		DBG_INFO(80, wst("removed duplicate old cache.\n"));
-	  }
+boolean
+TxHiResCache::addFile(uint64 chksum64, uint8 *tex, int width, int height, uint16 format, boolean replace)
+{
+  GHQTexInfo tmpInfo;
+  tmpInfo.data = tex;
+  tmpInfo.width = width;
+  tmpInfo.height = height;
+  tmpInfo.is_hires_tex = 1;
+  setTextureFormat(format, &tmpInfo);
+
+  /* remove redundant in cache */
+  if (replace && TxCache::del(chksum64)) {
+	DBG_INFO(80, wst("removed duplicate old cache.\n"));
+  }
 
-	  /* add to cache */
-	  if (TxCache::add(chksum64, &tmpInfo)) {
-		/* Callback to display hires texture info.
-		 * Gonetz <gonetz(at)ngs.ru> */
-		if (_callback) {
-		  wchar_t tmpbuf[MAX_PATH];
-		  mbstowcs(tmpbuf, fname, MAX_PATH);
-		  (*_callback)(wst("[%d] total mem:%.2fmb - %ls\n"), _cache.size(), (float)_totalSize/1000000, tmpbuf);
-		}
-		DBG_INFO(80, wst("texture loaded!\n"));
-	  }
-	  free(tex);
-	}
+  /* add to cache */
+  return TxCache::add(chksum64, &tmpInfo);
+}
 
-  } while (foundfilename != NULL);
-  osal_search_dir_close(dir);
+boolean
+TxHiResCache::saveArchive(const wchar_t *path, const wchar_t *filename)
+{
+  if (!count())
+	return 0;
 
-  CHDIR(curpath);
+  osal_mkdirp(path);
+  tx_wstring archivepath(path);
+  archivepath += OSAL_DIR_SEPARATOR_STR;
+  archivepath += filename;
 
-  return 1;
+  TxHiResArchive::Writer writer;
+  if (!writer.open(archivepath.c_str(), archiveConfig()))
+	return 0;
+
+  /* the archive index is sorted by checksum */
+  std::vector<uint64> list;
+  checksums(list);
+  std::sort(list.begin(), list.end());
+
+  int total = 0;
+  for (size_t i = 0; i < list.size(); i++) {
+	/* get() inflates textures of GZ_HIRESTEXCACHE */
+	GHQTexInfo info;
+	if (TxCache::get(list[i], &info)) {
+	  int dataSize = _txUtil->sizeofTx(info.width, info.height, info.format);
+	  if (!writer.add(list[i], &info, info.data, dataSize))
+		return 0;
+	}
+
+	if (_callback && !(++total % 100))
+	  (*_callback)(wst("Total textures saved to HDD: %d\n"), total);
+  }
+
+  return writer.close();
 }
@@ -34,6 +34,10 @@
 #include "TxQuantize.h"
 #include "TxImage.h"
 #include "TxReSample.h"
+#include "TxHiResArchive.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class TxHiResCache : public TxCache
 {
@@ -47,14 +51,42 @@ private:
   TxQuantize *_txQuantize;
   TxReSample *_txReSample;
   tx_wstring _texPackPath;
+  TxHiResArchive _archive;
+  /* LAZY_HIRESTEX: texture files found in the pack, decoded on first request */
+  struct HIRESFILE {
+    std::string path;  /* full path to the file */
+    uint16 suffix;     /* offset of the _all.png, _rgb.png, etc. part in path */
+    uint8 fmt;
+    uint8 siz;
+  };
+  std::unordered_map<uint64, HIRESFILE> _index;
+  /* full load: files are decoded on the thread pool in batches,
+   * then added to the cache in the order they were found */
+  struct HIRESLOAD {
+    uint64 chksum64;
+    HIRESFILE file;
+    uint8 *tex;
+    int width;
+    int height;
+    uint16 format;
+  };
+  std::vector<HIRESLOAD> _loadQueue;
+  void flushLoadQueue(boolean replace);
+  int archiveConfig() const;
   boolean loadHiResTextures(const wchar_t * dir_path, boolean replace);
+  uint8 *loadFile(char *fname, char *pfname, uint32 fmt, uint32 siz, int *width, int *height, uint16 *format);
+  boolean addFile(uint64 chksum64, uint8 *tex, int width, int height, uint16 format, boolean replace);
 public:
   ~TxHiResCache();
-  TxHiResCache(int maxwidth, int maxheight, int maxbpp, int options,
+  TxHiResCache(int maxwidth, int maxheight, int maxbpp, int options, int cachesize,
 	  const wchar_t *cachePath, const wchar_t *texPackPath, const wchar_t *ident,
       dispInfoFuncExt callback);
   boolean empty();
   boolean load(boolean replace);
+  boolean get(uint64 checksum, /* checksum hi:palette low:texture */
+              GHQTexInfo *info);
+  /* write loaded textures to a hires texture archive */
+  boolean saveArchive(const wchar_t *path, const wchar_t *filename);
 };
 
 #endif /* __TXHIRESCACHE_H__ */
@@ -57,7 +57,23 @@
 #include <GL/glext.h>
 #endif // OS_WINDOWS
 
-/* in-memory zlib texture compression */
-#define GL_TEXFMT_GZ 0x80000000
+/* GPU compressed texture formats, GLES headers may not have them */
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2          0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC     0x9278
+#endif
+
+/* in-memory texture compression */
+#define GL_TEXFMT_GZ 0x80000000  /* zlib, in caches saved by older versions */
+#define GL_TEXFMT_LZ4 0x40000000 /* txpack */
+#define GL_TEXFMT_PACKED (GL_TEXFMT_GZ|GL_TEXFMT_LZ4)
 
 #endif /* __INTERNAL_H__ */
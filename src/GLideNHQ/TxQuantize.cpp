@@ -27,23 +27,19 @@
 
 /* NOTE: The codes are not optimized. They can be made faster. */
 
-#include <functional>
-#include <thread>
-
 #include "TxQuantize.h"
+#include "TxThreadPool.h"
+
+/* rows in a block of work for pool threads */
+#define QUANTIZE_BLOCK_ROWS 16
 
 TxQuantize::TxQuantize()
 {
-	_txUtil = new TxUtil();
-
-	/* get number of CPU cores. */
-	_numcore = _txUtil->getNumberofProcessors();
 }
 
 
 TxQuantize::~TxQuantize()
 {
-	delete _txUtil;
 }
 
 const volatile unsigned char Five2Eight[32] =
@@ -855,10 +851,28 @@ TxQuantize::P8_16BPP(uint32* src, uint32* dest, int width, int height, uint32* p
 	}
 }
 
+void
+TxQuantize::_quantize(quantizerFunc quantizer, uint8* src, uint8* dest, int width, int height, int srcShift, int destShift, boolean errorDiffusion)
+{
+	TxThreadPool *pool = TxThreadPool::getInstance();
+	unsigned int blkheight = QUANTIZE_BLOCK_ROWS;
+	if (errorDiffusion) {
+		/* error is diffused down the rows of a block, so use one block per thread */
+		const unsigned int numBands = pool->getNumThreads();
+		blkheight = ((height >> 2) / numBands) << 2;
+		if (blkheight < QUANTIZE_BLOCK_ROWS)
+			blkheight = QUANTIZE_BLOCK_ROWS;
+	}
+	pool->run(height, blkheight, [=](unsigned int first, unsigned int last) {
+		(this->*quantizer)((uint32*)(src + ((width * first) << srcShift)),
+						   (uint32*)(dest + ((width * first) << destShift)),
+						   width, last - first);
+	});
+}
+
 boolean
 TxQuantize::quantize(uint8* src, uint8* dest, int width, int height, uint16 srcformat, uint16 destformat, boolean fastQuantizer)
 {
-	typedef void (TxQuantize::*quantizerFunc)(uint32* src, uint32* dest, int width, int height);
 	quantizerFunc quantizer;
 	int bpp_shift = 0;
 
@@ -880,41 +894,7 @@ TxQuantize::quantize(uint8* src, uint8* dest, int width, int height, uint16 srcf
 		return 0;
 		}
 
-		unsigned int numcore = _numcore;
-		unsigned int blkrow = 0;
-		while (numcore > 1 && blkrow == 0) {
-			blkrow = (height >> 2) / numcore;
-			numcore--;
-		}
-		if (blkrow > 0 && numcore > 1) {
-			std::thread *thrd[MAX_NUMCORE];
-			unsigned int i;
-			int blkheight = blkrow << 2;
-			unsigned int srcStride = (width * blkheight) << (2 - bpp_shift);
-			unsigned int destStride = srcStride << bpp_shift;
-			for (i = 0; i < numcore - 1; i++) {
-				thrd[i] = new std::thread(std::bind(quantizer,
-														this,
-														(uint32*)src,
-														(uint32*)dest,
-														width,
-														blkheight));
-				src  += srcStride;
-				dest += destStride;
-			}
-			thrd[i] = new std::thread(std::bind(quantizer,
-													this,
-													(uint32*)src,
-													(uint32*)dest,
-													width,
-													height - blkheight * i));
-			for (i = 0; i < numcore; i++) {
-				thrd[i]->join();
-				delete thrd[i];
-			}
-		} else {
-			(*this.*quantizer)((uint32*)src, (uint32*)dest, width, height);
-		}
+		_quantize(quantizer, src, dest, width, height, 2 - bpp_shift, 2, 0);
 
 	} else if (srcformat == GL_RGBA8 || srcformat == GL_RGBA) {
 		switch (destformat) {
@@ -934,41 +914,7 @@ TxQuantize::quantize(uint8* src, uint8* dest, int width, int height, uint16 srcf
 		return 0;
 		}
 
-		unsigned int numcore = _numcore;
-		unsigned int blkrow = 0;
-		while (numcore > 1 && blkrow == 0) {
-			blkrow = (height >> 2) / numcore;
-			numcore--;
-		}
-		if (blkrow > 0 && numcore > 1) {
-			std::thread *thrd[MAX_NUMCORE];
-			unsigned int i;
-			int blkheight = blkrow << 2;
-			unsigned int srcStride = (width * blkheight) << 2;
-			unsigned int destStride = srcStride >> bpp_shift;
-			for (i = 0; i < numcore - 1; i++) {
-				thrd[i] = new std::thread(std::bind(quantizer,
-														this,
-														(uint32*)src,
-														(uint32*)dest,
-														width,
-														blkheight));
-				src  += srcStride;
-				dest += destStride;
-			}
-			thrd[i] = new std::thread(std::bind(quantizer,
-													this,
-													(uint32*)src,
-													(uint32*)dest,
-													width,
-													height - blkheight * i));
-			for (i = 0; i < numcore; i++) {
-				thrd[i]->join();
-				delete thrd[i];
-			}
-		} else {
-			(*this.*quantizer)((uint32*)src, (uint32*)dest, width, height);
-		}
+		_quantize(quantizer, src, dest, width, height, 2, 2 - bpp_shift, !fastQuantizer);
 
 	} else {
 		return 0;
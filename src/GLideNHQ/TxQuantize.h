@@ -30,8 +30,9 @@
 class TxQuantize
 {
 private:
-  TxUtil *_txUtil;
-  int _numcore;
+  typedef void (TxQuantize::*quantizerFunc)(uint32* src, uint32* dst, int width, int height);
+  /* run quantizer over blocks of rows on the thread pool */
+  void _quantize(quantizerFunc quantizer, uint8* src, uint8* dest, int width, int height, int srcShift, int destShift, boolean errorDiffusion);
 
   /* fast optimized... well, sort of. */
   void ARGB1555_ARGB8888(uint32* src, uint32* dst, int width, int height);
@@ -22,9 +22,11 @@
  */
 
 #include "TxReSample.h"
+#include "TxThreadPool.h"
 #include "TxDbg.h"
 #include <stdlib.h>
 #include <memory.h>
+#include <atomic>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -33,6 +35,8 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+#define MINIFY_BLOCK_ROWS 8
+
 int
 TxReSample::nextPow2(int num)
 {
@@ -255,29 +259,21 @@ TxReSample::minify(uint8 **src, int *width, int *height, int ratio)
    */
 	double half_window = 5.0;
 
-	int x, y, x2, y2, z;
-	double A, R, G, B;
-	uint32 texel;
+	int x;
 
-	int tmpwidth = *width / ratio;
-	int tmpheight = *height / ratio;
+	const int srcwidth = *width;
+	const int srcheight = *height;
+	const int tmpwidth = srcwidth / ratio;
+	const int tmpheight = srcheight / ratio;
 
 	/* resampled destination */
 	uint8 *tmptex = (uint8*)malloc((tmpwidth * tmpheight) << 2);
 	if (!tmptex) return 0;
 
-	/* work buffer. single row */
-	uint8 *workbuf = (uint8*)malloc(*width << 2);
-	if (!workbuf) {
-		free(tmptex);
-		return 0;
-	}
-
 	/* prepare filter lookup table. only half width required for symetric filters. */
 	double *weight = (double*)malloc((int)((half_window * ratio) * sizeof(double)));
 	if (!weight) {
 		free(tmptex);
-		free(workbuf);
 		return 0;
 	}
 	for (x = 0; x < half_window * ratio; x++) {
@@ -288,70 +284,90 @@ TxReSample::minify(uint8 **src, int *width, int *height, int ratio)
 		weight[x] = kaiser((double)x / ratio) / ratio;
 	}
 
-	/* linear convolution */
-	for (y = 0; y < tmpheight; y++) {
-		for (x = 0; x < *width; x++) {
-			texel = ((uint32*)*src)[y * ratio * *width + x];
-			A = (double)(texel >> 24) * weight[0];
-			R = (double)((texel >> 16) & 0xff) * weight[0];
-			G = (double)((texel >>  8) & 0xff) * weight[0];
-			B = (double)((texel      ) & 0xff) * weight[0];
-			for (y2 = 1; y2 < half_window * ratio; y2++) {
-				z = y * ratio + y2;
-				if (z >= *height) z = *height - 1;
-				texel = ((uint32*)*src)[z * *width + x];
-				A += (double)(texel >> 24) * weight[y2];
-				R += (double)((texel >> 16) & 0xff) * weight[y2];
-				G += (double)((texel >>  8) & 0xff) * weight[y2];
-				B += (double)((texel      ) & 0xff) * weight[y2];
-				z = y * ratio - y2;
-				if (z < 0) z = 0;
-				texel = ((uint32*)*src)[z * *width + x];
-				A += (double)(texel >> 24) * weight[y2];
-				R += (double)((texel >> 16) & 0xff) * weight[y2];
-				G += (double)((texel >>  8) & 0xff) * weight[y2];
-				B += (double)((texel      ) & 0xff) * weight[y2];
-			}
-			if (A < 0) A = 0; else if (A > 255) A = 255;
-			if (R < 0) R = 0; else if (R > 255) R = 255;
-			if (G < 0) G = 0; else if (G > 255) G = 255;
-			if (B < 0) B = 0; else if (B > 255) B = 255;
-			((uint32*)workbuf)[x] = (((uint32)A << 24) | ((uint32)R << 16) | ((uint32)G << 8) | (uint32)B);
+	/* linear convolution. destination rows are independent, so blocks of them run on the thread pool */
+	const uint32 *srctex = (const uint32*)*src;
+	std::atomic<bool> bOutOfMemory(false);
+	TxThreadPool::getInstance()->run(tmpheight, MINIFY_BLOCK_ROWS, [&](unsigned int first, unsigned int last) {
+		int x, y, x2, y2, z;
+		double A, R, G, B;
+		uint32 texel;
+
+		/* work buffer. single row */
+		uint32 *workbuf = (uint32*)malloc(srcwidth << 2);
+		if (!workbuf) {
+			bOutOfMemory = true;
+			return;
 		}
-		for (x = 0; x < tmpwidth; x++) {
-			texel = ((uint32*)workbuf)[x * ratio];
-			A = (double)(texel >> 24) * weight[0];
-			R = (double)((texel >> 16) & 0xff) * weight[0];
-			G = (double)((texel >>  8) & 0xff) * weight[0];
-			B = (double)((texel      ) & 0xff) * weight[0];
-			for (x2 = 1; x2 < half_window * ratio; x2++) {
-				z = x * ratio + x2;
-				if (z >= *width) z = *width - 1;
-				texel = ((uint32*)workbuf)[z];
-				A += (double)(texel >> 24) * weight[x2];
-				R += (double)((texel >> 16) & 0xff) * weight[x2];
-				G += (double)((texel >>  8) & 0xff) * weight[x2];
-				B += (double)((texel      ) & 0xff) * weight[x2];
-				z = x * ratio - x2;
-				if (z < 0) z = 0;
-				texel = ((uint32*)workbuf)[z];
-				A += (double)(texel >> 24) * weight[x2];
-				R += (double)((texel >> 16) & 0xff) * weight[x2];
-				G += (double)((texel >>  8) & 0xff) * weight[x2];
-				B += (double)((texel      ) & 0xff) * weight[x2];
+
+		for (y = first; y < (int)last; y++) {
+			for (x = 0; x < srcwidth; x++) {
+				texel = srctex[y * ratio * srcwidth + x];
+				A = (double)(texel >> 24) * weight[0];
+				R = (double)((texel >> 16) & 0xff) * weight[0];
+				G = (double)((texel >>  8) & 0xff) * weight[0];
+				B = (double)((texel      ) & 0xff) * weight[0];
+				for (y2 = 1; y2 < half_window * ratio; y2++) {
+					z = y * ratio + y2;
+					if (z >= srcheight) z = srcheight - 1;
+					texel = srctex[z * srcwidth + x];
+					A += (double)(texel >> 24) * weight[y2];
+					R += (double)((texel >> 16) & 0xff) * weight[y2];
+					G += (double)((texel >>  8) & 0xff) * weight[y2];
+					B += (double)((texel      ) & 0xff) * weight[y2];
+					z = y * ratio - y2;
+					if (z < 0) z = 0;
+					texel = srctex[z * srcwidth + x];
+					A += (double)(texel >> 24) * weight[y2];
+					R += (double)((texel >> 16) & 0xff) * weight[y2];
+					G += (double)((texel >>  8) & 0xff) * weight[y2];
+					B += (double)((texel      ) & 0xff) * weight[y2];
+				}
+				if (A < 0) A = 0; else if (A > 255) A = 255;
+				if (R < 0) R = 0; else if (R > 255) R = 255;
+				if (G < 0) G = 0; else if (G > 255) G = 255;
+				if (B < 0) B = 0; else if (B > 255) B = 255;
+				workbuf[x] = (((uint32)A << 24) | ((uint32)R << 16) | ((uint32)G << 8) | (uint32)B);
+			}
+			for (x = 0; x < tmpwidth; x++) {
+				texel = workbuf[x * ratio];
+				A = (double)(texel >> 24) * weight[0];
+				R = (double)((texel >> 16) & 0xff) * weight[0];
+				G = (double)((texel >>  8) & 0xff) * weight[0];
+				B = (double)((texel      ) & 0xff) * weight[0];
+				for (x2 = 1; x2 < half_window * ratio; x2++) {
+					z = x * ratio + x2;
+					if (z >= srcwidth) z = srcwidth - 1;
+					texel = workbuf[z];
+					A += (double)(texel >> 24) * weight[x2];
+					R += (double)((texel >> 16) & 0xff) * weight[x2];
+					G += (double)((texel >>  8) & 0xff) * weight[x2];
+					B += (double)((texel      ) & 0xff) * weight[x2];
+					z = x * ratio - x2;
+					if (z < 0) z = 0;
+					texel = workbuf[z];
+					A += (double)(texel >> 24) * weight[x2];
+					R += (double)((texel >> 16) & 0xff) * weight[x2];
+					G += (double)((texel >>  8) & 0xff) * weight[x2];
+					B += (double)((texel      ) & 0xff) * weight[x2];
+				}
+				if (A < 0) A = 0; else if (A > 255) A = 255;
+				if (R < 0) R = 0; else if (R > 255) R = 255;
+				if (G < 0) G = 0; else if (G > 255) G = 255;
+				if (B < 0) B = 0; else if (B > 255) B = 255;
+				((uint32*)tmptex)[y * tmpwidth + x] = (((uint32)A << 24) | ((uint32)R << 16) | ((uint32)G << 8) | (uint32)B);
 			}
-			if (A < 0) A = 0; else if (A > 255) A = 255;
-			if (R < 0) R = 0; else if (R > 255) R = 255;
-			if (G < 0) G = 0; else if (G > 255) G = 255;
-			if (B < 0) B = 0; else if (B > 255) B = 255;
-			((uint32*)tmptex)[y * tmpwidth + x] = (((uint32)A << 24) | ((uint32)R << 16) | ((uint32)G << 8) | (uint32)B);
 		}
+		free(workbuf);
+	});
+
+	free(weight);
+	if (bOutOfMemory) {
+		free(tmptex);
+		return 0;
 	}
 
 	free(*src);
 	*src = tmptex;
-	free(weight);
-	free(workbuf);
 	*width = tmpwidth;
 	*height = tmpheight;
 
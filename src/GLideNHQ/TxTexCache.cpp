@@ -42,7 +42,7 @@ TxTexCache::~TxTexCache()
 		tx_wstring cachepath(_path);
 		cachepath += OSAL_DIR_SEPARATOR_STR;
 		cachepath += wst("cache");
-		int config = _options & (FILTER_MASK | ENHANCEMENT_MASK | FORCE16BPP_TEX | GZ_TEXCACHE);
+		int config = _options & (FILTER_MASK | ENHANCEMENT_MASK | COMPRESSION_MASK | COMPRESS_TEX | FORCE16BPP_TEX | GZ_TEXCACHE);
 
 		TxCache::save(cachepath.c_str(), filename.c_str(), config);
 	}
@@ -64,7 +64,7 @@ TxTexCache::TxTexCache(int options, int cachesize, const wchar_t *path, const wc
 		tx_wstring cachepath(_path);
 		cachepath += OSAL_DIR_SEPARATOR_STR;
 		cachepath += wst("cache");
-		int config = _options & (FILTER_MASK | ENHANCEMENT_MASK | FORCE16BPP_TEX | GZ_TEXCACHE);
+		int config = _options & (FILTER_MASK | ENHANCEMENT_MASK | COMPRESSION_MASK | COMPRESS_TEX | FORCE16BPP_TEX | GZ_TEXCACHE);
 
 		TxCache::load(cachepath.c_str(), filename.c_str(), config);
 	}
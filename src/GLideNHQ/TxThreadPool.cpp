@@ -0,0 +1,149 @@
+#include "TxThreadPool.h"
+
+/* set while the thread works on blocks of a job. Visual Studio 2013 has no thread_local */
+#if defined(_MSC_VER) && _MSC_VER < 1900
+static __declspec(thread) bool insideJob = false;
+#else
+static thread_local bool insideJob = false;
+#endif
+
+TxThreadPool::~TxThreadPool()
+{
+	shutdown();
+}
+
+void
+TxThreadPool::init(int numThreads)
+{
+	shutdown();
+	if (numThreads > MAX_NUMCORE) numThreads = MAX_NUMCORE;
+	/* new workers wait for the next job, _generation keeps counting after shutdown() */
+	uint32 generation;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = false;
+		generation = _generation;
+	}
+	for (int i = 1; i < numThreads; i++)
+		_workers.push_back(std::thread(&TxThreadPool::_workerLoop, this, (unsigned int)i, generation));
+}
+
+void
+TxThreadPool::shutdown()
+{
+	if (_workers.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wakeCond.notify_all();
+	for (size_t i = 0; i < _workers.size(); i++)
+		_workers[i].join();
+	_workers.clear();
+}
+
+void
+TxThreadPool::run(unsigned int rows, unsigned int blockRows, const Job &job)
+{
+	if (rows == 0)
+		return;
+	if (blockRows == 0)
+		blockRows = 1;
+	const uint32 numBlocks = (rows + blockRows - 1) / blockRows;
+
+	/* a nested job must not lock _runMutex, this thread may hold it already */
+	std::unique_lock<std::mutex> runLock;
+	if (!_workers.empty() && numBlocks > 1 && !insideJob)
+		runLock = std::unique_lock<std::mutex>(_runMutex, std::try_to_lock);
+	if (!runLock.owns_lock()) {
+		for (unsigned int first = 0; first < rows; first += blockRows)
+			job(first, first + blockRows < rows ? first + blockRows : rows);
+		return;
+	}
+
+	/* give each thread an equal share of blocks */
+	const uint32 numThreads = getNumThreads();
+	for (uint32 i = 0; i < numThreads; i++) {
+		const uint64 first = (uint64)numBlocks * i / numThreads;
+		const uint64 last = (uint64)numBlocks * (i + 1) / numThreads;
+		_ranges[i].store((first << 32) | last);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_job = &job;
+		_rows = rows;
+		_blockRows = blockRows;
+		_activeWorkers = (uint32)_workers.size();
+		_generation++;
+	}
+	_wakeCond.notify_all();
+
+	_work(0);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneCond.wait(lock, [this]{ return _activeWorkers == 0; });
+	_job = NULL;
+}
+
+void
+TxThreadPool::_workerLoop(unsigned int index, uint32 generation)
+{
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wakeCond.wait(lock, [this, generation]{ return _stop || _generation != generation; });
+			if (_stop)
+				return;
+			generation = _generation;
+		}
+
+		_work(index);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_activeWorkers == 0)
+			_doneCond.notify_one();
+	}
+}
+
+void
+TxThreadPool::_work(unsigned int index)
+{
+	insideJob = true;
+	uint32 block;
+	while (_takeBlock(index, block)) {
+		const unsigned int first = block * _blockRows;
+		const unsigned int last = first + _blockRows < _rows ? first + _blockRows : _rows;
+		(*_job)(first, last);
+	}
+	insideJob = false;
+}
+
+bool
+TxThreadPool::_takeBlock(unsigned int index, uint32 &block)
+{
+	/* own range: take from the front */
+	std::atomic<uint64> &own = _ranges[index];
+	uint64 range = own.load();
+	while ((uint32)(range >> 32) < (uint32)range) {
+		if (own.compare_exchange_weak(range, range + (1ULL << 32))) {
+			block = (uint32)(range >> 32);
+			return true;
+		}
+	}
+
+	/* steal from the back of other ranges */
+	const uint32 numThreads = getNumThreads();
+	for (uint32 i = 1; i < numThreads; i++) {
+		std::atomic<uint64> &other = _ranges[(index + i) % numThreads];
+		range = other.load();
+		while ((uint32)(range >> 32) < (uint32)range) {
+			if (other.compare_exchange_weak(range, range - 1)) {
+				block = (uint32)range - 1;
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,64 @@
+#ifndef __TXTHREADPOOL_H__
+#define __TXTHREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TxUtil.h"
+
+/* Persistent worker threads for texture filters, quantizers and resamplers.
+ * A job splits rows into blocks. Each thread takes blocks from its own range
+ * first and steals blocks from the end of other ranges when it runs out.
+ * The calling thread works on the job too and returns when all blocks are done.
+ */
+class TxThreadPool
+{
+public:
+	/* processes rows [first, last) */
+	typedef std::function<void(unsigned int first, unsigned int last)> Job;
+
+	static TxThreadPool* getInstance() {
+		static TxThreadPool txThreadPool;
+		return &txThreadPool;
+	}
+	~TxThreadPool();
+
+	/* start numThreads - 1 workers; the calling thread is the last one */
+	void init(int numThreads);
+	void shutdown();
+	unsigned int getNumThreads() const { return (unsigned int)_workers.size() + 1; }
+
+	/* run job over rows [0, rows) split into blocks of blockRows rows.
+	 * The pool runs one job at a time. A job started while another one runs,
+	 * or from inside a job, is processed by the calling thread alone. */
+	void run(unsigned int rows, unsigned int blockRows, const Job &job);
+
+private:
+	TxThreadPool() : _generation(0), _activeWorkers(0), _stop(false), _job(NULL), _rows(0), _blockRows(0) {}
+	TxThreadPool(const TxThreadPool &);
+
+	void _workerLoop(unsigned int index, uint32 generation);
+	void _work(unsigned int index);
+	bool _takeBlock(unsigned int index, uint32 &block);
+
+	std::vector<std::thread> _workers;
+	std::mutex _runMutex;
+	std::mutex _mutex;
+	std::condition_variable _wakeCond;
+	std::condition_variable _doneCond;
+	uint32 _generation;
+	uint32 _activeWorkers;
+	bool _stop;
+
+	/* current job */
+	const Job *_job;
+	unsigned int _rows;
+	unsigned int _blockRows;
+	/* per thread block range: next block in high 32 bits, end in low 32 bits */
+	std::atomic<uint64> _ranges[MAX_NUMCORE];
+};
+
+#endif /* __TXTHREADPOOL_H__ */
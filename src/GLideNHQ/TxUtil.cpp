@@ -68,6 +68,15 @@ TxUtil::sizeofTx(int width, int height, uint16 format)
 	case GL_RGBA8:
 		dataSize = (width * height) << 2;
 	break;
+	/* 4x4 blocks of 8 or 16 bytes */
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGB8_ETC2:
+		dataSize = ((width + 3) >> 2) * ((height + 3) >> 2) * 8;
+	break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		dataSize = ((width + 3) >> 2) * ((height + 3) >> 2) * 16;
+	break;
 	default:
 		/* unsupported format */
 		DBG_INFO(80, wst("Error: cannot get size. unsupported gfmt:%x\n"), format);
@@ -0,0 +1,125 @@
+/*
+ * Texture Filtering benchmark
+ *
+ * Compares per texture latency of the thread pool based filter_8888
+ * against spawning one thread per band for every texture.
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../TextureFilters.h"
+#include "../TxThreadPool.h"
+
+#define MAX_SIZE 512
+#define MAX_SCALE 4
+
+/* one std::thread per band for every texture */
+static void filterSpawnThreads(uint32 *src, uint32 width, uint32 height, uint32 *dest, uint32 filter, uint32 scale, unsigned int numcore)
+{
+	unsigned int blkrow = 0;
+	while (numcore > 1 && blkrow == 0) {
+		blkrow = (height >> 2) / numcore;
+		numcore--;
+	}
+	if (blkrow == 0 || numcore < 2) {
+		filter_8888(src, width, height, dest, filter);
+		return;
+	}
+	std::thread *thrd[MAX_NUMCORE];
+	unsigned int i;
+	const uint32 blkheight = blkrow << 2;
+	const uint32 srcStride = width * blkheight;
+	const uint32 destStride = srcStride * scale * scale;
+	for (i = 0; i < numcore - 1; i++) {
+		thrd[i] = new std::thread(std::bind(filter_8888, src, width, blkheight, dest, filter));
+		src += srcStride;
+		dest += destStride;
+	}
+	thrd[i] = new std::thread(std::bind(filter_8888, src, width, height - blkheight * i, dest, filter));
+	for (i = 0; i < numcore; i++) {
+		thrd[i]->join();
+		delete thrd[i];
+	}
+}
+
+template <typename F>
+static double measure(unsigned int iterations, F func)
+{
+	func();
+	const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < iterations; i++)
+		func();
+	const std::chrono::duration<double, std::micro> elapsed = std::chrono::high_resolution_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int numcore = std::thread::hardware_concurrency();
+	if (argc > 1)
+		numcore = atoi(argv[1]);
+	if (numcore < 1)
+		numcore = 1;
+	if (numcore > MAX_NUMCORE)
+		numcore = MAX_NUMCORE;
+
+	struct {
+		const char *name;
+		uint32 filter;
+		uint32 scale;
+	} filters[] = {
+		{ "hq2x", HQ2X_ENHANCEMENT, 2 },
+		{ "hq4x", HQ4X_ENHANCEMENT, 4 },
+		{ "xbrz4x", BRZ4X_ENHANCEMENT, 4 },
+		{ "smooth", SMOOTH_FILTER_4, 1 }
+	};
+
+	uint32 *src = (uint32*)malloc(MAX_SIZE * MAX_SIZE * 4);
+	uint32 *dest = (uint32*)malloc(MAX_SIZE * MAX_SIZE * MAX_SCALE * MAX_SCALE * 4);
+	if (!src || !dest)
+		return 1;
+	srand(1);
+	for (unsigned int i = 0; i < MAX_SIZE * MAX_SIZE; i++)
+		src[i] = (rand() & 0x3) * 0x55555555;
+
+	printf("threads: %u\n", numcore);
+	printf("%-8s %9s %14s %14s %8s\n", "filter", "size", "spawn (us)", "pool (us)", "speedup");
+	for (unsigned int f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+		for (uint32 size = 32; size <= MAX_SIZE; size <<= 1) {
+			const unsigned int iterations = (MAX_SIZE / size) * (MAX_SIZE / size) * 2;
+			const uint32 filter = filters[f].filter;
+			const uint32 scale = filters[f].scale;
+
+			/* without workers filter_8888 runs serially on the calling thread */
+			TxThreadPool::getInstance()->shutdown();
+			const double spawn = measure(iterations, [&]() {
+				filterSpawnThreads(src, size, size, dest, filter, scale, numcore);
+			});
+
+			TxThreadPool::getInstance()->init(numcore);
+			const double pool = measure(iterations, [&]() {
+				filter_8888(src, size, size, dest, filter);
+			});
+
+			printf("%-8s %4ux%-4u %14.1f %14.1f %7.2fx\n", filters[f].name, size, size, spawn, pool, spawn / pool);
+		}
+	}
+
+	TxThreadPool::getInstance()->shutdown();
+	free(src);
+	free(dest);
+	return 0;
+}
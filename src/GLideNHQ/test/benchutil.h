@@ -0,0 +1,98 @@
+/*
+ * Helpers shared by the texture pack benchmarks: reading the PNG textures
+ * of a folder, timing and resident memory. Unix only, like the benchmarks
+ * which use them.
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __BENCHUTIL_H__
+#define __BENCHUTIL_H__
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <osal_files.h>
+#include "../TxImage.h"
+
+struct Texture {
+	int width;
+	int height;
+	uint16 format;            /* GL_RGBA8 or GL_COLOR_INDEX8_EXT */
+	std::vector<uint8> data;
+};
+
+/* reads the PNG textures of folder and its subfolders */
+inline void readTextures(const std::string &folder, std::vector<Texture> &textures)
+{
+	wchar_t wfolder[MAX_PATH];
+	mbstowcs(wfolder, folder.c_str(), MAX_PATH);
+	void *dir = osal_search_dir_open(wfolder);
+	if (!dir)
+		return;
+	TxImage image;
+	const wchar_t *wname;
+	while ((wname = osal_search_dir_read_next(dir)) != NULL) {
+		char name[MAX_PATH];
+		wcstombs(name, wname, MAX_PATH);
+		if (name[0] == '.')
+			continue;
+		std::string path = folder + "/" + name;
+		wchar_t wpath[MAX_PATH];
+		mbstowcs(wpath, path.c_str(), MAX_PATH);
+		if (osal_is_directory(wpath)) {
+			readTextures(path, textures);
+			continue;
+		}
+		if (path.size() < 4 || path.compare(path.size() - 4, 4, ".png") != 0)
+			continue;
+		FILE *fp = fopen(path.c_str(), "rb");
+		if (!fp)
+			continue;
+		Texture texture;
+		texture.format = 0;
+		uint8 *tex = image.readPNG(fp, &texture.width, &texture.height, &texture.format);
+		fclose(fp);
+		if (!tex)
+			continue;
+		/* 8bit palette textures are width * height, RGBA textures 4 times that */
+		const size_t size = (size_t)texture.width * texture.height * (texture.format == GL_COLOR_INDEX8_EXT ? 1 : 4);
+		texture.data.assign(tex, tex + size);
+		textures.push_back(texture);
+		free(tex);
+	}
+	osal_search_dir_close(dir);
+}
+
+typedef std::chrono::high_resolution_clock Clock;
+
+inline double seconds(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/* resident set size in bytes */
+inline double residentBytes()
+{
+	long pages = 0, resident = 0;
+	FILE *fp = fopen("/proc/self/statm", "r");
+	if (fp) {
+		if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+			resident = 0;
+		fclose(fp);
+	}
+	return (double)resident * sysconf(_SC_PAGESIZE);
+}
+
+#endif /* __BENCHUTIL_H__ */
@@ -0,0 +1,113 @@
+/*
+ * Texture cache compression benchmark
+ *
+ * Reads all PNG textures of a folder (a hires texture pack) and compares the
+ * texture cache codecs: zlib level 1 and LZ4 blocks (txpack), LZ4 on one
+ * thread and on the thread pool. Prints compression ratio, compression speed
+ * and hit latency, the time to decompress a texture for upload. Every texture
+ * is checked to decompress to the original data.
+ *
+ * Usage: cachebench_hq <folder> [threads]
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <thread>
+#include <string.h>
+#include <zlib.h>
+#include "benchutil.h"
+#include "../TxCodec.h"
+#include "../TxThreadPool.h"
+
+enum Codec { CODEC_ZLIB, CODEC_LZ4 };
+
+/* compresses and decompresses all textures, returns 0 if some texture does not match */
+static bool bench(const char *name, Codec codec, const std::vector<Texture> &textures)
+{
+	size_t rawTotal = 0, packedTotal = 0;
+	double packTime = 0.0, unpackTime = 0.0;
+	bool match = true;
+	std::vector<uint8> packed, unpacked;
+	for (size_t i = 0; i < textures.size(); i++) {
+		const std::vector<uint8> &raw = textures[i].data;
+		unpacked.resize(raw.size());
+		size_t packedSize = 0;
+
+		Clock::time_point start = Clock::now();
+		if (codec == CODEC_ZLIB) {
+			packed.resize(compressBound((uLong)raw.size()));
+			uLongf destLen = (uLongf)packed.size();
+			if (compress2(packed.data(), &destLen, raw.data(), (uLong)raw.size(), 1) == Z_OK)
+				packedSize = destLen;
+		} else {
+			packed.resize(txpack_bound((uint32)raw.size()));
+			packedSize = txpack(raw.data(), (uint32)raw.size(), packed.data());
+		}
+		packTime += seconds(start);
+
+		/* the cache keeps textures which do not compress as they are */
+		if (packedSize == 0 || packedSize >= raw.size()) {
+			rawTotal += raw.size();
+			packedTotal += raw.size();
+			continue;
+		}
+
+		start = Clock::now();
+		bool ok;
+		if (codec == CODEC_ZLIB) {
+			uLongf destLen = (uLongf)unpacked.size();
+			ok = uncompress(unpacked.data(), &destLen, packed.data(), (uLong)packedSize) == Z_OK && destLen == raw.size();
+		} else {
+			ok = txunpack(packed.data(), (uint32)packedSize, unpacked.data(), (uint32)raw.size()) != 0;
+		}
+		unpackTime += seconds(start);
+
+		if (!ok || memcmp(unpacked.data(), raw.data(), raw.size()) != 0)
+			match = false;
+		rawTotal += raw.size();
+		packedTotal += packedSize;
+	}
+
+	printf("%-12s ratio %5.2f, compress %7.1f MB/s, decompress %7.1f MB/s, hit %8.1f us/texture%s\n",
+		   name, (double)rawTotal / packedTotal, rawTotal / packTime / 1000000, rawTotal / unpackTime / 1000000,
+		   unpackTime * 1000000 / textures.size(), match ? "" : ", MISMATCH");
+	return match;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <folder> [threads]\n", argv[0]);
+		return 1;
+	}
+	const int numThreads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+
+	std::vector<Texture> textures;
+	readTextures(argv[1], textures);
+	if (textures.empty()) {
+		fprintf(stderr, "No PNG textures in %s\n", argv[1]);
+		return 1;
+	}
+	size_t total = 0;
+	for (size_t i = 0; i < textures.size(); i++)
+		total += textures[i].data.size();
+	printf("%u textures, %.1f MB\n", (unsigned int)textures.size(), total / 1000000.0);
+
+	bool match = bench("zlib 1", CODEC_ZLIB, textures);
+	match = bench("lz4", CODEC_LZ4, textures) && match;
+	TxThreadPool::getInstance()->init(numThreads > 0 ? numThreads : 1);
+	char name[32];
+	snprintf(name, sizeof(name), "lz4 %ut", TxThreadPool::getInstance()->getNumThreads());
+	match = bench(name, CODEC_LZ4, textures) && match;
+	TxThreadPool::getInstance()->shutdown();
+
+	return match ? 0 : 2;
+}
@@ -0,0 +1,241 @@
+/*
+ * Texture cache correctness test
+ *
+ * Checks the TxCache index and LRU list: textures are evicted least recently
+ * used first, deleting from a probe sequence which wraps around the end of
+ * the hash table keeps the other textures reachable, and deleted or evicted
+ * textures can be added again. Random adds, gets and deletes are compared
+ * with a std::map model.
+ *
+ * Usage: cachetest_hq
+ * Exit code is 2 if a check fails.
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include "../TxCache.h"
+
+/* 4x4 RGBA8 textures */
+#define TEXTURE_SIZE 4
+#define TEXTURE_BYTES (TEXTURE_SIZE * TEXTURE_SIZE * 4)
+/* TxCache starts with 64 slots and keeps them at most 3/4 full */
+#define MIN_SLOTS 64
+
+static int failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* TxCache with its protected bookkeeping exposed */
+class TestCache : public TxCache
+{
+public:
+	TestCache(int cachesize) : TxCache(0, cachesize, NULL, NULL, NULL) {}
+	using TxCache::del;
+	using TxCache::is_cached;
+	using TxCache::count;
+	using TxCache::checksums;
+	using TxCache::clear;
+	int totalSize() const { return _totalSize; }
+};
+
+/* home slot of checksum in a table of MIN_SLOTS, the same hash as TxCache */
+static uint32 homeSlot(uint64 checksum)
+{
+	return (uint32)((checksum * 0x9E3779B97F4A7C15ULL) >> 32) & (MIN_SLOTS - 1);
+}
+
+/* adds a texture filled with a byte of its checksum */
+static boolean addTexture(TestCache &cache, uint64 checksum)
+{
+	uint8 data[TEXTURE_BYTES];
+	memset(data, (int)(checksum & 0xff), sizeof(data));
+	GHQTexInfo info;
+	memset(&info, 0, sizeof(info));
+	info.data = data;
+	info.width = TEXTURE_SIZE;
+	info.height = TEXTURE_SIZE;
+	setTextureFormat(GL_RGBA8, &info);
+	return cache.add(checksum, &info);
+}
+
+/* the texture is found and its data is its own */
+static bool hasTexture(TestCache &cache, uint64 checksum)
+{
+	GHQTexInfo info;
+	if (!cache.get(checksum, &info))
+		return false;
+	return info.data[0] == (uint8)(checksum & 0xff) && info.data[TEXTURE_BYTES - 1] == (uint8)(checksum & 0xff);
+}
+
+static void testEvictionOrder()
+{
+	const int count = 32;
+	std::vector<uint64> checksums;
+	for (int i = 0; i < count * 2; i++)
+		checksums.push_back(0x1000 + i);
+
+	/* the size of count textures with the bookkeeping, so the cache is full after them */
+	int fullSize;
+	{
+		TestCache probe(0);
+		for (int i = 0; i < count; i++)
+			addTexture(probe, checksums[i]);
+		fullSize = probe.totalSize();
+	}
+
+	TestCache cache(fullSize);
+	for (int i = 0; i < count; i++)
+		CHECK(addTexture(cache, checksums[i]));
+	CHECK(cache.count() == (uint32)count);
+
+	/* use the first half again, the second half is now the least recently used */
+	for (int i = 0; i < count / 2; i++)
+		CHECK(hasTexture(cache, checksums[i]));
+
+	/* each new texture evicts one texture of the second half, oldest first */
+	for (int i = 0; i < count / 2; i++) {
+		CHECK(addTexture(cache, checksums[count + i]));
+		CHECK(cache.count() == (uint32)count);
+		CHECK(!cache.is_cached(checksums[count / 2 + i]));
+		if (i + 1 < count / 2)
+			CHECK(cache.is_cached(checksums[count / 2 + i + 1]));
+	}
+	for (int i = 0; i < count / 2; i++)
+		CHECK(cache.is_cached(checksums[i]));
+
+	/* then the first half, in the order it was used */
+	CHECK(addTexture(cache, checksums[count + count / 2]));
+	CHECK(!cache.is_cached(checksums[0]));
+	CHECK(cache.is_cached(checksums[1]));
+
+	/* an evicted texture can be added again */
+	CHECK(addTexture(cache, checksums[0]));
+	CHECK(hasTexture(cache, checksums[0]));
+	CHECK(!cache.is_cached(checksums[1]));
+}
+
+static void testWrappedDelete()
+{
+	/* checksums whose home slots are the last two and the first two slots of the table,
+	 * so their probe sequences wrap around and overlap */
+	std::vector<uint64> checksums;
+	const uint32 homes[] = { MIN_SLOTS - 2, MIN_SLOTS - 1, 0, 1 };
+	for (int h = 0; h < 4; h++) {
+		int found = 0;
+		for (uint64 c = 1; found < 5; c++) {
+			if (homeSlot(c) == homes[h]) {
+				checksums.push_back(c);
+				found++;
+			}
+		}
+	}
+	CHECK(checksums.size() * 4 <= MIN_SLOTS * 3);
+
+	/* every order of deleting every other texture, then adding them again */
+	for (int round = 0; round < 64; round++) {
+		TestCache cache(0);
+		std::mt19937 random(round);
+		std::vector<uint64> order(checksums);
+		std::shuffle(order.begin(), order.end(), random);
+		for (size_t i = 0; i < order.size(); i++)
+			CHECK(addTexture(cache, order[i]));
+
+		std::shuffle(order.begin(), order.end(), random);
+		const size_t half = order.size() / 2;
+		for (size_t i = 0; i < half; i++) {
+			CHECK(cache.del(order[i]));
+			CHECK(!cache.del(order[i]));
+			for (size_t j = 0; j < order.size(); j++)
+				CHECK(cache.is_cached(order[j]) == (j > i));
+		}
+		for (size_t i = half; i < order.size(); i++)
+			CHECK(hasTexture(cache, order[i]));
+
+		for (size_t i = 0; i < half; i++)
+			CHECK(addTexture(cache, order[i]));
+		for (size_t i = 0; i < order.size(); i++)
+			CHECK(hasTexture(cache, order[i]));
+		CHECK(cache.count() == (uint32)order.size());
+	}
+}
+
+static void testRandomOperations()
+{
+	/* few checksums, so adds replace, deletes hit and the table grows and wraps */
+	std::mt19937_64 random(49);
+	std::vector<uint64> checksums;
+	for (int i = 0; i < 300; i++)
+		checksums.push_back(random() | 1);
+
+	TestCache cache(0);
+	std::map<uint64, bool> model;
+	for (int op = 0; op < 200000; op++) {
+		const uint64 checksum = checksums[random() % checksums.size()];
+		switch (random() % 3) {
+		case 0:
+			CHECK(addTexture(cache, checksum));
+			model[checksum] = true;
+			break;
+		case 1:
+			CHECK(cache.del(checksum) == (model.erase(checksum) != 0));
+			break;
+		default:
+			CHECK(hasTexture(cache, checksum) == (model.count(checksum) != 0));
+			break;
+		}
+		if (failures)
+			return;
+	}
+
+	CHECK(cache.count() == (uint32)model.size());
+	std::vector<uint64> list;
+	cache.checksums(list);
+	std::sort(list.begin(), list.end());
+	std::vector<uint64> expected;
+	for (std::map<uint64, bool>::const_iterator it = model.begin(); it != model.end(); ++it)
+		expected.push_back(it->first);
+	CHECK(list == expected);
+
+	/* cleared cache takes the same textures again */
+	cache.clear();
+	CHECK(cache.count() == 0);
+	for (size_t i = 0; i < checksums.size(); i++)
+		CHECK(!cache.is_cached(checksums[i]));
+	for (size_t i = 0; i < checksums.size(); i++)
+		CHECK(addTexture(cache, checksums[i]));
+	for (size_t i = 0; i < checksums.size(); i++)
+		CHECK(hasTexture(cache, checksums[i]));
+}
+
+int main(int argc, char* argv[])
+{
+	testEvictionOrder();
+	testWrappedDelete();
+	testRandomOperations();
+
+	if (failures) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 2;
+	}
+	printf("TxCache: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * GPU texture compression benchmark
+ *
+ * Reads all RGBA PNG textures of a folder (a hires texture pack) and
+ * compresses them to S3TC (BC1/BC3) and ETC2 (RGB8/RGBA8 EAC) the way the
+ * texture caches do. Prints video memory reduction against RGBA8888,
+ * compression speed, and PSNR of the decoded textures. The decoders here
+ * follow the format specs and are independent from the encoders.
+ *
+ * Usage: compressbench_hq <folder> [threads]
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <thread>
+#include <math.h>
+#include <string.h>
+#include "benchutil.h"
+#include "../TxCompress.h"
+#include "../TxThreadPool.h"
+#include "../TxUtil.h"
+
+static inline int clamp255(int v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/* decodes one block into 4x4 RGBA texels */
+static void decodeBC1(const uint8 *src, uint8 *out, bool bc3)
+{
+	const uint16 c0 = src[0] | (src[1] << 8), c1 = src[2] | (src[3] << 8);
+	int palette[4][4];
+	const uint16 c[2] = { c0, c1 };
+	for (int i = 0; i < 2; i++) {
+		const int r = c[i] >> 11, g = (c[i] >> 5) & 0x3f, b = c[i] & 0x1f;
+		palette[i][0] = (r << 3) | (r >> 2);
+		palette[i][1] = (g << 2) | (g >> 4);
+		palette[i][2] = (b << 3) | (b >> 2);
+		palette[i][3] = 255;
+	}
+	for (int j = 0; j < 3; j++) {
+		if (c0 > c1 || bc3) {
+			palette[2][j] = (2 * palette[0][j] + palette[1][j]) / 3;
+			palette[3][j] = (palette[0][j] + 2 * palette[1][j]) / 3;
+		} else {
+			palette[2][j] = (palette[0][j] + palette[1][j]) / 2;
+			palette[3][j] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = (c0 > c1 || bc3) ? 255 : 0;
+	const uint32 indices = src[4] | (src[5] << 8) | (src[6] << 16) | ((uint32)src[7] << 24);
+	for (int i = 0; i < 16; i++) {
+		const int *c = palette[(indices >> (i * 2)) & 3];
+		for (int j = 0; j < 4; j++)
+			out[i * 4 + j] = (uint8)c[j];
+	}
+}
+
+static void decodeBC3Alpha(const uint8 *src, uint8 *out)
+{
+	const int a0 = src[0], a1 = src[1];
+	int palette[8] = { a0, a1 };
+	for (int j = 2; j < 8; j++)
+		palette[j] = a0 > a1 ? ((8 - j) * a0 + (j - 1) * a1) / 7 : (j < 6 ? ((6 - j) * a0 + (j - 1) * a1) / 5 : (j == 6 ? 0 : 255));
+	uint64 indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (uint64)src[2 + i] << (i * 8);
+	for (int i = 0; i < 16; i++)
+		out[i * 4 + 3] = (uint8)palette[(indices >> (i * 3)) & 7];
+}
+
+static const int etcModifiers[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static const int eacModifiers[16][8] = {
+	{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+	{ -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+	{ -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+	{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+	{ -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+static inline uint32 readBE32(const uint8 *p)
+{
+	return ((uint32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/* individual and differential modes; the T, H and planar modes are never written */
+static bool decodeETC(const uint8 *src, uint8 *out)
+{
+	const uint32 high = readBE32(src), low = readBE32(src + 4);
+	const bool diff = (high & 2) != 0, flip = (high & 1) != 0;
+	int base[2][3];
+	for (int j = 0; j < 3; j++) {
+		const int shift = 27 - j * 8;
+		if (diff) {
+			const int c = (high >> shift) & 0x1f;
+			int d = (high >> (shift - 3)) & 7;
+			d = d >= 4 ? d - 8 : d;
+			if (c + d < 0 || c + d > 31)
+				return false;
+			base[0][j] = (c << 3) | (c >> 2);
+			base[1][j] = ((c + d) << 3) | ((c + d) >> 2);
+		} else {
+			base[0][j] = ((high >> (shift + 1)) & 0xf) * 17;
+			base[1][j] = ((high >> (shift - 3)) & 0xf) * 17;
+		}
+	}
+	const int table[2] = { (int)((high >> 5) & 7), (int)((high >> 2) & 7) };
+	for (int x = 0; x < 4; x++) {
+		for (int y = 0; y < 4; y++) {
+			const int s = flip ? (y >> 1) : (x >> 1);
+			const int i = x * 4 + y;
+			const int idx = (((low >> (16 + i)) & 1) << 1) | ((low >> i) & 1);
+			const int mod = (idx & 2) ? -etcModifiers[table[s]][idx & 1] : etcModifiers[table[s]][idx & 1];
+			uint8 *p = out + (y * 4 + x) * 4;
+			for (int j = 0; j < 3; j++)
+				p[j] = (uint8)clamp255(base[s][j] + mod);
+			p[3] = 255;
+		}
+	}
+	return true;
+}
+
+static void decodeEAC(const uint8 *src, uint8 *out)
+{
+	const uint64 bits = ((uint64)readBE32(src) << 32) | readBE32(src + 4);
+	const int base = (int)(bits >> 56), mul = (int)((bits >> 52) & 0xf), table = (int)((bits >> 48) & 0xf);
+	for (int x = 0; x < 4; x++)
+		for (int y = 0; y < 4; y++) {
+			const int idx = (int)((bits >> (45 - (x * 4 + y) * 3)) & 7);
+			out[(y * 4 + x) * 4 + 3] = (uint8)clamp255(base + eacModifiers[table][idx] * mul);
+		}
+}
+
+static bool decode(const uint8 *src, int width, int height, uint16 format, uint8 *dst)
+{
+	const bool alpha = format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || format == GL_COMPRESSED_RGBA8_ETC2_EAC;
+	const int blockSize = alpha ? 16 : 8;
+	uint8 block[64];
+	for (int by = 0; by < height / 4; by++) {
+		for (int bx = 0; bx < width / 4; bx++, src += blockSize) {
+			switch (format) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+				decodeBC1(src, block, false);
+				break;
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				decodeBC1(src + 8, block, true);
+				decodeBC3Alpha(src, block);
+				break;
+			case GL_COMPRESSED_RGB8_ETC2:
+				if (!decodeETC(src, block))
+					return false;
+				break;
+			case GL_COMPRESSED_RGBA8_ETC2_EAC:
+				if (!decodeETC(src + 8, block))
+					return false;
+				decodeEAC(src, block);
+				break;
+			}
+			for (int y = 0; y < 4; y++)
+				memcpy(dst + ((by * 4 + y) * width + bx * 4) * 4, block + y * 16, 16);
+		}
+	}
+	return true;
+}
+
+static double psnr(double squaredError, double samples)
+{
+	if (squaredError == 0.0)
+		return 99.0;
+	return 10.0 * log10(255.0 * 255.0 * samples / squaredError);
+}
+
+/* compresses and decodes all textures, returns false if some block does not decode */
+static bool bench(const char *name, int compression, const std::vector<Texture> &textures)
+{
+	TxUtil util;
+	size_t rawTotal = 0, compressedTotal = 0, opaque = 0;
+	double time = 0.0, rgbError = 0.0, rgbSamples = 0.0, alphaError = 0.0, alphaSamples = 0.0;
+	bool ok = true;
+	std::vector<uint8> compressed, decoded;
+	for (size_t i = 0; i < textures.size(); i++) {
+		const Texture &texture = textures[i];
+		Clock::time_point start = Clock::now();
+		const uint16 format = txcompress_format(texture.data.data(), texture.width, texture.height, compression);
+		compressed.resize(util.sizeofTx(texture.width, texture.height, format));
+		if (!format || !txcompress(texture.data.data(), texture.width, texture.height, format, compressed.data())) {
+			ok = false;
+			continue;
+		}
+		time += seconds(start);
+
+		decoded.resize(texture.data.size());
+		if (!decode(compressed.data(), texture.width, texture.height, format, decoded.data()))
+			ok = false;
+		const bool alpha = format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || format == GL_COMPRESSED_RGBA8_ETC2_EAC;
+		opaque += alpha ? 0 : 1;
+		for (size_t j = 0; j < texture.data.size(); j += 4) {
+			for (int c = 0; c < 3; c++) {
+				const double d = (double)texture.data[j + c] - decoded[j + c];
+				rgbError += d * d;
+			}
+			rgbSamples += 3.0;
+			if (alpha) {
+				const double d = (double)texture.data[j + 3] - decoded[j + 3];
+				alphaError += d * d;
+				alphaSamples += 1.0;
+			}
+		}
+		rawTotal += texture.data.size();
+		compressedTotal += compressed.size();
+	}
+
+	printf("%-6s %u opaque, VRAM %5.2fx smaller, compress %6.1f MPixel/s, PSNR RGB %5.2f dB, alpha %5.2f dB%s\n",
+		   name, (unsigned int)opaque, (double)rawTotal / compressedTotal, rawTotal / 4 / time / 1000000,
+		   psnr(rgbError, rgbSamples), alphaSamples > 0.0 ? psnr(alphaError, alphaSamples) : 99.0,
+		   ok ? "" : ", DECODE ERROR");
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <folder> [threads]\n", argv[0]);
+		return 1;
+	}
+	const int numThreads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+
+	/* only RGBA textures with whole blocks are compressed */
+	std::vector<Texture> all, textures;
+	readTextures(argv[1], all);
+	for (size_t i = 0; i < all.size(); i++) {
+		if (all[i].format == GL_RGBA8 && (all[i].width & 3) == 0 && (all[i].height & 3) == 0)
+			textures.push_back(all[i]);
+	}
+	if (textures.empty()) {
+		fprintf(stderr, "No RGBA PNG textures in %s\n", argv[1]);
+		return 1;
+	}
+	printf("%u textures\n", (unsigned int)textures.size());
+
+	TxThreadPool::getInstance()->init(numThreads > 0 ? numThreads : 1);
+	bool ok = bench("S3TC", S3TC_COMPRESSION, textures);
+	ok = bench("ETC2", ETC2_COMPRESSION, textures) && ok;
+	TxThreadPool::getInstance()->shutdown();
+
+	return ok ? 0 : 2;
+}
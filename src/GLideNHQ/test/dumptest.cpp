@@ -0,0 +1,218 @@
+/*
+ * Texture dump correctness test
+ *
+ * Checks the TxDump queue in a temporary folder: a texture is dumped once
+ * per checksum and format, textures over the memory budget are dropped and
+ * taken again later, a texture which failed to write is dumped again the
+ * next time, and files from an earlier session are not rewritten.
+ *
+ * Usage: dumptest_hq
+ * Exit code is 2 if a check fails.
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "../TxDump.h"
+
+/* 8x8 RGBA8 textures */
+#define TEXTURE_SIZE 8
+#define TEXTURE_BYTES (TEXTURE_SIZE * TEXTURE_SIZE * 4)
+#define IDENT "DUMPTEST"
+/* RGBA 16bit */
+#define N64FMT 0x0002
+
+static int failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+class Dump
+{
+public:
+	Dump(const std::string &path, size_t budget = TXDUMP_BUDGET) : _path(path)
+	{
+		wchar_t wpath[MAX_PATH], wident[MAX_PATH];
+		mbstowcs(wpath, path.c_str(), MAX_PATH);
+		mbstowcs(wident, IDENT, MAX_PATH);
+		_dump = new TxDump(wpath, wident, budget);
+	}
+	~Dump() { delete _dump; }
+	/* square RGBA8 texture filled with a byte of its checksum */
+	boolean dump(uint64 checksum, uint16 n64fmt, int size = TEXTURE_SIZE)
+	{
+		std::vector<uint8> data((size_t)size * size * 4, (uint8)(checksum & 0xff));
+		return _dump->dump(data.data(), size, size, size, GL_RGBA8, n64fmt, checksum);
+	}
+	void flush() { _dump->flush(); }
+	/* file the texture is written to */
+	std::string file(uint64 checksum, uint16 n64fmt) const
+	{
+		char name[MAX_PATH];
+		snprintf(name, sizeof(name), "%s/texture_dump/" IDENT "/GLideNHQ/" IDENT "#%08X#%01X#%01X_all.png",
+				 _path.c_str(), (uint32)(checksum & 0xffffffff), n64fmt >> 8, n64fmt & 0xf);
+		return name;
+	}
+	bool written(uint64 checksum, uint16 n64fmt) const
+	{
+		struct stat st;
+		return stat(file(checksum, n64fmt).c_str(), &st) == 0 && st.st_size > 0;
+	}
+private:
+	std::string _path;
+	TxDump *_dump;
+};
+
+static int removeFile(const char *path, const struct stat *, int, struct FTW *)
+{
+	return remove(path);
+}
+
+static void removeTree(const std::string &path)
+{
+	nftw(path.c_str(), removeFile, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static void testDedup(const std::string &path)
+{
+	Dump dump(path);
+	CHECK(dump.dump(1, N64FMT));
+	/* the same texture again, while it is queued and after it is written */
+	CHECK(!dump.dump(1, N64FMT));
+	dump.flush();
+	CHECK(dump.written(1, N64FMT));
+	CHECK(!dump.dump(1, N64FMT));
+
+	/* same checksum in another format, and another checksum */
+	CHECK(dump.dump(1, N64FMT | 0x0100));
+	CHECK(dump.dump(2, N64FMT));
+	CHECK(!dump.dump(1, N64FMT | 0x0100));
+	CHECK(!dump.dump(2, N64FMT));
+	dump.flush();
+	CHECK(dump.written(1, N64FMT | 0x0100));
+	CHECK(dump.written(2, N64FMT));
+}
+
+static void testBudget(const std::string &path)
+{
+	/* room for one texture and a half */
+	Dump dump(path, TEXTURE_BYTES * 3 / 2);
+
+	/* a texture larger than the budget is dropped and not remembered */
+	CHECK(!dump.dump(3, N64FMT, TEXTURE_SIZE * 2));
+	dump.flush();
+	CHECK(!dump.written(3, N64FMT));
+	CHECK(dump.dump(3, N64FMT));
+
+	/* the second texture fits only once the first is written; if it was dropped, it is taken later */
+	const boolean queued = dump.dump(4, N64FMT);
+	dump.flush();
+	CHECK(dump.written(3, N64FMT));
+	CHECK(dump.written(4, N64FMT) == (queued != 0));
+	CHECK(dump.dump(4, N64FMT) == !queued);
+	dump.flush();
+	CHECK(dump.written(4, N64FMT));
+	CHECK(!dump.dump(4, N64FMT));
+}
+
+static void testRetry(const std::string &path)
+{
+	/* a file in place of the dump folder fails every write */
+	mkdir(path.c_str(), 0755);
+	const std::string blocker = path + "/texture_dump";
+	FILE *fp = fopen(blocker.c_str(), "wb");
+	CHECK(fp != NULL);
+	if (fp)
+		fclose(fp);
+
+	Dump dump(path);
+	CHECK(dump.dump(5, N64FMT));
+	dump.flush();
+	CHECK(!dump.written(5, N64FMT));
+	/* failed texture is queued again */
+	CHECK(dump.dump(5, N64FMT));
+	dump.flush();
+	CHECK(!dump.written(5, N64FMT));
+
+	/* and written once the folder can be made */
+	remove(blocker.c_str());
+	CHECK(dump.dump(5, N64FMT));
+	dump.flush();
+	CHECK(dump.written(5, N64FMT));
+	CHECK(!dump.dump(5, N64FMT));
+}
+
+static void testEarlierSession(const std::string &path)
+{
+	std::string file;
+	{
+		Dump dump(path);
+		CHECK(dump.dump(6, N64FMT));
+		dump.flush();
+		file = dump.file(6, N64FMT);
+	}
+	/* mark the file, a rewrite would replace the mark */
+	FILE *fp = fopen(file.c_str(), "wb");
+	CHECK(fp != NULL);
+	if (fp) {
+		fputs("earlier session", fp);
+		fclose(fp);
+	}
+
+	{
+		Dump dump(path);
+		dump.dump(6, N64FMT);
+		dump.flush();
+	}
+	char mark[32] = { 0 };
+	fp = fopen(file.c_str(), "rb");
+	CHECK(fp != NULL);
+	if (fp) {
+		CHECK(fgets(mark, sizeof(mark), fp) != NULL);
+		fclose(fp);
+	}
+	CHECK(strcmp(mark, "earlier session") == 0);
+}
+
+int main(int argc, char* argv[])
+{
+	char folder[] = "/tmp/dumptest_hq.XXXXXX";
+	if (!mkdtemp(folder)) {
+		fprintf(stderr, "Cannot create a temporary folder\n");
+		return 1;
+	}
+	const std::string root(folder);
+
+	testDedup(root + "/dedup");
+	testBudget(root + "/budget");
+	testRetry(root + "/retry");
+	testEarlierSession(root + "/session");
+	removeTree(root);
+
+	if (failures) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 2;
+	}
+	printf("TxDump: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Texture Filtering benchmark
+ *
+ * Measures single thread throughput of the enhancement filters in source
+ * MPixel/s for the scalar code and the best SIMD kernels of the cpu, and
+ * checks that both produce the same output.
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../TextureFilters.h"
+#include "../TextureFilters_simd.h"
+
+#define SIZE 256
+#define MAX_SCALE 6
+#define MIN_SECONDS 0.5
+
+static const char * simdName(int level)
+{
+	switch (level) {
+	case SIMD_NEON: return "neon";
+	case SIMD_SSE41: return "sse4.1";
+	case SIMD_AVX2: return "avx2";
+	}
+	return "scalar";
+}
+
+/* source MPixel/s */
+static double measure(uint32 *src, uint32 *dest, uint32 filter)
+{
+	filter_8888(src, SIZE, SIZE, dest, filter);
+	unsigned int iterations = 0;
+	const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> elapsed;
+	do {
+		filter_8888(src, SIZE, SIZE, dest, filter);
+		iterations++;
+		elapsed = std::chrono::high_resolution_clock::now() - start;
+	} while (elapsed.count() < MIN_SECONDS);
+	return (double)SIZE * SIZE * iterations / elapsed.count() / 1000000.0;
+}
+
+int main(int argc, char* argv[])
+{
+	struct {
+		const char *name;
+		uint32 filter;
+		uint32 scale;
+	} filters[] = {
+		{ "2xsai", X2SAI_ENHANCEMENT, 2 },
+		{ "hq2x", HQ2X_ENHANCEMENT, 2 },
+		{ "lq2x", LQ2X_ENHANCEMENT, 2 },
+		{ "hq4x", HQ4X_ENHANCEMENT, 4 },
+		{ "xbrz", BRZ2X_ENHANCEMENT, 2 },
+		{ "xbrz", BRZ3X_ENHANCEMENT, 3 },
+		{ "xbrz", BRZ4X_ENHANCEMENT, 4 },
+		{ "xbrz", BRZ5X_ENHANCEMENT, 5 },
+		{ "xbrz", BRZ6X_ENHANCEMENT, 6 }
+	};
+
+	const unsigned int destSize = SIZE * SIZE * MAX_SCALE * MAX_SCALE;
+	uint32 *src = (uint32*)malloc(SIZE * SIZE * 4);
+	uint32 *destScalar = (uint32*)malloc(destSize * 4);
+	uint32 *destSimd = (uint32*)malloc(destSize * 4);
+	if (!src || !destScalar || !destSimd)
+		return 1;
+
+	/* blocky image with some noise, similar to N64 textures */
+	srand(1);
+	for (unsigned int y = 0; y < SIZE; y++) {
+		for (unsigned int x = 0; x < SIZE; x++) {
+			const uint32 block = ((x >> 3) * 0x9E3779B1u) ^ ((y >> 3) * 0x85EBCA6Bu);
+			src[y * SIZE + x] = 0xFF000000 | ((block ^ (rand() & 0x0F0F0F)) & 0xFFFFFF);
+		}
+	}
+
+	const int level = simd_getLevel();
+	int result = 0;
+	printf("%dx%d source, simd: %s\n", SIZE, SIZE, simdName(level));
+	printf("%-8s %5s %16s %16s %8s\n", "filter", "scale", "scalar (MP/s)", "simd (MP/s)", "match");
+	for (unsigned int f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+		const uint32 filter = filters[f].filter;
+		const uint32 scale = filters[f].scale;
+		memset(destScalar, 0, destSize * 4);
+		memset(destSimd, 0, destSize * 4);
+
+		simd_setLevel(SIMD_NONE);
+		const double scalar = measure(src, destScalar, filter);
+		simd_setLevel(level);
+		const double simd = measure(src, destSimd, filter);
+
+		const bool match = memcmp(destScalar, destSimd, SIZE * SIZE * scale * scale * 4) == 0;
+		if (!match)
+			result = 1;
+		printf("%-8s %4ux %16.2f %16.2f %8s\n", filters[f].name, scale, scalar, simd, match ? "yes" : "NO");
+	}
+
+	free(src);
+	free(destScalar);
+	free(destSimd);
+	return result;
+}
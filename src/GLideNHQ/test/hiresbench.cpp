@@ -0,0 +1,127 @@
+/*
+ * Hires texture pack loading benchmark
+ *
+ * Measures start time and resident memory of TxHiResCache for a Rice
+ * format texture pack, loaded fully at start or indexed for loading on
+ * first use (LAZY_HIRESTEX), or mapped from a hires texture archive made by
+ * GLideN64HiResPackCompiler -o <pack folder>/cache, and the time to request
+ * every texture once.
+ * Full load decodes files on the thread pool, threads 1 gives the serial time.
+ * Run it once per mode, resident memory of the process is not returned
+ * to the system reliably after a pack is freed.
+ *
+ * Usage: hiresbench_hq <pack folder> <rom name> full|lazy|archive [cache MB] [threads]
+ *        hiresbench_hq <pack folder> <rom name> generate <count> <size>
+ * generate writes <count> random <size> x <size> _all.png textures to
+ * <pack folder>/<rom name>.
+ *
+ * this is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * this is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <string.h>
+#include <thread>
+#include <zlib.h>
+#include "benchutil.h"
+#include "../TxHiResCache.h"
+#include "../TxThreadPool.h"
+
+#define MAX_TEXTURE_SIZE 4096
+
+/* chksum is made of the texture number, so requests can find them */
+static uint32 textureChksum(unsigned int i)
+{
+	return (i + 1) * 0x9E3779B1u;
+}
+
+static int generate(const char *packPath, const char *romName, unsigned int count, int size)
+{
+	std::string dir = std::string(packPath) + "/" + romName;
+	wchar_t wdir[MAX_PATH];
+	mbstowcs(wdir, dir.c_str(), MAX_PATH);
+	if (osal_mkdirp(wdir) != 0)
+		return 1;
+
+	TxImage image;
+	std::vector<uint32> tex(size * size);
+	srand(1);
+	for (unsigned int i = 0; i < count; i++) {
+		/* blocks with noise, so the files compress like real textures */
+		const uint32 color = ((uint32)rand() << 16) ^ (uint32)rand();
+		for (int p = 0; p < size * size; p++)
+			tex[p] = 0xFF000000 | ((color ^ ((p / size / 8) * 0x10305) ^ (rand() & 0x070707)) & 0xFFFFFF);
+		char fname[MAX_PATH];
+		snprintf(fname, MAX_PATH, "%s/%s#%08X#0#2_all.png", dir.c_str(), romName, textureChksum(i));
+		FILE *fp = fopen(fname, "wb");
+		if (!fp)
+			return 1;
+		image.writePNG((uint8*)tex.data(), fp, size, size, size << 2, 0x0003, 0);
+		fclose(fp);
+	}
+	printf("%u textures %d x %d written to %s\n", count, size, size, dir.c_str());
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 6 && strcmp(argv[3], "generate") == 0)
+		return generate(argv[1], argv[2], atoi(argv[4]), atoi(argv[5]));
+
+	if (argc < 4 || (strcmp(argv[3], "full") != 0 && strcmp(argv[3], "lazy") != 0 && strcmp(argv[3], "archive") != 0)) {
+		fprintf(stderr, "Usage: %s <pack folder> <rom name> full|lazy|archive [cache MB] [threads]\n", argv[0]);
+		fprintf(stderr, "       %s <pack folder> <rom name> generate <count> <size>\n", argv[0]);
+		return 1;
+	}
+	const bool lazy = strcmp(argv[3], "lazy") == 0;
+	const int cacheSize = (argc > 4 ? atoi(argv[4]) : 100) * 1000000;
+	const int numThreads = argc > 5 ? atoi(argv[5]) : (int)std::thread::hardware_concurrency();
+	TxThreadPool::getInstance()->init(numThreads > 0 ? numThreads : 1);
+
+	wchar_t packPath[MAX_PATH], romName[MAX_PATH], cachePath[MAX_PATH];
+	mbstowcs(packPath, argv[1], MAX_PATH);
+	mbstowcs(romName, argv[2], MAX_PATH);
+	/* cache path must be set for the pack to load, the archive is in its cache folder */
+	mbstowcs(cachePath, argv[1], MAX_PATH);
+	int options = RICE_HIRESTEXTURES;
+	if (lazy)
+		options |= LAZY_HIRESTEX;
+	if (strcmp(argv[3], "archive") == 0)
+		options |= DUMP_HIRESTEXCACHE;
+
+	const double residentBefore = residentBytes() / 1000000.0;
+	const Clock::time_point start = Clock::now();
+	TxHiResCache *cache = new TxHiResCache(MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE, 32, options, cacheSize,
+										   cachePath, packPath, romName, NULL);
+	const Clock::time_point loaded = Clock::now();
+	const double residentLoaded = residentBytes() / 1000000.0;
+
+	/* request every texture of the generated pack once, like a game going through all its levels.
+	 * crc of the data reads it like an upload does and must match between modes. */
+	unsigned int found = 0;
+	uLong crc = crc32(0L, Z_NULL, 0);
+	GHQTexInfo info;
+	TxUtil util;
+	while (cache->get(textureChksum(found), &info)) {
+		crc = crc32(crc, info.data, util.sizeofTx(info.width, info.height, info.format));
+		found++;
+	}
+	const Clock::time_point requested = Clock::now();
+	const double residentRequested = residentBytes() / 1000000.0;
+
+	printf("mode:  %s, cache %d MB, %u threads\n", argv[3], cacheSize / 1000000, TxThreadPool::getInstance()->getNumThreads());
+	printf("start: %8.3f s, resident %8.1f MB\n", std::chrono::duration<double>(loaded - start).count(),
+		   residentLoaded - residentBefore);
+	printf("get:   %8.3f s, resident %8.1f MB, %u textures, crc %08lX\n", std::chrono::duration<double>(requested - loaded).count(),
+		   residentRequested - residentBefore, found, crc);
+
+	delete cache;
+	TxThreadPool::getInstance()->shutdown();
+	return 0;
+}
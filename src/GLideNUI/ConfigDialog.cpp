@@ -142,7 +142,17 @@ void ConfigDialog::_init()
 		break;
 	}
 	ui->RenderFBCheckBox->setChecked(config.frameBufferEmulation.copyFromRDRAM != 0);
-	ui->CopyDepthCheckBox->setChecked(config.frameBufferEmulation.copyDepthToRDRAM != 0);
+	switch (config.frameBufferEmulation.copyDepthToRDRAM) {
+	case Config::ctDisable:
+		ui->copyDepthDisableRadioButton->setChecked(true);
+		break;
+	case Config::ctSync:
+		ui->copyDepthSyncRadioButton->setChecked(true);
+		break;
+	case Config::ctAsync:
+		ui->copyDepthAsyncRadioButton->setChecked(true);
+		break;
+	}
 	ui->n64DepthCompareCheckBox->setChecked(config.frameBufferEmulation.N64DepthCompare != 0);
 	switch (config.frameBufferEmulation.aspect) {
 	case Config::aStretch:
@@ -182,12 +192,15 @@ void ConfigDialog::_init()
 	ui->textureFilterCacheSpinBox->setValue(config.textureFilter.txCacheSize / gc_uMegabyte);
 	ui->deposterizeCheckBox->setChecked(config.textureFilter.txDeposterize != 0);
 	ui->ignoreBackgroundsCheckBox->setChecked(config.textureFilter.txFilterIgnoreBG != 0);
+	ui->enhancementGPUCheckBox->setChecked(config.textureFilter.txEnhancementGPU != 0);
 
 	ui->texturePackGroupBox->setChecked(config.textureFilter.txHiresEnable != 0);
 	ui->alphaChannelCheckBox->setChecked(config.textureFilter.txHiresFullAlphaChannel != 0);
 	ui->alternativeCRCCheckBox->setChecked(config.textureFilter.txHresAltCRC != 0);
+	ui->lazyLoadCheckBox->setChecked(config.textureFilter.txHiresLazyLoad != 0);
 	ui->textureDumpCheckBox->setChecked(config.textureFilter.txDump != 0);
 	ui->force16bppCheckBox->setChecked(config.textureFilter.txForce16bpp != 0);
+	ui->gpuCompressionCheckBox->setChecked(config.textureFilter.txGPUCompression != 0);
 	ui->compressCacheCheckBox->setChecked(config.textureFilter.txCacheCompression != 0);
 	ui->saveTextureCacheCheckBox->setChecked(config.textureFilter.txSaveCache != 0);
 
@@ -334,7 +347,12 @@ void ConfigDialog::accept()
 	else if (ui->copyBufferAsyncRadioButton->isChecked())
 		config.frameBufferEmulation.copyToRDRAM = Config::ctAsync;
 	config.frameBufferEmulation.copyFromRDRAM = ui->RenderFBCheckBox->isChecked() ? 1 : 0;
-	config.frameBufferEmulation.copyDepthToRDRAM = ui->CopyDepthCheckBox->isChecked() ? 1 : 0;
+	if (ui->copyDepthDisableRadioButton->isChecked())
+		config.frameBufferEmulation.copyDepthToRDRAM = Config::ctDisable;
+	else if (ui->copyDepthSyncRadioButton->isChecked())
+		config.frameBufferEmulation.copyDepthToRDRAM = Config::ctSync;
+	else if (ui->copyDepthAsyncRadioButton->isChecked())
+		config.frameBufferEmulation.copyDepthToRDRAM = Config::ctAsync;
 	config.frameBufferEmulation.N64DepthCompare = ui->n64DepthCompareCheckBox->isChecked() ? 1 : 0;
 	if (ui->aspectStretchRadioButton->isChecked())
 		config.frameBufferEmulation.aspect = Config::aStretch;
@@ -357,14 +375,17 @@ void ConfigDialog::accept()
 	config.textureFilter.txCacheSize = ui->textureFilterCacheSpinBox->value() * gc_uMegabyte;
 	config.textureFilter.txDeposterize = ui->deposterizeCheckBox->isChecked() ? 1 : 0;
 	config.textureFilter.txFilterIgnoreBG = ui->ignoreBackgroundsCheckBox->isChecked() ? 1 : 0;
+	config.textureFilter.txEnhancementGPU = ui->enhancementGPUCheckBox->isChecked() ? 1 : 0;
 
 	config.textureFilter.txHiresEnable = ui->texturePackGroupBox->isChecked() ? 1 : 0;
 	config.textureFilter.txHiresFullAlphaChannel = ui->alphaChannelCheckBox->isChecked() ? 1 : 0;
 	config.textureFilter.txHresAltCRC = ui->alternativeCRCCheckBox->isChecked() ? 1 : 0;
+	config.textureFilter.txHiresLazyLoad = ui->lazyLoadCheckBox->isChecked() ? 1 : 0;
 	config.textureFilter.txDump = ui->textureDumpCheckBox->isChecked() ? 1 : 0;
 
 	config.textureFilter.txCacheCompression = ui->compressCacheCheckBox->isChecked() ? 1 : 0;
 	config.textureFilter.txForce16bpp = ui->force16bppCheckBox->isChecked() ? 1 : 0;
+	config.textureFilter.txGPUCompression = ui->gpuCompressionCheckBox->isChecked() ? 1 : 0;
 	config.textureFilter.txSaveCache = ui->saveTextureCacheCheckBox->isChecked() ? 1 : 0;
 
 	QString txPath = ui->txPathLabel->text();
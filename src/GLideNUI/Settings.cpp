@@ -65,12 +65,15 @@ void _loadSettings(QSettings & settings)
 	config.textureFilter.txEnhancementMode = settings.value("txEnhancementMode", config.textureFilter.txEnhancementMode).toInt();
 	config.textureFilter.txDeposterize = settings.value("txDeposterize", config.textureFilter.txDeposterize).toInt();
 	config.textureFilter.txFilterIgnoreBG = settings.value("txFilterIgnoreBG", config.textureFilter.txFilterIgnoreBG).toInt();
+	config.textureFilter.txEnhancementGPU = settings.value("txEnhancementGPU", config.textureFilter.txEnhancementGPU).toInt();
 	config.textureFilter.txCacheSize = settings.value("txCacheSize", config.textureFilter.txCacheSize).toInt();
 	config.textureFilter.txHiresEnable = settings.value("txHiresEnable", config.textureFilter.txHiresEnable).toInt();
 	config.textureFilter.txHiresFullAlphaChannel = settings.value("txHiresFullAlphaChannel", config.textureFilter.txHiresFullAlphaChannel).toInt();
 	config.textureFilter.txHresAltCRC = settings.value("txHresAltCRC", config.textureFilter.txHresAltCRC).toInt();
+	config.textureFilter.txHiresLazyLoad = settings.value("txHiresLazyLoad", config.textureFilter.txHiresLazyLoad).toInt();
 	config.textureFilter.txDump = settings.value("txDump", config.textureFilter.txDump).toInt();
 	config.textureFilter.txForce16bpp = settings.value("txForce16bpp", config.textureFilter.txForce16bpp).toInt();
+	config.textureFilter.txGPUCompression = settings.value("txGPUCompression", config.textureFilter.txGPUCompression).toInt();
 	config.textureFilter.txCacheCompression = settings.value("txCacheCompression", config.textureFilter.txCacheCompression).toInt();
 	config.textureFilter.txSaveCache = settings.value("txSaveCache", config.textureFilter.txSaveCache).toInt();
 	QString txPath = QString::fromWCharArray(config.textureFilter.txPath);
@@ -179,12 +182,15 @@ void writeSettings(const QString & _strIniFolder)
 	settings.setValue("txEnhancementMode", config.textureFilter.txEnhancementMode);
 	settings.setValue("txDeposterize", config.textureFilter.txDeposterize);
 	settings.setValue("txFilterIgnoreBG", config.textureFilter.txFilterIgnoreBG);
+	settings.setValue("txEnhancementGPU", config.textureFilter.txEnhancementGPU);
 	settings.setValue("txCacheSize", config.textureFilter.txCacheSize);
 	settings.setValue("txHiresEnable", config.textureFilter.txHiresEnable);
 	settings.setValue("txHiresFullAlphaChannel", config.textureFilter.txHiresFullAlphaChannel);
 	settings.setValue("txHresAltCRC", config.textureFilter.txHresAltCRC);
+	settings.setValue("txHiresLazyLoad", config.textureFilter.txHiresLazyLoad);
 	settings.setValue("txDump", config.textureFilter.txDump);
 	settings.setValue("txForce16bpp", config.textureFilter.txForce16bpp);
+	settings.setValue("txGPUCompression", config.textureFilter.txGPUCompression);
 	settings.setValue("txCacheCompression", config.textureFilter.txCacheCompression);
 	settings.setValue("txSaveCache", config.textureFilter.txSaveCache);
 	settings.setValue("txPath", QString::fromWCharArray(config.textureFilter.txPath));
@@ -0,0 +1,107 @@
+/*
+Hires texture pack compiler.
+Loads a Rice format texture pack with GLideNHQ, the same way the plugin loads it,
+and writes the converted textures to a hires texture archive.
+The plugin maps the archive instead of loading the pack when "Save texture cache to HD" (txSaveCache) is on.
+Copy the archive to the cache folder of the plugin: <user cache path>/cache/<rom name>_HIRESTEXTURES.hta
+Textures are converted for 4096x4096 max texture size. The plugin skips archive textures larger than the size of the GPU.
+
+Usage: GLideN64HiResPackCompiler [-16] [-a] [-c s3tc|etc2] [-o <output folder>] <texture pack folder> <rom name>
+-16 - convert textures to 16 bit (txForce16bpp)
+-a - use full alpha channel (txHiresFullAlphaChannel)
+-c - compress textures for GPU (txGPUCompression), s3tc for desktop GL, etc2 for GLES 3.
+-o - folder to write the archive to, current folder by default.
+The options must match the plugin config, otherwise the plugin ignores the archive.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <wchar.h>
+
+#include "../GLideNHQ/TxHiResCache.h"
+#include "../GLideNHQ/TxThreadPool.h"
+
+#define MAX_TEXTURE_SIZE 4096
+
+static
+void displayProgress(const wchar_t * _format, ...)
+{
+	/* stdout stays byte oriented */
+	wchar_t buf[MAX_PATH * 2];
+	va_list args;
+	va_start(args, _format);
+	vswprintf(buf, MAX_PATH * 2, _format, args);
+	va_end(args);
+	printf("%ls", buf);
+}
+
+static
+void printUsage(const char * _name)
+{
+	fprintf(stderr, "Usage: %s [-16] [-a] [-c s3tc|etc2] [-o <output folder>] <texture pack folder> <rom name>\n", _name);
+}
+
+int main(int argc, char * argv[])
+{
+	int options = RICE_HIRESTEXTURES;
+	const char * outputPath = ".";
+	const char * args[2] = { NULL, NULL };
+	int numArgs = 0;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-16") == 0)
+			options |= FORCE16BPP_HIRESTEX;
+		else if (strcmp(argv[i], "-a") == 0)
+			options |= LET_TEXARTISTS_FLY;
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc && strcmp(argv[i + 1], "s3tc") == 0) {
+			options |= COMPRESS_HIRESTEX | S3TC_COMPRESSION;
+			++i;
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc && strcmp(argv[i + 1], "etc2") == 0) {
+			options |= COMPRESS_HIRESTEX | ETC2_COMPRESSION;
+			++i;
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			outputPath = argv[++i];
+		else if (argv[i][0] != '-' && numArgs < 2)
+			args[numArgs++] = argv[i];
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (numArgs != 2) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	wchar_t packPath[MAX_PATH], romName[MAX_PATH], output[MAX_PATH];
+	mbstowcs(packPath, args[0], MAX_PATH);
+	mbstowcs(romName, args[1], MAX_PATH);
+	mbstowcs(output, outputPath, MAX_PATH);
+
+	TxThreadPool::getInstance()->init(TxUtil().getNumberofProcessors());
+
+	/* cache path must be set for the pack to load. DUMP_HIRESTEXCACHE is off, so the cache writes nothing by itself. */
+	TxHiResCache * cache = new TxHiResCache(MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE, 32, options, 0,
+		output, packPath, romName, displayProgress);
+
+	int result = 0;
+	if (cache->empty()) {
+		fprintf(stderr, "No textures found for %s in %s\n", args[1], args[0]);
+		result = 1;
+	} else {
+		tx_wstring filename(romName);
+		filename += wst("_HIRESTEXTURES.");
+		filename += HIRESARCHIVE_EXT;
+		if (cache->saveArchive(output, filename.c_str())) {
+			printf("Archive written to %s/%ls\n", outputPath, filename.c_str());
+		} else {
+			fprintf(stderr, "Can't write archive to %s/%ls\n", outputPath, filename.c_str());
+			result = 1;
+		}
+	}
+
+	delete cache;
+	TxThreadPool::getInstance()->shutdown();
+	return result;
+}
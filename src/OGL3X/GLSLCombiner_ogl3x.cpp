@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
@@ -295,23 +296,89 @@ void DestroyShaderCombiner() {
 #endif // GL_IMAGE_TEXTURES_SUPPORT
 }
 
-ShaderCombiner::ShaderCombiner() : m_bNeedUpdate(true)
+ShaderCombiner::ShaderCombiner() : m_fragmentShader(0), m_bLinked(true), m_bNeedUpdate(true), m_bUsesNoise(false)
 {
+	_resetStateVersions();
 	m_program = glCreateProgram();
 	_locate_attributes();
 }
 
-ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCombine & _combine) : m_key(getCombinerKey(_combine.mux)), m_bNeedUpdate(true)
+ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCombine & _combine) : m_key(getCombinerKey(_combine.mux)), m_fragmentShader(0), m_bLinked(true), m_bNeedUpdate(true), m_bUsesNoise(false)
 {
+	_resetStateVersions();
 	std::string strCombiner;
 	m_nInputs = compileCombiner(_color, _alpha, strCombiner);
 
-	const bool bUseLod = usesLOD();
 	const bool bUseHWLight = config.generalEmulation.enableHWLighting != 0 && GBI.isHWLSupported() && usesShadeColor();
 
+	m_program = glCreateProgram();
+	_locate_attributes();
+	_linkProgram(strCombiner, bUseHWLight, false);
+}
+
+ShaderCombiner * ShaderCombiner::createUberShader()
+{
+	ShaderCombiner * pCombiner = new ShaderCombiner();
+	pCombiner->m_key = 0;
+	pCombiner->m_nInputs = (1 << TEXEL0) | (1 << TEXEL1) | (1 << TEXEL0_ALPHA) | (1 << TEXEL1_ALPHA) |
+		(1 << SHADE) | (1 << SHADE_ALPHA) | (1 << NOISE);
+
+	std::string strCombiner;
+	compileUberCombiner(strCombiner);
+	pCombiner->_linkProgram(strCombiner, false, true);
+	pCombiner->finishLinking(true);
+	return pCombiner;
+}
+
+void ShaderCombiner::setUberShaderCombine(u64 _key, int _nInputs, const CombineCycle * _color, const CombineCycle * _alpha, int _numCycles)
+{
+	m_key = _key;
+	if (m_nInputs != _nInputs) {
+		// Set of used uniforms depends on inputs.
+		m_nInputs = _nInputs;
+		_resetStateVersions();
+	}
+	glUseProgram(m_program);
+	m_uniforms.uCombineColor0.set(_color[0].sa, _color[0].sb, _color[0].m, _color[0].a, false);
+	m_uniforms.uCombineAlpha0.set(_alpha[0].sa, _alpha[0].sb, _alpha[0].m, _alpha[0].a, false);
+	m_uniforms.uCombineColor1.set(_color[1].sa, _color[1].sb, _color[1].m, _color[1].a, false);
+	m_uniforms.uCombineAlpha1.set(_alpha[1].sa, _alpha[1].sb, _alpha[1].m, _alpha[1].a, false);
+	m_uniforms.uCombineCycles.set(_numCycles, false);
+}
+
+bool ShaderCombiner::finishLinking(bool _bWait)
+{
+	if (isLinked())
+		return true;
+
+	if (!_bWait && isProgramLinkPending(m_program))
+		return false;
+
+	if (m_fragmentShader != 0) {
+		if (!checkShaderCompileStatus(m_fragmentShader)) {
+			GLint len = 0;
+			glGetShaderiv(m_fragmentShader, GL_SHADER_SOURCE_LENGTH, &len);
+			std::vector<GLchar> source(len + 1);
+			glGetShaderSource(m_fragmentShader, len + 1, NULL, source.data());
+			logErrorShader(GL_FRAGMENT_SHADER, source.data());
+		}
+		glDeleteShader(m_fragmentShader);
+		m_fragmentShader = 0;
+	}
+	assert(checkProgramLinkStatus(m_program));
+	m_bLinked = true;
+	_locateUniforms();
+	return true;
+}
+
+void ShaderCombiner::_linkProgram(const std::string & _strCombiner, bool _bUseHWLight, bool _bUberShader)
+{
+	const bool bUseLod = usesLOD();
+	const bool bBlendCycle2 = _bUberShader || gDP.otherMode.cycleType == G_CYC_2CYCLE;
+
 	if (usesTexture()) {
 		strFragmentShader.assign(fragment_shader_header_common_variables);
-		if (gDP.otherMode.cycleType == G_CYC_2CYCLE)
+		if (bBlendCycle2)
 			strFragmentShader.append(fragment_shader_header_common_variables_blend_mux_2cycle);
 
 #ifdef GL_MULTISAMPLING_SUPPORT
@@ -343,7 +410,7 @@ ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCo
 
 	} else {
 		strFragmentShader.assign(fragment_shader_header_common_variables_notex);
-		if (gDP.otherMode.cycleType == G_CYC_2CYCLE)
+		if (bBlendCycle2)
 			strFragmentShader.append(fragment_shader_header_common_variables_blend_mux_2cycle);
 		strFragmentShader.append(fragment_shader_header_noise);
 		strFragmentShader.append(fragment_shader_header_noise_dither);
@@ -355,9 +422,12 @@ ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCo
 
 	}
 
-	if (bUseHWLight)
+	if (_bUseHWLight)
 		strFragmentShader.append(fragment_shader_header_calc_light);
 
+	if (_bUberShader)
+		strFragmentShader.append(fragment_shader_header_uber_combiner);
+
 	strFragmentShader.append(fragment_shader_header_main);
 
 	if (bUseLod) {
@@ -388,12 +458,12 @@ ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCo
 			strFragmentShader.append("  lowp vec4 readtex1 = readTex(uTex1, vTexCoord1, uFbMonochrome[1], uFbFixedAlpha[1] != 0); \n");
 #endif // GL_MULTISAMPLING_SUPPORT
 	}
-	if (bUseHWLight)
+	if (_bUseHWLight)
 		strFragmentShader.append("  calc_light(vNumLights, vShadeColor.rgb, input_color); \n");
 	else
 		strFragmentShader.append("  input_color = vShadeColor.rgb;\n");
 	strFragmentShader.append("  vec_color = vec4(input_color, vShadeColor.a); \n");
-	strFragmentShader.append(strCombiner);
+	strFragmentShader.append(_strCombiner);
 
 	if (video().getRender().isImageTexturesSupported() && config.frameBufferEmulation.N64DepthCompare != 0)
 		strFragmentShader.append("  if (!depth_compare()) discard; \n");
@@ -423,7 +493,7 @@ ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCo
 		strFragmentShader.append(fragment_shader_fake_mipmap);
 
 #ifdef GLESX
-	if (bUseHWLight)
+	if (_bUseHWLight)
 		strFragmentShader.append(fragment_shader_calc_light);
 	if (bUseLod) {
 		if (config.generalEmulation.enableLOD != 0)
@@ -445,22 +515,18 @@ ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCo
 	}
 #endif
 
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	m_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 	const GLchar * strShaderData = strFragmentShader.data();
-	glShaderSource(fragmentShader, 1, &strShaderData, NULL);
-	glCompileShader(fragmentShader);
-	if (!checkShaderCompileStatus(fragmentShader))
-		logErrorShader(GL_FRAGMENT_SHADER, strFragmentShader);
+	glShaderSource(m_fragmentShader, 1, &strShaderData, NULL);
+	glCompileShader(m_fragmentShader);
 
-	m_program = glCreateProgram();
-	_locate_attributes();
 	if (usesTexture())
 		glAttachShader(m_program, g_vertex_shader_object);
 	else
 		glAttachShader(m_program, g_vertex_shader_object_notex);
-	glAttachShader(m_program, fragmentShader);
+	glAttachShader(m_program, m_fragmentShader);
 #ifndef GLESX
-	if (bUseHWLight)
+	if (_bUseHWLight)
 		glAttachShader(m_program, g_calc_light_shader_object);
 	if (bUseLod) {
 		if (config.generalEmulation.enableLOD != 0)
@@ -479,10 +545,9 @@ ShaderCombiner::ShaderCombiner(Combiner & _color, Combiner & _alpha, const gDPCo
 #endif
 	if (CombinerInfo::get().isShaderCacheSupported())
 		glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	// Compile and link status are checked in finishLinking, so the driver may build the program in background.
 	glLinkProgram(m_program);
-	assert(checkProgramLinkStatus(m_program));
-	glDeleteShader(fragmentShader);
-	_locateUniforms();
+	m_bLinked = false;
 }
 
 ShaderCombiner::~ShaderCombiner() {
@@ -538,6 +603,12 @@ void ShaderCombiner::_locateUniforms() {
 	LocateUniform(uBlendMux1);
 	LocateUniform(uBlendMux2);
 
+	LocateUniform(uCombineColor0);
+	LocateUniform(uCombineAlpha0);
+	LocateUniform(uCombineColor1);
+	LocateUniform(uCombineAlpha1);
+	LocateUniform(uCombineCycles);
+
 #ifdef GL_MULTISAMPLING_SUPPORT
 	LocateUniform(uMSTex0);
 	LocateUniform(uMSTex1);
@@ -580,15 +651,59 @@ void ShaderCombiner::update(bool _bForce) {
 		updateRenderState(true);
 	}
 
-	updateFogMode(_bForce);
-	updateBlendMode();
-	updateDitherMode(_bForce);
-	updateLOD(_bForce);
-	updateTextureInfo(_bForce);
-	updateAlphaTestInfo(_bForce);
-	updateDepthInfo(_bForce);
-	updateRenderTarget(_bForce);
-	updateScreenCoordsScale(_bForce);
+	// Uniform groups are recalculated only when state blocks they depend on have changed since the last update.
+	const u32 * versions = CombinerInfo::get().getStateVersions();
+	u32 changedBlocks = 0;
+	for (u32 i = 0; i < CombinerInfo::sbTotal; ++i) {
+		if (_bForce || m_stateVersions[i] != versions[i]) {
+			changedBlocks |= 1 << i;
+			m_stateVersions[i] = versions[i];
+		}
+	}
+
+	u32 updated = 0, skipped = 0;
+	_updateUniformGroups(changedBlocks, _bForce, updated, skipped);
+#ifndef NDEBUG
+	// Uniform groups must not change when their state blocks have not changed: recalculate all of them and compare.
+	UniformLocation uniforms;
+	memcpy(&uniforms, &m_uniforms, sizeof(uniforms));
+	u32 recalculated = 0, unchanged = 0;
+	_updateUniformGroups(~0U, false, recalculated, unchanged);
+	assert(memcmp(&uniforms, &m_uniforms, sizeof(uniforms)) == 0);
+#endif
+
+	// Noise texture is regenerated each frame while it is used.
+	if (m_bUsesNoise)
+		noiseTex.update();
+
+	CombinerInfo::get().countUniformUpdates(updated, skipped);
+}
+
+void ShaderCombiner::_updateUniformGroups(u32 _changedBlocks, bool _bForce, u32 & _updated, u32 & _skipped)
+{
+	const u32 otherMode = 1 << CombinerInfo::sbOtherMode;
+	const u32 geometry = 1 << CombinerInfo::sbGeometry;
+	const u32 viewport = 1 << CombinerInfo::sbViewport;
+	const u32 colors = 1 << CombinerInfo::sbColors;
+	const u32 frameBuffer = 1 << CombinerInfo::sbFrameBuffer;
+#define UPDATE_UNIFORM_GROUP(_blocks, _call) if ((_changedBlocks & (_blocks)) != 0) { _call; ++_updated; } else ++_skipped
+
+	UPDATE_UNIFORM_GROUP(otherMode | geometry, updateFogMode(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode, updateBlendMode(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode | frameBuffer, updateDitherMode(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode | geometry | colors | frameBuffer, updateLOD(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode | geometry, updateTextureInfo(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode | colors, updateAlphaTestInfo(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode | geometry | viewport | colors | frameBuffer, updateDepthInfo(_bForce));
+	UPDATE_UNIFORM_GROUP(otherMode | frameBuffer, updateRenderTarget(_bForce));
+	UPDATE_UNIFORM_GROUP(frameBuffer, updateScreenCoordsScale(_bForce));
+#undef UPDATE_UNIFORM_GROUP
+}
+
+void ShaderCombiner::_resetStateVersions()
+{
+	for (u32 i = 0; i < CombinerInfo::sbTotal; ++i)
+		m_stateVersions[i] = 0;
 }
 
 void ShaderCombiner::updateRenderState(bool _bForce)
@@ -663,6 +778,8 @@ void ShaderCombiner::disableBlending()
 {
 	m_uniforms.uForceBlendCycle1.set(0, false);
 	m_uniforms.uForceBlendCycle2.set(0, false);
+	// Blend uniforms no longer match other mode.
+	m_stateVersions[CombinerInfo::sbOtherMode] = 0;
 }
 
 void ShaderCombiner::updateDitherMode(bool _bForce)
@@ -678,12 +795,12 @@ void ShaderCombiner::updateDitherMode(bool _bForce)
 	}
 
 	const int nDither = (gDP.otherMode.cycleType < G_CYC_COPY) && (gDP.otherMode.colorDither == G_CD_NOISE || gDP.otherMode.alphaDither == G_AD_NOISE || gDP.otherMode.alphaCompare == G_AC_DITHER) ? 1 : 0;
-	if ((m_nInputs & (1 << NOISE)) + nDither != 0) {
+	m_bUsesNoise = (m_nInputs & (1 << NOISE)) + nDither != 0;
+	if (m_bUsesNoise) {
 		if (config.frameBufferEmulation.nativeResFactor == 0)
 			m_uniforms.uScreenScale.set(video().getScaleX(), video().getScaleY(), _bForce);
 		else
 			m_uniforms.uScreenScale.set(float(config.frameBufferEmulation.nativeResFactor), float(config.frameBufferEmulation.nativeResFactor), _bForce);
-		noiseTex.update();
 	}
 }
 
@@ -833,9 +950,9 @@ std::istream & operator>> (std::istream & _is, ShaderCombiner & _combiner)
 	std::vector<char> binary(binaryLength);
 	_is.read(binary.data(), binaryLength);
 
+	// Link status is checked in finishLinking when the combiner is used first time.
 	glProgramBinary(_combiner.m_program, binaryFormat, binary.data(), binaryLength);
-	assert(checkProgramLinkStatus(_combiner.m_program));
-	_combiner._locateUniforms();
+	_combiner.m_bLinked = false;
 	return _is;
 }
 
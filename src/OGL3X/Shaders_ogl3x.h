@@ -251,6 +251,76 @@ static const char* fragment_shader_header_alpha_noise_toonify =
 	"void toonify(in mediump float intensity);\n"
 #endif
 
+// Combiner inputs for the uber shader. Indices are the internal generalized combiner inputs (see Combiner.h).
+// LOD_FRACTION is not supported: combiners, which use it, are never drawn with the uber shader.
+static const char* fragment_shader_header_uber_combiner =
+"uniform lowp ivec4 uCombineColor0;		\n"
+"uniform lowp ivec4 uCombineAlpha0;		\n"
+"uniform lowp ivec4 uCombineColor1;		\n"
+"uniform lowp ivec4 uCombineAlpha1;		\n"
+"uniform lowp int uCombineCycles;		\n"
+"lowp vec3 uberColorInput(in lowp int _input, in lowp vec4 _combined, in lowp vec4 _tex0, in lowp vec4 _tex1, in lowp vec4 _shade)	\n"
+"{										\n"
+"  switch (_input) {					\n"
+"    case 0: return _combined.rgb;		\n"
+"    case 1: return _tex0.rgb;			\n"
+"    case 2: return _tex1.rgb;			\n"
+"    case 3: return uPrimColor.rgb;		\n"
+"    case 4: return _shade.rgb;			\n"
+"    case 5: return uEnvColor.rgb;		\n"
+"    case 6: return uCenterColor.rgb;	\n"
+"    case 7: return uScaleColor.rgb;	\n"
+"    case 8: return vec3(_combined.a);	\n"
+"    case 9: return vec3(_tex0.a);		\n"
+"    case 10: return vec3(_tex1.a);		\n"
+"    case 11: return vec3(uPrimColor.a);\n"
+"    case 12: return vec3(_shade.a);	\n"
+"    case 13: return vec3(uEnvColor.a);	\n"
+"    case 15: return vec3(uPrimLod);	\n"
+"    case 16: return vec3(0.5 + 0.5*snoise());	\n"
+"    case 17: return vec3(uK4);			\n"
+"    case 18: return vec3(uK5);			\n"
+"    case 19: return vec3(1.0);			\n"
+"  }									\n"
+"  return vec3(0.0);					\n"
+"}										\n"
+"lowp float uberAlphaInput(in lowp int _input, in lowp vec4 _combined, in lowp vec4 _tex0, in lowp vec4 _tex1, in lowp vec4 _shade)	\n"
+"{										\n"
+"  switch (_input) {					\n"
+"    case 0: return _combined.a;		\n"
+"    case 1: return _tex0.a;			\n"
+"    case 2: return _tex1.a;			\n"
+"    case 3: return uPrimColor.a;		\n"
+"    case 4: return _shade.a;			\n"
+"    case 5: return uEnvColor.a;		\n"
+"    case 6: return uCenterColor.a;		\n"
+"    case 7: return uScaleColor.a;		\n"
+"    case 8: return _combined.a;		\n"
+"    case 9: return _tex0.a;			\n"
+"    case 10: return _tex1.a;			\n"
+"    case 11: return uPrimColor.a;		\n"
+"    case 12: return _shade.a;			\n"
+"    case 13: return uEnvColor.a;		\n"
+"    case 15: return uPrimLod;			\n"
+"    case 16: return 0.5 + 0.5*snoise();\n"
+"    case 17: return uK4;				\n"
+"    case 18: return uK5;				\n"
+"    case 19: return 1.0;				\n"
+"  }									\n"
+"  return 0.0;							\n"
+"}										\n"
+"lowp vec3 uberColor(in lowp ivec4 _mux, in lowp vec4 _combined, in lowp vec4 _tex0, in lowp vec4 _tex1, in lowp vec4 _shade)	\n"
+"{										\n"
+"  return (uberColorInput(_mux[0], _combined, _tex0, _tex1, _shade) - uberColorInput(_mux[1], _combined, _tex0, _tex1, _shade)) *	\n"
+"    uberColorInput(_mux[2], _combined, _tex0, _tex1, _shade) + uberColorInput(_mux[3], _combined, _tex0, _tex1, _shade);			\n"
+"}										\n"
+"lowp float uberAlpha(in lowp ivec4 _mux, in lowp vec4 _combined, in lowp vec4 _tex0, in lowp vec4 _tex1, in lowp vec4 _shade)	\n"
+"{										\n"
+"  return (uberAlphaInput(_mux[0], _combined, _tex0, _tex1, _shade) - uberAlphaInput(_mux[1], _combined, _tex0, _tex1, _shade)) *	\n"
+"    uberAlphaInput(_mux[2], _combined, _tex0, _tex1, _shade) + uberAlphaInput(_mux[3], _combined, _tex0, _tex1, _shade);			\n"
+"}										\n"
+;
+
 static const char* fragment_shader_calc_light =
 AUXILIARY_SHADER_VERSION
 "layout (std140) uniform LightBlock {		\n"
@@ -1,6 +1,7 @@
 #include "UniformBlock.h"
 #include "../Config.h"
 #include "../Textures.h"
+#include "../Log.h"
 
 static
 const char * strTextureUniforms[UniformBlock::tuTotal] = {
@@ -31,8 +32,90 @@ const char * strLightUniforms[UniformBlock::luTotal] = {
 	"uLightColor"
 };
 
-UniformBlock::UniformBlock() : m_currentBuffer(0), m_renderer(video().getRender().getRenderer())
+UniformBlock::BufferRing::BufferRing() : m_buffer(0), m_pMappedData(NULL), m_offset(0), m_segment(0), m_alignment(256)
 {
+	memset(m_fences, 0, sizeof(m_fences));
+}
+
+UniformBlock::BufferRing::~BufferRing()
+{
+	for (u32 i = 0; i < SEGMENTS_COUNT; ++i) {
+		if (m_fences[i] != 0)
+			glDeleteSync(m_fences[i]);
+	}
+	if (m_buffer != 0)
+		glDeleteBuffers(1, &m_buffer);
+}
+
+void UniformBlock::BufferRing::init()
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+		m_alignment = alignment;
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+#ifdef GL_ARB_buffer_storage
+	if (OGLVideo::isExtensionSupported("GL_ARB_buffer_storage")) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, RING_SIZE, NULL, flags);
+		m_pMappedData = (GLbyte*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, RING_SIZE, flags);
+	}
+#endif
+	if (m_pMappedData == NULL)
+		glBufferData(GL_UNIFORM_BUFFER, RING_SIZE, NULL, GL_STREAM_DRAW);
+	LOG(LOG_VERBOSE, "Uniform buffer ring: %s mapping\n", m_pMappedData != NULL ? "persistent" : "unsynchronized");
+}
+
+void UniformBlock::BufferRing::_waitSegment(u32 _segment)
+{
+	if (m_fences[_segment] == 0)
+		return;
+	glClientWaitSync(m_fences[_segment], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(m_fences[_segment]);
+	m_fences[_segment] = 0;
+}
+
+bool UniformBlock::BufferRing::write(const void * _data, u32 _dataSize, GLintptr & _offset)
+{
+	u32 offset = (m_offset + m_alignment - 1) / m_alignment * m_alignment;
+	if (offset / SEGMENT_SIZE != (offset + _dataSize - 1) / SEGMENT_SIZE)
+		offset = (offset / SEGMENT_SIZE + 1) * SEGMENT_SIZE;
+	if (offset + _dataSize > RING_SIZE)
+		offset = 0;
+
+	const u32 segment = offset / SEGMENT_SIZE;
+	const bool bNewSegment = segment != m_segment;
+	if (bNewSegment) {
+		// Draws, which used the finished segment, are fenced. Reused segment is waited for.
+		m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_waitSegment(segment);
+		m_segment = segment;
+	}
+
+	if (m_pMappedData != NULL)
+		memcpy(m_pMappedData + offset, _data, _dataSize);
+	else {
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+		GLbyte * ptr = (GLbyte*)glMapBufferRange(GL_UNIFORM_BUFFER, offset, _dataSize, access);
+		if (ptr != NULL) {
+			memcpy(ptr, _data, _dataSize);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+		}
+	}
+	m_offset = offset + _dataSize;
+	_offset = offset;
+	return bNewSegment;
+}
+
+UniformBlock::UniformBlock()
+{
+	// Adreno drivers need uniform buffers specified again with glBufferData on each change,
+	// so each block keeps its own buffer there instead of the ring.
+	if (video().getRender().getRenderer() != OGLRender::glrAdreno)
+		m_ring.init();
 }
 
 UniformBlock::~UniformBlock()
@@ -47,9 +130,6 @@ void UniformBlock::_initTextureBuffer(GLuint _program)
 	m_textureBlockData.resize(blockSize);
 	GLbyte * pData = m_textureBlockData.data();
 	memset(pData, 0, blockSize);
-	glBindBuffer(GL_UNIFORM_BUFFER, m_textureBlock.m_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, blockSize, 0, GL_DYNAMIC_DRAW);
-	glBindBufferBase(GL_UNIFORM_BUFFER, m_textureBlock.m_blockBindingPoint, m_textureBlock.m_buffer);
 	updateTextureParameters();
 }
 
@@ -70,10 +150,8 @@ void UniformBlock::_initColorsBuffer(GLuint _program)
 	*(f32*)(pData + m_colorsBlock.m_offsets[cuK4]) = gDP.convert.k4*0.0039215689f;
 	*(f32*)(pData + m_colorsBlock.m_offsets[cuK5]) = gDP.convert.k5*0.0039215689f;
 
-	glBindBuffer(GL_UNIFORM_BUFFER, m_colorsBlock.m_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, blockSize, pData, GL_DYNAMIC_DRAW);
-	glBindBufferBase(GL_UNIFORM_BUFFER, m_colorsBlock.m_blockBindingPoint, m_colorsBlock.m_buffer);
-	m_currentBuffer = m_colorsBlock.m_buffer;
+	if (m_colorsBlock.upload(m_ring, m_colorsBlockData))
+		_uploadAllBlocks();
 }
 
 void UniformBlock::_initLightBuffer(GLuint _program)
@@ -84,12 +162,20 @@ void UniformBlock::_initLightBuffer(GLuint _program)
 	m_lightBlockData.resize(blockSize);
 	GLbyte * pData = m_lightBlockData.data();
 	memset(pData, 0, blockSize);
-	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBlock.m_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, blockSize, 0, GL_DYNAMIC_DRAW);
-	glBindBufferBase(GL_UNIFORM_BUFFER, m_lightBlock.m_blockBindingPoint, m_lightBlock.m_buffer);
 	updateLightParameters();
 }
 
+void UniformBlock::_uploadAllBlocks()
+{
+	// Unchanged blocks may still be bound to the segment, which is reused now. Move them to the current segment.
+	bool bNewSegment = true;
+	while (bNewSegment) {
+		bNewSegment = m_textureBlock.upload(m_ring, m_textureBlockData);
+		bNewSegment |= m_colorsBlock.upload(m_ring, m_colorsBlockData);
+		bNewSegment |= m_lightBlock.upload(m_ring, m_lightBlockData);
+	}
+}
+
 bool UniformBlock::_isDataChanged(void * _pBuffer, const void * _pData, u32 _dataSize)
 {
 	u32 * pSrc = (u32*)_pData;
@@ -108,7 +194,7 @@ void UniformBlock::bindWithShaderCombiner(ShaderCombiner * _pCombiner)
 {
 	const GLuint program = _pCombiner->m_program;
 	if (_pCombiner->usesTexture()) {
-		if (m_textureBlock.m_buffer == 0)
+		if (m_textureBlock.m_blockSize == 0)
 			_initTextureBuffer(program);
 		else {
 			const GLint blockIndex = glGetUniformBlockIndex(program, "TextureBlock");
@@ -117,7 +203,7 @@ void UniformBlock::bindWithShaderCombiner(ShaderCombiner * _pCombiner)
 		}
 	}
 
-	if (m_colorsBlock.m_buffer == 0)
+	if (m_colorsBlock.m_blockSize == 0)
 		_initColorsBuffer(program);
 	else {
 		const GLint blockIndex = glGetUniformBlockIndex(program, "ColorsBlock");
@@ -126,7 +212,7 @@ void UniformBlock::bindWithShaderCombiner(ShaderCombiner * _pCombiner)
 	}
 
 	if (_pCombiner->usesShadeColor() && config.generalEmulation.enableHWLighting != 0) {
-		if (m_lightBlock.m_buffer == 0)
+		if (m_lightBlock.m_blockSize == 0)
 			_initLightBuffer(program);
 		else {
 			const GLint blockIndex = glGetUniformBlockIndex(program, "LightBlock");
@@ -138,25 +224,18 @@ void UniformBlock::bindWithShaderCombiner(ShaderCombiner * _pCombiner)
 
 void UniformBlock::setColorData(ColorUniforms _index, u32 _dataSize, const void * _data)
 {
-	if (m_colorsBlock.m_buffer == 0)
+	if (m_colorsBlock.m_blockSize == 0)
 		return;
 	if (!_isDataChanged(m_colorsBlockData.data() + m_colorsBlock.m_offsets[_index], _data, _dataSize))
 		return;
 
-	if (m_currentBuffer != m_colorsBlock.m_buffer) {
-		m_currentBuffer = m_colorsBlock.m_buffer;
-		glBindBuffer(GL_UNIFORM_BUFFER, m_colorsBlock.m_buffer);
-	}
-
-	if (m_renderer != OGLRender::glrAdreno)
-		glBufferSubData(GL_UNIFORM_BUFFER, m_colorsBlock.m_offsets[_index], _dataSize, _data);
-	else
-		glBufferData(GL_UNIFORM_BUFFER, m_colorsBlockData.size(), m_colorsBlockData.data(), GL_STATIC_DRAW);
+	if (m_colorsBlock.upload(m_ring, m_colorsBlockData))
+		_uploadAllBlocks();
 }
 
 void UniformBlock::updateTextureParameters()
 {
-	if (m_textureBlock.m_buffer == 0)
+	if (m_textureBlock.m_blockSize == 0)
 		return;
 
 	GLbyte * pData = m_textureBlockData.data();
@@ -226,20 +305,13 @@ void UniformBlock::updateTextureParameters()
 	memcpy(pData + m_textureBlock.m_offsets[tuCacheShiftScale], texCacheShiftScale, m_textureBlock.m_offsets[tuCacheFrameBuffer] - m_textureBlock.m_offsets[tuCacheShiftScale]);
 	memcpy(pData + m_textureBlock.m_offsets[tuCacheFrameBuffer], texCacheFrameBuffer, m_textureBlockData.size() - m_textureBlock.m_offsets[tuCacheFrameBuffer]);
 
-	if (m_currentBuffer != m_textureBlock.m_buffer) {
-		m_currentBuffer = m_textureBlock.m_buffer;
-		glBindBuffer(GL_UNIFORM_BUFFER, m_textureBlock.m_buffer);
-	}
-
-	if (m_renderer != OGLRender::glrAdreno)
-		glBufferSubData(GL_UNIFORM_BUFFER, m_textureBlock.m_offsets[tuTexScale], m_textureBlockData.size(), pData);
-	else
-		glBufferData(GL_UNIFORM_BUFFER, m_textureBlockData.size(), m_textureBlockData.data(), GL_STATIC_DRAW);
+	if (m_textureBlock.upload(m_ring, m_textureBlockData))
+		_uploadAllBlocks();
 }
 
 void UniformBlock::updateLightParameters()
 {
-	if (m_lightBlock.m_buffer == 0)
+	if (m_lightBlock.m_blockSize == 0)
 		return;
 
 	GLbyte * pData = m_lightBlockData.data();
@@ -248,15 +320,8 @@ void UniformBlock::updateLightParameters()
 		memcpy(pData + m_lightBlock.m_offsets[luLightDirection] + arraySize*i, &gSP.lights[i].x, arraySize);
 		memcpy(pData + m_lightBlock.m_offsets[luLightColor] + arraySize*i, &gSP.lights[i].r, arraySize);
 	}
-	if (m_currentBuffer != m_lightBlock.m_buffer) {
-		m_currentBuffer = m_lightBlock.m_buffer;
-		glBindBuffer(GL_UNIFORM_BUFFER, m_lightBlock.m_buffer);
-	}
-
-	if (m_renderer != OGLRender::glrAdreno)
-		glBufferSubData(GL_UNIFORM_BUFFER, m_lightBlock.m_offsets[luLightDirection], m_lightBlockData.size(), pData);
-	else
-		glBufferData(GL_UNIFORM_BUFFER, m_lightBlockData.size(), m_lightBlockData.data(), GL_STATIC_DRAW);
+	if (m_lightBlock.upload(m_ring, m_lightBlockData))
+		_uploadAllBlocks();
 }
 
 UniformCollection * createUniformCollection()
@@ -21,11 +21,43 @@ private:
 	void _initLightBuffer(GLuint _program);
 
 	bool _isDataChanged(void * _pBuffer, const void * _pData, u32 _dataSize);
+	void _uploadAllBlocks();
+
+	// Blocks data is never updated in place, since a draw in flight may still use it.
+	// Each change appends a copy of the whole block to the ring and binds the block to the copy.
+	// Ring is not used on Adreno, see UniformBlock constructor.
+	class BufferRing
+	{
+	public:
+		BufferRing();
+		~BufferRing();
+
+		void init();
+		// Returns true when the data starts a new segment of the ring.
+		// Data never crosses a segment boundary, so a block is covered by the fence of one segment.
+		bool write(const void * _data, u32 _dataSize, GLintptr & _offset);
+		GLuint getBuffer() const { return m_buffer; }
+
+	private:
+		void _waitSegment(u32 _segment);
+
+		static const u32 RING_SIZE = 4 * 1024 * 1024;
+		static const u32 SEGMENTS_COUNT = 4;
+		static const u32 SEGMENT_SIZE = RING_SIZE / SEGMENTS_COUNT;
+
+		GLuint m_buffer;
+		GLbyte * m_pMappedData;
+		u32 m_offset;
+		u32 m_segment;
+		u32 m_alignment;
+		// GPU is done with a segment when its fence is signaled.
+		GLsync m_fences[SEGMENTS_COUNT];
+	};
 
 	template <u32 _numUniforms, u32 _bindingPoint>
 	struct UniformBlockData
 	{
-		UniformBlockData() : m_buffer(0), m_blockBindingPoint(_bindingPoint)
+		UniformBlockData() : m_buffer(0), m_blockSize(0), m_blockBindingPoint(_bindingPoint)
 		{
 			memset(m_indices, 0, sizeof(m_indices));
 			memset(m_offsets, 0, sizeof(m_offsets));
@@ -52,18 +84,39 @@ private:
 			glGetActiveUniformsiv(_program, numUniforms, m_indices, GL_UNIFORM_OFFSET, m_offsets);
 
 			glUniformBlockBinding(_program, blockIndex, m_blockBindingPoint);
-			glGenBuffers(1, &m_buffer);
+			m_blockSize = blockSize;
 			return blockSize;
 		}
 
-		GLuint m_buffer;
+		bool upload(BufferRing & _ring, const std::vector<GLbyte> & _data)
+		{
+			if (m_blockSize == 0)
+				return false;
+			if (_ring.getBuffer() == 0) {
+				// Adreno: the block has its own buffer, which is specified again on each change.
+				const bool bBind = m_buffer == 0;
+				if (bBind)
+					glGenBuffers(1, &m_buffer);
+				glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+				glBufferData(GL_UNIFORM_BUFFER, m_blockSize, _data.data(), GL_STATIC_DRAW);
+				if (bBind)
+					glBindBufferBase(GL_UNIFORM_BUFFER, m_blockBindingPoint, m_buffer);
+				return false;
+			}
+			GLintptr offset;
+			const bool bNewSegment = _ring.write(_data.data(), m_blockSize, offset);
+			glBindBufferRange(GL_UNIFORM_BUFFER, m_blockBindingPoint, _ring.getBuffer(), offset, m_blockSize);
+			return bNewSegment;
+		}
+
+		GLuint m_buffer; // used only when the ring is off
+		GLint m_blockSize;
 		GLuint m_blockBindingPoint;
 		GLuint m_indices[_numUniforms];
 		GLint m_offsets[_numUniforms];
 	};
 
-	GLuint m_currentBuffer;
-	OGLRender::OGL_RENDERER m_renderer;
+	BufferRing m_ring;
 
 	UniformBlockData<tuTotal, 1> m_textureBlock;
 	UniformBlockData<cuTotal, 2> m_colorsBlock;
@@ -26,6 +26,7 @@
 #include "TextDrawer.h"
 #include "PluginAPI.h"
 #include "PostProcessor.h"
+#include "TextureEnhancer.h"
 
 using namespace std;
 
@@ -157,6 +158,8 @@ void OGLVideo::restart()
 void OGLVideo::swapBuffers()
 {
 	_swapBuffers();
+	FrameBuffer_FlushDepthReadbacks();
+	glState.endFrame();
 	gDP.otherMode.l = 0;
 	if ((config.generalEmulation.hacks & hack_doNotResetTLUTmode) == 0)
 		gDPSetTextureLUT(G_TT_NONE);
@@ -742,11 +745,22 @@ void OGLRender::_setTexCoordArrays() const
 	}
 }
 
+void OGLRender::_setDepthImageChanged()
+{
+#ifdef GL_IMAGE_TEXTURES_SUPPORT
+	if (isN64DepthUpdate())
+		m_bDepthImageChanged = true;
+#endif // GL_IMAGE_TEXTURES_SUPPORT
+}
+
 void OGLRender::_prepareDrawTriangle(bool _dma)
 {
 #ifdef GL_IMAGE_TEXTURES_SUPPORT
-	if (m_bImageTexture && config.frameBufferEmulation.N64DepthCompare != 0)
+	// Image stores of previous draws must be visible to this one only if something was stored.
+	if (m_bImageTexture && config.frameBufferEmulation.N64DepthCompare != 0 && m_bDepthImageChanged) {
 		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		m_bDepthImageChanged = false;
+	}
 #endif // GL_IMAGE_TEXTURES_SUPPORT
 
 	if ((m_modifyVertices & MODIFY_XY) != 0)
@@ -820,7 +834,10 @@ void OGLRender::drawLLETriangle(u32 _numVtx)
 	glDisable(GL_CULL_FACE);
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVtx);
+	_setDepthImageChanged();
+	CombinerInfo::get().countDraw();
 	triangles.num = 0;
+	memset(m_pendingTiles, 0, sizeof(m_pendingTiles));
 
 	frameBufferList().setBufferChanged();
 	gSP.changed |= CHANGED_GEOMETRYMODE;
@@ -832,19 +849,68 @@ void OGLRender::drawDMATriangles(u32 _numVtx)
 		return;
 	_prepareDrawTriangle(true);
 	glDrawArrays(GL_TRIANGLES, 0, _numVtx);
+	_setDepthImageChanged();
+	CombinerInfo::get().countDraw();
 }
 
 void OGLRender::drawTriangles()
 {
 	if (triangles.num == 0 || !_canDraw()) {
 		triangles.num = 0;
+		memset(m_pendingTiles, 0, sizeof(m_pendingTiles));
 		return;
 	}
 
 	_prepareDrawTriangle(false);
 	glDrawElements(GL_TRIANGLES, triangles.num, GL_UNSIGNED_BYTE, triangles.elements);
-//	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+	_setDepthImageChanged();
+	CombinerInfo::get().countDraw();
 	triangles.num = 0;
+	memset(m_pendingTiles, 0, sizeof(m_pendingTiles));
+}
+
+static
+u32 getTile(f32 _ndc, u32 _tilesCount)
+{
+	const s32 tile = (s32)floorf((_ndc + 1.0f) * 0.5f * _tilesCount);
+	return (u32)max(0, min((s32)_tilesCount - 1, tile));
+}
+
+void OGLRender::drawTrianglesOnTilesOverlap(int _v0, int _v1, int _v2)
+{
+	u32 firstColumn = 0, lastColumn = TILES_COUNT - 1, firstRow = 0, lastRow = TILES_COUNT - 1;
+	const SPVertex * pVtx[3] = { &triangles.vertices[_v0], &triangles.vertices[_v1], &triangles.vertices[_v2] };
+	bool bBounded = true;
+	for (u32 i = 0; i < 3; ++i)
+		bBounded &= pVtx[i]->w > 0.0f && (pVtx[i]->modify & MODIFY_XY) == 0;
+	if (bBounded) {
+		// Bounding box in normalized device coordinates. Margin covers rasterization of edges, which lie on tile bounds.
+		f32 minX = pVtx[0]->x / pVtx[0]->w, maxX = minX;
+		f32 minY = pVtx[0]->y / pVtx[0]->w, maxY = minY;
+		for (u32 i = 1; i < 3; ++i) {
+			const f32 x = pVtx[i]->x / pVtx[i]->w;
+			const f32 y = pVtx[i]->y / pVtx[i]->w;
+			minX = min(minX, x);
+			maxX = max(maxX, x);
+			minY = min(minY, y);
+			maxY = max(maxY, y);
+		}
+		const f32 margin = 1.0f / 64.0f;
+		firstColumn = getTile(minX - margin, TILES_COUNT);
+		lastColumn = getTile(maxX + margin, TILES_COUNT);
+		firstRow = getTile(minY - margin, TILES_COUNT);
+		lastRow = getTile(maxY + margin, TILES_COUNT);
+	}
+
+	const u16 columns = (u16)((0xFFFF >> (TILES_COUNT - 1 - lastColumn)) & (0xFFFF << firstColumn));
+	for (u32 row = firstRow; row <= lastRow; ++row) {
+		if ((m_pendingTiles[row] & columns) != 0) {
+			drawTriangles();
+			break;
+		}
+	}
+	for (u32 row = firstRow; row <= lastRow; ++row)
+		m_pendingTiles[row] |= columns;
 }
 
 void OGLRender::drawLine(int _v0, int _v1, float _width)
@@ -883,6 +949,8 @@ void OGLRender::drawLine(int _v0, int _v1, float _width)
 	else
 		glLineWidth(_width * config.frameBufferEmulation.nativeResFactor);
 	glDrawElements(GL_LINES, 2, GL_UNSIGNED_SHORT, elem);
+	_setDepthImageChanged();
+	CombinerInfo::get().countDraw();
 }
 
 void OGLRender::drawRect(int _ulx, int _uly, int _lrx, int _lry, float *_pColor)
@@ -949,6 +1017,8 @@ void OGLRender::drawRect(int _ulx, int _uly, int _lrx, int _lry, float *_pColor)
 		glVertexAttrib4f(SC_COLOR, 0.0f, 0.0f, 0.0f, 0.0f);
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	_setDepthImageChanged();
+	CombinerInfo::get().countDraw();
 	gSP.changed |= CHANGED_GEOMETRYMODE | CHANGED_VIEWPORT;
 }
 
@@ -987,7 +1057,7 @@ bool texturedRectDepthBufferCopy(const OGLRender::TexturedRectParams & _params)
 		pBuffer->m_cleared = true;
 		if (rectDepthBufferCopyFrame != video().getBuffersSwapCount()) {
 			rectDepthBufferCopyFrame = video().getBuffersSwapCount();
-			if (!FrameBuffer_CopyDepthBuffer(gDP.colorImage.address))
+			if (!FrameBuffer_CopyDepthBuffer(gDP.colorImage.address, true))
 				return true;
 		}
 		RDP_RepeatLastLoadBlock();
@@ -1207,20 +1277,22 @@ void OGLRender::drawTexturedRect(const TexturedRectParams & _params)
 				texST[t].t1 = cache.current[t]->offsetT - texST[t].t1;
 			}
 
-			glActiveTexture(GL_TEXTURE0 + t);
-
+			GLint wrapS = 0, wrapT = 0;
 			if ((cache.current[t]->mirrorS == 0 && cache.current[t]->maskS == 0 &&
 				(texST[t].s0 < texST[t].s1 ?
 				texST[t].s0 >= 0.0 && texST[t].s1 <= (float)cache.current[t]->width :
 				texST[t].s1 >= 0.0 && texST[t].s0 <= (float)cache.current[t]->width))
 				|| (cache.current[t]->maskS == 0 && (texST[t].s0 < -1024.0f || texST[t].s1 > 1023.99f)))
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				wrapS = GL_CLAMP_TO_EDGE;
 
 			if (cache.current[t]->mirrorT == 0 &&
 				(texST[t].t0 < texST[t].t1 ?
 				texST[t].t0 >= 0.0f && texST[t].t1 <= (float)cache.current[t]->height :
 				texST[t].t1 >= 0.0f && texST[t].t0 <= (float)cache.current[t]->height))
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				wrapT = GL_CLAMP_TO_EDGE;
+
+			if (wrapS != 0 || wrapT != 0)
+				cache.setTextureWrap(t, wrapS, wrapT);
 
 			texST[t].s0 *= cache.current[t]->scaleS;
 			texST[t].t0 *= cache.current[t]->scaleT;
@@ -1229,11 +1301,8 @@ void OGLRender::drawTexturedRect(const TexturedRectParams & _params)
 		}
 	}
 
-	if (gDP.otherMode.cycleType == G_CYC_COPY) {
-		glActiveTexture( GL_TEXTURE0 );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-	}
+	if (gDP.otherMode.cycleType == G_CYC_COPY)
+		cache.setTextureFilter(0, GL_NEAREST, GL_NEAREST);
 
 	m_rect[0].s0 = texST[0].s0;
 	m_rect[0].t0 = texST[0].t0;
@@ -1277,6 +1346,8 @@ void OGLRender::drawTexturedRect(const TexturedRectParams & _params)
 	}
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	_setDepthImageChanged();
+	CombinerInfo::get().countDraw();
 	gSP.changed |= CHANGED_GEOMETRYMODE | CHANGED_VIEWPORT;
 }
 
@@ -1453,6 +1524,14 @@ void OGLRender::_initExtensions()
 	if (!m_bImageTexture)
 		LOG(LOG_WARNING, "N64 depth compare and depth based fog will not work without Image Textures support provided in OpenGL >= 4.3 or GLES >= 3.1");
 
+#ifndef GLES2
+	m_bParallelShaderCompile = OGLVideo::isExtensionSupported("GL_KHR_parallel_shader_compile") ||
+		OGLVideo::isExtensionSupported("GL_ARB_parallel_shader_compile");
+#else
+	m_bParallelShaderCompile = false;
+#endif
+	LOG(LOG_VERBOSE, "Parallel shader compile support: %s\n", m_bParallelShaderCompile ? "yes" : "no");
+
 	if (config.texture.maxAnisotropy != 0 && OGLVideo::isExtensionSupported("GL_EXT_texture_filter_anisotropic")) {
 		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &config.texture.maxAnisotropyF);
 		config.texture.maxAnisotropyF = min(config.texture.maxAnisotropyF, (f32)config.texture.maxAnisotropy);
@@ -1508,6 +1587,7 @@ void OGLRender::_initData()
 	Combiner_Init();
 	TextDrawer::get().init();
 	TFH.init();
+	TextureEnhancer::get().init(TFH.getEnhancement());
 	PostProcessor::get().init();
 	FBInfo::fbInfo.reset();
 	m_renderState = rsNone;
@@ -1532,7 +1612,9 @@ void OGLRender::_destroyData()
 	Combiner_Destroy();
 	FrameBuffer_Destroy();
 	DepthBuffer_Destroy();
+	TextureEnhancer::get().destroy();
 	textureCache().destroy();
+	glState.logStatistics();
 }
 
 void OGLRender::_setSpecialTexrect() const
@@ -1629,12 +1711,23 @@ u32 TextureFilterHandler::_getConfigOptions() const
 		options |= RICE_HIRESTEXTURES;
 	if (config.textureFilter.txForce16bpp)
 		options |= FORCE16BPP_TEX | FORCE16BPP_HIRESTEX;
+	if (config.textureFilter.txGPUCompression) {
+		// ETC2 is core in GLES 3, desktop GL needs S3TC extension
+#if defined(GLES3) || defined(GLES3_1)
+		options |= COMPRESS_TEX | COMPRESS_HIRESTEX | ETC2_COMPRESSION;
+#elif !defined(GLES2)
+		if (OGLVideo::isExtensionSupported("GL_EXT_texture_compression_s3tc"))
+			options |= COMPRESS_TEX | COMPRESS_HIRESTEX | S3TC_COMPRESSION;
+#endif
+	}
 	if (config.textureFilter.txCacheCompression)
 		options |= GZ_TEXCACHE | GZ_HIRESTEXCACHE;
 	if (config.textureFilter.txSaveCache)
 		options |= (DUMP_TEXCACHE | DUMP_HIRESTEXCACHE);
 	if (config.textureFilter.txHiresFullAlphaChannel)
 		options |= LET_TEXARTISTS_FLY;
+	if (config.textureFilter.txHiresLazyLoad)
+		options |= LAZY_HIRESTEX;
 	if (config.textureFilter.txDump)
 		options |= DUMP_TEX;
 	if (config.textureFilter.txDeposterize)
@@ -1642,6 +1735,11 @@ u32 TextureFilterHandler::_getConfigOptions() const
 	return options;
 }
 
+u32 TextureFilterHandler::getEnhancement() const
+{
+	return textureEnhancements[config.textureFilter.txEnhancementMode];
+}
+
 void TextureFilterHandler::init()
 {
 	if (isInited())
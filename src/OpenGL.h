@@ -22,12 +22,14 @@ typedef char GLchar;
 #include <GLES3/gl3.h>
 #define GLESX
 #define GL_UNIFORMBLOCK_SUPPORT
+#define GL_SAMPLER_OBJECTS_SUPPORT
 #elif defined(GLES3_1)
 #include <GLES3/gl31.h>
 #define GLESX
 #define GL_IMAGE_TEXTURES_SUPPORT
 #define GL_MULTISAMPLING_SUPPORT
 #define GL_UNIFORMBLOCK_SUPPORT
+#define GL_SAMPLER_OBJECTS_SUPPORT
 #else
 #if defined(OS_MAC_OS_X)
 #define GL_GLEXT_PROTOTYPES
@@ -41,6 +43,7 @@ typedef char GLchar;
 #define GL_IMAGE_TEXTURES_SUPPORT
 #define GL_MULTISAMPLING_SUPPORT
 #define GL_UNIFORMBLOCK_SUPPORT
+#define GL_SAMPLER_OBJECTS_SUPPORT
 #elif defined(OS_WINDOWS)
 #include <GL/gl.h>
 #include "glext.h"
@@ -48,6 +51,7 @@ typedef char GLchar;
 #define GL_IMAGE_TEXTURES_SUPPORT
 #define GL_MULTISAMPLING_SUPPORT
 #define GL_UNIFORMBLOCK_SUPPORT
+#define GL_SAMPLER_OBJECTS_SUPPORT
 #endif // OS_MAC_OS_X
 #endif // GLES2
 
@@ -66,6 +70,22 @@ typedef char GLchar;
 #define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
 #endif
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+#endif
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT   0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT  0x83F3
+#endif
+
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2           0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC      0x9278
+#endif
+
 #include "glState.h"
 #include "gSP.h"
 
@@ -78,6 +98,9 @@ class OGLRender
 public:
 	void addTriangle(int _v0, int _v1, int _v2);
 	void drawTriangles();
+	// Draws pending triangles if the triangle covers some screen tiles of them.
+	// Triangles, which update N64 depth image, are batched while they cover different tiles.
+	void drawTrianglesOnTilesOverlap(int _v0, int _v1, int _v2);
 	void drawLLETriangle(u32 _numVtx);
 	void drawDMATriangles(u32 _numVtx);
 	void drawLine(int _v0, int _v1, float _width);
@@ -118,6 +141,8 @@ public:
 		return (triangles.vertices[_v0].clip & triangles.vertices[_v1].clip & triangles.vertices[_v2].clip) != 0;
 	}
 	bool isImageTexturesSupported() const {return m_bImageTexture;}
+	bool isParallelShaderCompileSupported() const {return m_bParallelShaderCompile;}
+	bool isN64DepthUpdate() const {return (gSP.geometryMode & G_ZBUFFER) != 0 && gDP.otherMode.depthUpdate != 0;}
 	SPVertex & getVertex(u32 _v) {return triangles.vertices[_v];}
 	void setDMAVerticesSize(u32 _size) { if (triangles.dmaVertices.size() < _size) triangles.dmaVertices.resize(_size); }
 	SPVertex * getDMAVerticesData() { return triangles.dmaVertices.data(); }
@@ -145,7 +170,10 @@ private:
 		: m_oglRenderer(glrOther)
 		, m_modifyVertices(0)
 		, m_bImageTexture(false)
+		, m_bParallelShaderCompile(false)
+		, m_bDepthImageChanged(true)
 		, m_bFlatColors(false) {
+		memset(m_pendingTiles, 0, sizeof(m_pendingTiles));
 	}
 	OGLRender(const OGLRender &);
 	friend class OGLVideo;
@@ -166,6 +194,7 @@ private:
 	void _updateDepthUpdate() const;
 	void _updateStates(RENDER_STATE _renderState) const;
 	void _prepareDrawTriangle(bool _dma);
+	void _setDepthImageChanged();
 	bool _canDraw() const;
 
 	struct {
@@ -191,7 +220,12 @@ private:
 	GLVertex m_rect[4];
 	u32 m_modifyVertices;
 	bool m_bImageTexture;
+	bool m_bParallelShaderCompile;
+	bool m_bDepthImageChanged;
 	bool m_bFlatColors;
+	// Screen is split to TILES_COUNT x TILES_COUNT tiles. Bit i of row r is set when pending triangles cover tile (i, r).
+	static const u32 TILES_COUNT = 16;
+	u16 m_pendingTiles[TILES_COUNT];
 };
 
 class OGLVideo
@@ -313,6 +347,8 @@ public:
 	void shutdown();
 	bool isInited() const { return m_inited != 0; }
 	bool optionsChanged() const { return _getConfigOptions() != m_options; }
+	// GLideNHQ enhancement option of current config.
+	u32 getEnhancement() const;
 private:
 	u32 _getConfigOptions() const;
 	u32 m_inited;
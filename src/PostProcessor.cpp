@@ -238,18 +238,18 @@ FRAGMENT_SHADER_END
 "}																			\n"
 ;
 
+// Compile and link status are not queried here: programs are checked on first use,
+// so the driver may build all post processor programs in parallel.
 static
 GLuint _createShaderProgram(const char * _strVertex, const char * _strFragment)
 {
 	GLuint vertex_shader_object = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex_shader_object, 1, &_strVertex, nullptr);
 	glCompileShader(vertex_shader_object);
-	assert(checkShaderCompileStatus(vertex_shader_object));
 
 	GLuint fragment_shader_object = glCreateShader(GL_FRAGMENT_SHADER);
 	glShaderSource(fragment_shader_object, 1, &_strFragment, nullptr);
 	glCompileShader(fragment_shader_object);
-	assert(checkShaderCompileStatus(fragment_shader_object));
 
 	GLuint program = glCreateProgram();
 	glBindAttribLocation(program, SC_POSITION, "aPosition");
@@ -259,7 +259,6 @@ GLuint _createShaderProgram(const char * _strVertex, const char * _strFragment)
 	glLinkProgram(program);
 	glDeleteShader(vertex_shader_object);
 	glDeleteShader(fragment_shader_object);
-	assert(checkProgramLinkStatus(program));
 	return program;
 }
 
@@ -325,6 +324,7 @@ PostProcessor::PostProcessor()
 	, m_pTextureResolved(nullptr)
 	, m_pTextureGlowMap(nullptr)
 	, m_pTextureBlur(nullptr)
+	, m_bProgramsReady(false)
 {}
 
 void PostProcessor::_initCommon()
@@ -335,6 +335,8 @@ void PostProcessor::_initCommon()
 	}
 
 	m_pResultBuffer = new FrameBuffer();
+	// Frame buffer textures are taken from the pool on frame buffer init, which is not used for the result buffer.
+	m_pResultBuffer->m_pTexture = textureCache().addFrameBufferTexture();
 	_initTexture(m_pResultBuffer->m_pTexture);
 	_initFBO(m_pResultBuffer->m_FBO, m_pResultBuffer->m_pTexture);
 
@@ -344,6 +346,11 @@ void PostProcessor::_initCommon()
 void PostProcessor::_initGammaCorrection()
 {
 	m_gammaCorrectionProgram = _createShaderProgram(vertexShader, gammaCorrectionShader);
+}
+
+void PostProcessor::_setupGammaCorrection()
+{
+	assert(checkProgramLinkStatus(m_gammaCorrectionProgram));
 	glUseProgram(m_gammaCorrectionProgram);
 	int loc = glGetUniformLocation(m_gammaCorrectionProgram, "Sample0");
 	assert(loc >= 0);
@@ -358,6 +365,19 @@ void PostProcessor::_initGammaCorrection()
 void PostProcessor::_initBlur()
 {
 	m_extractBloomProgram = _createShaderProgram(vertexShader, extractBloomShader);
+	m_seperableBlurProgram = _createShaderProgram(vertexShader, seperableBlurShader);
+	m_glowProgram = _createShaderProgram(vertexShader, glowShader);
+
+	m_pTextureGlowMap = _createTexture();
+	m_pTextureBlur = _createTexture();
+
+	m_FBO_glowMap = _createFBO(m_pTextureGlowMap);
+	m_FBO_blur = _createFBO(m_pTextureBlur);
+}
+
+void PostProcessor::_setupBlur()
+{
+	assert(checkProgramLinkStatus(m_extractBloomProgram));
 	glUseProgram(m_extractBloomProgram);
 	int loc = glGetUniformLocation(m_extractBloomProgram, "Sample0");
 	assert(loc >= 0);
@@ -366,7 +386,7 @@ void PostProcessor::_initBlur()
 	assert(loc >= 0);
 	glUniform1i(loc, config.bloomFilter.thresholdLevel);
 
-	m_seperableBlurProgram = _createShaderProgram(vertexShader, seperableBlurShader);
+	assert(checkProgramLinkStatus(m_seperableBlurProgram));
 	glUseProgram(m_seperableBlurProgram);
 	loc = glGetUniformLocation(m_seperableBlurProgram, "Sample0");
 	assert(loc >= 0);
@@ -387,7 +407,7 @@ void PostProcessor::_initBlur()
 	assert(loc >= 0);
 	glUniform1f(loc, config.bloomFilter.blurStrength/100.0f);
 
-	m_glowProgram = _createShaderProgram(vertexShader, glowShader);
+	assert(checkProgramLinkStatus(m_glowProgram));
 	glUseProgram(m_glowProgram);
 	loc = glGetUniformLocation(m_glowProgram, "Sample0");
 	assert(loc >= 0);
@@ -399,15 +419,19 @@ void PostProcessor::_initBlur()
 	assert(loc >= 0);
 	glUniform1i(loc, config.bloomFilter.blendMode);
 
-	m_pTextureGlowMap = _createTexture();
-	m_pTextureBlur = _createTexture();
-
-	m_FBO_glowMap = _createFBO(m_pTextureGlowMap);
-	m_FBO_blur = _createFBO(m_pTextureBlur);
-
 	glUseProgram(0);
 }
 
+void PostProcessor::_setupPrograms()
+{
+	if (m_bProgramsReady)
+		return;
+	_setupGammaCorrection();
+	if (config.bloomFilter.enable != 0)
+		_setupBlur();
+	m_bProgramsReady = true;
+}
+
 void PostProcessor::init()
 {
 	_initCommon();
@@ -477,6 +501,7 @@ void PostProcessor::_destroyBlur()
 
 void PostProcessor::destroy()
 {
+	m_bProgramsReady = false;
 	_destroyBlur();
 	_destroyGammaCorrection();
 	_destroyCommon();
@@ -516,6 +541,7 @@ void _setGLState(FrameBuffer * _pBuffer) {
 
 void PostProcessor::_preDraw(FrameBuffer * _pBuffer)
 {
+	_setupPrograms();
 	_setGLState(_pBuffer);
 	OGLVideo & ogl = video();
 
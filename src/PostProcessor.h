@@ -24,9 +24,12 @@ private:
 	void _initCommon();
 	void _destroyCommon();
 	void _initGammaCorrection();
+	void _setupGammaCorrection();
 	void _destroyGammaCorrection();
 	void _initBlur();
+	void _setupBlur();
 	void _destroyBlur();
+	void _setupPrograms();
 	void _preDraw(FrameBuffer * _pBuffer);
 	void _postDraw();
 
@@ -47,6 +50,8 @@ private:
 	CachedTexture * m_pTextureResolved;
 	CachedTexture * m_pTextureGlowMap;
 	CachedTexture * m_pTextureBlur;
+
+	bool m_bProgramsReady;
 };
 
 #endif // POST_PROCESSOR_H
@@ -216,13 +216,14 @@ void RSP_ProcessDList()
 	}
 
 	if (config.frameBufferEmulation.copyDepthToRDRAM != Config::ctDisable) {
+		const bool sync = config.frameBufferEmulation.copyDepthToRDRAM == Config::ctSync;
 		if ((config.generalEmulation.hacks & hack_rectDepthBufferCopyCBFD) != 0) {
 			; // do nothing
 		} else if ((config.generalEmulation.hacks & hack_rectDepthBufferCopyPD) != 0) {
 			if (rectDepthBufferCopyFrame == video().getBuffersSwapCount())
-				FrameBuffer_CopyDepthBuffer(gDP.colorImage.address);
+				FrameBuffer_CopyDepthBuffer(gDP.colorImage.address, sync);
 		} else if (!FBInfo::fbInfo.isSupported())
-			FrameBuffer_CopyDepthBuffer(gDP.colorImage.address);
+			FrameBuffer_CopyDepthBuffer(gDP.colorImage.address, sync);
 	}
 
 	RSP.busy = FALSE;
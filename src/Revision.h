@@ -0,0 +1 @@
+#define PLUGIN_REVISION "16050d2"
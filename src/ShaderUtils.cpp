@@ -34,6 +34,17 @@ bool checkProgramLinkStatus(GLuint obj)
 	return true;
 }
 
+// Returns true while the driver builds the program in background.
+// Status of compile and link can't be polled without parallel shader compile support, so false is returned.
+bool isProgramLinkPending(GLuint _program)
+{
+	if (!video().getRender().isParallelShaderCompileSupported())
+		return false;
+	GLint status = GL_FALSE;
+	glGetProgramiv(_program, GL_COMPLETION_STATUS_KHR, &status);
+	return status == GL_FALSE;
+}
+
 void logErrorShader(GLenum _shaderType, const std::string & _strShader)
 {
 	LOG(LOG_ERROR, "Error in %s shader", _shaderType == GL_VERTEX_SHADER ? "vertex" : "fragment");
@@ -98,6 +109,31 @@ const char* fragment_shader_blender2 =
 "  }											\n"
 ;
 
+static
+const char* fragment_shader_alpha_test =
+"  if (uEnableAlphaTest != 0) {							\n"
+"    lowp float alphaTestValue = (uAlphaCompareMode == 3) ? snoise() : uAlphaTestValue;	\n"
+"    lowp float alphaValue = clamp(alpha1, 0.0, 1.0);	\n"
+"    if  (uAlphaCvgSel != 0) {							\n"
+"       if (uCvgXAlpha == 0) alphaValue = 0.125;		\n"
+"    }													\n"
+"    if (alphaValue < alphaTestValue) discard;			\n"
+"  }													\n"
+;
+
+static
+const char* fragment_shader_cvg_discard =
+"  if (uCvgXAlpha != 0 && alpha2 < 0.125) discard; \n"
+;
+
+#ifndef GLES2
+static
+const char* fragment_shader_noise_dither =
+"  if (uColorDitherMode == 2) colorNoiseDither(snoise(), color2);	\n"
+"  if (uAlphaDitherMode == 2) alphaNoiseDither(snoise(), alpha2);	\n"
+;
+#endif
+
 static
 const char *ColorInput[] = {
 	"combined_color.rgb",
@@ -265,16 +301,7 @@ int compileCombiner(Combiner & _color, Combiner & _alpha, std::string & _strShad
 	_strShader.append("  alpha1 = ");
 	int nInputs = _compileCombiner(_alpha.stage[0], AlphaInput, _strShader);
 
-	_strShader.append(
-		"  if (uEnableAlphaTest != 0) {							\n"
-		"    lowp float alphaTestValue = (uAlphaCompareMode == 3) ? snoise() : uAlphaTestValue;	\n"
-		"    lowp float alphaValue = clamp(alpha1, 0.0, 1.0);	\n"
-		"    if  (uAlphaCvgSel != 0) {							\n"
-		"       if (uCvgXAlpha == 0) alphaValue = 0.125;		\n"
-		"    }													\n"
-		"    if (alphaValue < alphaTestValue) discard;			\n"
-		"  }													\n"
-		);
+	_strShader.append(fragment_shader_alpha_test);
 
 	_strShader.append("  color1 = ");
 	nInputs |= _compileCombiner(_color.stage[0], ColorInput, _strShader);
@@ -288,7 +315,7 @@ int compileCombiner(Combiner & _color, Combiner & _alpha, std::string & _strShad
 	else
 		_strShader.append("  alpha2 = alpha1; \n");
 
-	_strShader.append("  if (uCvgXAlpha != 0 && alpha2 < 0.125) discard; \n");
+	_strShader.append(fragment_shader_cvg_discard);
 
 	if (_color.numStages == 2) {
 		_strShader.append("  color2 = ");
@@ -300,12 +327,8 @@ int compileCombiner(Combiner & _color, Combiner & _alpha, std::string & _strShad
 
 
 #ifndef GLES2
-	if (config.generalEmulation.enableNoise != 0) {
-		_strShader.append(
-			"  if (uColorDitherMode == 2) colorNoiseDither(snoise(), color2);	\n"
-			"  if (uAlphaDitherMode == 2) alphaNoiseDither(snoise(), alpha2);	\n"
-			);
-	}
+	if (config.generalEmulation.enableNoise != 0)
+		_strShader.append(fragment_shader_noise_dither);
 #endif
 
 	_strShader.append(fragment_shader_blender1);
@@ -318,3 +341,36 @@ int compileCombiner(Combiner & _color, Combiner & _alpha, std::string & _strShad
 
 	return nInputs;
 }
+
+#ifndef GLES2
+void compileUberCombiner(std::string & _strShader)
+{
+	_strShader.append("  alpha1 = uberAlpha(uCombineAlpha0, combined_color, readtex0, readtex1, vec_color); \n");
+	_strShader.append(fragment_shader_alpha_test);
+	_strShader.append(
+		"  color1 = uberColor(uCombineColor0, combined_color, readtex0, readtex1, vec_color); \n"
+		"  combined_color = vec4(color1, alpha1); \n"
+		"  if (uCombineCycles == 2) \n"
+		"    alpha2 = uberAlpha(uCombineAlpha1, combined_color, readtex0, readtex1, vec_color); \n"
+		"  else \n"
+		"    alpha2 = alpha1; \n"
+		);
+	_strShader.append(fragment_shader_cvg_discard);
+	_strShader.append(
+		"  if (uCombineCycles == 2) \n"
+		"    color2 = uberColor(uCombineColor1, combined_color, readtex0, readtex1, vec_color); \n"
+		"  else \n"
+		"    color2 = color1; \n"
+		);
+
+	if (config.generalEmulation.enableNoise != 0)
+		_strShader.append(fragment_shader_noise_dither);
+
+	_strShader.append(fragment_shader_blender1);
+	_strShader.append(fragment_shader_blender2);
+
+	_strShader.append(
+		"  fragColor = vec4(color2, alpha2);	\n"
+		);
+}
+#endif
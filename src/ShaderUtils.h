@@ -7,7 +7,11 @@
 GLuint createShaderProgram(const char * _strVertex, const char * _strFragment);
 bool checkShaderCompileStatus(GLuint obj);
 bool checkProgramLinkStatus(GLuint obj);
+bool isProgramLinkPending(GLuint _program);
 void logErrorShader(GLenum _shaderType, const std::string & _strShader);
 int compileCombiner(Combiner & _color, Combiner & _alpha, std::string & _strShader);
+#ifndef GLES2
+void compileUberCombiner(std::string & _strShader);
+#endif
 
 #endif // SHADER_UTILS_H
@@ -0,0 +1,262 @@
+#include <assert.h>
+#include <vector>
+
+#include "gSP.h"
+#include "gDP.h"
+#include "TextureEnhancer.h"
+#include "Textures.h"
+#include "FrameBuffer.h"
+#include "ShaderUtils.h"
+#include "Config.h"
+#include "Log.h"
+#include "GLideNHQ/Ext_TxFilter.h"
+
+#ifndef GLES2
+
+#if defined(GLES3_1)
+#define ENHANCER_SHADER_VERSION "#version 310 es \n"
+#elif defined(GLES3)
+#define ENHANCER_SHADER_VERSION "#version 300 es \n"
+#else
+#define ENHANCER_SHADER_VERSION "#version 330 core \n"
+#endif
+
+// Full screen triangle without vertex attributes, so the render's vertex arrays stay untouched.
+static const char * enhancerVertexShader =
+ENHANCER_SHADER_VERSION
+"void main()												\n"
+"{															\n"
+"  highp vec2 pos = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;\n"
+"  gl_Position = vec4(pos, 0.0, 1.0);						\n"
+"}															\n"
+;
+
+// Neighbour pattern and edge flags as in TextureFilters_hq2x.cpp and TextureFilters_hq4x.cpp.
+// Lookup table entry has up to three terms: neighbour index << 5 | weight in 1/16.
+static const char * enhancerFragmentShader =
+ENHANCER_SHADER_VERSION
+"uniform highp sampler2D uSource;							\n"
+"uniform highp usampler2D uLut;								\n"
+"uniform highp int uScale;									\n"
+"out highp vec4 fragColor;									\n"
+"highp uvec4 fetch(highp ivec2 pos)							\n"
+"{															\n"
+"  pos = clamp(pos, ivec2(0), textureSize(uSource, 0) - 1);	\n"
+"  return uvec4(texelFetch(uSource, pos, 0) * 255.0 + 0.5);	\n"
+"}															\n"
+"bool diff(highp uvec4 c1, highp uvec4 c2)					\n"
+"{															\n"
+"  highp ivec3 p1 = ivec3(c1.rgb);							\n"
+"  highp ivec3 p2 = ivec3(c2.rgb);							\n"
+"  if (uScale == 2) { // hq2x, else hq4x					\n"
+"    highp ivec3 d = p1 - p2;								\n"
+"    highp ivec3 yuv = ivec3(d.r + d.g + d.b, d.r - d.b, 2*d.g - d.r - d.b);\n"
+"    return any(greaterThan(abs(yuv), ivec3(0xC0, 0x1C, 0x30)));\n"
+"  }														\n"
+"  highp ivec3 yuv1 = ivec3(p1.r + p1.g + p1.b, 0x200 + p1.r - p1.b, 0x400 + 2*p1.g - p1.r - p1.b) >> ivec3(2, 2, 3);\n"
+"  highp ivec3 yuv2 = ivec3(p2.r + p2.g + p2.b, 0x200 + p2.r - p2.b, 0x400 + 2*p2.g - p2.r - p2.b) >> ivec3(2, 2, 3);\n"
+"  return any(greaterThan(abs(yuv1 - yuv2), ivec3(0x30, 0x07, 0x06)));\n"
+"}															\n"
+"void main()												\n"
+"{															\n"
+"  highp ivec2 dst = ivec2(gl_FragCoord.xy);				\n"
+"  highp ivec2 src = dst / uScale;							\n"
+"  highp ivec2 sub = dst - src * uScale;					\n"
+"  highp uvec4 c[9];										\n"
+"  for (int i = 0; i < 9; ++i)								\n"
+"    c[i] = fetch(src + ivec2(i % 3 - 1, i / 3 - 1));		\n"
+"  highp uint pattern = 0u;									\n"
+"  highp uint bit = 1u;										\n"
+"  for (int i = 0; i < 9; ++i) {							\n"
+"    if (i == 4) continue;									\n"
+"    if (diff(c[i], c[4])) pattern |= bit;					\n"
+"    bit <<= 1;												\n"
+"  }														\n"
+"  highp int flags = (diff(c[1], c[5]) ? 1 : 0) | (diff(c[5], c[7]) ? 2 : 0) |	\n"
+"                    (diff(c[7], c[3]) ? 4 : 0) | (diff(c[3], c[1]) ? 8 : 0);	\n"
+"  highp uint entry = texelFetch(uLut, ivec2((flags * uScale + sub.y) * uScale + sub.x, int(pattern)), 0).r;\n"
+"  highp uvec4 sum = uvec4(0u);								\n"
+"  for (int t = 0; t < 3; ++t) {							\n"
+"    highp uint term = (entry >> (9 * t)) & 0x1FFu;			\n"
+"    sum += (term & 0x1Fu) * c[int(term >> 5)];					\n"
+"  }														\n"
+"  fragColor = vec4(sum >> 4) / 255.0;						\n"
+"}															\n"
+;
+
+static const GLuint g_sourceTexIndex = g_MSTex0Index + 2;
+static const GLuint g_lutTexIndex = g_sourceTexIndex + 1;
+
+TextureEnhancer::TextureEnhancer()
+	: m_scale(0)
+	, m_maxTextureSize(0)
+	, m_FBO(0)
+	, m_program(0)
+	, m_pSourceTexture(nullptr)
+	, m_pLutTexture(nullptr)
+{}
+
+void TextureEnhancer::init(u32 _enhancement)
+{
+	// Texture filters and deposterization run before enhancement, so such configs stay on CPU.
+	if (config.textureFilter.txEnhancementGPU == 0 ||
+		config.textureFilter.txFilterMode != 0 ||
+		config.textureFilter.txDeposterize != 0)
+		return;
+
+	const u32 scale = txfilter_enhancementlut(_enhancement, nullptr);
+	if (scale == 0)
+		return;
+
+	const u32 lutWidth = 16 * scale * scale;
+	const u32 lutHeight = 256;
+	std::vector<u32> lut(lutWidth * lutHeight);
+	txfilter_enhancementlut(_enhancement, lut.data());
+
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
+
+	glActiveTexture(GL_TEXTURE0 + g_lutTexIndex);
+	m_pLutTexture = textureCache().addFrameBufferTexture();
+	m_pLutTexture->realWidth = lutWidth;
+	m_pLutTexture->realHeight = lutHeight;
+	m_pLutTexture->textureBytes = lutWidth * lutHeight * sizeof(u32);
+	textureCache().addFrameBufferTextureSize(m_pLutTexture->textureBytes);
+	glBindTexture(GL_TEXTURE_2D, m_pLutTexture->glName);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, lutWidth, lutHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, lut.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	glActiveTexture(GL_TEXTURE0 + g_sourceTexIndex);
+	m_pSourceTexture = textureCache().addFrameBufferTexture();
+	glBindTexture(GL_TEXTURE_2D, m_pSourceTexture->glName);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glActiveTexture(GL_TEXTURE0);
+
+	glGenFramebuffers(1, &m_FBO);
+
+	m_program = createShaderProgram(enhancerVertexShader, enhancerFragmentShader);
+	glUseProgram(m_program);
+	glUniform1i(glGetUniformLocation(m_program, "uSource"), g_sourceTexIndex);
+	glUniform1i(glGetUniformLocation(m_program, "uLut"), g_lutTexIndex);
+	glUniform1i(glGetUniformLocation(m_program, "uScale"), scale);
+	glUseProgram(0);
+
+	m_scale = scale;
+	LOG(LOG_VERBOSE, "Texture enhancement runs on GPU, scale %u\n", m_scale);
+}
+
+void TextureEnhancer::destroy()
+{
+	m_scale = 0;
+	if (m_FBO != 0) {
+		glDeleteFramebuffers(1, &m_FBO);
+		m_FBO = 0;
+	}
+	if (m_program != 0) {
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+	if (m_pSourceTexture != nullptr) {
+		textureCache().removeFrameBufferTexture(m_pSourceTexture);
+		m_pSourceTexture = nullptr;
+	}
+	if (m_pLutTexture != nullptr) {
+		textureCache().removeFrameBufferTexture(m_pLutTexture);
+		m_pLutTexture = nullptr;
+	}
+}
+
+u32 TextureEnhancer::enhance(const void * _pData, u32 _width, u32 _height, GLint _internalFormat, GLenum _type, GLuint _dstTexture)
+{
+	// GLideNHQ leaves small textures alone.
+	if (m_scale == 0 || _width < 4 || _height < 4)
+		return 0;
+	const u32 width = _width * m_scale;
+	const u32 height = _height * m_scale;
+	if (width > (u32)m_maxTextureSize || height > (u32)m_maxTextureSize)
+		return 0;
+
+	// Texture update runs in the middle of render state update, so the state is restored, not just marked changed.
+	const GLenum activeTexture = glState.cached_ActiveTexture_texture;
+	const GLuint program = glState.cached_UseProgram_program;
+	const GLuint drawFBO = glState.cached_BindFramebuffer_draw;
+	const GLint viewport[4] = { glState.cached_Viewport_x, glState.cached_Viewport_y,
+		glState.cached_Viewport_width, glState.cached_Viewport_height };
+	const bool scissorTest = glState.cached_SCISSOR_TEST;
+	const bool depthTest = glState.cached_DEPTH_TEST;
+	const bool blend = glState.cached_BLEND;
+	const bool cullFace = glState.cached_CULL_FACE;
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glActiveTexture(GL_TEXTURE0 + g_sourceTexIndex);
+	glBindTexture(GL_TEXTURE_2D, m_pSourceTexture->glName);
+	glTexImage2D(GL_TEXTURE_2D, 0, _internalFormat, _width, _height, 0, GL_RGBA, _type, _pData);
+	glActiveTexture(GL_TEXTURE0 + g_lutTexIndex);
+	glBindTexture(GL_TEXTURE_2D, m_pLutTexture->glName);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _dstTexture, 0);
+	assert(checkFBO());
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_CULL_FACE);
+	glViewport(0, 0, width, height);
+	glUseProgram(m_program);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+	if (drawFBO != GLState::UNKNOWN_BINDING)
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFBO);
+	else {
+		FrameBuffer * pBuffer = frameBufferList().getCurrent();
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pBuffer != nullptr ? pBuffer->m_FBO : 0);
+	}
+	glUseProgram(program != GLuint(-1) ? program : 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	if (scissorTest)
+		glEnable(GL_SCISSOR_TEST);
+	if (depthTest)
+		glEnable(GL_DEPTH_TEST);
+	if (blend)
+		glEnable(GL_BLEND);
+	if (cullFace)
+		glEnable(GL_CULL_FACE);
+	glActiveTexture(activeTexture);
+
+	return m_scale;
+}
+
+#else // GLES2
+
+TextureEnhancer::TextureEnhancer()
+	: m_scale(0)
+	, m_maxTextureSize(0)
+	, m_FBO(0)
+	, m_program(0)
+	, m_pSourceTexture(nullptr)
+	, m_pLutTexture(nullptr)
+{}
+
+void TextureEnhancer::init(u32)
+{
+}
+
+void TextureEnhancer::destroy()
+{
+}
+
+u32 TextureEnhancer::enhance(const void *, u32, u32, GLint, GLenum, GLuint)
+{
+	return 0;
+}
+
+#endif // GLES2
+
+TextureEnhancer & TextureEnhancer::get()
+{
+	static TextureEnhancer enhancer;
+	return enhancer;
+}
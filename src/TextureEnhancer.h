@@ -0,0 +1,39 @@
+#ifndef TEXTURE_ENHANCER_H
+#define TEXTURE_ENHANCER_H
+
+#include "Types.h"
+#include "OpenGL.h"
+
+struct CachedTexture;
+
+// Runs hq2x and hq4x texture enhancement in a fragment shader.
+// The shader classifies neighbours the same way as GLideNHQ and takes output pixels
+// from lookup tables built from GLideNHQ switch tables, so the result matches CPU filters.
+class TextureEnhancer {
+public:
+	// _enhancement is GLideNHQ enhancement option of the config.
+	void init(u32 _enhancement);
+	void destroy();
+
+	// True if current config enhancement runs on GPU.
+	bool isActive() const { return m_scale != 0; }
+
+	// Uploads native texture data and renders enhanced texture into _dstTexture.
+	// _dstTexture must be bound to the active texture unit. Returns the scale, 0 if texture can't be enhanced here.
+	u32 enhance(const void * _pData, u32 _width, u32 _height, GLint _internalFormat, GLenum _type, GLuint _dstTexture);
+
+	static TextureEnhancer & get();
+
+private:
+	TextureEnhancer();
+	TextureEnhancer(const TextureEnhancer & _other);
+
+	u32 m_scale;
+	GLint m_maxTextureSize;
+	GLuint m_FBO;
+	GLuint m_program;
+	CachedTexture * m_pSourceTexture;
+	CachedTexture * m_pLutTexture;
+};
+
+#endif // TEXTURE_ENHANCER_H
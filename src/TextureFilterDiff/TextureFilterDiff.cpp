@@ -0,0 +1,267 @@
+/*
+Headless texture enhancement quality check.
+Enhances generated test images on GPU with TextureEnhancer on an off-screen EGL context,
+reads the result back and compares it with the GLideNHQ CPU filter of the same enhancement.
+Reports max channel difference, number of different pixels and PSNR per image.
+CPU filter runs in one thread, so it has no band seams.
+
+Usage: GLideN64TextureFilterDiff [-e <enhancement option>]
+Enhancement option is the txEnhancementMode value of the config (4 - HQ2X, 8 - HQ4X). Without it all GPU enhancements are checked.
+Exit code is 2 if some image differs.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "../mupenplus/GLideN64_mupenplus.h"
+#include "../mupenplus/CoreVideo_EGL.h"
+#include "../OpenGL.h"
+#include "../TextureEnhancer.h"
+#include "../Config.h"
+#include "../RSP.h"
+#include "../GLideNHQ/Ext_TxFilter.h"
+
+// GLideNHQ/TextureFilters.h pulls GL headers of GLideNHQ, which clash with the plugin ones.
+void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter);
+
+static
+const char * GetUserPath()
+{
+	return "./";
+}
+
+struct Enhancement {
+	u32 mode;
+	u32 filter;
+	const char * name;
+};
+
+static const Enhancement enhancements[] = {
+	{ 4, HQ2X_ENHANCEMENT, "hq2x" },
+	{ 8, HQ4X_ENHANCEMENT, "hq4x" }
+};
+
+struct Image {
+	u32 width;
+	u32 height;
+	std::vector<u32> pixels; // RGBA8888 in GL byte order
+};
+
+// Blocky image with some noise, similar to N64 textures.
+static
+void makeBlocks(Image & _image)
+{
+	for (u32 y = 0; y < _image.height; ++y) {
+		for (u32 x = 0; x < _image.width; ++x) {
+			const u32 block = ((x >> 2) * 0x9E3779B1u) ^ ((y >> 2) * 0x85EBCA6Bu);
+			_image.pixels[y * _image.width + x] = 0xFF000000 | ((block ^ (rand() & 0x0F0F0F)) & 0xFFFFFF);
+		}
+	}
+}
+
+// Smooth ramps, which cross the difference thresholds slowly.
+static
+void makeGradient(Image & _image)
+{
+	for (u32 y = 0; y < _image.height; ++y) {
+		for (u32 x = 0; x < _image.width; ++x) {
+			const u32 r = x * 255 / _image.width;
+			const u32 g = y * 255 / _image.height;
+			const u32 b = (x + y) * 127 / (_image.width + _image.height);
+			_image.pixels[y * _image.width + x] = 0xFF000000 | (b << 16) | (g << 8) | r;
+		}
+	}
+}
+
+// Two color diagonal lines and dots, which produce most of the neighbour patterns.
+static
+void makeLines(Image & _image)
+{
+	for (u32 y = 0; y < _image.height; ++y) {
+		for (u32 x = 0; x < _image.width; ++x) {
+			const bool set = ((x + y) % 5 == 0) || ((x * 3 + y) % 7 == 0) || (rand() % 13 == 0);
+			_image.pixels[y * _image.width + x] = set ? 0xFF1030E0 : 0x80F0E0C0;
+		}
+	}
+}
+
+// Random colors and alpha.
+static
+void makeNoise(Image & _image)
+{
+	for (u32 i = 0; i < _image.pixels.size(); ++i)
+		_image.pixels[i] = ((u32)rand() << 16) ^ (u32)rand();
+}
+
+struct TestImage {
+	const char * name;
+	void (*make)(Image & _image);
+};
+
+static const TestImage testImages[] = {
+	{ "blocks", makeBlocks },
+	{ "gradient", makeGradient },
+	{ "lines", makeLines },
+	{ "noise", makeNoise }
+};
+
+static const u32 testSizes[][2] = { { 64, 64 }, { 33, 17 }, { 4, 4 }, { 256, 128 } };
+
+// Packs image to RGBA4444 and expands it back, the way GLideNHQ converts 16 bit textures.
+static
+void quantize4444(const Image & _image, std::vector<u16> & _packed, Image & _expanded)
+{
+	_packed.resize(_image.pixels.size());
+	_expanded = _image;
+	for (u32 i = 0; i < _image.pixels.size(); ++i) {
+		const u32 c = _image.pixels[i];
+		const u32 r = (c >> 4) & 0xF, g = (c >> 12) & 0xF, b = (c >> 20) & 0xF, a = (c >> 28) & 0xF;
+		_packed[i] = (u16)((r << 12) | (g << 8) | (b << 4) | a);
+		_expanded.pixels[i] = ((a * 17) << 24) | ((b * 17) << 16) | ((g * 17) << 8) | (r * 17);
+	}
+}
+
+struct DiffResult {
+	u32 maxDiff;
+	u32 pixels;
+	double psnr;
+};
+
+static
+DiffResult compare(const std::vector<u32> & _gpu, const std::vector<u32> & _cpu)
+{
+	DiffResult result = { 0, 0, INFINITY };
+	double squares = 0.0;
+	for (u32 i = 0; i < _gpu.size(); ++i) {
+		if (_gpu[i] == _cpu[i])
+			continue;
+		++result.pixels;
+		for (u32 shift = 0; shift < 32; shift += 8) {
+			const int d = (int)((_gpu[i] >> shift) & 0xFF) - (int)((_cpu[i] >> shift) & 0xFF);
+			squares += d * d;
+			if ((u32)abs(d) > result.maxDiff)
+				result.maxDiff = abs(d);
+		}
+	}
+	if (result.pixels != 0)
+		result.psnr = 10.0 * log10(255.0 * 255.0 * _gpu.size() * 4 / squares);
+	return result;
+}
+
+static
+bool enhanceOnGPU(const void * _pData, u32 _width, u32 _height, GLint _internalFormat, GLenum _type, u32 & _scale, std::vector<u32> & _output)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	if (_width % 2 != 0 && _type != GL_UNSIGNED_BYTE)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	_scale = TextureEnhancer::get().enhance(_pData, _width, _height, _internalFormat, _type, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	if (_scale != 0) {
+		GLuint fbo;
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		_output.resize(_width * _height * _scale * _scale);
+		glReadPixels(0, 0, _width * _scale, _height * _scale, GL_RGBA, GL_UNSIGNED_BYTE, _output.data());
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(1, &texture);
+	return _scale != 0;
+}
+
+static
+bool checkImage(const Enhancement & _enhancement, const char * _name, const char * _format, const Image & _reference,
+	const void * _pData, GLint _internalFormat, GLenum _type)
+{
+	u32 scale = 0;
+	std::vector<u32> gpu;
+	if (!enhanceOnGPU(_pData, _reference.width, _reference.height, _internalFormat, _type, scale, gpu)) {
+		printf("%s,%s,%ux%u,%s,,,,skipped\n", _enhancement.name, _name, _reference.width, _reference.height, _format);
+		return true;
+	}
+
+	std::vector<u32> source(_reference.pixels);
+	std::vector<u32> cpu(gpu.size());
+	filter_8888(source.data(), _reference.width, _reference.height, cpu.data(), _enhancement.filter);
+
+	const DiffResult diff = compare(gpu, cpu);
+	printf("%s,%s,%ux%u,%s,%u,%u,%.2f,%s\n", _enhancement.name, _name, _reference.width, _reference.height, _format,
+		diff.maxDiff, diff.pixels, diff.psnr, diff.pixels == 0 ? "match" : "DIFF");
+	return diff.pixels == 0;
+}
+
+int main(int argc, char * argv[])
+{
+	u32 mode = 0;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-e") == 0)
+			mode = strtoul(argv[i + 1], NULL, 0);
+	}
+
+	CoreVideo_EGL_Install();
+	ConfigGetUserDataPath = GetUserPath;
+	ConfigGetUserCachePath = GetUserPath;
+
+	config.resetToDefaults();
+	config.video.windowedWidth = 320;
+	config.video.windowedHeight = 240;
+	config.generalEmulation.enableShadersStorage = 0;
+	config.textureFilter.txEnhancementGPU = 1;
+	strcpy(RSP.romname, "TEXTURE FILTER DIFF");
+
+	video().start();
+	if (!CoreVideo_EGL_HasContext()) {
+		fprintf(stderr, "Can't create OpenGL 3.3 context\n");
+		return 1;
+	}
+	printf("# renderer: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	printf("filter,image,size,format,max_diff,diff_pixels,psnr_db,result\n");
+
+	bool match = true;
+	for (u32 e = 0; e < sizeof(enhancements) / sizeof(enhancements[0]); ++e) {
+		const Enhancement & enhancement = enhancements[e];
+		if (mode != 0 && mode != enhancement.mode)
+			continue;
+		TextureEnhancer::get().destroy();
+		TextureEnhancer::get().init(enhancement.filter);
+		if (!TextureEnhancer::get().isActive()) {
+			fprintf(stderr, "%s has no GPU implementation\n", enhancement.name);
+			match = false;
+			continue;
+		}
+
+		srand(1);
+		for (u32 i = 0; i < sizeof(testImages) / sizeof(testImages[0]); ++i) {
+			for (u32 s = 0; s < sizeof(testSizes) / sizeof(testSizes[0]); ++s) {
+				Image image;
+				image.width = testSizes[s][0];
+				image.height = testSizes[s][1];
+				image.pixels.resize(image.width * image.height);
+				testImages[i].make(image);
+
+				match = checkImage(enhancement, testImages[i].name, "rgba8888", image,
+					image.pixels.data(), GL_RGBA8, GL_UNSIGNED_BYTE) && match;
+
+				std::vector<u16> packed;
+				Image expanded;
+				quantize4444(image, packed, expanded);
+				match = checkImage(enhancement, testImages[i].name, "rgba4444", expanded,
+					packed.data(), GL_RGBA4, GL_UNSIGNED_SHORT_4_4_4_4) && match;
+			}
+		}
+	}
+	TextureEnhancer::get().destroy();
+
+	video().stop();
+	return match ? 0 : 2;
+}
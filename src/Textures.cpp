@@ -16,6 +16,7 @@
 #include "Config.h"
 #include "Keys.h"
 #include "GLideNHQ/Ext_TxFilter.h"
+#include "TextureEnhancer.h"
 
 using namespace std;
 
@@ -477,6 +478,13 @@ void TextureCache::init()
 	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, dummyTexture );
 
 	m_cachedBytes = m_pDummy->textureBytes;
+	for (u32 t = 0; t < 2; ++t) {
+		SamplerParameters & params = m_samplerParameters[t];
+		params.minFilter = params.magFilter = GL_NEAREST;
+		params.wrapS = params.wrapT = GL_CLAMP_TO_EDGE;
+		params.maxLod = 0;
+		params.anisotropy = false;
+	}
 	activateDummy( 0 );
 	activateDummy( 1 );
 	current[0] = current[1] = NULL;
@@ -516,6 +524,13 @@ void TextureCache::destroy()
 	for (FBTextures::const_iterator cur = m_fbTextures.cbegin(); cur != m_fbTextures.cend(); ++cur)
 		glDeleteTextures( 1, &cur->second.glName );
 	m_fbTextures.clear();
+	_clearFrameBufferTexturePool();
+
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+	for (Samplers::const_iterator cur = m_samplers.cbegin(); cur != m_samplers.cend(); ++cur)
+		glDeleteSamplers(1, &cur->second);
+#endif
+	m_samplers.clear();
 
 	m_cachedBytes = 0;
 }
@@ -556,6 +571,7 @@ void TextureCache::removeFrameBufferTexture(CachedTexture * _pTexture)
 	assert(iter != m_fbTextures.cend());
 	m_cachedBytes -= iter->second.textureBytes;
 	glDeleteTextures( 1, &iter->second.glName );
+	m_fbTextureStorages.erase(iter->first);
 	m_fbTextures.erase(iter);
 }
 
@@ -568,6 +584,57 @@ CachedTexture * TextureCache::addFrameBufferTexture()
 	return &m_fbTextures.at(glName);
 }
 
+// Memory limit for storage of released frame buffer textures.
+static const u32 g_maxFBTexturePoolBytes = 128 * 1024 * 1024;
+
+CachedTexture * TextureCache::getFrameBufferTexture(GLint _internalFormat, u32 _width, u32 _height, u32 _samples, bool & _bHasStorage)
+{
+	const FBTextureStorage storage = { _internalFormat, _width, _height, _samples };
+	for (FBTexturePool::iterator iter = m_fbTexturePool.begin(); iter != m_fbTexturePool.end(); ++iter) {
+		if (m_fbTextureStorages.at(*iter) == storage) {
+			CachedTexture * pTexture = &m_fbTextures.at(*iter);
+			m_fbTexturePoolBytes -= pTexture->textureBytes;
+			m_fbTexturePool.erase(iter);
+			_bHasStorage = true;
+			return pTexture;
+		}
+	}
+
+	CachedTexture * pTexture = addFrameBufferTexture();
+	m_fbTextureStorages.emplace(pTexture->glName, storage);
+	_bHasStorage = false;
+	return pTexture;
+}
+
+void TextureCache::releaseFrameBufferTexture(CachedTexture * _pTexture)
+{
+	if (m_fbTextureStorages.count(_pTexture->glName) == 0 || _pTexture->textureBytes > g_maxFBTexturePoolBytes) {
+		removeFrameBufferTexture(_pTexture);
+		return;
+	}
+
+	m_cachedBytes -= _pTexture->textureBytes;
+	m_fbTexturePoolBytes += _pTexture->textureBytes;
+	m_fbTexturePool.push_front(_pTexture->glName);
+
+	// Drop least recently released textures
+	while (m_fbTexturePoolBytes > g_maxFBTexturePoolBytes) {
+		const GLuint glName = m_fbTexturePool.back();
+		m_fbTexturePool.pop_back();
+		m_fbTexturePoolBytes -= m_fbTextures.at(glName).textureBytes;
+		glDeleteTextures(1, &glName);
+		m_fbTextureStorages.erase(glName);
+		m_fbTextures.erase(glName);
+	}
+}
+
+void TextureCache::_clearFrameBufferTexturePool()
+{
+	m_fbTextureStorages.clear();
+	m_fbTexturePool.clear();
+	m_fbTexturePoolBytes = 0;
+}
+
 struct TileSizes
 {
 	u32 maskWidth, clampWidth, width, realWidth;
@@ -673,6 +740,32 @@ void _calcTileSizes(u32 _t, TileSizes & _sizes, gDPTile * _pLoadTile)
 	}
 }
 
+// Size of texture compressed by GLideNHQ for the GPU, 0 for uncompressed formats
+inline
+u32 _compressedTextureBytes(const GHQTexInfo & _info)
+{
+	const u32 numBlocks = ((_info.width + 3) >> 2) * ((_info.height + 3) >> 2);
+	switch (_info.format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGB8_ETC2:
+		return numBlocks * 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		return numBlocks * 16;
+	}
+	return 0;
+}
+
+inline
+bool _loadCompressedTexture(const GHQTexInfo & _info)
+{
+	const u32 textureBytes = _compressedTextureBytes(_info);
+	if (textureBytes == 0)
+		return false;
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, _info.format, _info.width, _info.height, 0, textureBytes, _info.data);
+	return true;
+}
+
 inline
 void _updateCachedTexture(const GHQTexInfo & _info, CachedTexture *_pTexture)
 {
@@ -683,6 +776,12 @@ void _updateCachedTexture(const GHQTexInfo & _info, CachedTexture *_pTexture)
 		case GL_RGB5_A1:
 		_pTexture->textureBytes <<= 1;
 		break;
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RGB8_ETC2:
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		_pTexture->textureBytes = _compressedTextureBytes(_info);
+		break;
 		default:
 		_pTexture->textureBytes <<= 2;
 	}
@@ -722,9 +821,10 @@ bool TextureCache::_loadHiresBackground(CachedTexture *_pTexture)
 						bpl, paladdr);
 	GHQTexInfo ghqTexInfo;
 	if (txfilter_hirestex(_pTexture->crc, ricecrc, palette, &ghqTexInfo)) {
-		glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format,
-			ghqTexInfo.width, ghqTexInfo.height, 0, ghqTexInfo.texture_format,
-			ghqTexInfo.pixel_type, ghqTexInfo.data);
+		if (!_loadCompressedTexture(ghqTexInfo))
+			glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format,
+				ghqTexInfo.width, ghqTexInfo.height, 0, ghqTexInfo.texture_format,
+				ghqTexInfo.pixel_type, ghqTexInfo.data);
 		assert(!isGLError());
 		_updateCachedTexture(ghqTexInfo, _pTexture);
 		return true;
@@ -800,10 +900,11 @@ void TextureCache::_loadBackground(CachedTexture *pTexture)
 					ghqTexInfo.format != GL_RGBA &&
 					m_curUnpackAlignment > 1)
 				glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
-			glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format,
-					ghqTexInfo.width, ghqTexInfo.height, 0,
-					ghqTexInfo.texture_format, ghqTexInfo.pixel_type,
-					ghqTexInfo.data);
+			if (!_loadCompressedTexture(ghqTexInfo))
+				glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format,
+						ghqTexInfo.width, ghqTexInfo.height, 0,
+						ghqTexInfo.texture_format, ghqTexInfo.pixel_type,
+						ghqTexInfo.data);
 			_updateCachedTexture(ghqTexInfo, pTexture);
 			bLoaded = true;
 		}
@@ -872,7 +973,8 @@ bool TextureCache::_loadHiresTexture(u32 _tile, CachedTexture *_pTexture, u64 &
 #ifdef GLES2
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ghqTexInfo.width, ghqTexInfo.height, 0, GL_RGBA, ghqTexInfo.pixel_type, ghqTexInfo.data);
 #else
-		glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format, ghqTexInfo.width, ghqTexInfo.height, 0, ghqTexInfo.texture_format, ghqTexInfo.pixel_type, ghqTexInfo.data);
+		if (!_loadCompressedTexture(ghqTexInfo))
+			glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format, ghqTexInfo.width, ghqTexInfo.height, 0, ghqTexInfo.texture_format, ghqTexInfo.pixel_type, ghqTexInfo.data);
 #endif
 		assert(!isGLError());
 		_updateCachedTexture(ghqTexInfo, _pTexture);
@@ -1079,6 +1181,11 @@ void TextureCache::_load(u32 _tile, CachedTexture *_pTexture)
 					ricecrc);
 		}
 
+		if (tmptex.realWidth % 2 != 0 &&
+				glInternalFormat != GL_RGBA &&
+				m_curUnpackAlignment > 1)
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+
 		bool bLoaded = false;
 		if ((config.textureFilter.txEnhancementMode | config.textureFilter.txFilterMode) != 0 &&
 				maxLevel == 0 &&
@@ -1086,7 +1193,15 @@ void TextureCache::_load(u32 _tile, CachedTexture *_pTexture)
 				TFH.isInited())
 		{
 			GHQTexInfo ghqTexInfo;
-			if (txfilter_filter((u8*)pDest, tmptex.realWidth, tmptex.realHeight,
+			const u32 scale = TextureEnhancer::get().enhance(pDest, tmptex.realWidth, tmptex.realHeight,
+							glInternalFormat, glType, _pTexture->glName);
+			if (scale != 0) {
+				ghqTexInfo.width = tmptex.realWidth * scale;
+				ghqTexInfo.height = tmptex.realHeight * scale;
+				ghqTexInfo.format = GL_RGBA8;
+				_updateCachedTexture(ghqTexInfo, _pTexture);
+				bLoaded = true;
+			} else if (txfilter_filter((u8*)pDest, tmptex.realWidth, tmptex.realHeight,
 							glInternalFormat, (uint64)_pTexture->crc,
 							&ghqTexInfo) != 0 && ghqTexInfo.data != NULL) {
 #ifdef GLES2
@@ -1095,20 +1210,17 @@ void TextureCache::_load(u32 _tile, CachedTexture *_pTexture)
 						0, GL_RGBA, ghqTexInfo.pixel_type,
 						ghqTexInfo.data);
 #else
-				glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format,
-						ghqTexInfo.width, ghqTexInfo.height,
-						0, ghqTexInfo.texture_format, ghqTexInfo.pixel_type,
-						ghqTexInfo.data);
+				if (!_loadCompressedTexture(ghqTexInfo))
+					glTexImage2D(GL_TEXTURE_2D, 0, ghqTexInfo.format,
+							ghqTexInfo.width, ghqTexInfo.height,
+							0, ghqTexInfo.texture_format, ghqTexInfo.pixel_type,
+							ghqTexInfo.data);
 #endif
 				_updateCachedTexture(ghqTexInfo, _pTexture);
 				bLoaded = true;
 			}
 		}
 		if (!bLoaded) {
-			if (tmptex.realWidth % 2 != 0 &&
-					glInternalFormat != GL_RGBA &&
-					m_curUnpackAlignment > 1)
-				glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
 #ifdef GLES2
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tmptex.realWidth,
 					tmptex.realHeight, 0, GL_RGBA, glType, pDest);
@@ -1192,71 +1304,163 @@ u32 _calculateCRC(u32 t, const TextureParams & _params)
 
 void TextureCache::activateTexture(u32 _t, CachedTexture *_pTexture)
 {
-#ifdef GL_MULTISAMPLING_SUPPORT
-	if (config.video.multisampling > 0 && _pTexture->frameBufferTexture == CachedTexture::fbMultiSample) {
-		glActiveTexture(GL_TEXTURE0 + g_MSTex0Index + _t);
-		// Bind the cached texture
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, _pTexture->glName);
-	} else
-#endif
-	{
-		glActiveTexture(GL_TEXTURE0 + _t);
-		// Bind the cached texture
-		glBindTexture(GL_TEXTURE_2D, _pTexture->glName);
-	}
-
 	const bool bUseBilinear = (gDP.otherMode.textureFilter | (gSP.objRendermode&G_OBJRM_BILERP)) != 0;
 	const bool bUseLOD = currentCombiner()->usesLOD();
 	const GLint texLevel = bUseLOD ? _pTexture->max_level : 0;
+	SamplerParameters & params = m_samplerParameters[_t];
 
-#ifndef GLES2
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texLevel);
-#endif
+	params.maxLod = texLevel;
 	if (config.texture.bilinearMode == BILINEAR_STANDARD) {
 		if (bUseBilinear) {
-			if (texLevel > 0)
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-			else
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			params.minFilter = texLevel > 0 ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR;
+			params.magFilter = GL_LINEAR;
 		} else {
-			if (texLevel > 0)
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-			else
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			params.minFilter = texLevel > 0 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
+			params.magFilter = GL_NEAREST;
 		}
 	} else { // 3 point filter
 		if (texLevel > 0) { // Apply standard bilinear to mipmap textures
 			if (bUseBilinear) {
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				params.minFilter = GL_LINEAR_MIPMAP_NEAREST;
+				params.magFilter = GL_LINEAR;
 			} else {
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				params.minFilter = GL_NEAREST_MIPMAP_NEAREST;
+				params.magFilter = GL_NEAREST;
 			}
 		} else if (bUseBilinear && config.generalEmulation.enableLOD != 0 && bUseLOD) { // Apply standard bilinear to first tile of mipmap texture
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			params.minFilter = GL_LINEAR;
+			params.magFilter = GL_LINEAR;
 		} else { // Don't use texture filter. Texture will be filtered by 3 point filter shader
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			params.minFilter = GL_NEAREST;
+			params.magFilter = GL_NEAREST;
 		}
 	}
 
-
 	// Set clamping modes
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _pTexture->clampS ? GL_CLAMP_TO_EDGE : _pTexture->mirrorS ? GL_MIRRORED_REPEAT : GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _pTexture->clampT ? GL_CLAMP_TO_EDGE : _pTexture->mirrorT ? GL_MIRRORED_REPEAT : GL_REPEAT);
+	params.wrapS = _pTexture->clampS ? GL_CLAMP_TO_EDGE : _pTexture->mirrorS ? GL_MIRRORED_REPEAT : GL_REPEAT;
+	params.wrapT = _pTexture->clampT ? GL_CLAMP_TO_EDGE : _pTexture->mirrorT ? GL_MIRRORED_REPEAT : GL_REPEAT;
 
-	if (video().getRender().getRenderState() == OGLRender::rsTriangle && config.texture.maxAnisotropyF > 0.0f)
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, config.texture.maxAnisotropyF);
+	params.anisotropy = video().getRender().getRenderState() == OGLRender::rsTriangle && config.texture.maxAnisotropyF > 0.0f;
+
+#ifdef GL_MULTISAMPLING_SUPPORT
+	if (config.video.multisampling > 0 && _pTexture->frameBufferTexture == CachedTexture::fbMultiSample) {
+		glActiveTexture(GL_TEXTURE0 + g_MSTex0Index + _t);
+		// Bind the cached texture. Multisample textures are not filtered.
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, _pTexture->glName);
+	} else
+#endif
+	{
+		glActiveTexture(GL_TEXTURE0 + _t);
+		// Bind the cached texture
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+		cache_glBindTextureSampler(_pTexture->glName, _getSampler(params));
+		// Sampler's max LOD limits used levels, so the texture object does not change after the first activation.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, _pTexture->max_level);
+#else
+		glBindTexture(GL_TEXTURE_2D, _pTexture->glName);
+#ifndef GLES2
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texLevel);
+#endif
+		_applySamplerParameters(_t);
+#endif
+	}
 
 	_pTexture->lastDList = video().getBuffersSwapCount();
 
 	current[_t] = _pTexture;
 }
 
+void TextureCache::setTextureWrap(u32 _t, GLint _wrapS, GLint _wrapT)
+{
+	SamplerParameters & params = m_samplerParameters[_t];
+	if (_wrapS != 0)
+		params.wrapS = _wrapS;
+	if (_wrapT != 0)
+		params.wrapT = _wrapT;
+	_applySamplerParameters(_t);
+}
+
+void TextureCache::setTextureFilter(u32 _t, GLint _minFilter, GLint _magFilter)
+{
+	SamplerParameters & params = m_samplerParameters[_t];
+	if (_minFilter != 0)
+		params.minFilter = _minFilter;
+	if (_magFilter != 0)
+		params.magFilter = _magFilter;
+	_applySamplerParameters(_t);
+}
+
+void TextureCache::_applySamplerParameters(u32 _t)
+{
+	const SamplerParameters & params = m_samplerParameters[_t];
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+	glBindSampler(_t, _getSampler(params));
+#else
+	glActiveTexture(GL_TEXTURE0 + _t);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrapT);
+	if (params.anisotropy)
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, config.texture.maxAnisotropyF);
+#endif
+}
+
+static
+u32 _samplerFilterKey(GLint _filter)
+{
+	switch (_filter) {
+	case GL_LINEAR:
+		return 1;
+	case GL_NEAREST_MIPMAP_NEAREST:
+		return 2;
+	case GL_LINEAR_MIPMAP_NEAREST:
+		return 3;
+	}
+	return 0;
+}
+
+static
+u32 _samplerWrapKey(GLint _wrap)
+{
+	switch (_wrap) {
+	case GL_MIRRORED_REPEAT:
+		return 1;
+	case GL_CLAMP_TO_EDGE:
+		return 2;
+	}
+	return 0;
+}
+
+GLuint TextureCache::_getSampler(const SamplerParameters & _params)
+{
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+	const u32 key = _samplerFilterKey(_params.minFilter) |
+		(_samplerFilterKey(_params.magFilter) << 2) |
+		(_samplerWrapKey(_params.wrapS) << 4) |
+		(_samplerWrapKey(_params.wrapT) << 6) |
+		((_params.anisotropy ? 1 : 0) << 8) |
+		(_params.maxLod << 9);
+	Samplers::const_iterator iter = m_samplers.find(key);
+	if (iter != m_samplers.end())
+		return iter->second;
+
+	GLuint sampler;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, _params.minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, _params.magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, _params.wrapS);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, _params.wrapT);
+	glSamplerParameterf(sampler, GL_TEXTURE_MAX_LOD, (GLfloat)_params.maxLod);
+	if (_params.anisotropy)
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, config.texture.maxAnisotropyF);
+	m_samplers[key] = sampler;
+	return sampler;
+#else
+	return 0;
+#endif
+}
+
 void TextureCache::activateDummy(u32 _t)
 {
 	glActiveTexture( GL_TEXTURE0 + _t );
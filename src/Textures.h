@@ -56,7 +56,12 @@ struct TextureCache
 	CachedTexture * addFrameBufferTexture();
 	void addFrameBufferTextureSize(u32 _size) {m_cachedBytes += _size;}
 	void removeFrameBufferTexture(CachedTexture * _pTexture);
+	CachedTexture * getFrameBufferTexture(GLint _internalFormat, u32 _width, u32 _height, u32 _samples, bool & _bHasStorage);
+	void releaseFrameBufferTexture(CachedTexture * _pTexture);
 	void activateTexture(u32 _t, CachedTexture *_pTexture);
+	// Override sampling of texture activated in unit _t. Zero keeps the current value.
+	void setTextureWrap(u32 _t, GLint _wrapS, GLint _wrapT);
+	void setTextureFilter(u32 _t, GLint _minFilter, GLint _magFilter);
 	void activateDummy(u32 _t);
 	void activateMSDummy(u32 _t);
 	void update(u32 _t);
@@ -64,7 +69,7 @@ struct TextureCache
 	static TextureCache & get();
 
 private:
-	TextureCache() : m_pDummy(NULL), m_hits(0), m_misses(0), m_maxBytes(0), m_cachedBytes(0), m_curUnpackAlignment(4), m_toggleDumpTex(false)
+	TextureCache() : m_fbTexturePoolBytes(0), m_pDummy(NULL), m_hits(0), m_misses(0), m_maxBytes(0), m_cachedBytes(0), m_curUnpackAlignment(4), m_toggleDumpTex(false)
 	{
 		current[0] = NULL;
 		current[1] = NULL;
@@ -83,6 +88,16 @@ private:
 	void _clear();
 	void _initDummyTexture(CachedTexture * _pDummy);
 	void _getTextureDestData(CachedTexture& tmptex, u32* pDest, GLuint glInternalFormat, GetTexelFunc GetTexel, u16* pLine);
+	void _clearFrameBufferTexturePool();
+
+	struct SamplerParameters {
+		GLint minFilter, magFilter;
+		GLint wrapS, wrapT;
+		GLint maxLod;
+		bool anisotropy;
+	};
+	void _applySamplerParameters(u32 _t);
+	GLuint _getSampler(const SamplerParameters & _params);
 
 	typedef std::list<CachedTexture> Textures;
 	typedef std::map<u32, Textures::iterator> Texture_Locations;
@@ -90,6 +105,22 @@ private:
 	Textures m_textures;
 	Texture_Locations m_lruTextureLocations;
 	FBTextures m_fbTextures;
+
+	// Storage of frame buffer textures got with getFrameBufferTexture.
+	// Released textures keep their storage in the pool, most recently released first.
+	struct FBTextureStorage {
+		GLint internalFormat;
+		u32 width, height;
+		u32 samples;
+		bool operator==(const FBTextureStorage & _other) const {
+			return internalFormat == _other.internalFormat && width == _other.width && height == _other.height && samples == _other.samples;
+		}
+	};
+	typedef std::map<GLuint, FBTextureStorage> FBTextureStorages;
+	typedef std::list<GLuint> FBTexturePool;
+	FBTextureStorages m_fbTextureStorages;
+	FBTexturePool m_fbTexturePool;
+	u32 m_fbTexturePoolBytes;
 	CachedTexture * m_pDummy;
 	CachedTexture * m_pMSDummy;
 	u32 m_hits, m_misses;
@@ -97,6 +128,11 @@ private:
 	u32 m_cachedBytes;
 	GLint m_curUnpackAlignment;
 	bool m_toggleDumpTex;
+
+	SamplerParameters m_samplerParameters[2];
+	// Sampler objects by packed sampler parameters. Used if GL supports sampler objects.
+	typedef std::map<u32, GLuint> Samplers;
+	Samplers m_samplers;
 };
 
 void getTextureShiftScale(u32 tile, const TextureCache & cache, f32 & shiftScaleS, f32 & shiftScaleT);
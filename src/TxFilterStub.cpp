@@ -42,3 +42,8 @@ txfilter_reloadhirestex()
 	return 0;
 }
 
+TAPI int TAPIENTRY
+txfilter_enhancementlut(int enhancement, uint32 *lut)
+{
+	return 0;
+}
@@ -910,7 +910,7 @@ void gDPFullSync()
 
 	if (RSP.bLLE) {
 		if (config.frameBufferEmulation.copyDepthToRDRAM != Config::ctDisable && !FBInfo::fbInfo.isSupported())
-			FrameBuffer_CopyDepthBuffer(gDP.colorImage.address);
+			FrameBuffer_CopyDepthBuffer(gDP.colorImage.address, config.frameBufferEmulation.copyDepthToRDRAM == Config::ctSync);
 	}
 
 	*REG.MI_INTR |= MI_INTR_DP;
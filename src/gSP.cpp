@@ -52,9 +52,11 @@ void gSPTriangle(s32 v0, s32 v1, s32 v2)
 	if ((v0 < INDEXMAP_SIZE) && (v1 < INDEXMAP_SIZE) && (v2 < INDEXMAP_SIZE)) {
 		if (render.isClipped(v0, v1, v2))
 			return;
+		// Overlapping triangles of one draw may store to the depth image in any order,
+		// so a triangle, which updates depth over pending ones, starts a new draw. Depth test alone can be batched.
+		if (config.frameBufferEmulation.N64DepthCompare != 0 && render.isN64DepthUpdate())
+			render.drawTrianglesOnTilesOverlap(v0, v1, v2);
 		render.addTriangle(v0, v1, v2);
-		if (config.frameBufferEmulation.N64DepthCompare != 0)
-			render.drawTriangles();
 	}
 
 	frameBufferList().setBufferChanged();
@@ -1,9 +1,60 @@
+#include <string.h>
+#ifdef GL_STATE_TRACE
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+#endif
 #include "OpenGL.h"
+#include "Log.h"
 
 #ifdef GLSTATE_H
 
+static
+const char * CallNames[GLState::gcTotal] = {
+	"glActiveTexture",
+	"glBindTexture",
+	"glTexParameteri",
+	"glBindSampler",
+	"glBindFramebuffer",
+	"glBindBuffer",
+	"glBindBufferRange",
+	"glBlendFunc",
+	"glPixelStorei",
+	"glClearColor",
+	"glCullFace",
+	"glDepthFunc",
+	"glDepthMask",
+	"glEnable",
+	"glDisable",
+	"glPolygonOffset",
+	"glScissor",
+	"glUseProgram",
+	"glViewport"
+};
+
+#ifdef GL_STATE_TRACE
+static std::string traceFrame;
+static GLuint traceIssued[GLState::gcTotal];
+static GLuint traceSkipped[GLState::gcTotal];
+static u32 traceFrameCount = 0;
+
+void glStateTrace(const char * _format, ...)
+{
+	char buf[256];
+	va_list va;
+	va_start(va, _format);
+	vsnprintf(buf, sizeof(buf), _format, va);
+	va_end(va);
+	traceFrame += buf;
+	traceFrame += '\n';
+}
+#endif // GL_STATE_TRACE
+
 void GLState::reset()
 {
+	memset(issuedCalls, 0, sizeof(issuedCalls));
+	memset(skippedCalls, 0, sizeof(skippedCalls));
+	invalidateBindings();
 	cached_ActiveTexture_texture = 0;
 	cached_BlendFunc_sfactor = 0;
 	cached_BlendFunc_dfactor = 0;
@@ -40,6 +91,151 @@ void GLState::reset()
 	cached_Viewport_height = 0;
 }
 
+void GLState::invalidateBindings()
+{
+	cached_ActiveTexture_texture = 0;
+	for (GLuint i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+		for (GLuint j = 0; j < ttTotal; ++j)
+			cached_BindTexture[i][j] = UNKNOWN_BINDING;
+		cached_BindSampler[i] = UNKNOWN_BINDING;
+	}
+	for (GLuint i = 0; i < btTotal; ++i)
+		cached_BindBuffer[i] = UNKNOWN_BINDING;
+	cached_BindFramebuffer_draw = UNKNOWN_BINDING;
+	cached_BindFramebuffer_read = UNKNOWN_BINDING;
+	cached_TexParameters.clear();
+}
+
+GLuint * GLState::getTextureBinding(GLenum _target)
+{
+	const GLuint unit = cached_ActiveTexture_texture - GL_TEXTURE0;
+	if (unit >= MAX_TEXTURE_UNITS)
+		return NULL;
+	switch (_target) {
+	case GL_TEXTURE_2D:
+		return &cached_BindTexture[unit][ttTexture2D];
+#ifdef GL_MULTISAMPLING_SUPPORT
+	case GL_TEXTURE_2D_MULTISAMPLE:
+		return &cached_BindTexture[unit][ttTexture2DMultisample];
+#endif
+	}
+	return NULL;
+}
+
+GLint * GLState::getTextureParameter(GLenum _target, GLenum _pname)
+{
+	if (_target != GL_TEXTURE_2D)
+		return NULL;
+	const GLuint * pBinding = getTextureBinding(_target);
+	if (pBinding == NULL || *pBinding == UNKNOWN_BINDING || *pBinding == 0)
+		return NULL;
+	TextureParameters & params = cached_TexParameters[*pBinding];
+	switch (_pname) {
+	case GL_TEXTURE_MIN_FILTER:
+		return &params.minFilter;
+	case GL_TEXTURE_MAG_FILTER:
+		return &params.magFilter;
+	case GL_TEXTURE_WRAP_S:
+		return &params.wrapS;
+	case GL_TEXTURE_WRAP_T:
+		return &params.wrapT;
+#ifndef GLES2
+	case GL_TEXTURE_MAX_LEVEL:
+		return &params.maxLevel;
+#endif
+	}
+	return NULL;
+}
+
+GLuint * GLState::getBufferBinding(GLenum _target)
+{
+	switch (_target) {
+	case GL_ARRAY_BUFFER:
+		return &cached_BindBuffer[btArray];
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return &cached_BindBuffer[btElementArray];
+#ifndef GLES2
+	case GL_PIXEL_PACK_BUFFER:
+		return &cached_BindBuffer[btPixelPack];
+	case GL_PIXEL_UNPACK_BUFFER:
+		return &cached_BindBuffer[btPixelUnpack];
+#endif
+#ifdef GL_UNIFORMBLOCK_SUPPORT
+	case GL_UNIFORM_BUFFER:
+		return &cached_BindBuffer[btUniform];
+#endif
+	}
+	return NULL;
+}
+
+// Deleted objects are unbound by GL, and their names may be reused by glGen* calls.
+void GLState::forgetTextures(GLsizei _n, const GLuint * _textures)
+{
+	for (GLsizei n = 0; n < _n; ++n) {
+		const GLuint name = _textures[n];
+		cached_TexParameters.erase(name);
+		for (GLuint i = 0; i < MAX_TEXTURE_UNITS; ++i)
+			for (GLuint j = 0; j < ttTotal; ++j)
+				if (cached_BindTexture[i][j] == name)
+					cached_BindTexture[i][j] = 0;
+	}
+}
+
+void GLState::forgetFramebuffers(GLsizei _n, const GLuint * _framebuffers)
+{
+	for (GLsizei n = 0; n < _n; ++n) {
+		if (cached_BindFramebuffer_draw == _framebuffers[n])
+			cached_BindFramebuffer_draw = 0;
+		if (cached_BindFramebuffer_read == _framebuffers[n])
+			cached_BindFramebuffer_read = 0;
+	}
+}
+
+void GLState::forgetBuffers(GLsizei _n, const GLuint * _buffers)
+{
+	for (GLsizei n = 0; n < _n; ++n)
+		for (GLuint i = 0; i < btTotal; ++i)
+			if (cached_BindBuffer[i] == _buffers[n])
+				cached_BindBuffer[i] = 0;
+}
+
+void GLState::forgetSamplers(GLsizei _n, const GLuint * _samplers)
+{
+	for (GLsizei n = 0; n < _n; ++n)
+		for (GLuint i = 0; i < MAX_TEXTURE_UNITS; ++i)
+			if (cached_BindSampler[i] == _samplers[n])
+				cached_BindSampler[i] = 0;
+}
+
+void GLState::endFrame()
+{
+#ifdef GL_STATE_TRACE
+	FILE * f = fopen("gliden64_gltrace.log", traceFrameCount == 0 ? "w" : "a");
+	if (f != NULL) {
+		fprintf(f, "=== Frame %u ===\n%s", traceFrameCount, traceFrame.c_str());
+		for (u32 i = 0; i < gcTotal; ++i) {
+			const GLuint issued = issuedCalls[i] - traceIssued[i];
+			const GLuint skipped = skippedCalls[i] - traceSkipped[i];
+			if (issued + skipped > 0)
+				fprintf(f, "%s: issued %u, skipped %u\n", CallNames[i], issued, skipped);
+		}
+		fclose(f);
+	}
+	memcpy(traceIssued, issuedCalls, sizeof(traceIssued));
+	memcpy(traceSkipped, skippedCalls, sizeof(traceSkipped));
+	traceFrame.clear();
+	++traceFrameCount;
+#endif
+}
+
+void GLState::logStatistics() const
+{
+	for (u32 i = 0; i < gcTotal; ++i) {
+		if (issuedCalls[i] + skippedCalls[i] > 0)
+			LOG(LOG_VERBOSE, "GL state: %s issued %u, skipped %u\n", CallNames[i], issuedCalls[i], skippedCalls[i]);
+	}
+}
+
 GLState glState;
 
 #endif // GLSTATE_H
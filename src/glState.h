@@ -1,6 +1,11 @@
 #ifndef GLSTATE_H
 #define GLSTATE_H
 
+#include <unordered_map>
+
+// Uncomment to write all GL calls issued through the state cache to gliden64_gltrace.log, frame by frame.
+//#define GL_STATE_TRACE
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -8,6 +13,71 @@ extern "C" {
 struct GLState {
 	GLState() { reset(); }
 	void reset();
+	// Bindings may be changed outside of the plugin, e.g. by frontend's render callback.
+	void invalidateBindings();
+	void endFrame();
+	void logStatistics() const;
+
+	GLuint * getTextureBinding(GLenum _target);
+	GLint * getTextureParameter(GLenum _target, GLenum _pname);
+	GLuint * getBufferBinding(GLenum _target);
+	void forgetTextures(GLsizei _n, const GLuint * _textures);
+	void forgetFramebuffers(GLsizei _n, const GLuint * _framebuffers);
+	void forgetBuffers(GLsizei _n, const GLuint * _buffers);
+	void forgetSamplers(GLsizei _n, const GLuint * _samplers);
+
+	// GL entry points, which calls are counted.
+	enum Call {
+		gcActiveTexture,
+		gcBindTexture,
+		gcTexParameteri,
+		gcBindSampler,
+		gcBindFramebuffer,
+		gcBindBuffer,
+		gcBindBufferRange,
+		gcBlendFunc,
+		gcPixelStorei,
+		gcClearColor,
+		gcCullFace,
+		gcDepthFunc,
+		gcDepthMask,
+		gcEnable,
+		gcDisable,
+		gcPolygonOffset,
+		gcScissor,
+		gcUseProgram,
+		gcViewport,
+		gcTotal
+	};
+	GLuint issuedCalls[gcTotal];
+	GLuint skippedCalls[gcTotal];
+
+	static const GLuint UNKNOWN_BINDING = 0xFFFFFFFF;
+	static const GLuint MAX_TEXTURE_UNITS = 16;
+	enum TextureTarget {
+		ttTexture2D,
+		ttTexture2DMultisample,
+		ttTotal
+	};
+	enum BufferTarget {
+		btArray,
+		btElementArray,
+		btPixelPack,
+		btPixelUnpack,
+		btUniform,
+		btTotal
+	};
+	struct TextureParameters {
+		TextureParameters() : minFilter(-1), magFilter(-1), wrapS(-1), wrapT(-1), maxLevel(-1) {}
+		GLint minFilter, magFilter, wrapS, wrapT, maxLevel;
+	};
+
+	GLuint cached_BindTexture[MAX_TEXTURE_UNITS][ttTotal];
+	GLuint cached_BindSampler[MAX_TEXTURE_UNITS];
+	GLuint cached_BindFramebuffer_draw;
+	GLuint cached_BindFramebuffer_read;
+	GLuint cached_BindBuffer[btTotal];
+	std::unordered_map<GLuint, TextureParameters> cached_TexParameters;
 
 	GLenum cached_ActiveTexture_texture;
 
@@ -58,12 +128,22 @@ struct GLState {
 
 extern GLState glState;
 
+#ifdef GL_STATE_TRACE
+void glStateTrace(const char * _format, ...);
+#define GL_STATE_ISSUED(_call, ...) do { ++glState.issuedCalls[GLState::_call]; glStateTrace(__VA_ARGS__); } while (0)
+#else
+#define GL_STATE_ISSUED(_call, ...) ++glState.issuedCalls[GLState::_call]
+#endif
+#define GL_STATE_SKIPPED(_call) ++glState.skippedCalls[GLState::_call]
+
 void inline cache_glActiveTexture (GLenum texture)
 {
 	if (texture != glState.cached_ActiveTexture_texture) {
 		glActiveTexture(texture);
 		glState.cached_ActiveTexture_texture = texture;
-	}
+		GL_STATE_ISSUED(gcActiveTexture, "glActiveTexture(0x%04x)", texture);
+	} else
+		GL_STATE_SKIPPED(gcActiveTexture);
 }
 #define glActiveTexture(texture) cache_glActiveTexture(texture)
 
@@ -73,7 +153,9 @@ void inline cache_glBlendFunc (GLenum sfactor, GLenum dfactor)
 		glBlendFunc(sfactor, dfactor);
 		glState.cached_BlendFunc_sfactor = sfactor;
 		glState.cached_BlendFunc_dfactor = dfactor;
-	}
+		GL_STATE_ISSUED(gcBlendFunc, "glBlendFunc(0x%04x, 0x%04x)", sfactor, dfactor);
+	} else
+		GL_STATE_SKIPPED(gcBlendFunc);
 }
 #define glBlendFunc(sfactor, dfactor) cache_glBlendFunc(sfactor, dfactor)
 
@@ -90,7 +172,9 @@ void inline cache_glPixelStorei(GLenum target, GLint param)
 		glPixelStorei(target, param);
 		glState.cached_glPixelStorei_target = target;
 		glState.cached_glPixelStorei_param = param;
-	}
+		GL_STATE_ISSUED(gcPixelStorei, "glPixelStorei(0x%04x, %d)", target, param);
+	} else
+		GL_STATE_SKIPPED(gcPixelStorei);
 }
 #define glPixelStorei(target, param) cache_glPixelStorei(target, param)
 
@@ -102,7 +186,9 @@ void inline cache_glClearColor (GLclampf red, GLclampf green, GLclampf blue, GLc
 		glState.cached_ClearColor_green = green;
 		glState.cached_ClearColor_blue = blue;
 		glState.cached_ClearColor_alpha = alpha;
-	}
+		GL_STATE_ISSUED(gcClearColor, "glClearColor(%f, %f, %f, %f)", red, green, blue, alpha);
+	} else
+		GL_STATE_SKIPPED(gcClearColor);
 }
 #define glClearColor(red, green, blue, alpha) cache_glClearColor(red, green, blue, alpha)
 
@@ -111,7 +197,9 @@ void inline cache_glCullFace (GLenum mode)
 	if (mode != glState.cached_CullFace_mode) {
 		glCullFace(mode);
 		glState.cached_CullFace_mode = mode;
-	}
+		GL_STATE_ISSUED(gcCullFace, "glCullFace(0x%04x)", mode);
+	} else
+		GL_STATE_SKIPPED(gcCullFace);
 }
 #define glCullFace(mode) cache_glCullFace(mode)
 
@@ -120,7 +208,9 @@ void inline cache_glDepthFunc (GLenum func)
 	if (func != glState.cached_DepthFunc_func) {
 		glDepthFunc(func);
 		glState.cached_DepthFunc_func = func;
-	}
+		GL_STATE_ISSUED(gcDepthFunc, "glDepthFunc(0x%04x)", func);
+	} else
+		GL_STATE_SKIPPED(gcDepthFunc);
 }
 #define glDepthFunc(func) cache_glDepthFunc(func)
 
@@ -129,7 +219,9 @@ void inline cache_glDepthMask (GLboolean flag)
 	if (flag != glState.cached_DepthMask_flag) {
 		glDepthMask(flag);
 		glState.cached_DepthMask_flag = flag;
-	}
+		GL_STATE_ISSUED(gcDepthMask, "glDepthMask(%d)", flag);
+	} else
+		GL_STATE_SKIPPED(gcDepthMask);
 }
 #define glDepthMask(flag) cache_glDepthMask(flag)
 
@@ -139,67 +231,88 @@ void inline cache_glDisable (GLenum cap)
 	case GL_BLEND:
 		if (glState.cached_BLEND) {
 			glDisable(GL_BLEND);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_BLEND)");
 			glState.cached_BLEND = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_CULL_FACE:
 		if (glState.cached_CULL_FACE) {
 			glDisable(GL_CULL_FACE);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_CULL_FACE)");
 			glState.cached_CULL_FACE = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_DEPTH_TEST:
 		if (glState.cached_DEPTH_TEST) {
 			glDisable(GL_DEPTH_TEST);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_DEPTH_TEST)");
 			glState.cached_DEPTH_TEST = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 #ifndef GLESX
 	case GL_DEPTH_CLAMP:
 		if (glState.cached_DEPTH_CLAMP) {
 			glDisable(GL_DEPTH_CLAMP);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_DEPTH_CLAMP)");
 			glState.cached_DEPTH_CLAMP = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_CLIP_DISTANCE0:
 		if (glState.cached_CLIP_DISTANCE0) {
 			glDisable(GL_CLIP_DISTANCE0);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_CLIP_DISTANCE0)");
 			glState.cached_CLIP_DISTANCE0 = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 #endif
 	case GL_DITHER:
 		if (glState.cached_DITHER) {
 			glDisable(GL_DITHER);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_DITHER)");
 			glState.cached_DITHER = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_POLYGON_OFFSET_FILL:
 		if (glState.cached_POLYGON_OFFSET_FILL) {
 			glDisable(GL_POLYGON_OFFSET_FILL);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_POLYGON_OFFSET_FILL)");
 			glState.cached_POLYGON_OFFSET_FILL = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_SAMPLE_ALPHA_TO_COVERAGE:
 		if (glState.cached_SAMPLE_ALPHA_TO_COVERAGE) {
 			glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE)");
 			glState.cached_SAMPLE_ALPHA_TO_COVERAGE = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_SAMPLE_COVERAGE:
 		if (glState.cached_SAMPLE_COVERAGE) {
 			glDisable(GL_SAMPLE_COVERAGE);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_SAMPLE_COVERAGE)");
 			glState.cached_SAMPLE_COVERAGE = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	case GL_SCISSOR_TEST:
 		if (glState.cached_SCISSOR_TEST) {
 			glDisable(GL_SCISSOR_TEST);
+			GL_STATE_ISSUED(gcDisable, "glDisable(GL_SCISSOR_TEST)");
 			glState.cached_SCISSOR_TEST = false;
-		}
+		} else
+			GL_STATE_SKIPPED(gcDisable);
 		break;
 	default:
 		glDisable(cap);
+		GL_STATE_ISSUED(gcDisable, "glDisable(0x%04x)", cap);
 		break;
 	}
 }
@@ -211,67 +324,88 @@ void inline cache_glEnable(GLenum cap)
 	case GL_BLEND:
 		if (!glState.cached_BLEND) {
 			glEnable(GL_BLEND);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_BLEND)");
 			glState.cached_BLEND = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_CULL_FACE:
 		if (!glState.cached_CULL_FACE) {
 			glEnable(GL_CULL_FACE);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_CULL_FACE)");
 			glState.cached_CULL_FACE = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_DEPTH_TEST:
 		if (!glState.cached_DEPTH_TEST) {
 			glEnable(GL_DEPTH_TEST);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_DEPTH_TEST)");
 			glState.cached_DEPTH_TEST = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 #ifndef GLESX
 	case GL_DEPTH_CLAMP:
 		if (!glState.cached_DEPTH_CLAMP) {
 			glEnable(GL_DEPTH_CLAMP);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_DEPTH_CLAMP)");
 			glState.cached_DEPTH_CLAMP = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_CLIP_DISTANCE0:
 		if (!glState.cached_CLIP_DISTANCE0) {
 			glEnable(GL_CLIP_DISTANCE0);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_CLIP_DISTANCE0)");
 			glState.cached_CLIP_DISTANCE0 = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 #endif
 	case GL_DITHER:
 		if (!glState.cached_DITHER) {
 			glEnable(GL_DITHER);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_DITHER)");
 			glState.cached_DITHER = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_POLYGON_OFFSET_FILL:
 		if (!glState.cached_POLYGON_OFFSET_FILL) {
 			glEnable(GL_POLYGON_OFFSET_FILL);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_POLYGON_OFFSET_FILL)");
 			glState.cached_POLYGON_OFFSET_FILL = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_SAMPLE_ALPHA_TO_COVERAGE:
 		if (!glState.cached_SAMPLE_ALPHA_TO_COVERAGE) {
 			glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE)");
 			glState.cached_SAMPLE_ALPHA_TO_COVERAGE = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_SAMPLE_COVERAGE:
 		if (!glState.cached_SAMPLE_COVERAGE) {
 			glEnable(GL_SAMPLE_COVERAGE);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_SAMPLE_COVERAGE)");
 			glState.cached_SAMPLE_COVERAGE = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	case GL_SCISSOR_TEST:
 		if (!glState.cached_SCISSOR_TEST) {
 			glEnable(GL_SCISSOR_TEST);
+			GL_STATE_ISSUED(gcEnable, "glEnable(GL_SCISSOR_TEST)");
 			glState.cached_SCISSOR_TEST = true;
-		}
+		} else
+			GL_STATE_SKIPPED(gcEnable);
 		break;
 	default:
 		glEnable(cap);
+		GL_STATE_ISSUED(gcEnable, "glEnable(0x%04x)", cap);
 		break;
 	}
 }
@@ -283,7 +417,9 @@ void inline cache_glPolygonOffset (GLfloat factor, GLfloat units)
 		glPolygonOffset(factor, units);
 		glState.cached_PolygonOffset_factor = factor;
 		glState.cached_PolygonOffset_units = units;
-	}
+		GL_STATE_ISSUED(gcPolygonOffset, "glPolygonOffset(%f, %f)", factor, units);
+	} else
+		GL_STATE_SKIPPED(gcPolygonOffset);
 }
 #define glPolygonOffset(factor, units) cache_glPolygonOffset(factor, units)
 
@@ -295,7 +431,9 @@ void inline cache_glScissor (GLint x, GLint y, GLsizei width, GLsizei height)
 		glState.cached_Scissor_y = y;
 		glState.cached_Scissor_width = width;
 		glState.cached_Scissor_height = height;
-	}
+		GL_STATE_ISSUED(gcScissor, "glScissor(%d, %d, %d, %d)", x, y, width, height);
+	} else
+		GL_STATE_SKIPPED(gcScissor);
 }
 #define glScissor(x, y, width, height) cache_glScissor(x, y, width, height)
 
@@ -304,7 +442,9 @@ void inline cache_glUseProgram (GLuint program)
 	if (program != glState.cached_UseProgram_program) {
 		glUseProgram(program);
 		glState.cached_UseProgram_program = program;
-	}
+		GL_STATE_ISSUED(gcUseProgram, "glUseProgram(%u)", program);
+	} else
+		GL_STATE_SKIPPED(gcUseProgram);
 }
 #define glUseProgram(program) cache_glUseProgram(program)
 
@@ -316,10 +456,157 @@ void inline cache_glViewport (GLint x, GLint y, GLsizei width, GLsizei height)
 		glState.cached_Viewport_y = y;
 		glState.cached_Viewport_width = width;
 		glState.cached_Viewport_height = height;
-	}
+		GL_STATE_ISSUED(gcViewport, "glViewport(%d, %d, %d, %d)", x, y, width, height);
+	} else
+		GL_STATE_SKIPPED(gcViewport);
 }
 #define glViewport(x, y, width, height) cache_glViewport(x, y, width, height)
 
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+void inline cache_glBindSampler(GLuint unit, GLuint sampler)
+{
+	if (unit >= GLState::MAX_TEXTURE_UNITS || glState.cached_BindSampler[unit] != sampler) {
+		glBindSampler(unit, sampler);
+		if (unit < GLState::MAX_TEXTURE_UNITS)
+			glState.cached_BindSampler[unit] = sampler;
+		GL_STATE_ISSUED(gcBindSampler, "glBindSampler(%u, %u)", unit, sampler);
+	} else
+		GL_STATE_SKIPPED(gcBindSampler);
+}
+#define glBindSampler(unit, sampler) cache_glBindSampler(unit, sampler)
+
+void inline cache_glDeleteSamplers(GLsizei n, const GLuint * samplers)
+{
+	glDeleteSamplers(n, samplers);
+	glState.forgetSamplers(n, samplers);
+}
+#define glDeleteSamplers(n, samplers) cache_glDeleteSamplers(n, samplers)
+#endif // GL_SAMPLER_OBJECTS_SUPPORT
+
+void inline _cache_glBindTexture(GLenum target, GLuint texture)
+{
+	GLuint * pBinding = glState.getTextureBinding(target);
+	if (pBinding == NULL || *pBinding != texture) {
+		glBindTexture(target, texture);
+		if (pBinding != NULL)
+			*pBinding = texture;
+		GL_STATE_ISSUED(gcBindTexture, "glBindTexture(0x%04x, %u)", target, texture);
+	} else
+		GL_STATE_SKIPPED(gcBindTexture);
+}
+
+void inline cache_glBindTexture(GLenum target, GLuint texture)
+{
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+	// Textures bound outside of the texture cache use their own sampling parameters.
+	const GLuint unit = glState.cached_ActiveTexture_texture - GL_TEXTURE0;
+	if (target == GL_TEXTURE_2D && unit < GLState::MAX_TEXTURE_UNITS && glState.cached_BindSampler[unit] != 0)
+		cache_glBindSampler(unit, 0);
+#endif
+	_cache_glBindTexture(target, texture);
+}
+
+#ifdef GL_SAMPLER_OBJECTS_SUPPORT
+// Binds 2D texture to the active unit together with sampler object, which overrides texture's sampling parameters.
+void inline cache_glBindTextureSampler(GLuint texture, GLuint sampler)
+{
+	_cache_glBindTexture(GL_TEXTURE_2D, texture);
+	cache_glBindSampler(glState.cached_ActiveTexture_texture - GL_TEXTURE0, sampler);
+}
+#endif // GL_SAMPLER_OBJECTS_SUPPORT
+#define glBindTexture(target, texture) cache_glBindTexture(target, texture)
+
+void inline cache_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	GLint * pParam = glState.getTextureParameter(target, pname);
+	if (pParam == NULL || *pParam != param) {
+		glTexParameteri(target, pname, param);
+		if (pParam != NULL)
+			*pParam = param;
+		GL_STATE_ISSUED(gcTexParameteri, "glTexParameteri(0x%04x, 0x%04x, 0x%04x)", target, pname, param);
+	} else
+		GL_STATE_SKIPPED(gcTexParameteri);
+}
+#define glTexParameteri(target, pname, param) cache_glTexParameteri(target, pname, param)
+
+void inline cache_glDeleteTextures(GLsizei n, const GLuint * textures)
+{
+	glDeleteTextures(n, textures);
+	glState.forgetTextures(n, textures);
+}
+#define glDeleteTextures(n, textures) cache_glDeleteTextures(n, textures)
+
+void inline cache_glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	bool bSkip;
+	if (target == GL_DRAW_FRAMEBUFFER) {
+		bSkip = glState.cached_BindFramebuffer_draw == framebuffer;
+		glState.cached_BindFramebuffer_draw = framebuffer;
+	} else if (target == GL_READ_FRAMEBUFFER) {
+		bSkip = glState.cached_BindFramebuffer_read == framebuffer;
+		glState.cached_BindFramebuffer_read = framebuffer;
+	} else {
+		bSkip = glState.cached_BindFramebuffer_draw == framebuffer && glState.cached_BindFramebuffer_read == framebuffer;
+		glState.cached_BindFramebuffer_draw = glState.cached_BindFramebuffer_read = framebuffer;
+	}
+	if (!bSkip) {
+		glBindFramebuffer(target, framebuffer);
+		GL_STATE_ISSUED(gcBindFramebuffer, "glBindFramebuffer(0x%04x, %u)", target, framebuffer);
+	} else
+		GL_STATE_SKIPPED(gcBindFramebuffer);
+}
+#define glBindFramebuffer(target, framebuffer) cache_glBindFramebuffer(target, framebuffer)
+
+void inline cache_glDeleteFramebuffers(GLsizei n, const GLuint * framebuffers)
+{
+	glDeleteFramebuffers(n, framebuffers);
+	glState.forgetFramebuffers(n, framebuffers);
+}
+#define glDeleteFramebuffers(n, framebuffers) cache_glDeleteFramebuffers(n, framebuffers)
+
+void inline cache_glBindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint * pBinding = glState.getBufferBinding(target);
+	if (pBinding == NULL || *pBinding != buffer) {
+		glBindBuffer(target, buffer);
+		if (pBinding != NULL)
+			*pBinding = buffer;
+		GL_STATE_ISSUED(gcBindBuffer, "glBindBuffer(0x%04x, %u)", target, buffer);
+	} else
+		GL_STATE_SKIPPED(gcBindBuffer);
+}
+#define glBindBuffer(target, buffer) cache_glBindBuffer(target, buffer)
+
+#ifdef GL_UNIFORMBLOCK_SUPPORT
+// Indexed binding also changes the generic binding point of the target.
+void inline cache_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	glBindBufferBase(target, index, buffer);
+	GLuint * pBinding = glState.getBufferBinding(target);
+	if (pBinding != NULL)
+		*pBinding = buffer;
+	GL_STATE_ISSUED(gcBindBufferRange, "glBindBufferBase(0x%04x, %u, %u)", target, index, buffer);
+}
+#define glBindBufferBase(target, index, buffer) cache_glBindBufferBase(target, index, buffer)
+
+void inline cache_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	glBindBufferRange(target, index, buffer, offset, size);
+	GLuint * pBinding = glState.getBufferBinding(target);
+	if (pBinding != NULL)
+		*pBinding = buffer;
+	GL_STATE_ISSUED(gcBindBufferRange, "glBindBufferRange(0x%04x, %u, %u, %ld, %ld)", target, index, buffer, (long)offset, (long)size);
+}
+#define glBindBufferRange(target, index, buffer, offset, size) cache_glBindBufferRange(target, index, buffer, offset, size)
+#endif // GL_UNIFORMBLOCK_SUPPORT
+
+void inline cache_glDeleteBuffers(GLsizei n, const GLuint * buffers)
+{
+	glDeleteBuffers(n, buffers);
+	glState.forgetBuffers(n, buffers);
+}
+#define glDeleteBuffers(n, buffers) cache_glDeleteBuffers(n, buffers)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+#include <cstddef>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "GLideN64_mupenplus.h"
+#include "CoreVideo_EGL.h"
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLSurface eglSurface = EGL_NO_SURFACE;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+
+static
+m64p_error EGL_Init()
+{
+	eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (eglDisplay == EGL_NO_DISPLAY || eglInitialize(eglDisplay, NULL, NULL) != EGL_TRUE) {
+		// No window system. Try Mesa surfaceless platform.
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay == NULL)
+			return M64ERR_SYSTEM_FAIL;
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (eglDisplay == EGL_NO_DISPLAY || eglInitialize(eglDisplay, NULL, NULL) != EGL_TRUE)
+			return M64ERR_SYSTEM_FAIL;
+	}
+	return eglBindAPI(EGL_OPENGL_API) == EGL_TRUE ? M64ERR_SUCCESS : M64ERR_SYSTEM_FAIL;
+}
+
+static
+m64p_error EGL_Quit()
+{
+	if (eglDisplay == EGL_NO_DISPLAY)
+		return M64ERR_SUCCESS;
+	eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (eglContext != EGL_NO_CONTEXT)
+		eglDestroyContext(eglDisplay, eglContext);
+	if (eglSurface != EGL_NO_SURFACE)
+		eglDestroySurface(eglDisplay, eglSurface);
+	eglTerminate(eglDisplay);
+	eglDisplay = EGL_NO_DISPLAY;
+	eglSurface = EGL_NO_SURFACE;
+	eglContext = EGL_NO_CONTEXT;
+	return M64ERR_SUCCESS;
+}
+
+static
+m64p_error EGL_SetVideoMode(int _width, int _height, int, m64p_video_mode, m64p_video_flags)
+{
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 16,
+		EGL_NONE
+	};
+	EGLConfig eglConfig = NULL;
+	EGLint numConfigs = 0;
+	eglChooseConfig(eglDisplay, configAttribs, &eglConfig, 1, &numConfigs);
+	if (numConfigs > 0) {
+		const EGLint surfaceAttribs[] = { EGL_WIDTH, _width, EGL_HEIGHT, _height, EGL_NONE };
+		eglSurface = eglCreatePbufferSurface(eglDisplay, eglConfig, surfaceAttribs);
+	} else {
+		// Surfaceless context. Plugin renders to its own frame buffers anyway.
+		const EGLint anyConfigAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		eglChooseConfig(eglDisplay, anyConfigAttribs, &eglConfig, 1, &numConfigs);
+	}
+
+	// Plugin queries extensions with glGetString(GL_EXTENSIONS), which needs compatibility profile.
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	eglContext = eglCreateContext(eglDisplay, numConfigs > 0 ? eglConfig : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+	if (eglContext == EGL_NO_CONTEXT)
+		return M64ERR_SYSTEM_FAIL;
+	return eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext) == EGL_TRUE ? M64ERR_SUCCESS : M64ERR_SYSTEM_FAIL;
+}
+
+static
+m64p_error EGL_SetCaption(const char *)
+{
+	return M64ERR_SUCCESS;
+}
+
+static
+m64p_error EGL_SetAttribute(m64p_GLattr, int)
+{
+	return M64ERR_SUCCESS;
+}
+
+static
+m64p_error EGL_SwapBuffers()
+{
+	if (eglSurface != EGL_NO_SURFACE)
+		eglSwapBuffers(eglDisplay, eglSurface);
+	return M64ERR_SUCCESS;
+}
+
+static
+void * EGL_GetProcAddress(const char * _name)
+{
+	return (void*)eglGetProcAddress(_name);
+}
+
+void CoreVideo_EGL_Install()
+{
+	CoreVideo_Init = EGL_Init;
+	CoreVideo_Quit = EGL_Quit;
+	CoreVideo_SetVideoMode = EGL_SetVideoMode;
+	CoreVideo_SetCaption = EGL_SetCaption;
+	CoreVideo_GL_SetAttribute = EGL_SetAttribute;
+	CoreVideo_GL_SwapBuffers = EGL_SwapBuffers;
+	CoreVideo_GL_GetProcAddress = EGL_GetProcAddress;
+}
+
+bool CoreVideo_EGL_HasContext()
+{
+	return eglContext != EGL_NO_CONTEXT;
+}
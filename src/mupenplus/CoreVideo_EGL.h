@@ -0,0 +1,13 @@
+#ifndef COREVIDEO_EGL_H
+#define COREVIDEO_EGL_H
+
+// Emulation of the core video extension with off-screen EGL context, for headless tools.
+// Context is OpenGL 3.3 compatibility profile on a pbuffer, or surfaceless if there is no pbuffer config.
+
+// Sets CoreVideo_* pointers to the EGL implementation.
+void CoreVideo_EGL_Install();
+
+// True if video mode was set and the context is current.
+bool CoreVideo_EGL_HasContext();
+
+#endif // COREVIDEO_EGL_H
@@ -125,6 +125,7 @@ void OGLVideoMupenPlus::_swapBuffers()
 		}
 		gDP.changed |= CHANGED_COMBINE;
 		(*renderCallback)((gDP.changed&CHANGED_CPU_FB_WRITE) == 0 ? 1 : 0);
+		glState.invalidateBindings();
 	}
 	CoreVideo_GL_SwapBuffers();
 }
@@ -26,6 +26,8 @@
 #if !defined(OSAL_FILES_H)
 #define OSAL_FILES_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -61,6 +63,11 @@ EXPORT void * CALL osal_search_dir_open(const wchar_t *_pathname);
 EXPORT const wchar_t * CALL osal_search_dir_read_next(void * dir_handle);
 EXPORT void CALL osal_search_dir_close(void * dir_handle);
 
+// Maps the whole file read only into memory
+// Returns pointer to the mapped file and its size, NULL if file can't be mapped
+EXPORT const void * CALL osal_file_map(const wchar_t *path, size_t *size);
+EXPORT void CALL osal_file_unmap(const void *data, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
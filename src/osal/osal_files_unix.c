@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -140,6 +142,35 @@ EXPORT void CALL osal_search_dir_close(void * dir_handle)
     closedir((DIR *) dir_handle);
 }
 
+EXPORT const void * CALL osal_file_map(const wchar_t *_path, size_t *size)
+{
+    char path[PATH_MAX];
+    wcstombs(path, _path, PATH_MAX);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat fileinfo;
+    void *data = NULL;
+    if (fstat(fd, &fileinfo) == 0 && fileinfo.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+            data = NULL;
+        else
+            *size = (size_t)fileinfo.st_size;
+    }
+    /* the mapping stays valid after close */
+    close(fd);
+    return data;
+}
+
+EXPORT void CALL osal_file_unmap(const void *data, size_t size)
+{
+    if (data != NULL)
+        munmap((void *) data, size);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -157,6 +157,36 @@ EXPORT void CALL osal_search_dir_close(void * search_info)
     }
 }
 
+EXPORT const void * CALL osal_file_map(const wchar_t *path, size_t *size)
+{
+    HANDLE hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER fileSize;
+    const void *data = NULL;
+    if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (hMapping != NULL)
+        {
+            data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (data != NULL)
+                *size = (size_t)fileSize.QuadPart;
+            /* the view keeps the mapping open */
+            CloseHandle(hMapping);
+        }
+    }
+    CloseHandle(hFile);
+    return data;
+}
+
+EXPORT void CALL osal_file_unmap(const void *data, size_t size)
+{
+    if (data != NULL)
+        UnmapViewOfFile(data);
+}
+
 #ifdef __cplusplus
 }
 #endif